@@ -41,6 +41,6 @@
 #define NET_THREAD_STACK_SIZE   1024
 
 //      Core Thread Priority
-#define NET_THREAD_PRIORITY     osPriorityNormal
+#define NET_THREAD_PRIORITY     osPriorityAboveNormal
 //   </h>
 // </h>
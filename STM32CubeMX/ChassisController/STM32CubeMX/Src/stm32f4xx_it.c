@@ -22,6 +22,7 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "cpu_load.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -185,11 +186,11 @@ void DMA1_Stream1_IRQHandler(void)
 void TIM3_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM3_IRQn 0 */
-
+  uint32_t cpuLoadStart = CpuLoad_IsrEnter();
   /* USER CODE END TIM3_IRQn 0 */
   HAL_TIM_IRQHandler(&htim3);
   /* USER CODE BEGIN TIM3_IRQn 1 */
-
+  CpuLoad_IsrExit(CPU_LOAD_ISR_TIM3, cpuLoadStart);
   /* USER CODE END TIM3_IRQn 1 */
 }
 
@@ -199,11 +200,11 @@ void TIM3_IRQHandler(void)
 void TIM4_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM4_IRQn 0 */
-
+  uint32_t cpuLoadStart = CpuLoad_IsrEnter();
   /* USER CODE END TIM4_IRQn 0 */
   HAL_TIM_IRQHandler(&htim4);
   /* USER CODE BEGIN TIM4_IRQn 1 */
-
+  CpuLoad_IsrExit(CPU_LOAD_ISR_TIM4, cpuLoadStart);
   /* USER CODE END TIM4_IRQn 1 */
 }
 
@@ -213,11 +214,11 @@ void TIM4_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  uint32_t cpuLoadStart = CpuLoad_IsrEnter();
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  CpuLoad_IsrExit(CPU_LOAD_ISR_USART3, cpuLoadStart);
   /* USER CODE END USART3_IRQn 1 */
 }
 
@@ -241,11 +242,11 @@ void TIM8_TRG_COM_TIM14_IRQHandler(void)
 void TIM7_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM7_IRQn 0 */
-
+  uint32_t cpuLoadStart = CpuLoad_IsrEnter();
   /* USER CODE END TIM7_IRQn 0 */
   HAL_TIM_IRQHandler(&htim7);
   /* USER CODE BEGIN TIM7_IRQn 1 */
-
+  CpuLoad_IsrExit(CPU_LOAD_ISR_TIM7, cpuLoadStart);
   /* USER CODE END TIM7_IRQn 1 */
 }
 
@@ -255,11 +256,11 @@ void TIM7_IRQHandler(void)
 void ETH_IRQHandler(void)
 {
   /* USER CODE BEGIN ETH_IRQn 0 */
-
+  uint32_t cpuLoadStart = CpuLoad_IsrEnter();
   /* USER CODE END ETH_IRQn 0 */
   HAL_ETH_IRQHandler(&heth);
   /* USER CODE BEGIN ETH_IRQn 1 */
-
+  CpuLoad_IsrExit(CPU_LOAD_ISR_ETH, cpuLoadStart);
   /* USER CODE END ETH_IRQn 1 */
 }
 
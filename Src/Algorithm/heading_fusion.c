@@ -0,0 +1,87 @@
+/**
+ * @file heading_fusion.c
+ * @brief Fusion of the wheel odometry heading with a yaw-rate gyro
+ *
+ * @details
+ *  - The heading increment of a step is the angle the gyro turned during it,
+ *    integrated from all its samples (Gyro_TakeTurn), minus the bias times dt.
+ *  - The wheels agree with the gyro up to the noise and the scale errors of
+ *    both; a share wheelGain of the disagreement is taken from the wheels,
+ *    so a gyro scale error does not build up over long turns.
+ *  - A disagreement above slipGate is a wheel slipping or the chassis being
+ *    pushed: the wheels are ignored for that step.
+ *  - After stillTime with no encoder edge on either wheel, the chassis stands
+ *    still: the gyro turn of each step over dt measures the bias, filtered
+ *    by the Kalman module, and the heading is held. While moving the
+ *    variance of the bias grows by biasVariance per second, nothing
+ *    measures it then.
+ *
+ * @dependencies kalman_filter
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "heading_fusion.h"
+
+#include <math.h>
+#include <stddef.h>
+
+/**
+ * @brief Initialize the heading fusion
+ * The bias starts at 0 with the variance of one gyro sample.
+ * @param fusion Pointer to the fusion state
+ * @param params Pointer to the settings
+ */
+void HeadingFusion_Init(HeadingFusion_t* fusion, const HeadingFusion_Params_t* params)
+{
+    if (fusion == NULL || params == NULL) return;
+    fusion->params = *params;
+    // The drift of the bias is added by the steps, with their own dt
+    KalmanFilter_Init(&fusion->bias, params->gyroVariance, params->gyroVariance, 0.0f);
+    fusion->stillTime = 0.0f;
+    fusion->slipCount = 0;
+}
+
+/**
+ * @brief Fuse the heading increment of one odometry step
+ * @param fusion Pointer to the fusion state
+ * @param wheelTurn Heading increment measured by the wheels in radians
+ * @param isStill true if no wheel moved during the step
+ * @param gyroTurn Angle turned by the gyro during the step in radians, counterclockwise positive
+ * @param dt Time interval in seconds of the step
+ * @param variance Pointer to store the variance of the fused increment in rad^2
+ * @return Fused heading increment in radians
+ */
+float HeadingFusion_Step(HeadingFusion_t* fusion, float wheelTurn, bool isStill, float gyroTurn, float dt, float* variance)
+{
+    const HeadingFusion_Params_t *params = &fusion->params;
+    fusion->bias.estimateVariance += params->biasVariance * dt;
+    fusion->stillTime = isStill ? fusion->stillTime + dt : 0.0f;
+    if (fusion->stillTime >= params->stillTime)
+    {
+        // Standing still: the gyro reads its bias and the heading holds
+        KalmanFilter_Calc(&fusion->bias, gyroTurn / dt);
+        *variance = 0.0f;
+        return 0.0f;
+    }
+
+    float turn = gyroTurn - fusion->bias.lastEstimateValue * dt;
+    *variance = (params->gyroVariance + fusion->bias.estimateVariance) * dt * dt;
+    float disagreement = wheelTurn - turn;
+    if (fabsf(disagreement) > params->slipGate * dt)
+    {
+        fusion->slipCount++;
+        return turn;
+    }
+    return turn + params->wheelGain * disagreement;
+}
+
+/**
+ * @brief Get the estimated gyro bias
+ * @param fusion Pointer to the fusion state
+ * @return Bias in rad/s
+ */
+float HeadingFusion_GetBias(const HeadingFusion_t* fusion)
+{
+    return fusion->bias.lastEstimateValue;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file heading_fusion.h
+ * @brief Fusion of the wheel odometry heading with a yaw-rate gyro
+ *
+ * @details Declares a complementary filter on the heading increments of each
+ * odometry step. The angle turned by the gyro during the step gives the
+ * increment, corrected by its bias; the wheels pull it by a small share of
+ * their disagreement, or not at all when the disagreement says a wheel slips. The bias is estimated by a Kalman
+ * filter while the wheels stand still. No hardware access: the same code runs
+ * on recorded samples on a host.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "kalman_filter.h"
+
+/**
+ * @brief Settings of the heading fusion
+ */
+typedef struct {
+    float gyroVariance;     // Variance of a gyro rate sample in (rad/s)^2
+    float biasVariance;     // Variance of the bias drift per second in (rad/s)^2
+    float wheelGain;        // Share of the wheel and gyro disagreement taken from the wheels per step, 0 to 1
+    float slipGate;         // Disagreement in rad/s above which the wheels are taken to slip
+    float stillTime;        // Time in seconds the wheels must stand still before the bias is measured
+} HeadingFusion_Params_t;
+
+/**
+ * @brief State of the heading fusion
+ */
+typedef struct {
+    HeadingFusion_Params_t params;
+    KalmanFilter_t bias;    // Gyro bias in rad/s
+    float stillTime;        // Time the wheels have been standing still
+    uint32_t slipCount;     // Steps where the wheels were taken to slip
+} HeadingFusion_t;
+
+/**
+ * @brief Initialize the heading fusion
+ * The bias starts at 0 with the variance of one gyro sample.
+ * @param fusion Pointer to the fusion state
+ * @param params Pointer to the settings
+ */
+void HeadingFusion_Init(HeadingFusion_t* fusion, const HeadingFusion_Params_t* params);
+
+/**
+ * @brief Fuse the heading increment of one odometry step
+ * @param fusion Pointer to the fusion state
+ * @param wheelTurn Heading increment measured by the wheels in radians
+ * @param isStill true if no wheel moved during the step
+ * @param gyroTurn Angle turned by the gyro during the step in radians, counterclockwise positive
+ * @param dt Time interval in seconds of the step
+ * @param variance Pointer to store the variance of the fused increment in rad^2
+ * @return Fused heading increment in radians
+ */
+float HeadingFusion_Step(HeadingFusion_t* fusion, float wheelTurn, bool isStill, float gyroTurn, float dt, float* variance);
+
+/**
+ * @brief Get the estimated gyro bias
+ * @param fusion Pointer to the fusion state
+ * @return Bias in rad/s
+ */
+float HeadingFusion_GetBias(const HeadingFusion_t* fusion);
@@ -40,3 +40,17 @@ float KalmanFilter_Calc(KalmanFilter_t* filter, float measurement)
     filter->estimateVariance += filter->processErrorVariance;
     return filter->lastEstimateValue;
 }
+
+/**
+ * @brief Change the noise variances of a running filter
+ * The estimate and its variance are kept, the filter goes on smoothly.
+ * 
+ * @param filter Pointer to the Kalman filter structure
+ * @param measureVariance Variance of the measurement noise
+ * @param processErrorVariance Variance of the process error
+ */
+void KalmanFilter_SetVariances(KalmanFilter_t* filter, float measureVariance, float processErrorVariance)
+{
+    filter->measureVariance = measureVariance;
+    filter->processErrorVariance = processErrorVariance;
+}
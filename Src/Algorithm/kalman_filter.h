@@ -13,3 +13,4 @@ typedef struct kalman
 
 void KalmanFilter_Init(KalmanFilter_t* , float estimateVariance, float measureVariance, float processErrorVariance);
 float KalmanFilter_Calc(KalmanFilter_t* , float measurement);
+void KalmanFilter_SetVariances(KalmanFilter_t* , float measureVariance, float processErrorVariance);
@@ -2,18 +2,24 @@
  * @file pid.c
  * @author Young.R com.wang@hotmail.com
  * @brief PID control algorithm implementation
- * @version 0.1
+ * @version 0.2
  * @date 2025-07-02
  * 
  * @copyright Copyright (c) 2025
  * 
+ * Modified on 2026-10-17: feed-forward input, anti-windup by back-calculation
+ * against the output limits, and a filtered derivative on the measurement so
+ * that setpoint steps do not kick the output. Gains can be changed while
+ * running without a step of the output.
  */
 #include "pid.h"
 
-#define MAX_SUM_ERROR   1000
+#define MAX_SUM_ERROR   1000    // Integral bound in error units when the output is not limited
 
 /**
  * @brief Initialize the PID controller
+ * The output is not limited, the derivative is not filtered and there is no
+ * feed-forward until configured.
  * @param pid Pointer to the PID controller structure
  * @param kP Proportional gain
  * @param kI Integral gain
@@ -24,7 +30,14 @@ void PID_Init(PID_t* pid, float kP, float kI, float kD)
     pid->kP = kP;
     pid->kI = kI;
     pid->kD = kD;
-    pid->lastError = 0;
+    pid->kAW = 0;
+    pid->derivativeAlpha = 1.0f;
+    pid->outputMin = 0;
+    pid->outputMax = 0;
+    pid->isLimited = false;
+    pid->feedForward = 0;
+    pid->lastMeasurement = 0;
+    pid->derivative = 0;
     pid->sumError = 0;
     pid->object = 0;
 }
@@ -37,12 +50,85 @@ void PID_Init(PID_t* pid, float kP, float kI, float kD)
 void PID_SetObject(PID_t* pid, float object)
 {
     pid->object = object;
-    // pid->lastError = 0;
-    // pid->sumError = 0;
+}
+
+/**
+ * @brief Change the gains of a running PID controller
+ * The integral takes over the change of the proportional and derivative
+ * terms at the last measurement, so the output goes on from where it was
+ * (bumpless transfer). The integral is kept in output units, a new kI only
+ * acts on the errors to come.
+ * @param pid Pointer to the PID controller structure
+ * @param kP Proportional gain
+ * @param kI Integral gain
+ * @param kD Derivative gain
+ */
+void PID_SetGains(PID_t* pid, float kP, float kI, float kD)
+{
+    double error = pid->object - pid->lastMeasurement;
+    pid->sumError += (pid->kP - kP) * error + (pid->kD - kD) * pid->derivative;
+    pid->kP = kP;
+    pid->kI = kI;
+    pid->kD = kD;
+}
+
+/**
+ * @brief Limit the output of the PID controller
+ * While the output is clamped, the integral is pulled back by kAW times the
+ * part of the output which was cut, so it does not wind up.
+ * @param pid Pointer to the PID controller structure
+ * @param outputMin Lowest output
+ * @param outputMax Highest output
+ * @param kAW Back-calculation gain per sample, 0 to 1
+ */
+void PID_SetOutputLimits(PID_t* pid, float outputMin, float outputMax, float kAW)
+{
+    pid->outputMin = outputMin;
+    pid->outputMax = outputMax;
+    pid->kAW = kAW;
+    pid->isLimited = outputMax > outputMin;
+}
+
+/**
+ * @brief Filter the derivative term
+ * First order low pass: derivative += alpha * (raw - derivative).
+ * @param pid Pointer to the PID controller structure
+ * @param alpha Smoothing factor, 1 for no filter, smaller for more smoothing
+ */
+void PID_SetDerivativeFilter(PID_t* pid, float alpha)
+{
+    if (alpha <= 0.0f || alpha > 1.0f) alpha = 1.0f;
+    pid->derivativeAlpha = alpha;
+}
+
+/**
+ * @brief Set the feed-forward term
+ * The value is added to the output at each calculation, before the clamp.
+ * @param pid Pointer to the PID controller structure
+ * @param feedForward The feed-forward output
+ */
+void PID_SetFeedForward(PID_t* pid, float feedForward)
+{
+    pid->feedForward = feedForward;
+}
+
+/**
+ * @brief Change the feed-forward model of a running PID controller
+ * Unlike PID_SetFeedForward, the integral takes over the difference, so the
+ * output goes on from where it was (bumpless transfer). Use it when the
+ * model changes, not the target.
+ * @param pid Pointer to the PID controller structure
+ * @param feedForward The feed-forward output of the new model
+ */
+void PID_ChangeFeedForward(PID_t* pid, float feedForward)
+{
+    pid->sumError -= feedForward - pid->feedForward;
+    pid->feedForward = feedForward;
 }
 
 /**
  * @brief Calculate the PID output based on the current measurement
+ * The derivative acts on the measurement, not on the error.
  * @param pid Pointer to the PID controller structure
  * @param measurement The current measurement value
  * @return The calculated PID output
@@ -50,10 +136,24 @@ void PID_SetObject(PID_t* pid, float object)
 float PID_Calc(PID_t* pid, float measurement)
 {
     float error = pid->object - measurement;
-    float differentialError = error - pid->lastError;
-    pid->sumError += error;
-    if(pid->sumError > MAX_SUM_ERROR) pid->sumError = MAX_SUM_ERROR;
-    else if (pid->sumError < -MAX_SUM_ERROR) pid->sumError = -MAX_SUM_ERROR;
-    pid->lastError = error;
-    return (pid->kP*error + pid->kI*pid->sumError + pid->kD*differentialError);
+    double rawDerivative = pid->lastMeasurement - measurement;
+    pid->derivative += pid->derivativeAlpha * (rawDerivative - pid->derivative);
+    pid->lastMeasurement = measurement;
+
+    pid->sumError += pid->kI * error;
+    if (!pid->isLimited)
+    {
+        double maxSum = pid->kI * MAX_SUM_ERROR;
+        if (maxSum < 0) maxSum = -maxSum;
+        if (pid->sumError > maxSum) pid->sumError = maxSum;
+        else if (pid->sumError < -maxSum) pid->sumError = -maxSum;
+        return (float)(pid->kP*error + pid->sumError + pid->kD*pid->derivative + pid->feedForward);
+    }
+
+    double output = pid->kP*error + pid->sumError + pid->kD*pid->derivative + pid->feedForward;
+    double clamped = output;
+    if (clamped > pid->outputMax) clamped = pid->outputMax;
+    else if (clamped < pid->outputMin) clamped = pid->outputMin;
+    pid->sumError += pid->kAW * (clamped - output);
+    return (float)clamped;
 }
@@ -1,17 +1,30 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct pid
 {
     float kP;
     float kI;
     float kD;
+    float kAW;              // Back-calculation gain of the anti-windup, per sample
+    float derivativeAlpha;  // Smoothing of the derivative, 1 for no filter
+    float outputMin;
+    float outputMax;
+    bool isLimited;         // Output clamped to [outputMin, outputMax]
+    float feedForward;      // Added to the output before the clamp
     double object;
-    double sumError;
-    double lastError;
+    double sumError;        // Integral term, in output units
+    double lastMeasurement;
+    double derivative;      // Filtered derivative of the measurement
 } PID_t;
 
 void PID_Init(PID_t* instancePID, float kP, float kI, float kD);
 float PID_Calc(PID_t* p, float measurement);
 void PID_SetObject(PID_t* instancePID, float object);
+void PID_SetGains(PID_t* instancePID, float kP, float kI, float kD);
+void PID_SetOutputLimits(PID_t* instancePID, float outputMin, float outputMax, float kAW);
+void PID_SetDerivativeFilter(PID_t* instancePID, float alpha);
+void PID_SetFeedForward(PID_t* instancePID, float feedForward);
+void PID_ChangeFeedForward(PID_t* instancePID, float feedForward);
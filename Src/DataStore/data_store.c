@@ -3,6 +3,8 @@
  * @brief Data Store Module Implementation
  * @version 1.0
  * @date 2025-07-22
+ *       Modified on 2026-10-17: parameter registry, schema version and range checks
+ *       Modified on 2026-10-17: range checks of the motor and odometry records
  * 
  * @details This module provides a centralized, thread-safe data storage system
  * for the chassis controller. It manages configuration parameters including:
@@ -15,6 +17,22 @@
  * The module uses RTOS mutexes to ensure thread-safe access to all stored data,
  * making it suitable for use in multi-threaded environments. All data is stored
  * in RAM and initialized with default values from system_config.h.
+ *
+ * Persistence uses the log-structured key/value store (kv_store.c): every
+ * field has its own key, and a save appends records only for the fields whose
+ * value differs from flash. The whole-struct image written by older firmware
+ * through StoreFile is read once to migrate it when the key/value log is empty.
+ *
+ * The scalar parameters are declared once in DATA_STORE_PARAMETERS (data_store.h)
+ * with their key, type, default, range and persistence; their fields, defaults,
+ * getters, setters and records are generated from it. A schema version record
+ * tells which layout wrote the log; records of unknown keys or of another size
+ * are skipped, so older and newer firmware read the same log.
+ *
+ * Saves are coalesced: a save request marks the data store dirty, the data
+ * store thread gathers the requests of a debounce window and commits them
+ * together, never sooner than a minimum interval after the previous commit.
+ * DataStore_Flush commits at once, before a reset.
  * 
  * @section Features
  * - Thread-safe getter/setter functions for all parameters
@@ -62,11 +80,19 @@
 #include "main.h"
 #include "crc32.h"
 #include "store_file.h"
+#include "kv_store.h"
+#include "flight_recorder.h"
 #include "system_config.h"
+#include "rtx_os.h"
 
-#include "rl_net.h" // For netIP_aton
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
 
 #define EVENT_FLAG_DATA_STORE_MODIFIED 0x01 // Event flag for data store modification
+#define EVENT_FLAG_DATA_STORE_FLUSH    0x02 // Event flag to commit at once
+#define EVENT_FLAG_DATA_STORE_FLUSHED  0x04 // Event flag set when the flush is committed
+#define DATA_STORE_SCHEMA_VERSION   2   // 1: key/value log before the registry, 2: registry with range checks
 
 /* ------------------ Data type declaration --------------------*/
 typedef struct ipAddress {
@@ -80,8 +106,10 @@ typedef struct {
     float gearRatio;          // Gear ratio
 } MotorParameters_t;
 
-/* ------------------ Static variables definition --------------------*/
-static struct {
+/**
+ * @brief Whole-struct image written by older firmware, padding included
+ */
+typedef struct {
     MotorParameters_t motorParams;  // Motor parameters
     ipAddress_t localUdpAddress;    // UDP server address
     float wheelRadius;
@@ -92,22 +120,123 @@ static struct {
     float maxAngularAcceleration;
     float maxVelocity;
     float maxOmega;
-} dataStore;
+} LegacyImage_t;
+
+typedef struct {
+    // Scalar parameters, named as in DATA_STORE_PARAMETERS
+#define DATA_STORE_FIELD_DECLARE(name, keyId, valueType, defaultValue, min, max, persist) DATA_STORE_CTYPE_##valueType name;
+    DATA_STORE_PARAMETERS(DATA_STORE_FIELD_DECLARE)
+#undef DATA_STORE_FIELD_DECLARE
+    DataStore_MotorGains_t motorGains[TOTAL_MOTOR_NUMBER];
+    DataStore_MotorModel_t motorModel[TOTAL_MOTOR_NUMBER];
+    DataStore_MotorFilter_t motorFilter[TOTAL_MOTOR_NUMBER];
+    uint32_t encoderResolution[TOTAL_MOTOR_NUMBER];    // Encoder edges per wheel revolution
+    DataStore_OdometryNoise_t odometryNoise;
+    uint32_t schemaVersion;                             // DATA_STORE_SCHEMA_VERSION of the layout which wrote the log
+} DataStore_t;
+
+/* ------------------ Static variables definition --------------------*/
+static DataStore_t dataStore;
 
 static osMutexId_t dataStoreMutex;
 static osEventFlagsId_t dataStoreEventFlags;
 static osThreadId_t threadIdDataStore;
+static uint64_t threadStackDataStore[1024 / sizeof(uint64_t)];
+static osRtxThread_t threadControlBlockDataStore;
 static const osThreadAttr_t threadAttrDataStore = {
     .name = "ThreadDataStore",
-    .stack_size = 1024,
-    .priority = osPriorityBelowNormal,
+    .cb_mem = &threadControlBlockDataStore,
+    .cb_size = sizeof(threadControlBlockDataStore),
+    .stack_mem = threadStackDataStore,
+    .stack_size = sizeof(threadStackDataStore),
+    .priority = THREAD_PRIORITY_PERSISTENCE,
+};
+static struct {
+    uint64_t keyMask;
+    osThreadId_t thread;
+    uint32_t flags;
+} subscribers[DATA_STORE_MAX_SUBSCRIBERS];
+static volatile uint32_t subscriberCount = 0;
+static volatile bool isSavePending = false;    // Save requested and not yet committed
+static volatile uint32_t saveRequestCount = 0;  // Save requests since boot
+static volatile uint32_t commitCount = 0;       // Commits which wrote to flash since boot
+static StoreFile_t paramFile;   // Legacy parameter file, only read to migrate old images
+static KVStore_t paramStore;    // Key/value parameter log
+
+// Defaults of the records, declared in system_config.h
+static const DataStore_MotorGains_t defaultMotorGains = {
+    DEFAULT_MOTOR_KP, DEFAULT_MOTOR_KI, DEFAULT_MOTOR_KD, DEFAULT_MOTOR_FF_KS, DEFAULT_MOTOR_FF_KV, DEFAULT_MOTOR_FF_KA
+};
+static const DataStore_MotorFilter_t defaultMotorFilter = {
+    DEFAULT_MOTOR_DERIVATIVE_ALPHA, DEFAULT_MOTOR_ANTI_WINDUP, DEFAULT_MOTOR_MEASURE_VARIANCE, DEFAULT_MOTOR_PROCESS_VARIANCE
+};
+static const DataStore_OdometryNoise_t defaultOdometryNoise = {
+    { DEFAULT_ODOMETRY_WHEEL_SLIP, DEFAULT_ODOMETRY_WHEEL_SLIP },
+    { DEFAULT_ODOMETRY_SPEED_VARIANCE, DEFAULT_ODOMETRY_SPEED_VARIANCE },
 };
-static StoreFile_t paramFile;   // Pointer to parameter file interface
+
+/**
+ * @brief Map of persisted fields to their key ids
+ */
+#define DATA_STORE_FIELD(key, field) { key, offsetof(DataStore_t, field), sizeof(dataStore.field), DATA_STORE_PERSIST }
+#define DATA_STORE_MOTOR_FIELDS(motorId) \
+    DATA_STORE_FIELD(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_GAINS, motorId), motorGains[motorId]), \
+    DATA_STORE_FIELD(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_MODEL, motorId), motorModel[motorId]), \
+    DATA_STORE_FIELD(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_FILTER, motorId), motorFilter[motorId]), \
+    DATA_STORE_FIELD(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_ENCODER_RESOLUTION, motorId), encoderResolution[motorId]),
+#if TOTAL_MOTOR_NUMBER < 2 || TOTAL_MOTOR_NUMBER > 4
+#error "The persisted motor records are listed for 2 to 4 motors"
+#endif
+_Static_assert(DATA_STORE_KEY_NUMBER <= DATA_STORE_KEY_MOTOR_BLOCKS, "Keys overlap the motor key blocks");
+_Static_assert(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_RECORD_NUMBER - 1, TOTAL_MOTOR_NUMBER - 1) < KV_STORE_MAX_KEYS &&
+               DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_RECORD_NUMBER - 1, TOTAL_MOTOR_NUMBER - 1) < 64,
+               "Motor keys beyond the key/value store or the subscription mask");
+#define DATA_STORE_PARAMETER_FIELD(name, keyId, valueType, defaultValue, min, max, persist) \
+    { keyId, offsetof(DataStore_t, name), sizeof(dataStore.name), persist },
+static const struct {
+    uint16_t key;
+    uint16_t offset;
+    uint16_t size;
+    bool persist;
+} persistedFields[] = {
+    DATA_STORE_PARAMETERS(DATA_STORE_PARAMETER_FIELD)
+    DATA_STORE_MOTOR_FIELDS(0)
+    DATA_STORE_MOTOR_FIELDS(1)
+#if TOTAL_MOTOR_NUMBER > 2
+    DATA_STORE_MOTOR_FIELDS(2)
+#endif
+#if TOTAL_MOTOR_NUMBER > 3
+    DATA_STORE_MOTOR_FIELDS(3)
+#endif
+    DATA_STORE_FIELD(DATA_STORE_KEY_ODOMETRY_NOISE, odometryNoise),
+    DATA_STORE_FIELD(DATA_STORE_KEY_SCHEMA_VERSION, schemaVersion),
+};
+#define PERSISTED_FIELD_NUMBER (sizeof(persistedFields) / sizeof(persistedFields[0]))
+
+// Every persisted field fits a key/value record and the value of its flight record
+#define DATA_STORE_FIELD_FITS(size) \
+    ((size) <= KV_STORE_MAX_VALUE_SIZE && (size) <= sizeof(((FlightRecordParameter_t*)0)->value))
+#define DATA_STORE_PARAMETER_FITS(name, keyId, valueType, defaultValue, min, max, persist) \
+    _Static_assert(DATA_STORE_FIELD_FITS(sizeof(((DataStore_t*)0)->name)), #name " does not fit a parameter record");
+DATA_STORE_PARAMETERS(DATA_STORE_PARAMETER_FITS)
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(DataStore_MotorGains_t)), "Motor gains do not fit a parameter record");
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(DataStore_MotorModel_t)), "Motor model does not fit a parameter record");
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(DataStore_MotorFilter_t)), "Motor filter does not fit a parameter record");
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(((DataStore_t*)0)->encoderResolution[0])), "Encoder resolution does not fit a parameter record");
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(DataStore_OdometryNoise_t)), "Odometry noise does not fit a parameter record");
+_Static_assert(DATA_STORE_FIELD_FITS(sizeof(((DataStore_t*)0)->schemaVersion)), "Schema version does not fit a parameter record");
 
 /* ------------------ Static functions declaration --------------------*/
 static void DataStoreThread(void* arg);
-static void SaveDataToFile(void);
+static void SetDefaultValues(void);
+static bool SaveDataToStore(void);
+static bool ReadDataFromStore(void);
 static bool ReadDataFromFile(void);
+static void MigrateData(void);
+static void NotifyChange(DataStoreKey_t key);
+static bool InRangeF32(float value, float min, float max);
+static bool InRangeU32(uint32_t value, uint32_t min, uint32_t max);
+static bool InRangeU16(uint16_t value, uint16_t min, uint16_t max);
 
 /**
  * @brief Initialize the Data Store module.
@@ -126,424 +255,577 @@ void DataStore_Init(void)
     // Create the data store thread
     threadIdDataStore = osThreadNew(DataStoreThread, NULL, &threadAttrDataStore);
     assert_param(threadIdDataStore != NULL);
-    // Get the parameter file interface instance
-    bool result = StoreFile_Init(&paramFile, EXT_FLASH_PARAMETER_FILE_ADDRESS, EXT_FLASH_PARAMETER_FILE_SIZE);
+    // Get the parameter store and the legacy parameter file instances
+    bool result = KVStore_Init(&paramStore, EXT_FLASH_PARAMETER_KV_ADDRESS, EXT_FLASH_PARAMETER_KV_SIZE);
     assert_param(result);
-    // Load existing parameters from the file, or initialize with defaults
-    if (!ReadDataFromFile())
+    result = StoreFile_Init(&paramFile, EXT_FLASH_PARAMETER_FILE_ADDRESS, EXT_FLASH_PARAMETER_FILE_SIZE);
+    assert_param(result);
+    // Load existing parameters, migrate an old whole-struct image, or initialize with defaults
+    if (!ReadDataFromStore())
+    {
+        if (!ReadDataFromFile()) SetDefaultValues();
+        SaveDataToStore();  // Before the thread runs, not coalesced
+    }
+}
+
+/**
+ * @brief Set every field of the data store to its default value.
+ */
+void SetDefaultValues(void)
+{
+    osMutexAcquire(dataStoreMutex, osWaitForever);
+    // Scalar parameters, defaults declared in system_config.h
+#define DATA_STORE_SET_DEFAULT(name, keyId, valueType, defaultValue, min, max, persist) \
+    dataStore.name = (DATA_STORE_CTYPE_##valueType)(defaultValue);
+    DATA_STORE_PARAMETERS(DATA_STORE_SET_DEFAULT)
+#undef DATA_STORE_SET_DEFAULT
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
     {
-        uint32_t defaultIP;
-        netIP_aton(DEFAULT_LOCAL_UDP_ADDRESS, NET_ADDR_IP4, (uint8_t*)&defaultIP);
-        dataStore.localUdpAddress.ipv4 = defaultIP;                 // Default IP address, declared in system_config.h
-        dataStore.localUdpAddress.port = DEFAULT_LOCAL_UDP_PORT;    // Default port, declared in system_config.h
-        dataStore.wheelRadius = DEFAULT_WHEEL_DIAMETER/2;           // Default wheel radius in meters, declared in system_config.h
-        dataStore.trackWidth = DEFAULT_TRACK_WIDTH;                 // Default track width in meters, declared in system_config.h
-        dataStore.motorParams.pulsePerRevolution = DEFAULT_PULSE_PER_REVOL; // Default pulses per revolution, declared in system_config.h
-        dataStore.maxVelocity = DEFAULT_MAX_VELOCITY;               // Default maximum linear speed in m/s, declared in system_config.h
-        dataStore.maxOmega = DEFAULT_MAX_OMEGA;                     // Default maximum angular speed in rad/s, declared in system_config.h
+        // Default gains, filters and encoder, no identified model
+        dataStore.motorGains[i] = defaultMotorGains;
+        memset(&dataStore.motorModel[i], 0, sizeof(DataStore_MotorModel_t));
+        dataStore.motorFilter[i] = defaultMotorFilter;
+        dataStore.encoderResolution[i] = DEFAULT_ENCODER_RESOLUTION;
     }
+    dataStore.odometryNoise = defaultOdometryNoise;
+    dataStore.schemaVersion = DATA_STORE_SCHEMA_VERSION;
+    osMutexRelease(dataStoreMutex);
 }
 
 /**
  * @brief Data Store Thread
- * This thread waits for modification events and saves the data store to the
- * parameter file when changes are detected.
+ * This thread waits for save requests and appends the changed fields to the
+ * parameter store. The requests of DATA_STORE_SAVE_DEBOUNCE ms from the first
+ * one are committed together, and a commit waits for DATA_STORE_SAVE_MIN_INTERVAL
+ * ms after the previous one; a flush request ends the wait.
  * @param arg pointer to argument (not used)
  */
 void DataStoreThread(void* arg)
 {
     (void)arg; // Suppress unused parameter warning
+    uint32_t lastCommitTick = 0;
+    bool hasCommitted = false;
     for (;;)
     {
-        osEventFlagsWait(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_MODIFIED, osFlagsWaitAny, osWaitForever);
-        uint32_t paramCRC, fileCRC;
-        osMutexAcquire(dataStoreMutex, osWaitForever);
-        paramCRC = Crc32(CRC32_INITIAL_VALUE, &dataStore, sizeof(dataStore));
-        osMutexRelease(dataStoreMutex);
-        fileCRC = paramFile.CalculateCRC(&paramFile);
-        if (paramCRC != fileCRC) SaveDataToFile();
+        const uint32_t requestFlags = EVENT_FLAG_DATA_STORE_MODIFIED | EVENT_FLAG_DATA_STORE_FLUSH;
+        uint32_t flags = osEventFlagsWait(dataStoreEventFlags, requestFlags, osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+        if (!(flags & EVENT_FLAG_DATA_STORE_FLUSH))
+        {
+            uint32_t due = osKernelGetTickCount() + DATA_STORE_SAVE_DEBOUNCE;
+            if (hasCommitted && (int32_t)(lastCommitTick + DATA_STORE_SAVE_MIN_INTERVAL - due) > 0)
+                due = lastCommitTick + DATA_STORE_SAVE_MIN_INTERVAL;
+            int32_t remaining;
+            while ((remaining = (int32_t)(due - osKernelGetTickCount())) > 0)
+            {
+                flags = osEventFlagsWait(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_FLUSH, osFlagsWaitAny | osFlagsNoClear, (uint32_t)remaining);
+                if (!(flags & osFlagsError)) break; // Flush requested
+            }
+        }
+        // Requests from here on are seen by the next round
+        flags = osEventFlagsClear(dataStoreEventFlags, requestFlags);
+        isSavePending = false;
+        if (SaveDataToStore())
+        {
+            commitCount++;
+            lastCommitTick = osKernelGetTickCount();
+            hasCommitted = true;
+        }
+        if (flags & EVENT_FLAG_DATA_STORE_FLUSH) osEventFlagsSet(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_FLUSHED);
     }
 }
 
 /**
- * @brief Save the current data store to the parameter file.
- * This function writes the current state of the data store to the
- * parameter file in a thread-safe manner. It is called automatically
- * by the data store thread when a modification event is detected.
+ * @brief Save the current data store to the parameter store.
+ * Each field is written under its own key; the key/value store skips fields
+ * whose value is unchanged, so only modified fields cost flash writes.
+ * Modified fields are also logged in the flight recorder.
+ * @return true if a field was written, false if the flash was up to date
  */
-void SaveDataToFile(void)
+bool SaveDataToStore(void)
 {
-    paramFile.NewFile(&paramFile);
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    paramFile.Write(&paramFile, &dataStore, sizeof(dataStore));
-    osMutexRelease(dataStoreMutex);
-    paramFile.UpdateFileDescription(&paramFile);
+    bool modified = false;
+    for (uint32_t i = 0; i < PERSISTED_FIELD_NUMBER; i++)
+    {
+        if (!persistedFields[i].persist) continue;
+        FlightRecordParameter_t record;
+        uint8_t value[KV_STORE_MAX_VALUE_SIZE], stored[KV_STORE_MAX_VALUE_SIZE];
+        osMutexAcquire(dataStoreMutex, osWaitForever);
+        memcpy(value, (uint8_t*)&dataStore + persistedFields[i].offset, persistedFields[i].size);
+        osMutexRelease(dataStoreMutex);
+        int32_t length = paramStore.Read(&paramStore, persistedFields[i].key, stored, sizeof(stored));
+        if (length == (int32_t)persistedFields[i].size && memcmp(stored, value, persistedFields[i].size) == 0)
+            continue;
+        paramStore.Write(&paramStore, persistedFields[i].key, value, persistedFields[i].size);
+        record.key = persistedFields[i].key;
+        record.size = persistedFields[i].size;
+        memcpy(record.value, value, record.size);
+        FlightRecorder_Log(FLIGHT_RECORD_PARAMETER, &record, offsetof(FlightRecordParameter_t, value) + record.size);
+        modified = true;
+    }
+    if (modified) FlightRecorder_Flush();
+    return modified;
 }
 
 /**
- * @brief Read the data store from the parameter file.
- * This function reads the data store from the parameter file in a
- * thread-safe manner. It verifies the integrity of the data using CRC32.
- * @return true if the data was read successfully and passed the CRC check,
- *         false otherwise.
+ * @brief Read the data store from the parameter store.
+ * Fields start from their defaults and are overwritten by every key found,
+ * so fields added by newer firmware keep a sane value. A log without schema
+ * version record was written by schema 1.
+ * @return true if the parameter store holds data, false if it is empty
  */
-bool ReadDataFromFile(void)
+bool ReadDataFromStore(void)
 {
-    paramFile.SetReadPos(&paramFile, 0);
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    
-    bool result = paramFile.Read(&paramFile, &dataStore, sizeof(dataStore));
-    if (!result)
+    if (paramStore.IsEmpty(&paramStore)) return false;
+    SetDefaultValues();
+    dataStore.schemaVersion = 1;
+    for (uint32_t i = 0; i < PERSISTED_FIELD_NUMBER; i++)
     {
+        if (!persistedFields[i].persist) continue;
+        uint8_t value[KV_STORE_MAX_VALUE_SIZE];
+        int32_t length = paramStore.Read(&paramStore, persistedFields[i].key, value, sizeof(value));
+        if (length != (int32_t)persistedFields[i].size) continue;
+        osMutexAcquire(dataStoreMutex, osWaitForever);
+        memcpy((uint8_t*)&dataStore + persistedFields[i].offset, value, persistedFields[i].size);
         osMutexRelease(dataStoreMutex);
-        return false;
     }
-
-    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, &dataStore, sizeof(dataStore));
-    osMutexRelease(dataStoreMutex);
-    uint32_t fileCrc = paramFile.ReadCRC(&paramFile);
-    paramFile.SetReadPos(&paramFile, 0);
-    return fileCrc == crc;
+    MigrateData();
+    return true;
 }
 
 /**
- * @brief Notify that the data store has been modified.
- * This function sets an event flag to indicate that the data store has been modified.
- * It can be called after any setter function to notify other threads of the change.
+ * @brief Read the data store from the legacy parameter file.
+ * This function reads the whole-struct image written by older firmware and
+ * verifies its integrity using CRC32 before taking its fields.
+ * @return true if the data was read successfully and passed the CRC check,
+ *         false otherwise.
  */
-void DataStore_SaveDataIfModified(void)
+bool ReadDataFromFile(void)
 {
-    osEventFlagsSet(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_MODIFIED);
-}
+    LegacyImage_t image;
+    SetDefaultValues(); // For the fields the image does not hold
+    paramFile.SetReadPos(&paramFile, 0);
+    bool result = paramFile.Read(&paramFile, &image, sizeof(image));
+    uint32_t fileCrc = paramFile.ReadCRC(&paramFile);
+    paramFile.SetReadPos(&paramFile, 0);
+    if (!result || fileCrc != Crc32(CRC32_INITIAL_VALUE, &image, sizeof(image))) return false;
 
-/**
- * @brief Get state feedback frequency.
- * This function retrieves the state feedback frequency from the data store.
- * @return float The state feedback frequency.
- */
-float DataStore_GetStateFeedbackFrequency(void)
-{
-    float freq;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    freq = dataStore.stateFeedbackFrequency;
+    dataStore.MotorParamPulsePerRevolution = image.motorParams.pulsePerRevolution;
+    dataStore.MotorParamMaxRpm = image.motorParams.maxRpm;
+    dataStore.MotorParamGearRatio = image.motorParams.gearRatio;
+    dataStore.LocalIpAddress = image.localUdpAddress.ipv4;
+    dataStore.LocalUdpPort = image.localUdpAddress.port;
+    dataStore.WheelRadius = image.wheelRadius;
+    dataStore.TrackWidth = image.trackWidth;
+    dataStore.StateFeedbackFrequency = image.stateFeedbackFrequency;
+    dataStore.OdometryFeedbackFrequency = image.odometryFeedbackFrequency;
+    dataStore.MaxLinearAcceleration = image.maxLinearAcceleration;
+    dataStore.MaxAngularAcceleration = image.maxAngularAcceleration;
+    dataStore.MaxVelocity = image.maxVelocity;
+    dataStore.MaxOmega = image.maxOmega;
+    dataStore.schemaVersion = 0;
     osMutexRelease(dataStoreMutex);
-    return freq;
+    MigrateData();
+    return true;
 }
 
 /**
- * @brief Set state feedback frequency.
- * This function updates the state feedback frequency in the data store.
- * @param frequency The new state feedback frequency.
+ * @brief Bring the data read from flash to the current schema.
+ * The whole-struct image and schema 1 had no default for the feedback
+ * frequencies, the gear ratio and the maximum rpm, they hold 0 there. Those,
+ * and any value out of its range, take their default. A motor or odometry
+ * record with a value out of its range, NaN included, takes its default as
+ * a whole: the motor control divides by the encoder resolution and feeds
+ * the gains to the PID. The version is kept if a newer firmware wrote the log.
  */
-void DataStore_SetStateFeedbackFrequency(float frequency)
+void MigrateData(void)
 {
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.stateFeedbackFrequency = frequency;
+#define DATA_STORE_VALIDATE(name, keyId, valueType, defaultValue, min, max, persist) \
+    if (!InRange##valueType(dataStore.name, min, max)) dataStore.name = (DATA_STORE_CTYPE_##valueType)(defaultValue);
+    DATA_STORE_PARAMETERS(DATA_STORE_VALIDATE)
+#undef DATA_STORE_VALIDATE
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!DataStore_IsMotorGainsValid(&dataStore.motorGains[i])) dataStore.motorGains[i] = defaultMotorGains;
+        if (!DataStore_IsMotorFilterValid(&dataStore.motorFilter[i])) dataStore.motorFilter[i] = defaultMotorFilter;
+        if (dataStore.encoderResolution[i] == 0) dataStore.encoderResolution[i] = DEFAULT_ENCODER_RESOLUTION;
+    }
+    if (!DataStore_IsOdometryNoiseValid(&dataStore.odometryNoise)) dataStore.odometryNoise = defaultOdometryNoise;
+    if (dataStore.schemaVersion < DATA_STORE_SCHEMA_VERSION) dataStore.schemaVersion = DATA_STORE_SCHEMA_VERSION;
     osMutexRelease(dataStoreMutex);
 }
 
 /**
- * @brief Set odometry feedback frequency.
- * This function updates the odometry feedback frequency in the data store.
- * @param frequency The new odometry feedback frequency.
+ * @brief Request the data store to be saved.
+ * This function marks the data store dirty and returns. The data store thread
+ * commits the changes later, together with the other requests of its
+ * debounce window, so it can be called after every setter.
  */
-void DataStore_SetOdometryFeedbackFrequency(float frequency)
+void DataStore_SaveDataIfModified(void)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.odometryFeedbackFrequency = frequency;
-    osMutexRelease(dataStoreMutex);
+    isSavePending = true;
+    saveRequestCount++;
+    osEventFlagsSet(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_MODIFIED);
 }
 
 /**
- * @brief Get odometry feedback frequency.
- * This function retrieves the odometry feedback frequency from the data store.
- * @return float The odometry feedback frequency.
+ * @brief Commit the data store to flash now.
+ * This function ends the debounce window and the minimum interval of a
+ * pending save and waits for the commit, call it before a reset. One flush
+ * at a time; not from the data store thread.
+ * @return true if committed within DATA_STORE_FLUSH_TIMEOUT ms, false otherwise
  */
-float DataStore_GetOdometryFeedbackFrequency(void)
+bool DataStore_Flush(void)
 {
-    float freq;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    freq = dataStore.odometryFeedbackFrequency;
-    osMutexRelease(dataStoreMutex);
-    return freq;
+    osEventFlagsClear(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_FLUSHED);
+    osEventFlagsSet(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_FLUSH);
+    uint32_t flags = osEventFlagsWait(dataStoreEventFlags, EVENT_FLAG_DATA_STORE_FLUSHED, osFlagsWaitAny, DATA_STORE_FLUSH_TIMEOUT);
+    return !(flags & osFlagsError);
 }
 
 /**
- * @brief Get pulses per revolution of the motor.
- * This function retrieves the motor's pulses per revolution from the data store.
-*/
-float DataStore_GetMotorParamPulsePerRevolution(void)
+ * @brief Get the statistics of the parameter persistence.
+ * @param stats Pointer to the statistics to fill
+ */
+void DataStore_GetPersistenceStats(DataStore_PersistenceStats_t* stats)
 {
-    float pulses;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    pulses = dataStore.motorParams.pulsePerRevolution;
-    osMutexRelease(dataStoreMutex);
-    return pulses;
+    if (stats == NULL) return;
+    stats->isPending = isSavePending;
+    stats->requestCount = saveRequestCount;
+    stats->commitCount = commitCount;
+    stats->recordCount = paramStore.recordCount;
+    stats->eraseCount = paramStore.eraseCount;
 }
 
 /**
- * @brief Get gear ratio of the motor.
- * This function retrieves the motor's gear ratio from the data store.
-*/
-float DataStore_GetMotorParamGearRatio(void)
+ * @brief Subscribe a thread to changes of fields.
+ * Every setter of a field in the mask sets the thread flags of the thread
+ * once the new value is stored, the thread reads it back in its own context.
+ * Several changes before the thread runs are seen once.
+ * @param keyMask DATA_STORE_KEY_MASK of every field to watch
+ * @param thread the thread to signal
+ * @param flags thread flags to set
+ * @return true if successful, false if the subscriptions are full
+ */
+bool DataStore_Subscribe(uint64_t keyMask, osThreadId_t thread, uint32_t flags)
 {
-    float ratio;
+    if (thread == NULL || flags == 0) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    ratio = dataStore.motorParams.gearRatio;
+    bool result = subscriberCount < DATA_STORE_MAX_SUBSCRIBERS;
+    if (result)
+    {
+        subscribers[subscriberCount].keyMask = keyMask;
+        subscribers[subscriberCount].thread = thread;
+        subscribers[subscriberCount].flags = flags;
+        subscriberCount++;  // Published last, the notifications do not lock
+    }
     osMutexRelease(dataStoreMutex);
-    return ratio;
+    return result;
 }
 
 /**
- * @brief Get the maximum RPM of the motor.
- * This function retrieves the motor's maximum revolutions per minute from the data store.
+ * @brief Signal the subscribers of a field
+ * Called by the setters after the mutex is released.
+ * @param key the field which was set
  */
-float DataStore_GetMotorParamMaxRpm(void)
+void NotifyChange(DataStoreKey_t key)
 {
-    float rpm;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    rpm = dataStore.motorParams.maxRpm;
-    osMutexRelease(dataStoreMutex);
-    return rpm;
+    uint32_t count = subscriberCount;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (subscribers[i].keyMask & DATA_STORE_KEY_MASK(key))
+            osThreadFlagsSet(subscribers[i].thread, subscribers[i].flags);
+    }
 }
 
 /**
- * @brief Set pulses per revolution of the motor.
- * This function updates the motor's pulses per revolution in the data store.
+ * @brief Getters and setters of the scalar parameters, see DATA_STORE_PARAMETERS.
  */
-void DataStore_SetMotorParamPulsePerRevolution(float pulses)
-{
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.motorParams.pulsePerRevolution = pulses;
-    osMutexRelease(dataStoreMutex);
+#define DATA_STORE_DEFINE(name, keyId, valueType, defaultValue, min, max, persist) \
+DATA_STORE_CTYPE_##valueType DataStore_Get##name(void) \
+{ \
+    osMutexAcquire(dataStoreMutex, osWaitForever); \
+    DATA_STORE_CTYPE_##valueType value = dataStore.name; \
+    osMutexRelease(dataStoreMutex); \
+    return value; \
+} \
+bool DataStore_Set##name(DATA_STORE_CTYPE_##valueType value) \
+{ \
+    if (!InRange##valueType(value, min, max)) return false; \
+    osMutexAcquire(dataStoreMutex, osWaitForever); \
+    dataStore.name = value; \
+    osMutexRelease(dataStoreMutex); \
+    NotifyChange(keyId); \
+    return true; \
 }
+DATA_STORE_PARAMETERS(DATA_STORE_DEFINE)
+#undef DATA_STORE_DEFINE
 
 /**
- * @brief Set gear ratio of the motor.
- * This function updates the motor's gear ratio in the data store.
+ * @brief Get a scalar parameter by its key.
+ * @param key Key of the parameter
+ * @param type Pointer to store the type of the parameter
+ * @param value Pointer to store the value
+ * @return true if the key is a scalar parameter, false otherwise
  */
-void DataStore_SetMotorParamGearRatio(float ratio)
+bool DataStore_GetParameter(DataStoreKey_t key, DataStore_Type_t* type, DataStore_Value_t* value)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.motorParams.gearRatio = ratio;
-    osMutexRelease(dataStoreMutex);
+    if (type == NULL || value == NULL) return false;
+    switch (key)
+    {
+#define DATA_STORE_GET_CASE(name, keyId, valueType, defaultValue, min, max, persist) \
+    case keyId: \
+        *type = DATA_STORE_TYPE_##valueType; \
+        value->valueType = DataStore_Get##name(); \
+        return true;
+    DATA_STORE_PARAMETERS(DATA_STORE_GET_CASE)
+#undef DATA_STORE_GET_CASE
+    default:
+        return false;
+    }
 }
 
 /**
- * @brief Set the maximum RPM of the motor.
- * This function updates the motor's maximum revolutions per minute in the data store.
+ * @brief Set a scalar parameter by its key.
+ * @param key Key of the parameter
+ * @param value New value, in the member of the type of the parameter
+ * @return true if stored, false if the key is not a scalar parameter or
+ *         the value is out of its range
  */
-void DataStore_SetMotorParamMaxRpm(float rpm)
+bool DataStore_SetParameter(DataStoreKey_t key, DataStore_Value_t value)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.motorParams.maxRpm = rpm;
-    osMutexRelease(dataStoreMutex);
+    switch (key)
+    {
+#define DATA_STORE_SET_CASE(name, keyId, valueType, defaultValue, min, max, persist) \
+    case keyId: \
+        return DataStore_Set##name(value.valueType);
+    DATA_STORE_PARAMETERS(DATA_STORE_SET_CASE)
+#undef DATA_STORE_SET_CASE
+    default:
+        return false;
+    }
 }
 
 /**
- * @brief Get the local UDP IP address.
- * This function retrieves the current local UDP IP address from the data store.
- * @param None
- * @return uint32_t The local UDP IP address.
+ * @brief Get the controller gains of a motor.
+ * @param motorId The ID of the motor
+ * @param gains Pointer to the gains to fill
+ * @return true if the motor exists, false otherwise
  */
-uint32_t DataStore_GetLocalIpAddress(void)
+bool DataStore_GetMotorGains(uint32_t motorId, DataStore_MotorGains_t* gains)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || gains == NULL) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    uint32_t ip = dataStore.localUdpAddress.ipv4;
+    *gains = dataStore.motorGains[motorId];
     osMutexRelease(dataStoreMutex);
-    return ip;
+    return true;
 }
 
 /**
- * @brief Get the local UDP port.
- * This function retrieves the current local UDP port from the data store.
- * @param None
- * @return uint16_t The local UDP port.
+ * @brief Set the controller gains of a motor.
+ * @param motorId The ID of the motor
+ * @param gains Pointer to the new gains
+ * @return true if stored, false if the motor does not exist or the gains are invalid
  */
-uint16_t DataStore_GetLocalUdpPort(void)
+bool DataStore_SetMotorGains(uint32_t motorId, const DataStore_MotorGains_t* gains)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || !DataStore_IsMotorGainsValid(gains)) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    uint16_t port = dataStore.localUdpAddress.port;
+    dataStore.motorGains[motorId] = *gains;
     osMutexRelease(dataStoreMutex);
-    return port;
+    NotifyChange(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_GAINS, motorId));
+    return true;
 }
 
 /**
- * @brief Set the local UDP IP address.
- * This function updates the local UDP IP address in the data store.
- * @param ip The new local UDP IP address.
+ * @brief Get the identified model of a motor.
+ * @param motorId The ID of the motor
+ * @param model Pointer to the model to fill
+ * @return true if the motor exists, false otherwise
  */
-void DataStore_SetLocalUdpAddress(uint32_t ip)
+bool DataStore_GetMotorModel(uint32_t motorId, DataStore_MotorModel_t* model)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || model == NULL) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.localUdpAddress.ipv4 = ip;
+    *model = dataStore.motorModel[motorId];
     osMutexRelease(dataStoreMutex);
+    return true;
 }
 
 /**
- * @brief Set the local UDP port.
- * This function updates the local UDP port in the data store.
- * @param port The new local UDP port.
+ * @brief Set the identified model of a motor.
+ * @param motorId The ID of the motor
+ * @param model Pointer to the new model
+ * @return true if the motor exists, false otherwise
  */
-void DataStore_SetLocalUdpPort(uint16_t port)
+bool DataStore_SetMotorModel(uint32_t motorId, const DataStore_MotorModel_t* model)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || model == NULL) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.localUdpAddress.port = port;
+    dataStore.motorModel[motorId] = *model;
     osMutexRelease(dataStoreMutex);
+    NotifyChange(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_MODEL, motorId));
+    return true;
 }
 
 /**
- * @brief Get the wheel diameter.
- * This function retrieves the current wheel diameter from the data store.
- * @param None
- * @return float The wheel diameter in meters.
+ * @brief Get the filter settings of a motor.
+ * @param motorId The ID of the motor
+ * @param filter Pointer to the settings to fill
+ * @return true if the motor exists, false otherwise
  */
-float DataStore_GetWheelRadius(void)
+bool DataStore_GetMotorFilter(uint32_t motorId, DataStore_MotorFilter_t* filter)
 {
-    float radius;
+    if (motorId >= TOTAL_MOTOR_NUMBER || filter == NULL) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    radius = dataStore.wheelRadius;
+    *filter = dataStore.motorFilter[motorId];
     osMutexRelease(dataStoreMutex);
-    return radius;
+    return true;
 }
 
 /**
- * @brief Set the wheel radius.
- * This function updates the wheel radius in the data store.
- * @param radius The new wheel radius in meters.
+ * @brief Set the filter settings of a motor.
+ * @param motorId The ID of the motor
+ * @param filter Pointer to the new settings
+ * @return true if stored, false if the motor does not exist or the settings are invalid
  */
-void DataStore_SetWheelRadius(float radius)
+bool DataStore_SetMotorFilter(uint32_t motorId, const DataStore_MotorFilter_t* filter)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || !DataStore_IsMotorFilterValid(filter)) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.wheelRadius = radius;
+    dataStore.motorFilter[motorId] = *filter;
     osMutexRelease(dataStoreMutex);
+    NotifyChange(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_FILTER, motorId));
+    return true;
 }
 
 /**
- * @brief Get the track width.
- * This function retrieves the current track width from the data store.
- * @param None
- * @return float The track width in meters.
+ * @brief Get the encoder resolution of a motor.
+ * @param motorId The ID of the motor
+ * @return Encoder edges per wheel revolution, both phases, 0 if the motor does not exist
  */
-float DataStore_GetTrackWidth(void)
+uint32_t DataStore_GetEncoderResolution(uint32_t motorId)
 {
-    float width;
+    if (motorId >= TOTAL_MOTOR_NUMBER) return 0;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    width = dataStore.trackWidth;
+    uint32_t resolution = dataStore.encoderResolution[motorId];
     osMutexRelease(dataStoreMutex);
-    return width;
+    return resolution;
 }
 
 /**
- * @brief Set the track width.
- * This function updates the wheel base in the data store.
- * @param base The new track width in meters.
+ * @brief Set the encoder resolution of a motor.
+ * @param motorId The ID of the motor
+ * @param resolution Encoder edges per wheel revolution, both phases
+ * @return true if stored, false if the motor does not exist or the resolution is 0
  */
-void DataStore_SetTrackWidth(float width)
+bool DataStore_SetEncoderResolution(uint32_t motorId, uint32_t resolution)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER || resolution == 0) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.trackWidth = width;
+    dataStore.encoderResolution[motorId] = resolution;
     osMutexRelease(dataStoreMutex);
+    NotifyChange(DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_ENCODER_RESOLUTION, motorId));
+    return true;
 }
 
 /**
- * @brief Get the maximum linear velocity (canonical).
- * This function retrieves the stored maximum velocity used across modules.
+ * @brief Get the noise model of the odometry.
+ * @param noise Pointer to the model to fill
+ * @return true if successful, false otherwise
  */
-float DataStore_GetMaxVelocity(void)
+bool DataStore_GetOdometryNoise(DataStore_OdometryNoise_t* noise)
 {
-    float velocity;
+    if (noise == NULL) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    velocity = dataStore.maxVelocity;
+    *noise = dataStore.odometryNoise;
     osMutexRelease(dataStoreMutex);
-    return velocity;
+    return true;
 }
 
 /**
- * @brief Set the maximum linear velocity (canonical).
- * This function stores the maximum velocity used across modules.
+ * @brief Set the noise model of the odometry.
+ * @param noise Pointer to the new model
+ * @return true if stored, false if the model is invalid
  */
-void DataStore_SetMaxVelocity(float velocity)
+bool DataStore_SetOdometryNoise(const DataStore_OdometryNoise_t* noise)
 {
+    if (!DataStore_IsOdometryNoiseValid(noise)) return false;
     osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.maxVelocity = velocity;
+    dataStore.odometryNoise = *noise;
     osMutexRelease(dataStoreMutex);
+    NotifyChange(DATA_STORE_KEY_ODOMETRY_NOISE);
+    return true;
 }
 
 /**
- * @brief Get the maximum angular velocity (canonical).
- * This function retrieves the stored maximum angular velocity used across modules.
+ * @brief Check the controller gains of a motor
+ * The PID gains must be positive or zero, every gain finite.
+ * @param gains Pointer to the gains
+ * @return true if the gains can be used, false otherwise
  */
-float DataStore_GetMaxOmega(void)
+bool DataStore_IsMotorGainsValid(const DataStore_MotorGains_t* gains)
 {
-    float omega;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    omega = dataStore.maxOmega;
-    osMutexRelease(dataStoreMutex);
-    return omega;
+    if (gains == NULL) return false;
+    // Written so that NaN fails every test
+    if (!(gains->kP >= 0.0f && gains->kI >= 0.0f && gains->kD >= 0.0f)) return false;
+    return isfinite(gains->kP + gains->kI + gains->kD + gains->ffKs + gains->ffKv + gains->ffKa);
 }
 
 /**
- * @brief Set the maximum angular velocity (canonical).
- * This function stores the maximum angular velocity used across modules.
+ * @brief Check the filter settings of a motor
+ * The derivative smoothing must be in (0, 1], the anti-windup gain in
+ * [0, 1] and the Kalman variances positive and finite.
+ * @param filter Pointer to the settings
+ * @return true if the settings can be used, false otherwise
  */
-void DataStore_SetMaxOmega(float omega)
+bool DataStore_IsMotorFilterValid(const DataStore_MotorFilter_t* filter)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.maxOmega = omega;
-    osMutexRelease(dataStoreMutex);
+    if (filter == NULL) return false;
+    if (!(filter->derivativeAlpha > 0.0f && filter->derivativeAlpha <= 1.0f)) return false;
+    if (!(filter->antiWindupGain >= 0.0f && filter->antiWindupGain <= 1.0f)) return false;
+    if (!(filter->measureVariance > 0.0f && filter->processVariance > 0.0f)) return false;
+    return isfinite(filter->measureVariance + filter->processVariance);
 }
 
 /**
- * @brief Get the maximum linear acceleration.
- * This function retrieves the current maximum linear acceleration from the data store.
- * @param None
- * @return float The maximum linear acceleration in meters per second squared.
+ * @brief Check the noise model of the odometry
+ * The variances must be positive or zero and finite.
+ * @param noise Pointer to the model
+ * @return true if the model can be used, false otherwise
  */
-float DataStore_GetMaxLinearAcceleration(void)
+bool DataStore_IsOdometryNoiseValid(const DataStore_OdometryNoise_t* noise)
 {
-    float acceleration;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    acceleration = dataStore.maxLinearAcceleration;
-    osMutexRelease(dataStoreMutex);
-    return acceleration;
+    if (noise == NULL) return false;
+    for (uint32_t i = 0; i < sizeof(noise->wheelSlip) / sizeof(noise->wheelSlip[0]); i++)
+    {
+        if (!(noise->wheelSlip[i] >= 0.0f && noise->speedVariance[i] >= 0.0f)) return false;
+        if (!isfinite(noise->wheelSlip[i] + noise->speedVariance[i])) return false;
+    }
+    return true;
 }
 
 /**
- * @brief Set the maximum linear acceleration.
- * This function updates the maximum linear acceleration in the data store.
- * @param acceleration The new maximum linear acceleration in meters per second squared.
+ * @brief Check a float parameter against its range, NaN is out of range
  */
-void DataStore_SetMaxLinearAcceleration(float acceleration)
+bool InRangeF32(float value, float min, float max)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.maxLinearAcceleration = acceleration;
-    osMutexRelease(dataStoreMutex);
+    return value >= min && value <= max;
 }
 
 /**
- * @brief Get the maximum angular acceleration.
- * This function retrieves the current maximum angular acceleration from the data store.
- * @param None
- * @return float The maximum angular acceleration in radians per second squared.
+ * @brief Check a uint32_t parameter against its range
  */
-float DataStore_GetMaxAngularAcceleration(void)
+bool InRangeU32(uint32_t value, uint32_t min, uint32_t max)
 {
-    float acceleration;
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    acceleration = dataStore.maxAngularAcceleration;
-    osMutexRelease(dataStoreMutex);
-    return acceleration;
+    return value >= min && value <= max;
 }
 
 /**
- * @brief Set the maximum angular acceleration.
- * This function updates the maximum angular acceleration in the data store.
- * @param acceleration The new maximum angular acceleration in radians per second squared.
+ * @brief Check a uint16_t parameter against its range
  */
-void DataStore_SetMaxAngularAcceleration(float acceleration)
+bool InRangeU16(uint16_t value, uint16_t min, uint16_t max)
 {
-    osMutexAcquire(dataStoreMutex, osWaitForever);
-    dataStore.maxAngularAcceleration = acceleration;
-    osMutexRelease(dataStoreMutex);
+    return value >= min && value <= max;
 }
@@ -11,6 +11,8 @@
  * 
  * @author Youmg.W <com.wang@hotmail.com>
  * @date 2025-08-20
+ *       Modified on 2026-10-17: the scalar parameters are declared once in
+ *       DATA_STORE_PARAMETERS, their getters and setters are generated.
  * @version 1.0
  */
 #pragma once
@@ -18,192 +20,338 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "cmsis_os2.h"
+
+#define DATA_STORE_MAX_SUBSCRIBERS  8   // Maximum number of change subscriptions
+
 /**
- * @brief Initialize the Data Store module.
- * This function sets up the data store with default values and initializes
- * the necessary resources for thread-safe access. It must be called before
- * any other data store functions are used.
+ * @brief Key ids of the persisted fields
+ * Ids are stored in flash, never renumber or reuse them. They also name the
+ * fields in change subscriptions, see DataStore_Subscribe.
  */
-void DataStore_Init(void);
+typedef enum {
+    DATA_STORE_KEY_PULSE_PER_REVOLUTION = 0,
+    DATA_STORE_KEY_MAX_RPM,
+    DATA_STORE_KEY_GEAR_RATIO,
+    DATA_STORE_KEY_LOCAL_IP,
+    DATA_STORE_KEY_LOCAL_PORT,
+    DATA_STORE_KEY_WHEEL_RADIUS,
+    DATA_STORE_KEY_TRACK_WIDTH,
+    DATA_STORE_KEY_STATE_FREQUENCY,
+    DATA_STORE_KEY_ODOMETRY_FREQUENCY,
+    DATA_STORE_KEY_MAX_LINEAR_ACCELERATION,
+    DATA_STORE_KEY_MAX_ANGULAR_ACCELERATION,
+    DATA_STORE_KEY_MAX_VELOCITY,
+    DATA_STORE_KEY_MAX_OMEGA,
+    DATA_STORE_KEY_MOTOR0_GAINS,
+    DATA_STORE_KEY_MOTOR1_GAINS,
+    DATA_STORE_KEY_MOTOR0_MODEL,
+    DATA_STORE_KEY_MOTOR1_MODEL,
+    DATA_STORE_KEY_MOTOR0_FILTER,
+    DATA_STORE_KEY_MOTOR1_FILTER,
+    DATA_STORE_KEY_MOTOR0_ENCODER_RESOLUTION,
+    DATA_STORE_KEY_MOTOR1_ENCODER_RESOLUTION,
+    DATA_STORE_KEY_ODOMETRY_NOISE,
+    DATA_STORE_KEY_WHEEL_BASE,
+    DATA_STORE_KEY_SCHEMA_VERSION,
+    DATA_STORE_KEY_NUMBER           // Not a key, append new keys above
+} DataStoreKey_t;
+
+#define DATA_STORE_KEY_MASK(key)    (1ULL << (key))     // Bit of a key in a subscription mask
 
 /**
- * @brief Notify that the data store has been modified.
- * This function sets an event flag to indicate that the data store has been modified.
- * It can be called after any setter function to notify other threads of the change.
+ * @brief Records kept for every motor
+ * Motors 0 and 1 keep their interleaved keys, DATA_STORE_KEY_MOTOR0_GAINS to
+ * DATA_STORE_KEY_MOTOR1_ENCODER_RESOLUTION. The motors from 2 on have a block
+ * of DATA_STORE_MOTOR_RECORD_NUMBER keys each, from DATA_STORE_KEY_MOTOR_BLOCKS,
+ * which leaves room for new keys below. DATA_STORE_MOTOR_KEY gives the key.
  */
-void DataStore_SaveDataIfModified(void);
+typedef enum {
+    DATA_STORE_MOTOR_GAINS = 0,
+    DATA_STORE_MOTOR_MODEL,
+    DATA_STORE_MOTOR_FILTER,
+    DATA_STORE_MOTOR_ENCODER_RESOLUTION,
+    DATA_STORE_MOTOR_RECORD_NUMBER  // Not a record
+} DataStore_MotorRecord_t;
+
+#define DATA_STORE_KEY_MOTOR_BLOCKS 48  // Key of the first record of motor 2
+#define DATA_STORE_MOTOR_KEY(record, motorId) ((DataStoreKey_t)((motorId) < 2 \
+    ? DATA_STORE_KEY_MOTOR0_GAINS + 2 * (record) + (motorId) \
+    : DATA_STORE_KEY_MOTOR_BLOCKS + DATA_STORE_MOTOR_RECORD_NUMBER * ((motorId) - 2) + (record)))
+
+/**
+ * @brief Types of the scalar parameters
+ * Also the type ids of the parameters in the ROS parameter messages.
+ */
+typedef enum {
+    DATA_STORE_TYPE_F32 = 0,
+    DATA_STORE_TYPE_U32 = 1,
+    DATA_STORE_TYPE_U16 = 2,
+} DataStore_Type_t;
+
+#define DATA_STORE_CTYPE_F32    float
+#define DATA_STORE_CTYPE_U32    uint32_t
+#define DATA_STORE_CTYPE_U16    uint16_t
+
+/**
+ * @brief Value of a scalar parameter, the member is named by its type
+ */
+typedef union {
+    float F32;
+    uint32_t U32;
+    uint16_t U16;
+} DataStore_Value_t;
+
+#define DATA_STORE_PERSIST      true    // The parameter is saved in flash
+#define DATA_STORE_VOLATILE     false   // The parameter starts from its default at every boot
 
 /**
- * @brief Get pulses per revolution of the motor.
- * This function retrieves the motor's pulses per revolution from the data store.
-*/
-float DataStore_GetMotorParamPulsePerRevolution(void);
+ * @brief Registry of the scalar parameters
+ * X(name, key, type, default, min, max, persist)
+ *  - DataStore_Get<name>(void) returns the value.
+ *  - DataStore_Set<name>(value) stores it and signals the subscribers of the
+ *    key; it returns false and keeps the value if it is out of [min, max].
+ *  - Values loaded from flash out of [min, max] are replaced by the default.
+ * Defaults are declared in system_config.h.
+ */
+#define DATA_STORE_PARAMETERS(X) \
+    X(MotorParamPulsePerRevolution, DATA_STORE_KEY_PULSE_PER_REVOLUTION, F32, DEFAULT_PULSE_PER_REVOL, 1.0f, 1e6f, DATA_STORE_PERSIST) \
+    X(MotorParamMaxRpm, DATA_STORE_KEY_MAX_RPM, F32, DEFAULT_MAX_RPM, 1.0f, 1e5f, DATA_STORE_PERSIST) \
+    X(MotorParamGearRatio, DATA_STORE_KEY_GEAR_RATIO, F32, DEFAULT_GEAR_RATIO, 0.01f, 1000.0f, DATA_STORE_PERSIST) \
+    X(LocalIpAddress, DATA_STORE_KEY_LOCAL_IP, U32, DEFAULT_LOCAL_UDP_ADDRESS, 0U, UINT32_MAX, DATA_STORE_PERSIST) \
+    X(LocalUdpPort, DATA_STORE_KEY_LOCAL_PORT, U16, DEFAULT_LOCAL_UDP_PORT, 1U, UINT16_MAX, DATA_STORE_PERSIST) \
+    X(WheelRadius, DATA_STORE_KEY_WHEEL_RADIUS, F32, DEFAULT_WHEEL_RADIUS, 0.005f, 1.0f, DATA_STORE_PERSIST) \
+    X(TrackWidth, DATA_STORE_KEY_TRACK_WIDTH, F32, DEFAULT_TRACK_WIDTH, 0.01f, 5.0f, DATA_STORE_PERSIST) \
+    X(WheelBase, DATA_STORE_KEY_WHEEL_BASE, F32, DEFAULT_WHEEL_BASE, 0.0f, 5.0f, DATA_STORE_PERSIST) \
+    X(StateFeedbackFrequency, DATA_STORE_KEY_STATE_FREQUENCY, F32, DEFAULT_STATE_FREQUENCY, 0.1f, 200.0f, DATA_STORE_PERSIST) \
+    X(OdometryFeedbackFrequency, DATA_STORE_KEY_ODOMETRY_FREQUENCY, F32, DEFAULT_ODOMETRY_FREQUENCY, 0.1f, 200.0f, DATA_STORE_PERSIST) \
+    X(MaxLinearAcceleration, DATA_STORE_KEY_MAX_LINEAR_ACCELERATION, F32, DEFAULT_MAX_LINEAR_ACCEL, 0.0f, 20.0f, DATA_STORE_PERSIST) \
+    X(MaxAngularAcceleration, DATA_STORE_KEY_MAX_ANGULAR_ACCELERATION, F32, DEFAULT_MAX_ANGULAR_ACCEL, 0.0f, 100.0f, DATA_STORE_PERSIST) \
+    X(MaxVelocity, DATA_STORE_KEY_MAX_VELOCITY, F32, DEFAULT_MAX_VELOCITY, 0.0f, 10.0f, DATA_STORE_PERSIST) \
+    X(MaxOmega, DATA_STORE_KEY_MAX_OMEGA, F32, DEFAULT_MAX_OMEGA, 0.0f, 50.0f, DATA_STORE_PERSIST)
 
 /**
- * @brief Get gear ratio of the motor.
- * This function retrieves the motor's gear ratio from the data store.
-*/
-float DataStore_GetMotorParamGearRatio(void);
+ * @brief Controller gains of one wheel motor
+ */
+typedef struct {
+    float kP;       // Proportional gain in duty per rad/s
+    float kI;       // Integral gain per control period
+    float kD;       // Derivative gain
+    float ffKs;     // Feed-forward of the static friction in duty
+    float ffKv;     // Feed-forward of the speed in duty per rad/s
+    float ffKa;     // Feed-forward of the acceleration in duty per rad/s^2
+} DataStore_MotorGains_t;
 
 /**
- * @brief Get the maximum RPM of the motor.
- * This function retrieves the motor's maximum revolutions per minute from the data store.
+ * @brief Filter settings of one wheel motor
  */
-float DataStore_GetMotorParamMaxRpm(void);
+typedef struct {
+    float derivativeAlpha;  // Smoothing of the PID derivative, 1 for no filter
+    float antiWindupGain;   // Back-calculation gain of the PID integral per control period, 0 to 1
+    float measureVariance;  // Kalman variance of the speed measured by the encoder
+    float processVariance;  // Kalman variance of the speed change per control period
+} DataStore_MotorFilter_t;
 
 /**
- * @brief Set pulses per revolution of the motor.
- * This function updates the motor's pulses per revolution in the data store.
+ * @brief Identified model of one wheel motor, first order plus dead time
  */
-void DataStore_SetMotorParamPulsePerRevolution(float pulses);
+typedef struct {
+    float gain;         // Steady-state speed per duty in rad/s, 0 if never identified
+    float timeConstant; // Time constant in seconds
+    float deadTime;     // Dead time in seconds
+    float friction;     // Duty lost to the static friction
+} DataStore_MotorModel_t;
 
 /**
- * @brief Set gear ratio of the motor.
- * This function updates the motor's gear ratio in the data store.
+ * @brief Noise model of the odometry, index 0 is the left wheel, 1 the right wheel
  */
-void DataStore_SetMotorParamGearRatio(float ratio);
+typedef struct {
+    float wheelSlip[2];     // Variance of the wheel travel per meter travelled, in m^2/m
+    float speedVariance[2]; // Variance of a measured wheel speed, in (m/s)^2
+} DataStore_OdometryNoise_t;
 
 /**
- * @brief Set the maximum RPM of the motor.
- * This function updates the motor's maximum revolutions per minute in the data store.
+ * @brief Statistics of the parameter persistence, counted since boot
  */
-void DataStore_SetMotorParamMaxRpm(float rpm);
+typedef struct {
+    bool isPending;         // A save is requested and not yet committed
+    uint32_t requestCount;  // Save requests
+    uint32_t commitCount;   // Commits which wrote to flash
+    uint32_t recordCount;   // Records appended to the key/value log
+    uint32_t eraseCount;    // Sectors of the key/value log erased
+} DataStore_PersistenceStats_t;
 
 /**
- * @brief Get the local UDP IP address.
- * This function retrieves the local UDP IP address from the data store.
- * @return uint32_t The local UDP IP address in IPv4 format.
+ * @brief Initialize the Data Store module.
+ * This function sets up the data store with default values and initializes
+ * the necessary resources for thread-safe access. It must be called before
+ * any other data store functions are used.
  */
-uint32_t DataStore_GetLocalIpAddress(void);
+void DataStore_Init(void);
 
 /**
- * @brief Set the local UDP IP address.
- * This function updates the local UDP IP address in the data store.
- * @param ip The new local UDP IP address in IPv4 format.
+ * @brief Request the data store to be saved.
+ * This function marks the data store dirty and returns. The data store thread
+ * commits the changes later, together with the other requests of its
+ * debounce window, so it can be called after every setter.
  */
-void DataStore_SetLocalUdpAddress(uint32_t ip);
+void DataStore_SaveDataIfModified(void);
 
 /**
- * @brief Get the local UDP port.
- * This function retrieves the local UDP port from the data store.
- * @return uint16_t The local UDP port.
+ * @brief Commit the data store to flash now.
+ * This function ends the debounce window and the minimum interval of a
+ * pending save and waits for the commit, call it before a reset. One flush
+ * at a time; not from the data store thread.
+ * @return true if committed within DATA_STORE_FLUSH_TIMEOUT ms, false otherwise
  */
-uint16_t DataStore_GetLocalUdpPort(void);
+bool DataStore_Flush(void);
 
 /**
- * @brief Set the local UDP port.
- * This function updates the local UDP port in the data store.
- * @param port The new local UDP port.
+ * @brief Get the statistics of the parameter persistence.
+ * @param stats Pointer to the statistics to fill
  */
-void DataStore_SetLocalUdpPort(uint16_t port);
+void DataStore_GetPersistenceStats(DataStore_PersistenceStats_t* stats);
+
+/**
+ * @brief Subscribe a thread to changes of fields.
+ * Every setter of a field in the mask sets the thread flags of the thread
+ * once the new value is stored, the thread reads it back in its own context.
+ * Several changes before the thread runs are seen once.
+ * @param keyMask DATA_STORE_KEY_MASK of every field to watch
+ * @param thread the thread to signal
+ * @param flags thread flags to set
+ * @return true if successful, false if the subscriptions are full
+ */
+bool DataStore_Subscribe(uint64_t keyMask, osThreadId_t thread, uint32_t flags);
+
+#define DATA_STORE_COUNT_PARAMETER(name, keyId, valueType, defaultValue, min, max, persist) + 1
+#define DATA_STORE_PARAMETER_NUMBER (0 DATA_STORE_PARAMETERS(DATA_STORE_COUNT_PARAMETER))  // Number of scalar parameters
 
 /**
- * @brief Set the number of wheels.
- * This function updates the number of wheels in the data store.
- * @param number The new number of wheels.
+ * @brief Getters and setters of the scalar parameters, see DATA_STORE_PARAMETERS.
  */
-float DataStore_GetWheelRadius(void);
+#define DATA_STORE_DECLARE(name, key, type, defaultValue, min, max, persist) \
+    DATA_STORE_CTYPE_##type DataStore_Get##name(void); \
+    bool DataStore_Set##name(DATA_STORE_CTYPE_##type value);
+DATA_STORE_PARAMETERS(DATA_STORE_DECLARE)
+#undef DATA_STORE_DECLARE
 
 /**
- * @brief Set the wheel radius.
- * This function updates the wheel radius in the data store.
- * @param radius The new wheel radius in meters.
+ * @brief Get a scalar parameter by its key.
+ * @param key Key of the parameter
+ * @param type Pointer to store the type of the parameter
+ * @param value Pointer to store the value
+ * @return true if the key is a scalar parameter, false otherwise
  */
-void DataStore_SetWheelRadius(float radius);
+bool DataStore_GetParameter(DataStoreKey_t key, DataStore_Type_t* type, DataStore_Value_t* value);
 
 /**
- * @brief Get the track width.
- * This function retrieves the current track width from the data store.
- * @param None
- * @return float The track width in meters.
+ * @brief Set a scalar parameter by its key.
+ * @param key Key of the parameter
+ * @param value New value, in the member of the type of the parameter
+ * @return true if stored, false if the key is not a scalar parameter or
+ *         the value is out of its range
  */
-float DataStore_GetTrackWidth(void);
+bool DataStore_SetParameter(DataStoreKey_t key, DataStore_Value_t value);
 
 /**
- * @brief Set the track width.
- * This function updates the wheel base in the data store.
- * @param base The new track width in meters.
+ * @brief Get the controller gains of a motor.
+ * @param motorId The ID of the motor
+ * @param gains Pointer to the gains to fill
+ * @return true if the motor exists, false otherwise
  */
-void DataStore_SetTrackWidth(float width);
+bool DataStore_GetMotorGains(uint32_t motorId, DataStore_MotorGains_t* gains);
 
 /**
- * @brief Get the maximum linear velocity (canonical).
- * This function retrieves the stored maximum velocity used across modules.
+ * @brief Set the controller gains of a motor.
+ * @param motorId The ID of the motor
+ * @param gains Pointer to the new gains
+ * @return true if stored, false if the motor does not exist or the gains are invalid
  */
-float DataStore_GetMaxVelocity(void);
+bool DataStore_SetMotorGains(uint32_t motorId, const DataStore_MotorGains_t* gains);
 
 /**
- * @brief Set the maximum linear velocity (canonical).
- * This function stores the maximum velocity used across modules.
+ * @brief Get the identified model of a motor.
+ * @param motorId The ID of the motor
+ * @param model Pointer to the model to fill
+ * @return true if the motor exists, false otherwise
  */
-void DataStore_SetMaxVelocity(float velocity);
+bool DataStore_GetMotorModel(uint32_t motorId, DataStore_MotorModel_t* model);
 
 /**
- * @brief Get the maximum angular velocity (canonical).
- * This function retrieves the stored maximum angular velocity used across modules.
+ * @brief Set the identified model of a motor.
+ * @param motorId The ID of the motor
+ * @param model Pointer to the new model
+ * @return true if the motor exists, false otherwise
  */
-float DataStore_GetMaxOmega(void);
+bool DataStore_SetMotorModel(uint32_t motorId, const DataStore_MotorModel_t* model);
 
 /**
- * @brief Set the maximum angular velocity (canonical).
- * This function stores the maximum angular velocity used across modules.
+ * @brief Get the filter settings of a motor.
+ * @param motorId The ID of the motor
+ * @param filter Pointer to the settings to fill
+ * @return true if the motor exists, false otherwise
  */
-void DataStore_SetMaxOmega(float omega);
+bool DataStore_GetMotorFilter(uint32_t motorId, DataStore_MotorFilter_t* filter);
 
 /**
- * @brief Get the maximum linear acceleration.
- * This function retrieves the current maximum linear acceleration from the data store.
- * @param None
- * @return float The maximum linear acceleration in meters per second squared.
+ * @brief Set the filter settings of a motor.
+ * @param motorId The ID of the motor
+ * @param filter Pointer to the new settings
+ * @return true if stored, false if the motor does not exist or the settings are invalid
  */
-float DataStore_GetMaxLinearAcceleration(void);
+bool DataStore_SetMotorFilter(uint32_t motorId, const DataStore_MotorFilter_t* filter);
 
 /**
- * @brief Set the maximum linear acceleration.
- * This function updates the maximum linear acceleration in the data store.
- * @param acceleration The new maximum linear acceleration in meters per second squared.
+ * @brief Get the encoder resolution of a motor.
+ * @param motorId The ID of the motor
+ * @return Encoder edges per wheel revolution, both phases, 0 if the motor does not exist
  */
-void DataStore_SetMaxLinearAcceleration(float acceleration);
+uint32_t DataStore_GetEncoderResolution(uint32_t motorId);
 
 /**
- * @brief Get the maximum angular acceleration.
- * This function retrieves the current maximum angular acceleration from the data store.
- * @param None
- * @return float The maximum angular acceleration in radians per second squared.
+ * @brief Set the encoder resolution of a motor.
+ * @param motorId The ID of the motor
+ * @param resolution Encoder edges per wheel revolution, both phases
+ * @return true if stored, false if the motor does not exist or the resolution is 0
  */
-float DataStore_GetMaxAngularAcceleration(void);
+bool DataStore_SetEncoderResolution(uint32_t motorId, uint32_t resolution);
 
 /**
- * @brief Set the maximum angular acceleration.
- * This function updates the maximum angular acceleration in the data store.
- * @param acceleration The new maximum angular acceleration in radians per second squared.
+ * @brief Get the noise model of the odometry.
+ * @param noise Pointer to the model to fill
+ * @return true if successful, false otherwise
  */
-void DataStore_SetMaxAngularAcceleration(float acceleration);
+bool DataStore_GetOdometryNoise(DataStore_OdometryNoise_t* noise);
 
 /**
- * @brief Get state feedback frequency.
- * This function retrieves the state feedback frequency from the data store.
- * @return float The state feedback frequency.
+ * @brief Set the noise model of the odometry.
+ * @param noise Pointer to the new model
+ * @return true if stored, false if the model is invalid
  */
-float DataStore_GetStateFeedbackFrequency(void);
+bool DataStore_SetOdometryNoise(const DataStore_OdometryNoise_t* noise);
 
 /**
- * @brief Set state feedback frequency.
- * This function updates the state feedback frequency in the data store.
- * @param frequency The new state feedback frequency.
+ * @brief Check the controller gains of a motor
+ * The PID gains must be positive or zero, every gain finite.
+ * @param gains Pointer to the gains
+ * @return true if the gains can be used, false otherwise
  */
-void DataStore_SetStateFeedbackFrequency(float frequency);
+bool DataStore_IsMotorGainsValid(const DataStore_MotorGains_t* gains);
 
 /**
- * @brief Set odometry feedback frequency.
- * This function updates the odometry feedback frequency in the data store.
- * @param frequency The new odometry feedback frequency.
+ * @brief Check the filter settings of a motor
+ * The derivative smoothing must be in (0, 1], the anti-windup gain in
+ * [0, 1] and the Kalman variances positive and finite.
+ * @param filter Pointer to the settings
+ * @return true if the settings can be used, false otherwise
  */
-void DataStore_SetOdometryFeedbackFrequency(float frequency);
+bool DataStore_IsMotorFilterValid(const DataStore_MotorFilter_t* filter);
 
 /**
- * @brief Get odometry feedback frequency.
- * This function retrieves the odometry feedback frequency from the data store.
- * @return float The odometry feedback frequency.
+ * @brief Check the noise model of the odometry
+ * The variances must be positive or zero and finite.
+ * @param noise Pointer to the model
+ * @return true if the model can be used, false otherwise
  */
-float DataStore_GetOdometryFeedbackFrequency(void);
+bool DataStore_IsOdometryNoiseValid(const DataStore_OdometryNoise_t* noise);
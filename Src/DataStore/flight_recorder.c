@@ -0,0 +1,426 @@
+/**
+ * @file flight_recorder.c
+ * @brief Binary flight recorder backed by external SPI flash.
+ *
+ * @details Keeps a post-mortem history of the chassis in the EXT_FLASH_LOG_FILE
+ * region. Producers (control threads, timer callbacks, interrupts) copy
+ * compact records into a bounded multi-producer ring in RAM without taking any
+ * lock. A low priority thread drains the ring into a page buffer and programs
+ * only whole 256 byte pages, so flash is never rewritten in place. A partial
+ * page is programmed early, padded with 0xFF, when a rare event asks for it.
+ *
+ * Responsibilities:
+ *  - Stage records from any context in a lock-free ring.
+ *  - Pack records into CRC-protected pages and program them sequentially,
+ *    erasing the next sector as soon as the current one is full.
+ *  - Recover the write position and sequence number at boot.
+ *  - Give page based read access, oldest page first, for the dump service.
+ *
+ * Flash memory layout overview:
+ * @verbatim
+ *  Region (EXT_FLASH_LOG_FILE_ADDRESS, EXT_FLASH_LOG_FILE_SIZE), circular
+ *
+ *  ┌──────────┬──────────┬─────┬───────────────────┬──────────┬─────┐
+ *  │ sector 0 │ sector 1 │ ... │ sector k          │ k+1      │ ... │
+ *  │ (older)  │          │     │ pages │ erased    │ (oldest) │     │
+ *  └──────────┴──────────┴─────┴───────────────────┴──────────┴─────┘
+ *                                      ▲ writePage
+ * @endverbatim
+ *
+ *  The sector holding writePage is always erased from writePage on, so after
+ *  the log wraps the oldest page is the first page of the next sector. At boot
+ *  the page with the highest sequence number is located and writing resumes
+ *  after the last programmed page of its sector; a page torn by a power loss
+ *  fails its CRC and is skipped by readers.
+ *
+ * @note Staging ring: every slot carries a sequence number. A producer claims
+ * a slot by a compare-and-swap on the head index, fills it and then publishes
+ * it by setting the slot sequence; the single consumer only reads published
+ * slots in order. A full ring drops the record and counts it.
+ *
+ * @dependencies flight_recorder.h, w25qxx.h, crc32.h, system_config.h, cmsis_os2
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "flight_recorder.h"
+
+#include "main.h"
+#include "cmsis_os2.h"
+#include "crc32.h"
+#include "w25qxx.h"
+#include "system_config.h"
+#include "rtx_os.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define STAGING_RING_SIZE       64      // Number of staged records, power of 2
+#define FLUSH_PERIOD            200     // ms, period to drain the staging ring
+#define FLAG_FLUSH              0x01    // Thread flag to write a partial page now
+#define FLAG_DRAIN              0x02    // Thread flag to drain the staging ring
+#define PAGES_PER_SECTOR        (EXT_FLASH_SECTOR_SIZE / FLIGHT_RECORDER_PAGE_SIZE)
+#define TOTAL_PAGES             (EXT_FLASH_LOG_FILE_SIZE / FLIGHT_RECORDER_PAGE_SIZE)
+
+typedef struct {
+    uint32_t sequence;      // Page sequence number, increases by one per page
+    uint16_t length;        // Bytes of records following the header
+    uint16_t dropped;       // Records dropped since the previous page
+    uint32_t crc;           // CRC32 of the header fields above and the records
+} PageHeader_t;
+#define PAGE_PAYLOAD_SIZE   (FLIGHT_RECORDER_PAGE_SIZE - sizeof(PageHeader_t))
+
+typedef struct {
+    uint32_t timestamp;     // Kernel tick in ms
+    uint8_t type;           // FlightRecordType_t
+    uint8_t size;           // Payload size in bytes
+    uint16_t reserved;
+} RecordHeader_t;
+
+typedef struct {
+    volatile uint32_t sequence; // Slot sequence, equals the ticket + 1 once published
+    RecordHeader_t header;
+    uint8_t payload[FLIGHT_RECORDER_MAX_PAYLOAD];
+} StagingSlot_t;
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static W25QXX_t *w25qxx = NULL;     // W25QXX flash instance
+static osThreadId_t threadId;
+static uint64_t threadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t threadControlBlock;
+static const osThreadAttr_t threadAttr = {
+    .name = "ThreadFlightRecorder",
+    .cb_mem = &threadControlBlock,
+    .cb_size = sizeof(threadControlBlock),
+    .stack_mem = threadStack,
+    .stack_size = sizeof(threadStack),
+    .priority = THREAD_PRIORITY_LOGGING,
+};
+
+static StagingSlot_t stagingRing[STAGING_RING_SIZE];
+static volatile uint32_t stagingHead;   // Next ticket handed to a producer
+static uint32_t stagingTail;            // Next ticket read by the consumer
+static volatile uint32_t droppedCount;  // Records dropped because the ring was full
+static volatile bool isInitialized;
+
+static uint8_t pageBuffer[FLIGHT_RECORDER_PAGE_SIZE];
+static uint32_t pageLength;             // Bytes of records in pageBuffer
+static uint32_t pageDropped;            // Dropped count already reported in flash
+static uint32_t pageSequence;           // Sequence of the next page
+static volatile uint32_t writePage;     // Index of the next page to program
+static volatile bool isWrapped;         // True once the log has been filled once
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static void FlightRecorderThread(void *arg);
+static void FlushTimerCallback(void *arg);
+static bool CompareAndSwap(volatile uint32_t *address, uint32_t expected, uint32_t desired);
+static void Drain(void);
+static void ProgramPage(void);
+static void RecoverWritePosition(void);
+static bool ReadPageHeader(uint32_t page, PageHeader_t *header);
+
+static inline uint32_t PageAddress(uint32_t page)
+{
+    return EXT_FLASH_LOG_FILE_ADDRESS + page * FLIGHT_RECORDER_PAGE_SIZE;
+}
+
+/**
+ * @brief Initialize the flight recorder
+ * This function recovers the write position from flash, starts the flush
+ * thread and logs a boot record. Records logged before are dropped.
+ */
+void FlightRecorder_Init(void)
+{
+    w25qxx = W25QXX_Init(EXT_FLASH_W25Q128);
+    assert_param(w25qxx != NULL);
+    for (uint32_t i = 0; i < STAGING_RING_SIZE; i++)
+        stagingRing[i].sequence = i;
+    stagingHead = 0;
+    stagingTail = 0;
+    RecoverWritePosition();
+
+    threadId = osThreadNew(FlightRecorderThread, NULL, &threadAttr);
+    assert_param(threadId != NULL);
+    osTimerId_t flushTimer = osTimerNew(FlushTimerCallback, osTimerPeriodic, NULL, NULL);
+    assert_param(flushTimer != NULL);
+    osTimerStart(flushTimer, FLUSH_PERIOD);
+    isInitialized = true;
+
+    FlightRecordBoot_t boot = { .resetFlags = RCC->CSR };
+    __HAL_RCC_CLEAR_RESET_FLAGS();  // Next boot reports its own reset cause only
+    FlightRecorder_Log(FLIGHT_RECORD_BOOT, &boot, sizeof(boot));
+    FlightRecorder_Flush();
+}
+
+/**
+ * @brief Log a record
+ * The record is copied into the staging ring without locking, so this can be
+ * called from any thread or interrupt. It is dropped if the ring is full.
+ * @param type type of the record
+ * @param payload pointer to the payload
+ * @param size size of the payload in bytes, at most FLIGHT_RECORDER_MAX_PAYLOAD
+ * @return true if the record is staged, false otherwise
+ */
+bool FlightRecorder_Log(FlightRecordType_t type, const void *payload, uint32_t size)
+{
+    if (!isInitialized || size > FLIGHT_RECORDER_MAX_PAYLOAD || (payload == NULL && size > 0)) return false;
+
+    // Claim a slot: it is free when its sequence equals the ticket
+    uint32_t ticket;
+    StagingSlot_t *slot;
+    for (;;)
+    {
+        ticket = stagingHead;
+        slot = &stagingRing[ticket & (STAGING_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(slot->sequence - ticket);
+        if (diff == 0)
+        {
+            if (CompareAndSwap(&stagingHead, ticket, ticket + 1)) break;
+        }
+        else if (diff < 0)
+        {
+            // Ring full, the consumer has not released this slot yet
+            uint32_t dropped;
+            do {
+                dropped = droppedCount;
+            } while (!CompareAndSwap(&droppedCount, dropped, dropped + 1));
+            return false;
+        }
+        // Otherwise another producer took the ticket, retry with the new head
+    }
+
+    slot->header.timestamp = osKernelGetTickCount();
+    slot->header.type = (uint8_t)type;
+    slot->header.size = (uint8_t)size;
+    slot->header.reserved = 0;
+    if (size > 0) memcpy(slot->payload, payload, size);
+    __DMB();    // Make the record visible before publishing it
+    slot->sequence = ticket + 1;
+    return true;
+}
+
+/**
+ * @brief Request the staged records to be written to flash now
+ * Used after rare events so they survive a power loss shortly after.
+ */
+void FlightRecorder_Flush(void)
+{
+    if (!isInitialized) return;
+    osThreadFlagsSet(threadId, FLAG_FLUSH);
+}
+
+/**
+ * @brief Get the number of pages held by the log
+ * @return number of pages, page 0 being the oldest
+ */
+uint32_t FlightRecorder_GetPageCount(void)
+{
+    uint32_t page = writePage;
+    if (!isWrapped) return page;
+    uint32_t oldest = (page / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR % TOTAL_PAGES;
+    return (page + TOTAL_PAGES - oldest) % TOTAL_PAGES;
+}
+
+/**
+ * @brief Read pages of the log
+ * Pages are returned as stored, readers check each page CRC themselves since
+ * the oldest sector may be erased while it is being read.
+ * @param page index of the first page, 0 is the oldest page
+ * @param buffer pointer to the buffer, count * FLIGHT_RECORDER_PAGE_SIZE bytes
+ * @param count number of pages to read
+ * @return number of pages read
+ */
+uint32_t FlightRecorder_ReadPages(uint32_t page, uint8_t *buffer, uint32_t count)
+{
+    if (buffer == NULL || w25qxx == NULL) return 0;
+    uint32_t total = FlightRecorder_GetPageCount();
+    if (page >= total) return 0;
+    if (count > total - page) count = total - page;
+    uint32_t oldest = isWrapped ? (writePage / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR % TOTAL_PAGES : 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t physical = (oldest + page + i) % TOTAL_PAGES;
+        w25qxx->Read(buffer + i * FLIGHT_RECORDER_PAGE_SIZE, PageAddress(physical), FLIGHT_RECORDER_PAGE_SIZE);
+    }
+    return count;
+}
+
+/**
+ * @brief Flight recorder thread
+ * This thread drains the staging ring periodically and programs a partial
+ * page when a flush is requested.
+ * @param arg pointer to argument (not used)
+ */
+void FlightRecorderThread(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        uint32_t flags = osThreadFlagsWait(FLAG_FLUSH | FLAG_DRAIN, osFlagsWaitAny, osWaitForever);
+        if (flags & osFlagsError) continue;
+        Drain();
+        if ((flags & FLAG_FLUSH) && pageLength > 0) ProgramPage();
+    }
+}
+
+/**
+ * @brief Timer callback to drain the staging ring.
+ * @param arg unused
+ */
+void FlushTimerCallback(void *arg)
+{
+    (void)arg;
+    osThreadFlagsSet(threadId, FLAG_DRAIN);
+}
+
+/**
+ * @brief Atomically replace a word if it holds the expected value
+ * @param address pointer to the word
+ * @param expected value the word must hold
+ * @param desired new value of the word
+ * @return true if the word was replaced, false otherwise
+ */
+bool CompareAndSwap(volatile uint32_t *address, uint32_t expected, uint32_t desired)
+{
+    do {
+        if (__LDREXW(address) != expected)
+        {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(desired, address) != 0);
+    return true;
+}
+
+/**
+ * @brief Move the published records from the staging ring into the page buffer
+ * A page is programmed each time the next record does not fit anymore.
+ */
+void Drain(void)
+{
+    for (;;)
+    {
+        StagingSlot_t *slot = &stagingRing[stagingTail & (STAGING_RING_SIZE - 1)];
+        if (slot->sequence != stagingTail + 1) break;  // Not published yet
+        __DMB();    // Read the record only after its sequence
+
+        uint32_t size = sizeof(RecordHeader_t) + slot->header.size;
+        if (pageLength + size > PAGE_PAYLOAD_SIZE) ProgramPage();
+        uint8_t *dst = pageBuffer + sizeof(PageHeader_t) + pageLength;
+        memcpy(dst, &slot->header, sizeof(RecordHeader_t));
+        memcpy(dst + sizeof(RecordHeader_t), slot->payload, slot->header.size);
+        pageLength += size;
+
+        __DMB();    // Finish reading before releasing the slot
+        slot->sequence = stagingTail + STAGING_RING_SIZE;
+        stagingTail++;
+    }
+}
+
+/**
+ * @brief Program the page buffer into the next flash page
+ * The rest of the page is padded with 0xFF. The next sector is erased as soon
+ * as the current one is full, so the write sector is always erased ahead.
+ */
+void ProgramPage(void)
+{
+    PageHeader_t header;
+    uint32_t dropped = droppedCount;
+    header.sequence = pageSequence++;
+    header.length = (uint16_t)pageLength;
+    header.dropped = (dropped - pageDropped > 0xFFFF) ? 0xFFFF : (uint16_t)(dropped - pageDropped);
+    pageDropped = dropped;
+    memset(pageBuffer + sizeof(PageHeader_t) + pageLength, 0xFF, PAGE_PAYLOAD_SIZE - pageLength);
+    memcpy(pageBuffer, &header, offsetof(PageHeader_t, crc));
+    header.crc = Crc32(CRC32_INITIAL_VALUE, pageBuffer, offsetof(PageHeader_t, crc));
+    header.crc = Crc32(header.crc, pageBuffer + sizeof(PageHeader_t), pageLength);
+    memcpy(pageBuffer, &header, sizeof(PageHeader_t));
+
+    w25qxx->Program(pageBuffer, PageAddress(writePage), FLIGHT_RECORDER_PAGE_SIZE);
+    pageLength = 0;
+
+    uint32_t next = (writePage + 1) % TOTAL_PAGES;
+    if (next % PAGES_PER_SECTOR == 0)
+    {
+        w25qxx->EraseSector(PageAddress(next));
+        if (next == 0) isWrapped = true;
+    }
+    writePage = next;
+}
+
+/**
+ * @brief Recover the write position and the page sequence from flash
+ * The sector whose first page has the highest sequence is the write sector;
+ * writing resumes after its last programmed page. An empty log is formatted.
+ */
+void RecoverWritePosition(void)
+{
+    const uint32_t sectors = TOTAL_PAGES / PAGES_PER_SECTOR;
+    PageHeader_t header;
+    bool found = false;
+    uint32_t newestSector = 0, newestSequence = 0;
+    for (uint32_t sector = 0; sector < sectors; sector++)
+    {
+        if (!ReadPageHeader(sector * PAGES_PER_SECTOR, &header)) continue;
+        if (!found || (int32_t)(header.sequence - newestSequence) > 0)
+        {
+            newestSector = sector;
+            newestSequence = header.sequence;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        pageSequence = 0;
+        writePage = 0;
+        isWrapped = false;
+        w25qxx->EraseSector(PageAddress(0));
+        return;
+    }
+
+    // Resume after the last page which is not blank, torn pages included
+    uint32_t first = newestSector * PAGES_PER_SECTOR;
+    uint32_t next = first + PAGES_PER_SECTOR;
+    static uint32_t scratch[FLIGHT_RECORDER_PAGE_SIZE / sizeof(uint32_t)];
+    while (next > first)
+    {
+        uint32_t page = next - 1;
+        const uint32_t *word = (const uint32_t*)w25qxx->Map((uint8_t*)scratch, PageAddress(page), FLIGHT_RECORDER_PAGE_SIZE);
+        bool blank = (word != NULL);
+        for (uint32_t i = 0; i < FLIGHT_RECORDER_PAGE_SIZE / sizeof(uint32_t) && blank; i++)
+            blank = (word[i] == 0xFFFFFFFF);
+        w25qxx->Unmap((const uint8_t*)word);
+        if (!blank) break;
+        next = page;
+    }
+    pageSequence = newestSequence + (next - first);
+    writePage = next % TOTAL_PAGES;
+    if (writePage % PAGES_PER_SECTOR == 0)
+    {
+        // The sector was completed but possibly not erased ahead before the reset
+        w25qxx->EraseSector(PageAddress(writePage));
+    }
+    // Once wrapped, the sector after the write sector holds the oldest pages
+    isWrapped = ReadPageHeader((writePage / PAGES_PER_SECTOR + 1) % sectors * PAGES_PER_SECTOR, &header);
+}
+
+/**
+ * @brief Read and check the header of a page
+ * @param page index of the physical page
+ * @param header pointer to the header to fill
+ * @return true if the page holds a valid header and records, false otherwise
+ */
+bool ReadPageHeader(uint32_t page, PageHeader_t *header)
+{
+    static uint8_t scratch[FLIGHT_RECORDER_PAGE_SIZE];
+    w25qxx->Read((uint8_t*)header, PageAddress(page), sizeof(PageHeader_t));
+    if (header->length > PAGE_PAYLOAD_SIZE) return false;   // Blank pages end here
+    // The header read above cached the page, the records are checked in place
+    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, header, offsetof(PageHeader_t, crc));
+    const uint8_t *records = w25qxx->Map(scratch, PageAddress(page) + sizeof(PageHeader_t), header->length);
+    if (records != NULL) crc = Crc32(crc, records, header->length);
+    w25qxx->Unmap(records);
+    return records != NULL && crc == header->crc;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file flight_recorder.h
+ * @brief Interface definition for the binary flight recorder on external SPI flash.
+ *
+ * @details Declares the record types, their payloads and the API of the
+ * flight recorder implemented in `flight_recorder.c`. Records are staged in a
+ * lock-free RAM ring by any thread or interrupt, and a background thread packs
+ * them into 256 byte pages which are programmed into the EXT_FLASH_LOG_FILE
+ * region as a circular log. The newest data overwrites the oldest sector.
+ *
+ * Page layout, all fields little endian:
+ * @verbatim
+ *  ┌──────────┬────────┬─────────┬────────┬──────────────────────────────┐
+ *  │ sequence │ length │ dropped │ crc32  │ records (length bytes) + 0xFF│
+ *  │  4 bytes │ 2 bytes│ 2 bytes │ 4 bytes│ up to 244 bytes              │
+ *  └──────────┴────────┴─────────┴────────┴──────────────────────────────┘
+ *  crc32 covers sequence, length, dropped and the records.
+ *  dropped counts records lost because the staging ring was full.
+ *
+ *  Record: timestamp (4 bytes, ms) | type (1 byte) | size (1 byte) |
+ *          reserved (2 bytes) | payload (size bytes)
+ * @endverbatim
+ *
+ * Responsibilities:
+ *  - Define the record types and payloads stored in the log.
+ *  - Provide the logging API which is safe to call from any context.
+ *  - Provide page based access to the log for the dump service.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system_config.h"
+
+#define FLIGHT_RECORDER_PAGE_SIZE       256     // Size of one log page in bytes, the flash page size
+#define FLIGHT_RECORDER_MAX_PAYLOAD     32      // Maximum payload size of one record in bytes, a parameter record holds the motor gains
+#define FLIGHT_RECORDER_SAMPLE_PERIOD   100     // ms, period of the periodic samples (odometry, wheel speeds)
+
+/**
+ * @brief Types of the flight records
+ * Types are stored in flash, never renumber or reuse them.
+ */
+typedef enum {
+    FLIGHT_RECORD_BOOT = 1,         // FlightRecordBoot_t
+    FLIGHT_RECORD_ODOMETRY,         // FlightRecordOdometry_t
+    FLIGHT_RECORD_WHEEL_SPEED,      // FlightRecordWheelSpeed_t
+    FLIGHT_RECORD_HEARTBEAT,        // FlightRecordHeartbeat_t
+    FLIGHT_RECORD_RC_FAILSAFE,      // FlightRecordRcFailsafe_t
+    FLIGHT_RECORD_PARAMETER,        // FlightRecordParameter_t
+} FlightRecordType_t;
+
+/** @brief Payload of FLIGHT_RECORD_BOOT */
+typedef struct {
+    uint32_t resetFlags;    // Reset flags of RCC_CSR, tell watchdog, brown-out and software resets apart
+} FlightRecordBoot_t;
+
+/** @brief Payload of FLIGHT_RECORD_ODOMETRY */
+typedef struct {
+    float posX;             // m
+    float posY;             // m
+    float theta;            // rad
+    float velocity;         // m/s
+    float omega;            // rad/s
+} FlightRecordOdometry_t;
+
+/**
+ * @brief Payload of FLIGHT_RECORD_WHEEL_SPEED
+ * One entry per motor, the record size gives the motor count of the board.
+ */
+typedef struct {
+    float commanded[TOTAL_MOTOR_NUMBER];    // Target angular speed of each wheel in rad/s
+    float measured[TOTAL_MOTOR_NUMBER];     // Filtered angular speed of each wheel in rad/s
+} FlightRecordWheelSpeed_t;
+_Static_assert(sizeof(FlightRecordWheelSpeed_t) <= FLIGHT_RECORDER_MAX_PAYLOAD, "Wheel speeds exceed a record");
+
+/** @brief Payload of FLIGHT_RECORD_HEARTBEAT */
+typedef struct {
+    uint32_t alive;         // 1 when the upper machine came back, 0 when its heartbeat was lost
+} FlightRecordHeartbeat_t;
+
+#define FLIGHT_RECORD_RC_FAILSAFE_FLAG      0x01    // Receiver reports failsafe
+#define FLIGHT_RECORD_RC_FRAME_LOST_FLAG    0x02    // Receiver reports a lost frame
+#define FLIGHT_RECORD_RC_NO_SIGNAL_FLAG     0x04    // No frame received from the receiver
+
+/** @brief Payload of FLIGHT_RECORD_RC_FAILSAFE */
+typedef struct {
+    uint32_t flags;         // FLIGHT_RECORD_RC_* flags after the transition
+} FlightRecordRcFailsafe_t;
+
+/** @brief Payload of FLIGHT_RECORD_PARAMETER */
+typedef struct {
+    uint16_t key;           // Key id of the parameter in the data store
+    uint16_t size;          // Size of the value in bytes
+    uint8_t value[FLIGHT_RECORDER_MAX_PAYLOAD - 4];  // New value
+} FlightRecordParameter_t;
+
+/**
+ * @brief Initialize the flight recorder
+ * This function recovers the write position from flash, starts the flush
+ * thread and logs a boot record. Records logged before are dropped.
+ */
+void FlightRecorder_Init(void);
+
+/**
+ * @brief Log a record
+ * The record is copied into the staging ring without locking, so this can be
+ * called from any thread or interrupt. It is dropped if the ring is full.
+ * @param type type of the record
+ * @param payload pointer to the payload
+ * @param size size of the payload in bytes, at most FLIGHT_RECORDER_MAX_PAYLOAD
+ * @return true if the record is staged, false otherwise
+ */
+bool FlightRecorder_Log(FlightRecordType_t type, const void *payload, uint32_t size);
+
+/**
+ * @brief Request the staged records to be written to flash now
+ * Used after rare events so they survive a power loss shortly after.
+ */
+void FlightRecorder_Flush(void);
+
+/**
+ * @brief Get the number of pages held by the log
+ * @return number of pages, page 0 being the oldest
+ */
+uint32_t FlightRecorder_GetPageCount(void);
+
+/**
+ * @brief Read pages of the log
+ * @param page index of the first page, 0 is the oldest page
+ * @param buffer pointer to the buffer, count * FLIGHT_RECORDER_PAGE_SIZE bytes
+ * @param count number of pages to read
+ * @return number of pages read
+ */
+uint32_t FlightRecorder_ReadPages(uint32_t page, uint8_t *buffer, uint32_t count);
@@ -0,0 +1,429 @@
+/**
+ * @file kv_store.c
+ * @brief Log-structured key/value store backed by external SPI flash.
+ *
+ * @details Persists small values as append-only records inside a ring of
+ * 4KB sectors on W25Qxx flash. A value update appends one record to the
+ * active sector; nothing is erased until the active sector is full. The
+ * in-RAM index maps every key to the flash address of its latest record and
+ * is rebuilt at boot by replaying the sectors from the oldest to the newest.
+ *
+ * Responsibilities:
+ *  - Initialize `KVStore_t` instances, replay records and format blank regions.
+ *  - Append CRC-protected records and keep the index up to date.
+ *  - Rotate to the spare sector when the active one fills and compact the
+ *    oldest sector into it, so exactly one sector is erased per rotation.
+ *
+ * Flash memory layout overview:
+ * @verbatim
+ *  Region (base = store->regionPosition, sectorCount sectors of 4KB)
+ *
+ *  ┌──────────┬──────────┬──────────┬──────────┬─────┬──────────┐
+ *  │ sector 0 │ sector 1 │   ...    │ active k │ k+1 │ k+2 ...  │
+ *  │ (older)  │ (older)  │          │          │spare│ (oldest) │
+ *  └──────────┴──────────┴──────────┴──────────┴─────┴──────────┘
+ *
+ *  Sector:
+ *  ┌───────────────────────────────┐
+ *  │ SectorHeader_t (magic, seq)   │  sequence increases on every rotation
+ *  ├───────────────────────────────┤
+ *  │ Record: key | len | crc       │
+ *  │         value (4-byte padded) │
+ *  ├───────────────────────────────┤
+ *  │ Record ...                    │◄─ store->writeOffset in the active sector
+ *  ├───────────────────────────────┤
+ *  │ 0xFF ... (erased)             │
+ *  └───────────────────────────────┘
+ * @endverbatim
+ *
+ *  Rotation: when a record does not fit, the spare sector (k+1, always erased)
+ *  becomes the active one with sequence + 1. The oldest sector (k+2) then has
+ *  its still-live records copied into the new active sector and is erased to
+ *  become the next spare. A power cut at any step leaves either the old or
+ *  the new copy of every value valid, and replay order makes the newest win.
+ *
+ * Example usage:
+ * @code{.c}
+ * static KVStore_t store;
+ * KVStore_Init(&store, EXT_FLASH_PARAMETER_KV_ADDRESS, EXT_FLASH_PARAMETER_KV_SIZE);
+ *
+ * float radius = 0.032f;
+ * store.Write(&store, 3, &radius, sizeof(radius));
+ * store.Read(&store, 3, &radius, sizeof(radius));
+ * @endcode
+ *
+ * @note Flash access is serialized by the recursive mutex of the W25QXX
+ * driver, which each Program and EraseSector sequence holds, so the store can
+ * share the chip with the flight recorder and the OTA receiver. The index and
+ * write offset of a KVStore_t are not locked: one instance is used by one
+ * thread (DataStoreThread for the parameter store).
+ *
+ * @dependencies kv_store.h, w25qxx.h, crc32.h, system_config.h
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "kv_store.h"
+
+#include "crc32.h"
+#include "w25qxx.h"
+#include "system_config.h"
+
+#include <string.h>
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define SECTOR_HEADER_MAGIC 0x3153564BU     // "KVS1"
+typedef struct {
+    uint32_t magic;         // Sector header magic, should be SECTOR_HEADER_MAGIC
+    uint32_t sequence;      // Sector sequence number, the highest one is the active sector
+    uint32_t reserved;      // Reserved, kept erased
+    uint32_t headerCRC;     // CRC32 of the fields above
+} SectorHeader_t;
+
+typedef struct {
+    uint16_t key;           // Key id
+    uint16_t length;        // Length of the value in bytes
+    uint32_t crc;           // CRC32 of key, length and value
+} RecordHeader_t;
+
+#define RECORD_ALIGN(len)   (((len) + 3U) & ~3U)
+#define RECORD_SIZE(len)    (sizeof(RecordHeader_t) + RECORD_ALIGN(len))
+#define MIN_SECTOR_COUNT    3   // Active + spare + at least one sector of history
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static W25QXX_t *w25qxx = NULL;     // W25QXX flash instance
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static int32_t Read(const void* store, uint16_t key, void* buffer, uint32_t size);
+static bool Write(const void* store, uint16_t key, const void* value, uint32_t size);
+static bool IsEmpty(const void* store);
+static bool Append(KVStore_t* kv, uint16_t key, const void* value, uint32_t size);
+static bool Rotate(KVStore_t* kv);
+static bool CompactSector(KVStore_t* kv, uint32_t sector);
+static bool ReadSectorHeader(const KVStore_t* kv, uint32_t sector, SectorHeader_t* header);
+static bool WriteSectorHeader(KVStore_t* kv, uint32_t sector, uint32_t sequence);
+static uint32_t ReplaySector(KVStore_t* kv, uint32_t sector);
+static uint32_t FindSectorTail(const KVStore_t* kv, uint32_t sector);
+static uint32_t RecordCRC(uint16_t key, uint16_t length, const void* value);
+
+static inline uint32_t SectorAddress(const KVStore_t* kv, uint32_t sector)
+{
+    return kv->regionPosition + sector * EXT_FLASH_SECTOR_SIZE;
+}
+
+/**
+ * @brief Initialize the key/value storage structure
+ * This function binds the structure to a flash region, replays all records to
+ * build the in-RAM index, and formats the region if it holds no valid sector.
+ * @param store pointer to the KVStore_t structure to initialize
+ * @param memoryPosition start position of the region, sector aligned
+ * @param memoryLength length of the region, a multiple of the sector size
+ * @return true if initialization was successful, false otherwise
+ */
+bool KVStore_Init(KVStore_t* store, uint32_t memoryPosition, uint32_t memoryLength)
+{
+    if (store == NULL) return false;
+    if ((memoryPosition % EXT_FLASH_SECTOR_SIZE) != 0 || (memoryLength % EXT_FLASH_SECTOR_SIZE) != 0) return false;
+    if (memoryLength / EXT_FLASH_SECTOR_SIZE < MIN_SECTOR_COUNT) return false;
+    w25qxx = W25QXX_Init(EXT_FLASH_W25Q128);
+    if (w25qxx == NULL) return false;
+
+    store->Read = Read;
+    store->Write = Write;
+    store->IsEmpty = IsEmpty;
+    store->regionPosition = memoryPosition;
+    store->sectorCount = memoryLength / EXT_FLASH_SECTOR_SIZE;
+    store->eraseCount = 0;
+    store->recordCount = 0;
+    memset(store->index, 0, sizeof(store->index));
+
+    // Replay valid sectors from the oldest to the newest so later records win
+    uint32_t lastSequence = 0;
+    bool found = false;
+    for (;;)
+    {
+        uint32_t nextSector = 0, nextSequence = 0xFFFFFFFFU;
+        bool hasNext = false;
+        for (uint32_t i = 0; i < store->sectorCount; i++)
+        {
+            SectorHeader_t header;
+            if (!ReadSectorHeader(store, i, &header)) continue;
+            if ((!found || header.sequence > lastSequence) && header.sequence <= nextSequence)
+            {
+                nextSector = i;
+                nextSequence = header.sequence;
+                hasNext = true;
+            }
+        }
+        if (!hasNext) break;
+        store->activeSector = nextSector;
+        store->sequence = nextSequence;
+        store->writeOffset = ReplaySector(store, nextSector);
+        lastSequence = nextSequence;
+        found = true;
+    }
+
+    if (!found)
+    {
+        // Blank or foreign content: start a new log in sector 0, sector 1 is the spare
+        store->activeSector = 0;
+        store->sequence = 1;
+        store->writeOffset = sizeof(SectorHeader_t);
+        if (!w25qxx->EraseSector(SectorAddress(store, 0))) return false;
+        store->eraseCount++;
+        if (!WriteSectorHeader(store, 0, store->sequence)) return false;
+    }
+
+    // The sector after the active one must be erased before the next rotation.
+    // It still holds data if a previous compaction was interrupted.
+    uint32_t spare = (store->activeSector + 1) % store->sectorCount;
+    SectorHeader_t header;
+    if (ReadSectorHeader(store, spare, &header))
+        return CompactSector(store, spare);
+    if (FindSectorTail(store, spare) != 0)
+    {
+        if (!w25qxx->EraseSector(SectorAddress(store, spare))) return false;
+        store->eraseCount++;
+    }
+    return true;
+}
+
+/**
+ * @brief Read the latest value of a key
+ * @param store pointer to the KVStore_t structure
+ * @param key key id
+ * @param buffer pointer to the buffer to store the value
+ * @param size size of the buffer in bytes
+ * @return length of the stored value, 0 if the key is absent, or -1 on error
+ */
+static int32_t Read(const void* store, uint16_t key, void* buffer, uint32_t size)
+{
+    if (store == NULL || buffer == NULL || key >= KV_STORE_MAX_KEYS) return -1;
+    const KVStore_t* kv = (const KVStore_t*)store;
+    const KVStoreIndex_t* entry = &kv->index[key];
+    if (entry->address == 0) return 0;
+    if (size < entry->length) return -1;
+    if (!w25qxx->Read((uint8_t*)buffer, entry->address, entry->length)) return -1;
+    return entry->length;
+}
+
+/**
+ * @brief Append a new value for a key
+ * Nothing is written if the stored value is already identical.
+ * @param store pointer to the KVStore_t structure
+ * @param key key id
+ * @param value pointer to the value
+ * @param size length of the value in bytes, at most KV_STORE_MAX_VALUE_SIZE
+ * @return true if the value is persisted, false otherwise
+ */
+static bool Write(const void* store, uint16_t key, const void* value, uint32_t size)
+{
+    if (store == NULL || value == NULL || size == 0) return false;
+    if (key >= KV_STORE_MAX_KEYS || size > KV_STORE_MAX_VALUE_SIZE) return false;
+    KVStore_t* kv = (KVStore_t*)store;
+
+    if (kv->index[key].address != 0 && kv->index[key].length == size)
+    {
+        uint8_t stored[KV_STORE_MAX_VALUE_SIZE];
+        if (w25qxx->Read(stored, kv->index[key].address, size) && memcmp(stored, value, size) == 0)
+            return true; // Unchanged, nothing to program
+    }
+    return Append(kv, key, value, size);
+}
+
+/**
+ * @brief Check whether the store holds any key
+ * @param store pointer to the KVStore_t structure
+ * @return true if at least one key has a value, false otherwise
+ */
+static bool IsEmpty(const void* store)
+{
+    if (store == NULL) return true;
+    const KVStore_t* kv = (const KVStore_t*)store;
+    for (uint32_t i = 0; i < KV_STORE_MAX_KEYS; i++)
+        if (kv->index[i].address != 0) return false;
+    return true;
+}
+
+/**
+ * @brief Append one record to the active sector
+ * The active sector is rotated first if the record does not fit.
+ * @param kv pointer to the KVStore_t structure
+ * @param key key id
+ * @param value pointer to the value
+ * @param size length of the value in bytes
+ * @return true if the record was programmed, false otherwise
+ */
+static bool Append(KVStore_t* kv, uint16_t key, const void* value, uint32_t size)
+{
+    uint32_t recordSize = RECORD_SIZE(size);
+    if (kv->writeOffset + recordSize > EXT_FLASH_SECTOR_SIZE)
+    {
+        if (!Rotate(kv)) return false;
+    }
+
+    // Header and value are programmed in one go so a record is never split across calls
+    uint8_t record[RECORD_SIZE(KV_STORE_MAX_VALUE_SIZE)];
+    memset(record, 0xFF, sizeof(record));
+    RecordHeader_t header;
+    header.key = key;
+    header.length = (uint16_t)size;
+    header.crc = RecordCRC(key, (uint16_t)size, value);
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), value, size);
+
+    uint32_t address = SectorAddress(kv, kv->activeSector) + kv->writeOffset;
+    if (!w25qxx->Program(record, address, recordSize)) return false;
+    kv->index[key].address = address + sizeof(RecordHeader_t);
+    kv->index[key].length = (uint16_t)size;
+    kv->writeOffset += recordSize;
+    kv->recordCount++;
+    return true;
+}
+
+/**
+ * @brief Switch to the spare sector and compact the oldest sector into it
+ * @param kv pointer to the KVStore_t structure
+ * @return true if the rotation was successful, false otherwise
+ */
+static bool Rotate(KVStore_t* kv)
+{
+    uint32_t newActive = (kv->activeSector + 1) % kv->sectorCount;
+    if (!WriteSectorHeader(kv, newActive, kv->sequence + 1)) return false;
+    kv->activeSector = newActive;
+    kv->sequence++;
+    kv->writeOffset = sizeof(SectorHeader_t);
+    return CompactSector(kv, (newActive + 1) % kv->sectorCount);
+}
+
+/**
+ * @brief Move live records out of a sector and erase it
+ * A record is live when the index still points into the sector. The live set
+ * is bounded by KV_STORE_MAX_KEYS * RECORD_SIZE(KV_STORE_MAX_VALUE_SIZE), which
+ * always fits into the freshly rotated active sector.
+ * @param kv pointer to the KVStore_t structure
+ * @param sector index of the sector to compact
+ * @return true if the sector was compacted and erased, false otherwise
+ */
+static bool CompactSector(KVStore_t* kv, uint32_t sector)
+{
+    uint32_t start = SectorAddress(kv, sector);
+    uint32_t end = start + EXT_FLASH_SECTOR_SIZE;
+    for (uint16_t key = 0; key < KV_STORE_MAX_KEYS; key++)
+    {
+        KVStoreIndex_t* entry = &kv->index[key];
+        if (entry->address < start || entry->address >= end) continue;
+        uint8_t value[KV_STORE_MAX_VALUE_SIZE];
+        if (!w25qxx->Read(value, entry->address, entry->length)) return false;
+        if (kv->writeOffset + RECORD_SIZE(entry->length) > EXT_FLASH_SECTOR_SIZE) return false;
+        if (!Append(kv, key, value, entry->length)) return false;
+    }
+    if (!w25qxx->EraseSector(start)) return false;
+    kv->eraseCount++;
+    return true;
+}
+
+/**
+ * @brief Read and validate a sector header
+ * @param kv pointer to the KVStore_t structure
+ * @param sector index of the sector
+ * @param header pointer to store the header
+ * @return true if the header is valid, false otherwise
+ */
+static bool ReadSectorHeader(const KVStore_t* kv, uint32_t sector, SectorHeader_t* header)
+{
+    if (!w25qxx->Read((uint8_t*)header, SectorAddress(kv, sector), sizeof(SectorHeader_t))) return false;
+    if (header->magic != SECTOR_HEADER_MAGIC) return false;
+    return header->headerCRC == Crc32(CRC32_INITIAL_VALUE, header, sizeof(SectorHeader_t) - sizeof(uint32_t));
+}
+
+/**
+ * @brief Write a sector header into an erased sector
+ * @param kv pointer to the KVStore_t structure
+ * @param sector index of the sector
+ * @param sequence sequence number of the sector
+ * @return true if the header was programmed, false otherwise
+ */
+static bool WriteSectorHeader(KVStore_t* kv, uint32_t sector, uint32_t sequence)
+{
+    SectorHeader_t header;
+    header.magic = SECTOR_HEADER_MAGIC;
+    header.sequence = sequence;
+    header.reserved = 0xFFFFFFFFU;
+    header.headerCRC = Crc32(CRC32_INITIAL_VALUE, &header, sizeof(SectorHeader_t) - sizeof(uint32_t));
+    return w25qxx->Program((uint8_t*)&header, SectorAddress(kv, sector), sizeof(header));
+}
+
+/**
+ * @brief Replay the records of a sector into the index
+ * Records are parsed up to the end of the programmed area. A damaged record
+ * (torn write) fails its CRC and is skipped word by word until the next valid
+ * record, so nothing written after it is lost.
+ * @param kv pointer to the KVStore_t structure
+ * @param sector index of the sector
+ * @return offset of the first free byte in the sector
+ */
+static uint32_t ReplaySector(KVStore_t* kv, uint32_t sector)
+{
+    uint32_t base = SectorAddress(kv, sector);
+    uint32_t tail = FindSectorTail(kv, sector);
+    uint32_t offset = sizeof(SectorHeader_t);
+    if (tail < offset) return offset;
+    while (offset + sizeof(RecordHeader_t) <= tail)
+    {
+        RecordHeader_t header;
+        uint8_t value[KV_STORE_MAX_VALUE_SIZE];
+        if (w25qxx->Read((uint8_t*)&header, base + offset, sizeof(header))
+            && header.key < KV_STORE_MAX_KEYS && header.length != 0 && header.length <= KV_STORE_MAX_VALUE_SIZE
+            && offset + RECORD_SIZE(header.length) <= EXT_FLASH_SECTOR_SIZE
+            && w25qxx->Read(value, base + offset + sizeof(header), header.length)
+            && header.crc == RecordCRC(header.key, header.length, value))
+        {
+            kv->index[header.key].address = base + offset + sizeof(header);
+            kv->index[header.key].length = header.length;
+            offset += RECORD_SIZE(header.length);
+        }
+        else
+        {
+            offset += sizeof(uint32_t); // Damaged record, resynchronize on the next word
+        }
+    }
+    return (offset > tail) ? offset : tail;
+}
+
+/**
+ * @brief Find the end of the programmed area of a sector
+ * Programming is strictly sequential, so everything after the last word that
+ * is not 0xFFFFFFFF is erased and can be appended to.
+ * @param kv pointer to the KVStore_t structure
+ * @param sector index of the sector
+ * @return offset following the last programmed word, 0 if the sector is blank
+ */
+static uint32_t FindSectorTail(const KVStore_t* kv, uint32_t sector)
+{
+    uint32_t chunk[16];
+    uint32_t base = SectorAddress(kv, sector);
+    for (uint32_t offset = EXT_FLASH_SECTOR_SIZE; offset > 0; offset -= sizeof(chunk))
+    {
+        if (!w25qxx->Read((uint8_t*)chunk, base + offset - sizeof(chunk), sizeof(chunk)))
+            return EXT_FLASH_SECTOR_SIZE;
+        for (uint32_t i = sizeof(chunk) / sizeof(chunk[0]); i > 0; i--)
+            if (chunk[i - 1] != 0xFFFFFFFFU) return offset - sizeof(chunk) + i * sizeof(uint32_t);
+    }
+    return 0;
+}
+
+/**
+ * @brief Calculate the CRC32 protecting one record
+ * @param key key id
+ * @param length length of the value in bytes
+ * @param value pointer to the value
+ * @return CRC32 of key, length and value
+ */
+static uint32_t RecordCRC(uint16_t key, uint16_t length, const void* value)
+{
+    uint16_t head[2] = {key, length};
+    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, head, sizeof(head));
+    return Crc32(crc, value, length);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file kv_store.h
+ * @brief Interface definition for the log-structured key/value store on
+ * external SPI flash.
+ *
+ * @details Declares the `KVStore_t` control structure used to persist small
+ * values (parameters) as append-only records. Each record carries a key id,
+ * a length, the value and a CRC32. Records are appended to a rotating set of
+ * flash sectors, an in-RAM index is rebuilt at boot and a full sector is
+ * compacted into a pre-erased spare sector, so saving one value costs a few
+ * dozen bytes of programming and no erase in the common case.
+ *
+ * Responsibilities:
+ *  - Describe the runtime state of one key/value region.
+ *  - Publish function pointers for reading and writing values by key.
+ *  - Provide the initialization API which rebuilds the index from flash.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define KV_STORE_MAX_KEYS       64  // Number of key ids supported, key range is [0, KV_STORE_MAX_KEYS)
+#define KV_STORE_MAX_VALUE_SIZE 32  // Maximum length of one value in bytes
+
+/**
+ * @brief Index entry of one key, pointing at its latest record in flash
+ */
+typedef struct {
+    uint32_t address;       // Flash address of the latest value, 0 if the key has never been written
+    uint16_t length;        // Length of the latest value in bytes
+} KVStoreIndex_t;
+
+/**
+ * @brief Structure for key/value storage operations
+ */
+typedef struct {
+    uint32_t regionPosition;    // Start position of the key/value region in the flash memory
+    uint32_t sectorCount;       // Number of sectors in the region, at least 3
+    uint32_t activeSector;      // Index of the sector records are appended to
+    uint32_t writeOffset;       // Offset of the next record inside the active sector
+    uint32_t sequence;          // Sequence number of the active sector
+    uint32_t eraseCount;        // Sectors erased since initialization
+    uint32_t recordCount;       // Records appended since initialization
+    KVStoreIndex_t index[KV_STORE_MAX_KEYS];    // In-RAM index built at boot
+
+    /**
+     * @brief Read the latest value of a key
+     * @param store pointer to the KVStore_t structure
+     * @param key key id
+     * @param buffer pointer to the buffer to store the value
+     * @param size size of the buffer in bytes
+     * @return length of the stored value, 0 if the key is absent, or -1 on error
+     */
+    int32_t (*Read)(const void*, uint16_t, void*, uint32_t);
+
+    /**
+     * @brief Append a new value for a key
+     * Nothing is written if the stored value is already identical.
+     * @param store pointer to the KVStore_t structure
+     * @param key key id
+     * @param value pointer to the value
+     * @param size length of the value in bytes, at most KV_STORE_MAX_VALUE_SIZE
+     * @return true if the value is persisted, false otherwise
+     */
+    bool (*Write)(const void*, uint16_t, const void*, uint32_t);
+
+    /**
+     * @brief Check whether the store holds any key
+     * @param store pointer to the KVStore_t structure
+     * @return true if at least one key has a value, false otherwise
+     */
+    bool (*IsEmpty)(const void*);
+} KVStore_t;
+
+/**
+ * @brief Initialize the key/value storage structure
+ * This function binds the structure to a flash region, replays all records to
+ * build the in-RAM index, and formats the region if it holds no valid sector.
+ * @param store pointer to the KVStore_t structure to initialize
+ * @param memoryPosition start position of the region, sector aligned
+ * @param memoryLength length of the region, a multiple of the sector size
+ * @return true if initialization was successful, false otherwise
+ */
+bool KVStore_Init(KVStore_t *store, uint32_t memoryPosition, uint32_t memoryLength);
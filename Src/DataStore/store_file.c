@@ -10,10 +10,35 @@
  * and memory buffering uses the shared mem-pool utilities.
  *
  * Responsibilities:
- *  - Initialize `StoreFile_t` instances and locate the latest valid FDB.
- *  - Persist new metadata records (FDBs) with CRC protection.
+ *  - Initialize `StoreFile_t` instances and recover the last committed file.
+ *  - Persist new metadata records (FDBs) with a two-phase commit.
  *  - Handle wrap-around when data crosses the end of the storage segment.
  *
+ * Commit protocol:
+ *  1. NewFile starts the file on the next sector boundary of the data area,
+ *     and Write programs the data, erasing each sector as it is entered.
+ *  2. UpdateFileDescription programs an FDB into the next blank slot. The FDB
+ *     holds a sequence number, the file position, length and CRC32, and a
+ *     CRC32 of its own fields. The commit marker word is left erased.
+ *  3. The FDB is read back and the commit marker is programmed on its own.
+ *
+ * A power loss before step 3 completes leaves an FDB without marker (or a
+ * torn one failing its CRC), which StoreFile_Init ignores: it scans every
+ * slot and picks the committed FDB with the highest sequence number. The
+ * description area spans two sectors and a sector is erased only when the
+ * slot cursor enters it, so the latest committed FDB, living in the other
+ * sector, always survives. A file is limited to half of the data area so
+ * writing a new file never erases the sectors of the committed one.
+ *
+ * Images written by older firmware (single sector description area, FDBs
+ * without sequence and marker) are still found and can be read; the next
+ * commit switches the block to the current layout. That first file is
+ * written past the end of the legacy one and its FDB goes into a blank slot
+ * of the legacy description sector, next to the legacy FDB, so nothing of
+ * the legacy image is erased before the new FDB carries its marker. The
+ * legacy sectors are only erased later, when the slot cursor and the files
+ * reach them.
+ *
  * Flash memory layout overview:
  * @verbatim
  *  Flash block (base = fp->blockPosition, length = fp->blockLength)
@@ -21,16 +46,17 @@
  *  ┌────────────────────────────────────────────────────────────────┐
  *  │   offset 0 (base = fp->blockPosition)                          │
  *  │                                                                │
- *  │   File Description Area (FILE_DESCRIPTION_AREA_SIZE bytes)     │
+ *  │   File Description Area (FILE_DESCRIPTION_AREA_SIZE bytes,     │
+ *  │   two sectors used alternately)                                │
  *  │      ┌──────────┐                                              │
  *  │      │   FDB0   │   First FDB                                  │
  *  │      ├──────────┤                                              │
  *  │      │   …      │                                              │
  *  │      ├──────────┤                                              │
- *  │ ┌────│   FDBn   │◄─ fp->fdbPos (offset of latest valid FDB)    │
+ *  │ ┌────│   FDBn   │◄─ fp->fdbPos (latest committed FDB)          │
  *  │ |    └──────────┘                                              │
  *  │ |                                                              │
- *  │ | Data Area (fp->blockLength - FILE_DESCRIPTION_AREA_SIZE)     │
+ *  │ | Data Area (fp->blockLength - fp->dataPos)                    │
  *  │ | ┌─────────────────────────────────────────────────────────┐  │
  *  │ | │  Logical files stored in FDB sequence (oldest → latest) │  │
  *  │ | │  ┌──────────┐                                           │  │
@@ -42,12 +68,12 @@
  *  │   │  └──────────┘                                           │  │
  *  │   │                                                         │  │
  *  │   │  Logical read pointer:                                  │  │
- *  │   │    fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE       │  │
- *  │   │    + fp->readPos                                        │  │
+ *  │   │    fp->blockPosition + fp->dataPos                      │  │
+ *  │   │    + (fp->filePos + fp->readPos) % data area length     │  │
  *  │   │                                                         │  │
  *  │   │  Logical write pointer:                                 │  │
- *  │   │    fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE       │  │
- *  │   │    + fp->writePos                                       │  │
+ *  │   │    fp->blockPosition + fp->dataPos                      │  │
+ *  │   │    + (fp->filePos + fp->writePos) % data area length    │  │
  *  │   │                                                         │  │
  *  │   └─────────────────────────────────────────────────────────┘  │
  *  │                                                                │
@@ -58,8 +84,8 @@
  *    • fp->filePos selects the start of the latest logical file (FDBn) inside the
  *      data area. Dereferencing `base + fp->filePos` yields the file pointer for
  *      that entry, while earlier FDB indices map to preceding segments.
- *    • fp->readPos and fp->writePos are offsets from the data area base used by
- *      Read/Write helpers; they can advance past fp->filePos as the file grows.
+ *    • fp->readPos and fp->writePos are offsets from the start of the file used
+ *      by Read/Write helpers, wrapping at the end of the data area.
  * @endverbatim
  *
  * Example usage:
@@ -72,7 +98,7 @@
  * const uint8_t payload[] = {0x01, 0x02, 0x03};
  * store.Write(&store, payload, sizeof(payload));
  * 
- * // Update the file description block in flash
+ * // Commit the file description block in flash
  * store.UpdateFileDescription(&store);
  * store.SetReadPos(&store, 0);
  * uint8_t buffer[sizeof(payload)];
@@ -88,7 +114,7 @@
  * const uint8_t newPayload[] = {0x04, 0x05, 0x06};
  * store.Write(&store, newPayload, sizeof(newPayload));
  * 
- * // Update the file description block for the new file
+ * // Commit the file description block for the new file
  * store.UpdateFileDescription(&store);
  * 
  * // Read back the new data
@@ -115,18 +141,34 @@
 #include "mem_pool.h"
 #include "system_config.h"
 
+#include <stddef.h>
 #include <string.h>
 
 /* -------------------------------------- Data Type Definitions -------------------------------- */
-#define FILE_DESCRIPTION_BLOCK_HEADER 0xA5A55A5A    // File description block header
+#define FILE_DESCRIPTION_BLOCK_HEADER 0xA5A55A5B    // File description block header
+#define FILE_COMMIT_MARKER            0x5AA5C3C3    // Programmed once the FDB is complete
+#define FILE_FLASH_BLANK_WORD         0xFFFFFFFF    // Content of an erased word
+typedef struct {
+    uint32_t fdbHeader;     // File description block header, should be 0xA5A55A5B
+    uint32_t sequence;      // Sequence number, incremented on every commit
+    uint32_t filePos;       // Start position of the file in the data area
+    uint32_t length;        // Length of the file
+    uint32_t fileCRC;       // CRC32 checksum of the file content
+    uint32_t fdbCRC;        // CRC32 checksum of the fields above
+    uint32_t reserved;      // Left erased
+    uint32_t commitMarker;  // FILE_COMMIT_MARKER once committed, programmed separately
+} FileDescriptionBlock_t;
+#define FILE_DESCRIPTION_AREA_SIZE (2 * EXT_FLASH_SECTOR_SIZE) // 8KB for file description blocks
+
+#define LEGACY_FILE_DESCRIPTION_BLOCK_HEADER 0xA5A55A5A    // File description block header of older images
 typedef struct {
     uint32_t fdbHeader;     // File description block header, should be 0xA5A55A5A
     uint32_t filePos;       // Start position of the file in the flash memory
     uint32_t length;        // Length of the file
     uint32_t fileCRC;       // CRC32 checksum of the file content
     uint32_t fdbCRC;
-} FileDescriptionBlock_t;
-#define FILE_DESCRIPTION_AREA_SIZE (1 * EXT_FLASH_SECTOR_SIZE) // 4KB for file description blocks
+} LegacyFileDescriptionBlock_t;
+#define LEGACY_FILE_DESCRIPTION_AREA_SIZE (1 * EXT_FLASH_SECTOR_SIZE) // 4KB for file description blocks
 
 /* -------------------------------------- Static variables ------------------------------------- */
 static W25QXX_t *w25qxx = NULL;     // W25QXX flash instance
@@ -139,12 +181,17 @@ static void SetReadPos(const void*, uint32_t pos);
 static uint32_t CalculateCRC(const void*);
 static uint32_t ReadCRC(const void*);
 static bool UpdateFileDescription(const void*);
-static bool FindOutFileDescriptionBlock(const void* file, FileDescriptionBlock_t* fdb);
 static bool NewFile(const void* file);
+static uint32_t MaxFileLength(const StoreFile_t* fp);
+static bool IsCommitted(const StoreFile_t* fp, const FileDescriptionBlock_t* fdb);
+static bool FindLastCommittedDescription(StoreFile_t* fp, FileDescriptionBlock_t* fdb);
+static bool FindLegacyDescription(StoreFile_t* fp, LegacyFileDescriptionBlock_t* fdb);
+static bool AdvanceDescriptionSlot(StoreFile_t* fp);
 
 /**
  * @brief Initialize the update file storage structure
- * This function initializes the update file storage structure and its function pointers.
+ * This function initializes the update file storage structure and its function pointers,
+ * and recovers the last fully committed file from flash.
  * @param file pointer to the StoreFile_t structure to initialize
  * @param memoryPosition start position of the file in the flash memory
  * @param memoryLength length of the file in the flash memory
@@ -153,6 +200,7 @@ static bool NewFile(const void* file);
 bool StoreFile_Init(StoreFile_t* file, uint32_t memoryPosition, uint32_t memoryLength)
 {
     if (file == NULL) return false;
+    if (memoryLength <= FILE_DESCRIPTION_AREA_SIZE + EXT_FLASH_SECTOR_SIZE) return false;
     w25qxx = W25QXX_Init(EXT_FLASH_W25Q128);
     if (w25qxx == NULL) return false;
     file->Read = Read;
@@ -166,22 +214,37 @@ bool StoreFile_Init(StoreFile_t* file, uint32_t memoryPosition, uint32_t memoryL
 
     file->blockPosition = memoryPosition;
     file->blockLength = memoryLength;
+    file->dataPos = FILE_DESCRIPTION_AREA_SIZE;
     file->readPos = 0;
     file->writePos = 0;
+    file->committed = true;
     
     FileDescriptionBlock_t fdb;
-    if (!FindOutFileDescriptionBlock(file, &fdb))
-    {
-        file->fdbPos = 0;
-        file->filePos = FILE_DESCRIPTION_AREA_SIZE;
-        file->crc = 0;
-        file->length = 0;
-    }
-    else
+    LegacyFileDescriptionBlock_t legacy;
+    if (FindLastCommittedDescription(file, &fdb))
     {
+        file->sequence = fdb.sequence;
         file->filePos = fdb.filePos;
         file->crc = fdb.fileCRC;
         file->length = fdb.length;
+        return true;
+    }
+
+    // Nothing committed yet, the first commit goes to slot 0
+    file->fdbPos = FILE_DESCRIPTION_AREA_SIZE - sizeof(FileDescriptionBlock_t);
+    file->sequence = 0;
+    file->filePos = 0;
+    if (FindLegacyDescription(file, &legacy))
+    {
+        // Older firmware always wrote its file at the start of the data area
+        file->dataPos = LEGACY_FILE_DESCRIPTION_AREA_SIZE;
+        file->crc = legacy.fileCRC;
+        file->length = legacy.length;
+    }
+    else
+    {
+        file->crc = 0;
+        file->length = 0;
     }
     return true;
 }
@@ -189,32 +252,36 @@ bool StoreFile_Init(StoreFile_t* file, uint32_t memoryPosition, uint32_t memoryL
 /**
  * @brief Write data to the file
  * This function writes data to the file at the current write position.
+ * Sectors are erased as the data enters them, files start on a sector boundary.
  * @param file pointer to the StoreFile_t structure
  * @param data pointer to the data to be written
  * @param size number of bytes to write
  * @return true if the write operation was successful, false otherwise
- * @note This function does not update the file length or CRC32.
+ * @note This function does not update the CRC32. A committed file cannot be
+ * written, call NewFile first.
  */
 static bool Write(const void* file, const void* data, uint32_t size)
 {
     if (file == NULL || data == NULL || size == 0) return false;
     StoreFile_t* fp = (StoreFile_t*)file;
-    if (fp->writePos + size > fp->blockLength - FILE_DESCRIPTION_AREA_SIZE)
-    {
-        uint32_t writeSize = fp->blockLength - FILE_DESCRIPTION_AREA_SIZE - fp->writePos;
-        uint32_t remainingSize = size - writeSize;
-        w25qxx->Write((uint8_t*)data, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->writePos, writeSize);
-        fp->writePos = 0;
-        w25qxx->Write((uint8_t*)data + writeSize, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->writePos, remainingSize);
-        fp->writePos += remainingSize;
-    }
-    else
+    if (fp->committed) return false;
+    if (fp->writePos + size > MaxFileLength(fp)) return false;
+
+    uint32_t dataLength = fp->blockLength - fp->dataPos;
+    const uint8_t* src = (const uint8_t*)data;
+    bool result = true;
+    while (size > 0)
     {
-        w25qxx->Write((uint8_t*)data, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->writePos, size);
-        fp->writePos += size;
+        uint32_t offset = (fp->filePos + fp->writePos) % dataLength;
+        uint32_t writeSize = dataLength - offset;  // Bytes left before wrapping around
+        if (writeSize > size) writeSize = size;
+        result &= w25qxx->Write((uint8_t*)src, fp->blockPosition + fp->dataPos + offset, writeSize);
+        src += writeSize;
+        size -= writeSize;
+        fp->writePos += writeSize;
     }
-    fp->length = fp->writePos;
-    return true;
+    if (fp->writePos > fp->length) fp->length = fp->writePos;
+    return result;
 }
 
 /**
@@ -231,19 +298,19 @@ static int32_t Read(const void* file, void* buffer, uint32_t size)
     StoreFile_t* fp = (StoreFile_t*)file;
     if (fp->readPos >= fp->length) return 0;
     if (fp->readPos + size > fp->length) size = fp->length - fp->readPos;
-    if (fp->readPos + size > fp->blockLength - FILE_DESCRIPTION_AREA_SIZE)
-    {
-        uint32_t readSize = fp->blockLength - FILE_DESCRIPTION_AREA_SIZE - fp->readPos;
-        uint32_t remainingSize = size - readSize;
-        w25qxx->Read(buffer, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->readPos, readSize);
-        fp->readPos = 0;
-        w25qxx->Read((uint8_t*)buffer + readSize, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->readPos, remainingSize);
-        fp->readPos += remainingSize;
-    }
-    else
+
+    uint32_t dataLength = fp->blockLength - fp->dataPos;
+    uint8_t* dst = (uint8_t*)buffer;
+    uint32_t remaining = size;
+    while (remaining > 0)
     {
-        w25qxx->Read(buffer, fp->blockPosition + FILE_DESCRIPTION_AREA_SIZE + fp->readPos, size);
-        fp->readPos += size;
+        uint32_t offset = (fp->filePos + fp->readPos) % dataLength;
+        uint32_t readSize = dataLength - offset;   // Bytes left before wrapping around
+        if (readSize > remaining) readSize = remaining;
+        w25qxx->Read(dst, fp->blockPosition + fp->dataPos + offset, readSize);
+        dst += readSize;
+        remaining -= readSize;
+        fp->readPos += readSize;
     }
     return size;
 }
@@ -318,100 +385,217 @@ static void SetReadPos(const void* file, uint32_t pos)
 }
 
 /**
- * @brief Update the file description block in flash
- * This function updates the file description block in flash memory
- * with the current length and CRC32 of the file.
+ * @brief Commit the file description block in flash
+ * This function commits the current length and CRC32 of the file in two
+ * phases: the FDB fields are programmed into a blank slot first, and the
+ * commit marker is programmed only after they read back intact.
  * @param file pointer to the StoreFile_t structure
  * @return true if the update was successful, false otherwise
  */
 static bool UpdateFileDescription(const void* file)
 {
     if (file == NULL) return false;
-    bool result;
     StoreFile_t* fp = (StoreFile_t*)file;
-    FileDescriptionBlock_t fdb;
+    if (fp->dataPos != FILE_DESCRIPTION_AREA_SIZE) return false;   // Legacy image, start a new file first
+    if (fp->length > MaxFileLength(fp)) return false;
+    FileDescriptionBlock_t fdb, verify;
     fdb.fdbHeader = FILE_DESCRIPTION_BLOCK_HEADER;
+    fdb.sequence = fp->sequence + 1;
     fdb.filePos = fp->filePos;
     fdb.length = fp->length;
 
     fp->crc = CalculateCRC(fp);
     fdb.fileCRC = fp->crc;
     
-    // Compute CRC over all fields except the trailing fdbCRC itself
-    fdb.fdbCRC = Crc32(0xFFFFFFFF, (uint8_t*)&fdb, sizeof(FileDescriptionBlock_t) - sizeof(uint32_t));
-    result = w25qxx->Write((uint8_t*)&fdb, fp->blockPosition + fp->fdbPos, sizeof(FileDescriptionBlock_t));
-    return result;
+    // Compute CRC over all fields before the fdbCRC itself
+    fdb.fdbCRC = Crc32(CRC32_INITIAL_VALUE, (uint8_t*)&fdb, offsetof(FileDescriptionBlock_t, fdbCRC));
+    fdb.reserved = FILE_FLASH_BLANK_WORD;
+    fdb.commitMarker = FILE_FLASH_BLANK_WORD;
+
+    if (!AdvanceDescriptionSlot(fp)) return false;
+    uint32_t address = fp->blockPosition + fp->fdbPos;
+
+    // Phase 1: the description without its marker
+    if (!w25qxx->Program((uint8_t*)&fdb, address, offsetof(FileDescriptionBlock_t, commitMarker))) return false;
+    w25qxx->Read((uint8_t*)&verify, address, sizeof(verify));
+    if (memcmp(&fdb, &verify, sizeof(fdb)) != 0) return false;
+
+    // Phase 2: the marker, the file is committed once this word is programmed
+    uint32_t marker = FILE_COMMIT_MARKER;
+    if (!w25qxx->Program((uint8_t*)&marker, address + offsetof(FileDescriptionBlock_t, commitMarker), sizeof(marker)))
+        return false;
+    w25qxx->Read((uint8_t*)&verify, address, sizeof(verify));
+    if (!IsCommitted(fp, &verify)) return false;
+
+    fp->sequence = fdb.sequence;
+    fp->committed = true;
+    return true;
 }
 
 /**
- * @brief Find out the file description block in flash
- * This function searches for the file description block in flash memory
- * and updates the file structure with the found positions.
- * @param file pointer to the StoreFile_t structure
+ * @brief Maximum length of one file
+ * Half of the data area rounded down to whole sectors, so a file being written
+ * never reaches the sectors of the previously committed one.
+ * @param fp pointer to the StoreFile_t structure
+ * @return maximum file length in bytes
+ */
+static uint32_t MaxFileLength(const StoreFile_t* fp)
+{
+    uint32_t half = (fp->blockLength - FILE_DESCRIPTION_AREA_SIZE) / 2;
+    return half / EXT_FLASH_SECTOR_SIZE * EXT_FLASH_SECTOR_SIZE;
+}
+
+/**
+ * @brief Check whether a file description block is committed
+ * @param fp pointer to the StoreFile_t structure
+ * @param fdb pointer to the file description block read from flash
+ * @return true if the header, CRC and commit marker are valid, false otherwise
+ */
+static bool IsCommitted(const StoreFile_t* fp, const FileDescriptionBlock_t* fdb)
+{
+    if (fdb->fdbHeader != FILE_DESCRIPTION_BLOCK_HEADER) return false;
+    if (fdb->commitMarker != FILE_COMMIT_MARKER) return false;
+    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, (uint8_t*)fdb, offsetof(FileDescriptionBlock_t, fdbCRC));
+    if (fdb->fdbCRC != crc) return false;
+    return fdb->filePos < fp->blockLength - FILE_DESCRIPTION_AREA_SIZE && fdb->length <= MaxFileLength(fp);
+}
+
+/**
+ * @brief Find out the last committed file description block in flash
+ * This function scans every slot of the description area and keeps the
+ * committed block with the highest sequence number. Blocks without commit
+ * marker or with a bad CRC were interrupted by a power loss and are skipped.
+ * @param fp pointer to the StoreFile_t structure
  * @param fdb pointer to a FileDescriptionBlock_t structure to store the found block
+ * @return true if a committed file description block was found, false otherwise
+ */
+static bool FindLastCommittedDescription(StoreFile_t* fp, FileDescriptionBlock_t* fdb)
+{
+    FileDescriptionBlock_t tmp;
+    bool found = false;
+    uint32_t bestSequence = 0;
+    for (uint32_t pos = 0; pos < FILE_DESCRIPTION_AREA_SIZE; pos += sizeof(FileDescriptionBlock_t))
+    {
+        // Slots are checked in the page cache, eight slots per page read
+        const FileDescriptionBlock_t* slot = (const FileDescriptionBlock_t*)
+            w25qxx->Map((uint8_t*)&tmp, fp->blockPosition + pos, sizeof(tmp));
+        if (slot == NULL) continue;
+        if (IsCommitted(fp, slot) && (!found || (int32_t)(slot->sequence - bestSequence) > 0))
+        {
+            *fdb = *slot;
+            bestSequence = slot->sequence;
+            fp->fdbPos = pos;
+            found = true;
+        }
+        w25qxx->Unmap((const uint8_t*)slot);
+    }
+    return found;
+}
+
+/**
+ * @brief Find out the file description block written by older firmware
+ * Older images append FDBs without sequence number from the first slot on,
+ * so the last one is found by binary searching the first invalid header.
+ * @param fp pointer to the StoreFile_t structure
+ * @param fdb pointer to a LegacyFileDescriptionBlock_t structure to store the found block
  * @return true if a valid file description block was found, false otherwise
  */
-static bool FindOutFileDescriptionBlock(const void* file, FileDescriptionBlock_t* fdb)
+static bool FindLegacyDescription(StoreFile_t* fp, LegacyFileDescriptionBlock_t* fdb)
 {
-    if (fdb == NULL || file == NULL) return false;
-    StoreFile_t* fp = (StoreFile_t*)file;
-    uint32_t slots = FILE_DESCRIPTION_AREA_SIZE / sizeof(FileDescriptionBlock_t);
+    uint32_t slots = LEGACY_FILE_DESCRIPTION_AREA_SIZE / sizeof(LegacyFileDescriptionBlock_t);
 
     // If the very first slot is invalid, nothing to find
-    FileDescriptionBlock_t tmp;
+    LegacyFileDescriptionBlock_t tmp;
     w25qxx->Read((uint8_t*)&tmp, fp->blockPosition, sizeof(tmp));
-    if (tmp.fdbHeader != FILE_DESCRIPTION_BLOCK_HEADER) return false;
+    if (tmp.fdbHeader != LEGACY_FILE_DESCRIPTION_BLOCK_HEADER) return false;
 
     // Binary search the first invalid slot in [0, slots)
     uint32_t lo = 0, hi = slots;
     while (lo < hi) {
         uint32_t mid = lo + ((hi - lo) >> 1);
-        uint32_t addr = fp->blockPosition + mid * sizeof(FileDescriptionBlock_t);
+        uint32_t addr = fp->blockPosition + mid * sizeof(LegacyFileDescriptionBlock_t);
         w25qxx->Read((uint8_t*)&tmp, addr, sizeof(tmp));
 
-        if (tmp.fdbHeader == FILE_DESCRIPTION_BLOCK_HEADER) {
+        if (tmp.fdbHeader == LEGACY_FILE_DESCRIPTION_BLOCK_HEADER) {
             lo = mid + 1;  // valid at mid, search right
         } else {
             hi = mid;      // invalid at mid, search left
         }
     }
 
-    if (lo == 0) return false; // No valid FDB found
-    uint32_t lastIndex = lo - 1;
-    uint32_t lastAddr = fp->blockPosition + lastIndex * sizeof(FileDescriptionBlock_t);
-
-    // Read the last valid FDB entry found into the output buffer
-    w25qxx->Read((uint8_t*)fdb, lastAddr, sizeof(FileDescriptionBlock_t));
-    // Check if we found a valid FDB
-    uint32_t crc = Crc32(0xFFFFFFFF, (uint8_t*)fdb, sizeof(FileDescriptionBlock_t) - sizeof(uint32_t));
-    if (fdb->fdbHeader != FILE_DESCRIPTION_BLOCK_HEADER || fdb->fdbCRC != crc)
+    uint32_t lastAddr = fp->blockPosition + (lo - 1) * sizeof(LegacyFileDescriptionBlock_t);
+    w25qxx->Read((uint8_t*)fdb, lastAddr, sizeof(LegacyFileDescriptionBlock_t));
+    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, (uint8_t*)fdb, offsetof(LegacyFileDescriptionBlock_t, fdbCRC));
+    if (fdb->fdbHeader != LEGACY_FILE_DESCRIPTION_BLOCK_HEADER || fdb->fdbCRC != crc)
         return false; // invalid FDB
-    
-    fp->fdbPos = lastIndex * sizeof(FileDescriptionBlock_t);
-    return true;
+    return fdb->length <= fp->blockLength - LEGACY_FILE_DESCRIPTION_AREA_SIZE;
+}
+
+/**
+ * @brief Move the slot cursor to the next blank description slot
+ * A sector of the description area is erased when the cursor enters it, the
+ * latest committed FDB is then in the other sector. Slots left dirty by an
+ * interrupted commit are skipped.
+ * @param fp pointer to the StoreFile_t structure
+ * @return true if a blank slot was found, false otherwise
+ */
+static bool AdvanceDescriptionSlot(StoreFile_t* fp)
+{
+    const uint32_t slots = FILE_DESCRIPTION_AREA_SIZE / sizeof(FileDescriptionBlock_t);
+    uint32_t slot[sizeof(FileDescriptionBlock_t) / sizeof(uint32_t)];
+    for (uint32_t i = 0; i < slots; i++)
+    {
+        fp->fdbPos += sizeof(FileDescriptionBlock_t);
+        if (fp->fdbPos >= FILE_DESCRIPTION_AREA_SIZE) fp->fdbPos = 0;
+        if (fp->fdbPos % EXT_FLASH_SECTOR_SIZE == 0)
+            return w25qxx->EraseSector(fp->blockPosition + fp->fdbPos);
+
+        w25qxx->Read((uint8_t*)slot, fp->blockPosition + fp->fdbPos, sizeof(slot));
+        bool blank = true;
+        for (uint32_t j = 0; j < sizeof(slot) / sizeof(uint32_t); j++)
+            blank &= (slot[j] == FILE_FLASH_BLANK_WORD);
+        if (blank) return true;
+    }
+    return false;
 }
 
 /**
  * @brief Create a new file
- * This function creates a new file by updating the file description block position
- * and resetting the file parameters.
+ * This function starts a new file on the next sector boundary after the
+ * current one and resets the file parameters. Nothing is written to flash
+ * until the new file is written and committed.
  * @param file pointer to the StoreFile_t structure
  * @return true if the new file was created successfully, false otherwise
  */
-bool NewFile(const void* file)
+static bool NewFile(const void* file)
 {
     if (file == NULL) return false;
     StoreFile_t* fp = (StoreFile_t*)file;
-    fp->fdbPos += sizeof(FileDescriptionBlock_t);
-    if (fp->fdbPos + sizeof(FileDescriptionBlock_t) >= FILE_DESCRIPTION_AREA_SIZE)
-        fp->fdbPos = 0; // Reset to the beginning if exceeding the area size
-    fp->filePos += fp->length;
-    if (fp->filePos > fp->blockLength - FILE_DESCRIPTION_AREA_SIZE)
-        fp->filePos -= (fp->blockLength - FILE_DESCRIPTION_AREA_SIZE);  // Wrap around
+    if (fp->dataPos != FILE_DESCRIPTION_AREA_SIZE)
+    {
+        // Leaving a legacy image, the block is rewritten in the current layout.
+        // The new file starts after the legacy one and its FDB takes a blank
+        // slot of the legacy description sector, so the legacy image stays
+        // whole until the new FDB is committed
+        uint32_t legacyEnd = LEGACY_FILE_DESCRIPTION_AREA_SIZE + fp->length + EXT_FLASH_SECTOR_SIZE - 1;
+        legacyEnd = legacyEnd / EXT_FLASH_SECTOR_SIZE * EXT_FLASH_SECTOR_SIZE;
+        fp->dataPos = FILE_DESCRIPTION_AREA_SIZE;
+        fp->filePos = legacyEnd > FILE_DESCRIPTION_AREA_SIZE ? legacyEnd - FILE_DESCRIPTION_AREA_SIZE : 0;
+        if (fp->filePos >= fp->blockLength - FILE_DESCRIPTION_AREA_SIZE) fp->filePos = 0;
+        fp->fdbPos = 0;
+    }
+    else
+    {
+        uint32_t dataLength = fp->blockLength - FILE_DESCRIPTION_AREA_SIZE;
+        uint32_t end = fp->filePos + fp->length + EXT_FLASH_SECTOR_SIZE - 1;
+        fp->filePos = end / EXT_FLASH_SECTOR_SIZE * EXT_FLASH_SECTOR_SIZE;
+        if (fp->filePos >= dataLength)
+            fp->filePos -= dataLength;  // Wrap around
+    }
     fp->crc = 0;
     fp->length = 0;
     fp->readPos = 0;
     fp->writePos = 0;
+    fp->committed = false;
     return true;
 }
-
@@ -6,7 +6,8 @@
  * helpers that back the implementation in `store_file.c`. The interface exposes
  * metadata fields and function pointers required to operate flash-resident
  * files with File Description Blocks (FDBs), CRC protection, and read/write
- * cursors.
+ * cursors. A file becomes visible only after its FDB is committed, so a power
+ * loss at any point leaves the previously committed file readable.
  *
  * Responsibilities:
  *  - Describe the persistent metadata tracked for each logical file instance.
@@ -31,11 +32,14 @@ typedef struct {
     uint32_t blockPosition; // Start position of the file block in the flash memory
     uint32_t blockLength;   // Length of the file block in the flash memory
     uint32_t fdbPos;        // Start position of the file description block in the flash memory
+    uint32_t dataPos;       // Offset of the data area inside the file block
     uint32_t filePos;       // Start position of the file in the flash memory
     uint32_t length;        // Current length of the file
     uint32_t crc;           // CRC32 checksum of the file content
     uint32_t readPos;       // Current read position in the file
     uint32_t writePos;      // Current write position in the file
+    uint32_t sequence;      // Sequence number of the latest committed FDB
+    bool committed;         // True if the current file is committed and can no longer be written
 
     /**
      * @brief Read data from the file
@@ -54,7 +58,8 @@ typedef struct {
      * @param data pointer to the data to be written
      * @param size number of bytes to write
      * @return true if the write operation was successful, false otherwise
-     * @note This function does not update the file length or CRC32.
+     * @note This function does not update the CRC32. A committed file cannot be
+     * written, call NewFile first.
      */
     bool (*Write)(const void*, const void*, uint32_t);
 
@@ -83,7 +88,8 @@ typedef struct {
     uint32_t (*ReadCRC)(const void*);
 
     /** 
-     * @brief Function pointer to update the file description block in flash
+     * @brief Function pointer to commit the file description block in flash
+     * The file becomes the one found by StoreFile_Init only once this returns true.
      * @param file pointer to the StoreFile_t structure
      * @return true if the update was successful, false otherwise
      */
@@ -99,7 +105,8 @@ typedef struct {
 
 /**
  * @brief Initialize the update file storage structure
- * This function initializes the update file storage structure and its function pointers.
+ * This function initializes the update file storage structure and its function pointers,
+ * and recovers the last fully committed file from flash.
  * @param file pointer to the StoreFile_t structure to initialize
  * @param memoryPosition start position of the file in the flash memory
  * @param memoryLength length of the file in the flash memory
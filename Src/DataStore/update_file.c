@@ -0,0 +1,330 @@
+/**
+ * @file update_file.c
+ * @brief Firmware update image backed by external SPI flash.
+ *
+ * @details Receives a firmware image into the EXT_FLASH_OTA_FILE region. The
+ * transport hands over whole pages, possibly out of order but never further
+ * than UPDATE_FILE_WINDOW_PAGES ahead of the first missing page. Each page is
+ * programmed straight from the caller's buffer into a sector erased on demand.
+ * Whenever the first missing page arrives, the contiguous pages are read back
+ * from flash into a running CRC32, so the final check covers what is really
+ * stored and not what was received.
+ *
+ * Responsibilities:
+ *  - Initialize `UpdateFile_t` instances and restore the last checkpoint.
+ *  - Program pages, track the receive window and the running CRC32.
+ *  - Checkpoint the progress so an interrupted transfer resumes.
+ *  - Program the apply flag once the whole image is verified.
+ *
+ * Flash memory layout overview:
+ * @verbatim
+ *  Region (base = file->regionPosition, length = file->regionLength)
+ *
+ *  ┌─────────────────────────────────────────────┐
+ *  │ Descriptor sector (EXT_FLASH_SECTOR_SIZE)    │
+ *  │  UpdateFileDescriptor_t  (32 bytes)          │
+ *  │  Checkpoint 0: pages | crc | ~pages | check  │
+ *  │  Checkpoint 1 ...                            │
+ *  │  0xFF ... (erased)                           │
+ *  ├─────────────────────────────────────────────┤
+ *  │ Image (descriptor.imagePosition)             │
+ *  │  page 0 | page 1 | ... | page n-1            │
+ *  └─────────────────────────────────────────────┘
+ * @endverbatim
+ *
+ *  A checkpoint is appended every UPDATE_FILE_CHECKPOINT_PAGES committed
+ *  pages, a whole number of sectors, so resuming restarts on a sector
+ *  boundary and the sectors after it are simply erased again. The apply flag
+ *  is programmed last and on its own; the bootloader only trusts a descriptor
+ *  whose apply flag is set and whose image CRC matches.
+ *
+ * @note CRC32 values use Crc32() of crc32.c (polynomial 0x04C11DB7, initial
+ * value 0xFFFFFFFF, 32-bit words, no final XOR), the same as the STM32 CRC unit.
+ *
+ * @dependencies update_file.h, w25qxx.h, crc32.h, system_config.h
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "update_file.h"
+
+#include "crc32.h"
+#include "w25qxx.h"
+#include "system_config.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define UPDATE_FILE_MAGIC               0x3141544FU // "OTA1"
+#define UPDATE_FILE_CHECKPOINT_PAGES    128         // 32KB, a whole number of sectors
+#define UPDATE_FILE_BLANK_WORD          0xFFFFFFFFU
+
+typedef struct {
+    uint32_t pages;         // Pages committed when the checkpoint was written
+    uint32_t crc;           // Running CRC32 over these pages
+    uint32_t inversePages;  // ~pages
+    uint32_t checkCRC;      // CRC32 of the fields above
+} Checkpoint_t;
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static W25QXX_t *w25qxx = NULL;     // W25QXX flash instance
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static bool Begin(const void* file, uint32_t imageSize, uint32_t imageCRC, uint32_t version);
+static bool WritePage(const void* file, uint32_t page, const void* data, uint32_t size);
+static bool Finish(const void* file);
+static void RestoreProgress(UpdateFile_t* fp);
+static bool AdvanceCommittedPages(UpdateFile_t* fp);
+static bool WriteCheckpoint(UpdateFile_t* fp);
+static bool IsDescriptorValid(const UpdateFileDescriptor_t* descriptor);
+
+static inline uint32_t PageCount(const UpdateFile_t* fp)
+{
+    return (fp->descriptor.imageSize + UPDATE_FILE_PAGE_SIZE - 1) / UPDATE_FILE_PAGE_SIZE;
+}
+
+static inline uint32_t PageSize(const UpdateFile_t* fp, uint32_t page)
+{
+    uint32_t remain = fp->descriptor.imageSize - page * UPDATE_FILE_PAGE_SIZE;
+    return remain < UPDATE_FILE_PAGE_SIZE ? remain : UPDATE_FILE_PAGE_SIZE;
+}
+
+/**
+ * @brief Initialize the firmware update image structure
+ * This function binds the structure to a flash region and restores the
+ * progress of an interrupted transfer from its checkpoints.
+ * @param file pointer to the UpdateFile_t structure to initialize
+ * @param memoryPosition start position of the region, sector aligned
+ * @param memoryLength length of the region, a multiple of the sector size
+ * @return true if initialization was successful, false otherwise
+ */
+bool UpdateFile_Init(UpdateFile_t* file, uint32_t memoryPosition, uint32_t memoryLength)
+{
+    if (file == NULL) return false;
+    if ((memoryPosition % EXT_FLASH_SECTOR_SIZE) != 0 || (memoryLength % EXT_FLASH_SECTOR_SIZE) != 0) return false;
+    if (memoryLength < 2 * EXT_FLASH_SECTOR_SIZE) return false;
+    w25qxx = W25QXX_Init(EXT_FLASH_W25Q128);
+    if (w25qxx == NULL) return false;
+
+    file->Begin = Begin;
+    file->WritePage = WritePage;
+    file->Finish = Finish;
+    file->regionPosition = memoryPosition;
+    file->regionLength = memoryLength;
+    RestoreProgress(file);
+    return true;
+}
+
+/**
+ * @brief Begin receiving an image, or resume it
+ * A transfer of the same image (size, CRC and version) resumes where it is;
+ * any other image restarts from the first page.
+ * @param file pointer to the UpdateFile_t structure
+ * @param imageSize size of the image in bytes
+ * @param imageCRC CRC32 of the whole image
+ * @param version version of the image
+ * @return true if the image fits and the transfer can go on, false otherwise
+ */
+static bool Begin(const void* file, uint32_t imageSize, uint32_t imageCRC, uint32_t version)
+{
+    if (file == NULL) return false;
+    UpdateFile_t* fp = (UpdateFile_t*)file;
+    if (imageSize == 0 || imageSize > fp->regionLength - EXT_FLASH_SECTOR_SIZE) return false;
+    if (fp->isStarted && fp->descriptor.imageSize == imageSize &&
+        fp->descriptor.imageCRC == imageCRC && fp->descriptor.version == version)
+        return true;    // Same image, resume
+
+    // New image: the descriptor sector is rewritten, image sectors are erased on demand
+    UpdateFileDescriptor_t* descriptor = &fp->descriptor;
+    descriptor->magic = UPDATE_FILE_MAGIC;
+    descriptor->imageSize = imageSize;
+    descriptor->imageCRC = imageCRC;
+    descriptor->version = version;
+    descriptor->imagePosition = fp->regionPosition + EXT_FLASH_SECTOR_SIZE;
+    descriptor->descriptorCRC = Crc32(CRC32_INITIAL_VALUE, descriptor, offsetof(UpdateFileDescriptor_t, descriptorCRC));
+    descriptor->reserved = UPDATE_FILE_BLANK_WORD;
+    descriptor->applyFlag = UPDATE_FILE_BLANK_WORD;
+
+    fp->isStarted = false;
+    if (!w25qxx->EraseSector(fp->regionPosition)) return false;
+    w25qxx->Program((uint8_t*)descriptor, fp->regionPosition, offsetof(UpdateFileDescriptor_t, applyFlag));
+    UpdateFileDescriptor_t verify;
+    w25qxx->Read((uint8_t*)&verify, fp->regionPosition, sizeof(verify));
+    if (memcmp(&verify, descriptor, sizeof(verify)) != 0) return false;
+
+    fp->committedPages = 0;
+    fp->runningCRC = CRC32_INITIAL_VALUE;
+    fp->pendingMask = 0;
+    fp->erasedLength = 0;
+    fp->checkpointOffset = sizeof(UpdateFileDescriptor_t);
+    fp->isStarted = true;
+    return true;
+}
+
+/**
+ * @brief Write one page of the image
+ * Pages already committed are accepted and ignored. Pages beyond the
+ * window are rejected.
+ * @param file pointer to the UpdateFile_t structure
+ * @param page index of the page
+ * @param data pointer to the page content
+ * @param size size of the page, UPDATE_FILE_PAGE_SIZE except for the last page
+ * @return true if the page is stored, false otherwise
+ */
+static bool WritePage(const void* file, uint32_t page, const void* data, uint32_t size)
+{
+    if (file == NULL || data == NULL) return false;
+    UpdateFile_t* fp = (UpdateFile_t*)file;
+    if (!fp->isStarted || page >= PageCount(fp) || size != PageSize(fp, page)) return false;
+    if (page < fp->committedPages) return true;     // Retransmission of a committed page
+    uint32_t bit = page - fp->committedPages;
+    if (bit >= UPDATE_FILE_WINDOW_PAGES) return false;
+    if (fp->pendingMask & (1U << bit)) return true; // Retransmission of a pending page
+
+    // Erase the sectors up to this page, they hold nothing of this transfer yet
+    uint32_t end = (page + 1) * UPDATE_FILE_PAGE_SIZE;
+    while (fp->erasedLength < end)
+    {
+        if (!w25qxx->EraseSector(fp->descriptor.imagePosition + fp->erasedLength)) return false;
+        fp->erasedLength += EXT_FLASH_SECTOR_SIZE;
+    }
+    if (!w25qxx->Program((uint8_t*)data, fp->descriptor.imagePosition + page * UPDATE_FILE_PAGE_SIZE, size))
+        return false;
+    fp->pendingMask |= 1U << bit;
+    return AdvanceCommittedPages(fp);
+}
+
+/**
+ * @brief Finish the image and hand it to the bootloader
+ * A complete image whose CRC does not match is discarded: the descriptor
+ * sector is erased with its checkpoints, so neither a resume after a reset
+ * nor the bootloader finds it, and the next Begin restarts the transfer from
+ * the first page. Its image sectors are erased again as the pages arrive.
+ * @param file pointer to the UpdateFile_t structure
+ * @return true if all pages are committed, the CRC matches and the apply
+ * flag is programmed, false otherwise
+ */
+static bool Finish(const void* file)
+{
+    if (file == NULL) return false;
+    UpdateFile_t* fp = (UpdateFile_t*)file;
+    if (!fp->isStarted || fp->committedPages != PageCount(fp)) return false;
+    if (fp->runningCRC != fp->descriptor.imageCRC)
+    {
+        fp->isStarted = false;
+        w25qxx->EraseSector(fp->regionPosition);
+        return false;
+    }
+    if (fp->descriptor.applyFlag == UPDATE_FILE_APPLY_FLAG) return true;
+
+    uint32_t flag = UPDATE_FILE_APPLY_FLAG;
+    w25qxx->Program((uint8_t*)&flag, fp->regionPosition + offsetof(UpdateFileDescriptor_t, applyFlag), sizeof(flag));
+    UpdateFileDescriptor_t verify;
+    w25qxx->Read((uint8_t*)&verify, fp->regionPosition, sizeof(verify));
+    if (verify.applyFlag != UPDATE_FILE_APPLY_FLAG) return false;
+    fp->descriptor.applyFlag = UPDATE_FILE_APPLY_FLAG;
+    return true;
+}
+
+/**
+ * @brief Restore the transfer state from the descriptor sector
+ * The last valid checkpoint gives the committed pages and the running CRC.
+ * Slots torn by a power loss are skipped and never reused.
+ * @param fp pointer to the UpdateFile_t structure
+ */
+static void RestoreProgress(UpdateFile_t* fp)
+{
+    fp->isStarted = false;
+    fp->committedPages = 0;
+    fp->runningCRC = CRC32_INITIAL_VALUE;
+    fp->pendingMask = 0;
+    fp->erasedLength = 0;
+    fp->checkpointOffset = sizeof(UpdateFileDescriptor_t);
+
+    w25qxx->Read((uint8_t*)&fp->descriptor, fp->regionPosition, sizeof(UpdateFileDescriptor_t));
+    if (!IsDescriptorValid(&fp->descriptor)) return;
+    if (fp->descriptor.imageSize == 0 || fp->descriptor.imageSize > fp->regionLength - EXT_FLASH_SECTOR_SIZE) return;
+    if (fp->descriptor.imagePosition != fp->regionPosition + EXT_FLASH_SECTOR_SIZE) return;
+    fp->isStarted = true;
+    if (fp->descriptor.applyFlag == UPDATE_FILE_APPLY_FLAG)
+    {
+        // Verified before the reset, waiting for the bootloader
+        fp->committedPages = PageCount(fp);
+        fp->runningCRC = fp->descriptor.imageCRC;
+        fp->erasedLength = fp->committedPages * UPDATE_FILE_PAGE_SIZE;
+        return;
+    }
+
+    Checkpoint_t checkpoint;
+    for (uint32_t offset = sizeof(UpdateFileDescriptor_t);
+         offset + sizeof(Checkpoint_t) <= EXT_FLASH_SECTOR_SIZE;
+         offset += sizeof(Checkpoint_t))
+    {
+        w25qxx->Read((uint8_t*)&checkpoint, fp->regionPosition + offset, sizeof(checkpoint));
+        if (checkpoint.pages == UPDATE_FILE_BLANK_WORD && checkpoint.crc == UPDATE_FILE_BLANK_WORD &&
+            checkpoint.inversePages == UPDATE_FILE_BLANK_WORD && checkpoint.checkCRC == UPDATE_FILE_BLANK_WORD)
+            break;
+        fp->checkpointOffset = offset + sizeof(Checkpoint_t);
+        if (checkpoint.checkCRC != Crc32(CRC32_INITIAL_VALUE, &checkpoint, offsetof(Checkpoint_t, checkCRC))) continue;
+        if (checkpoint.inversePages != ~checkpoint.pages || checkpoint.pages > PageCount(fp)) continue;
+        fp->committedPages = checkpoint.pages;
+        fp->runningCRC = checkpoint.crc;
+    }
+    // Pages after the checkpoint may be partly written, their sectors are erased again
+    fp->erasedLength = fp->committedPages * UPDATE_FILE_PAGE_SIZE;
+}
+
+/**
+ * @brief Commit the contiguous pages at the start of the window
+ * Each page is read back from flash into the running CRC32.
+ * @param fp pointer to the UpdateFile_t structure
+ * @return true if successful, false if a checkpoint could not be written
+ */
+static bool AdvanceCommittedPages(UpdateFile_t* fp)
+{
+    uint8_t buffer[UPDATE_FILE_PAGE_SIZE];
+    bool result = true;
+    while (fp->pendingMask & 1U)
+    {
+        uint32_t size = PageSize(fp, fp->committedPages);
+        w25qxx->Read(buffer, fp->descriptor.imagePosition + fp->committedPages * UPDATE_FILE_PAGE_SIZE, size);
+        fp->runningCRC = Crc32(fp->runningCRC, buffer, size);
+        fp->committedPages++;
+        fp->pendingMask >>= 1;
+        if (fp->committedPages % UPDATE_FILE_CHECKPOINT_PAGES == 0)
+            result &= WriteCheckpoint(fp);
+    }
+    return result;
+}
+
+/**
+ * @brief Append a checkpoint of the committed pages to the descriptor sector
+ * @param fp pointer to the UpdateFile_t structure
+ * @return true if the checkpoint is written, false otherwise
+ */
+static bool WriteCheckpoint(UpdateFile_t* fp)
+{
+    if (fp->checkpointOffset + sizeof(Checkpoint_t) > EXT_FLASH_SECTOR_SIZE) return false;
+    Checkpoint_t checkpoint;
+    checkpoint.pages = fp->committedPages;
+    checkpoint.crc = fp->runningCRC;
+    checkpoint.inversePages = ~fp->committedPages;
+    checkpoint.checkCRC = Crc32(CRC32_INITIAL_VALUE, &checkpoint, offsetof(Checkpoint_t, checkCRC));
+    bool result = w25qxx->Program((uint8_t*)&checkpoint, fp->regionPosition + fp->checkpointOffset, sizeof(checkpoint));
+    fp->checkpointOffset += sizeof(Checkpoint_t);
+    return result;
+}
+
+/**
+ * @brief Check the magic and CRC of a descriptor
+ * @param descriptor pointer to the descriptor read from flash
+ * @return true if the descriptor is valid, false otherwise
+ */
+static bool IsDescriptorValid(const UpdateFileDescriptor_t* descriptor)
+{
+    if (descriptor->magic != UPDATE_FILE_MAGIC) return false;
+    uint32_t crc = Crc32(CRC32_INITIAL_VALUE, descriptor, offsetof(UpdateFileDescriptor_t, descriptorCRC));
+    return crc == descriptor->descriptorCRC;
+}
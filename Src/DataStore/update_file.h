@@ -0,0 +1,104 @@
+/**
+ * @file update_file.h
+ * @brief Interface definition for the firmware update image on external SPI flash.
+ *
+ * @details Declares the `UpdateFile_t` control structure used to receive a
+ * firmware image into the EXT_FLASH_OTA_FILE region page by page. Pages may
+ * arrive out of order inside a small window; they are programmed as they
+ * arrive and verified in order by reading them back into a running CRC32.
+ * Progress is checkpointed in flash so an interrupted transfer resumes, and a
+ * separately programmed apply flag hands a verified image to the bootloader.
+ *
+ * Responsibilities:
+ *  - Describe the runtime state of one update image.
+ *  - Publish function pointers to begin (or resume), write and finish an image.
+ *  - Provide the initialization API which restores the progress from flash.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UPDATE_FILE_PAGE_SIZE       256     // Size of one image page in bytes, the flash page size
+#define UPDATE_FILE_WINDOW_PAGES    32      // Pages accepted ahead of the first missing page
+#define UPDATE_FILE_APPLY_FLAG      0x41505059U // "YPPA", programmed once the image is verified
+
+/**
+ * @brief Image descriptor stored at the start of the region
+ * The bootloader applies the image when magic, descriptorCRC and applyFlag are
+ * valid and the image CRC matches, then erases the descriptor sector.
+ */
+typedef struct {
+    uint32_t magic;         // UPDATE_FILE_MAGIC
+    uint32_t imageSize;     // Size of the image in bytes
+    uint32_t imageCRC;      // CRC32 of the whole image
+    uint32_t version;       // Version of the image, opaque to the firmware
+    uint32_t imagePosition; // Flash address of the first image byte
+    uint32_t descriptorCRC; // CRC32 of the fields above
+    uint32_t reserved;      // Left erased
+    uint32_t applyFlag;     // UPDATE_FILE_APPLY_FLAG once verified, programmed separately
+} UpdateFileDescriptor_t;
+
+/**
+ * @brief Structure for firmware update image operations
+ */
+typedef struct {
+    uint32_t regionPosition;    // Start position of the region, holds the descriptor sector
+    uint32_t regionLength;      // Length of the region in the flash memory
+    UpdateFileDescriptor_t descriptor;  // Descriptor of the image being received
+    bool isStarted;             // True once Begin accepted an image
+    uint32_t committedPages;    // Pages verified in order, the next missing page
+    uint32_t runningCRC;        // CRC32 state over the committed pages
+    uint32_t pendingMask;       // Bit n set when page committedPages + n is written
+    uint32_t erasedLength;      // Image bytes whose sectors are erased
+    uint32_t checkpointOffset;  // Offset of the next free checkpoint slot in the descriptor sector
+
+    /**
+     * @brief Begin receiving an image, or resume it
+     * A transfer of the same image (size, CRC and version) resumes from its
+     * last checkpoint; any other image restarts from the first page.
+     * @param file pointer to the UpdateFile_t structure
+     * @param imageSize size of the image in bytes
+     * @param imageCRC CRC32 of the whole image
+     * @param version version of the image
+     * @return true if the image fits and the transfer can go on, false otherwise
+     */
+    bool (*Begin)(const void*, uint32_t, uint32_t, uint32_t);
+
+    /**
+     * @brief Write one page of the image
+     * Pages already committed are accepted and ignored. Pages beyond the
+     * window are rejected.
+     * @param file pointer to the UpdateFile_t structure
+     * @param page index of the page
+     * @param data pointer to the page content
+     * @param size size of the page, UPDATE_FILE_PAGE_SIZE except for the last page
+     * @return true if the page is stored, false otherwise
+     */
+    bool (*WritePage)(const void*, uint32_t, const void*, uint32_t);
+
+    /**
+     * @brief Finish the image and hand it to the bootloader
+     * An image whose CRC does not match is discarded with its checkpoints.
+     * @param file pointer to the UpdateFile_t structure
+     * @return true if all pages are committed, the CRC matches and the apply
+     * flag is programmed, false otherwise
+     */
+    bool (*Finish)(const void*);
+} UpdateFile_t;
+
+/**
+ * @brief Initialize the firmware update image structure
+ * This function binds the structure to a flash region and restores the
+ * progress of an interrupted transfer from its checkpoints.
+ * @param file pointer to the UpdateFile_t structure to initialize
+ * @param memoryPosition start position of the region, sector aligned
+ * @param memoryLength length of the region, a multiple of the sector size
+ * @return true if initialization was successful, false otherwise
+ */
+bool UpdateFile_Init(UpdateFile_t *file, uint32_t memoryPosition, uint32_t memoryLength);
@@ -3,20 +3,16 @@
 #include "pid.h"
 #include "kalman_filter.h"
 #include "system_config.h"
+#include "data_store.h"
 
 /* ------------------ Definitions --------------------*/
 // PI
 #define PI 3.14159265358979323846
-// The sum of the edge counts of the A and B phases of the encoder for every turn of the reducer.
-#define EDGE_PER_ROUND	(13*30*4) // 13 pulses per turn, 30:1 reducer, 4 edges per pulse
-// PID parameters
-#define KP  0.1f
-#define KI  0.01f
-#define KD  0.01f
-// Kalman parameter
+// Gains, filters and encoder resolution come from the data store (defaults in system_config.h)
+// Feed-forward model of the duty needed for a wheel speed: friction, back-EMF, inertia
+#define FF_MIN_SPEED 0.05f      // Below this target in rad/s no friction term is applied
+// Initial variance of the Kalman estimate, the noise variances are configured
 #define KALMAN_ESTIMATE_VARIANCE    8.0f
-#define KALMAN_MEASURE_VARIANCE     1.0f
-#define KALMAN_PROCESS_VARIANCE     0.1f
 // Encoder timer tick frequency
 #define ENCODE_TIMER_FREQUENCY  4200000.0f
 // Encoder timer period
@@ -31,15 +27,34 @@ static void PeriodCallback(void);
 static void InputCaptureCallback(int32_t motorID, int32_t channelID, int32_t captureCounter, int32_t edge, int32_t pairLevel);
 static void Encoder0_OverflowCallback(void);
 static void Encoder1_OverflowCallback(void);
+static void AdoptConfig(uint32_t motorId);
+static void ResetController(uint32_t motorId);
+static float FeedForward(const DataStore_MotorGains_t *gains, float speed, float acceleration);
 
 /* ---------------- Static variables ------------------ */
 static int64_t encoderPosition[TOTAL_MOTOR_NUMBER];
 static PID_t pid[TOTAL_MOTOR_NUMBER];
+// Configuration used by the control period
+static DCMotor_Config_t config[TOTAL_MOTOR_NUMBER];
+static float radiansPerCount[TOTAL_MOTOR_NUMBER];
+// Configuration written by threads, adopted at the start of the next control period
+static DCMotor_Config_t pendingConfig[TOTAL_MOTOR_NUMBER];
+static volatile bool isConfigPending[TOTAL_MOTOR_NUMBER];
+// Motors driven by the identification routine, their PID is suspended
+static volatile bool isTuning[TOTAL_MOTOR_NUMBER];
+// Motors restarted after a park, their next encoder delta spans the park
+static bool isResuming[TOTAL_MOTOR_NUMBER];
+// Target speed of the previous period, its change gives the profiled acceleration
+static float lastTargetSpeed[TOTAL_MOTOR_NUMBER];
+// Acceleration in the current feed-forward, to rebuild it with new gains
+static float lastTargetAcceleration[TOTAL_MOTOR_NUMBER];
 static KalmanFilter_t filter[TOTAL_MOTOR_NUMBER];
 // Angular velocity measured by encoders after passing a Kalman filter.
 static float measuredAngularSpeed[TOTAL_MOTOR_NUMBER];
 // Motor's encoder overflow counter
 static int32_t encoderOverflowCounter[TOTAL_MOTOR_NUMBER];
+// Receives the encoder deltas of every control period
+static DCMotor_EncoderCallback_t EncoderCallback;
 
 /**
  * @brief Initialize the DC Motor control system
@@ -50,8 +65,13 @@ void DCMotor_Init(void)
 {
     for (int i = 0; i < TOTAL_MOTOR_NUMBER; i++)
     {
-        PID_Init(&pid[i], KP, KI, KD);
-        KalmanFilter_Init(&filter[i], KALMAN_ESTIMATE_VARIANCE, KALMAN_MEASURE_VARIANCE, KALMAN_PROCESS_VARIANCE);
+        DataStore_GetMotorGains(i, &config[i].gains);
+        DataStore_GetMotorFilter(i, &config[i].filter);
+        config[i].encoderResolution = DataStore_GetEncoderResolution(i);
+        if (config[i].encoderResolution == 0) config[i].encoderResolution = DEFAULT_ENCODER_RESOLUTION;
+        radiansPerCount[i] = (float)(2.0 * PI / config[i].encoderResolution);
+        ResetController(i);
+        KalmanFilter_Init(&filter[i], KALMAN_ESTIMATE_VARIANCE, config[i].filter.measureVariance, config[i].filter.processVariance);
     }
     Timer_RegisterEncoderOverflowCallback(0, Encoder0_OverflowCallback);
     Timer_RegisterEncoderOverflowCallback(1, Encoder1_OverflowCallback);
@@ -66,17 +86,50 @@ void DCMotor_Init(void)
  */
 int64_t DCMotor_ReadEncoder(uint32_t motorId)
 {
-    return encoderPosition[motorId];
+    // The control period writes the 64 bit value in two words
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    int64_t position = encoderPosition[motorId];
+    __set_PRIMASK(primask);
+    return position;
 }
 
 /**
  * @brief Set the angular speed of the motor
+ * The duty predicted by the motor model is fed forward, the PID only corrects
+ * the error of the model. The acceleration term uses the change of the target
+ * over one control period, which the motion profiler keeps smooth.
+ * The gains are read with interrupts masked: the control period may adopt
+ * new ones meanwhile.
  * @param motorId The ID of the motor
  * @param angularSpeed The desired angular speed in rad/s
  */
 void DCMotor_SetAngularSpeed(uint32_t motorId, float angularSpeed)
 {
+    if (motorId >= TOTAL_MOTOR_NUMBER) return;
+    float acceleration = (angularSpeed - lastTargetSpeed[motorId]) / PID_CONTROL_PERIOD_S;
+    lastTargetSpeed[motorId] = angularSpeed;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    lastTargetAcceleration[motorId] = acceleration;
+    PID_SetFeedForward(&pid[motorId], FeedForward(&config[motorId].gains, angularSpeed, acceleration));
     PID_SetObject(&pid[motorId], angularSpeed);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Duty predicted by the motor model
+ * @param gains Pointer to the feed-forward gains
+ * @param speed Target angular speed in rad/s
+ * @param acceleration Target angular acceleration in rad/s^2
+ * @return Feed-forward duty
+ */
+float FeedForward(const DataStore_MotorGains_t *gains, float speed, float acceleration)
+{
+    float feedForward = gains->ffKv * speed + gains->ffKa * acceleration;
+    if (speed > FF_MIN_SPEED) feedForward += gains->ffKs;
+    else if (speed < -FF_MIN_SPEED) feedForward -= gains->ffKs;
+    return feedForward;
 }
 
 /**
@@ -85,21 +138,218 @@ void DCMotor_SetAngularSpeed(uint32_t motorId, float angularSpeed)
  */
 static void PeriodCallback(void)
 {
+    int32_t deltaCounts[TOTAL_MOTOR_NUMBER];
+    uint32_t timestamp = DWT->CYCCNT;   // Time of the encoder sampling
     for (int i = 0; i < TOTAL_MOTOR_NUMBER; ++i)
     {
+        // Adopt a new configuration between two periods
+        if (isConfigPending[i]) AdoptConfig(i);
         // Read the encoder value
         int64_t position = (int64_t)Timer_ReadEncoder(i) + encoderOverflowCounter[i] * 0x10000;
         // Calculate the position difference
         int64_t deltaPosition = position - encoderPosition[i];
         encoderPosition[i] = position;
+        deltaCounts[i] = (int32_t)deltaPosition;
         // Calculate the angular speed in rad/s
-        float angularSpeed = (float)deltaPosition * (2.0f * PI * (float)PID_CONTROL_FREQUENCY  / (float)EDGE_PER_ROUND);
-        // Apply Kalman filter to the measured angular speed
-        measuredAngularSpeed[i] = KalmanFilter_Calc(&filter[i], angularSpeed);
-        // PID control
+        float angularSpeed = (float)deltaPosition * radiansPerCount[i] * (float)PID_CONTROL_FREQUENCY;
+        // Apply Kalman filter to the measured angular speed, the first period after a park has none
+        if (isResuming[i]) isResuming[i] = false;
+        else measuredAngularSpeed[i] = KalmanFilter_Calc(&filter[i], angularSpeed);
+        // PID control, unless the identification routine drives the motor
+        if (isTuning[i]) continue;
         float output = PID_Calc(&pid[i], measuredAngularSpeed[i]);
         Timer_PWM_SetDuty(i, output);
     }
+    if (EncoderCallback != NULL) EncoderCallback(deltaCounts, timestamp);
+}
+
+/**
+ * @brief Register the receiver of the encoder deltas
+ * The callback runs in the TIM7 interrupt at every control period, right
+ * after the encoders are read; it must be short.
+ * @param callback function receiving the counts of each motor since the last
+ *        period and the DWT cycle counter when they were read
+ * @return true if registered, false if a callback is already registered
+ */
+bool DCMotor_RegisterEncoderCallback(DCMotor_EncoderCallback_t callback)
+{
+    if (EncoderCallback != NULL) return false;
+    EncoderCallback = callback;
+    return true;
+}
+
+/**
+ * @brief Get the configuration of a motor
+ * A configuration set but not adopted yet is returned.
+ * @param motorId The ID of the motor
+ * @param motorConfig Pointer to the configuration to fill
+ * @return true if the motor exists, false otherwise
+ */
+bool DCMotor_GetConfig(uint32_t motorId, DCMotor_Config_t* motorConfig)
+{
+    if (motorId >= TOTAL_MOTOR_NUMBER || motorConfig == NULL) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *motorConfig = isConfigPending[motorId] ? pendingConfig[motorId] : config[motorId];
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Set the configuration of a motor
+ * The control period adopts it at its next start: the PID keeps its output
+ * and the speed filter its estimate, so the wheel does not jerk.
+ * @param motorId The ID of the motor
+ * @param motorConfig Pointer to the configuration
+ * @return true if the motor exists and the resolution is valid, false otherwise
+ */
+bool DCMotor_SetConfig(uint32_t motorId, const DCMotor_Config_t* motorConfig)
+{
+    if (motorId >= TOTAL_MOTOR_NUMBER || motorConfig == NULL || motorConfig->encoderResolution == 0) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pendingConfig[motorId] = *motorConfig;
+    isConfigPending[motorId] = true;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Set the controller gains of a motor
+ * Adopted at the start of the next control period, like DCMotor_SetConfig.
+ * @param motorId The ID of the motor
+ * @param newGains Pointer to the gains
+ * @return true if the motor exists, false otherwise
+ */
+bool DCMotor_SetGains(uint32_t motorId, const DataStore_MotorGains_t* newGains)
+{
+    DCMotor_Config_t motorConfig;
+    if (newGains == NULL || !DCMotor_GetConfig(motorId, &motorConfig)) return false;
+    motorConfig.gains = *newGains;
+    return DCMotor_SetConfig(motorId, &motorConfig);
+}
+
+/**
+ * @brief Adopt the pending configuration of a motor
+ * Runs in the control period, before the speed is measured. The feed-forward
+ * of the current target is rebuilt with the new gains and, like the PID
+ * gains, handed over without a step of the output.
+ * @param motorId The ID of the motor
+ */
+void AdoptConfig(uint32_t motorId)
+{
+    const DCMotor_Config_t *next = &pendingConfig[motorId];
+    PID_SetGains(&pid[motorId], next->gains.kP, next->gains.kI, next->gains.kD);
+    PID_ChangeFeedForward(&pid[motorId], FeedForward(&next->gains, (float)pid[motorId].object, lastTargetAcceleration[motorId]));
+    PID_SetOutputLimits(&pid[motorId], -1.0f, 1.0f, next->filter.antiWindupGain);
+    PID_SetDerivativeFilter(&pid[motorId], next->filter.derivativeAlpha);
+    KalmanFilter_SetVariances(&filter[motorId], next->filter.measureVariance, next->filter.processVariance);
+    radiansPerCount[motorId] = (float)(2.0 * PI / next->encoderResolution);
+    config[motorId] = *next;
+    isConfigPending[motorId] = false;
+}
+
+/**
+ * @brief Restart the PID of a motor from a clean state
+ * The target and the feed-forward are kept. Interrupts must be disabled or
+ * the control period not running.
+ * @param motorId The ID of the motor
+ */
+void ResetController(uint32_t motorId)
+{
+    const DCMotor_Config_t *c = &config[motorId];
+    float object = (float)pid[motorId].object;
+    float feedForward = pid[motorId].feedForward;
+    PID_Init(&pid[motorId], c->gains.kP, c->gains.kI, c->gains.kD);
+    PID_SetOutputLimits(&pid[motorId], -1.0f, 1.0f, c->filter.antiWindupGain); // Same range as Timer_PWM_SetDuty
+    PID_SetDerivativeFilter(&pid[motorId], c->filter.derivativeAlpha);
+    PID_SetFeedForward(&pid[motorId], feedForward);
+    PID_SetObject(&pid[motorId], object);
+}
+
+/**
+ * @brief Hand a motor over to the identification routine or take it back
+ * While tuning, the PID does not drive the motor; the encoder and the
+ * measured speed keep being updated. Taking the motor back stops it and
+ * restarts its PID from a clean state.
+ * @param motorId The ID of the motor
+ * @param tuning true to suspend the PID, false to resume it
+ */
+void DCMotor_SetTuningMode(uint32_t motorId, bool tuning)
+{
+    if (motorId >= TOTAL_MOTOR_NUMBER) return;
+    if (tuning)
+    {
+        isTuning[motorId] = true;
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Timer_PWM_SetDuty(motorId, 0.0f);
+    ResetController(motorId);
+    isTuning[motorId] = false;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Stop driving the motors before the control period is stopped
+ * The duties are set to zero. Refused while the identification routine
+ * drives a motor, it needs the control period.
+ * @return true if the motors are released, false if a motor is tuning
+ */
+bool DCMotor_Park(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (int i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!isTuning[i]) continue;
+        __set_PRIMASK(primask);
+        return false;
+    }
+    for (int i = 0; i < TOTAL_MOTOR_NUMBER; i++) Timer_PWM_SetDuty(i, 0.0f);
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Prepare the motors for the control period to restart after a park
+ * The PIDs restart from a clean state and the speed filters from rest. The
+ * first period spans the whole park, the speed of its encoder delta is not
+ * measured. Must be called before the control period is started again.
+ */
+void DCMotor_Resume(void)
+{
+    for (int i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        ResetController(i);
+        KalmanFilter_Init(&filter[i], KALMAN_ESTIMATE_VARIANCE, config[i].filter.measureVariance, config[i].filter.processVariance);
+        measuredAngularSpeed[i] = 0.0f;
+        isResuming[i] = true;
+    }
+}
+
+/**
+ * @brief Read the current encoder position of the motor
+ * Unlike DCMotor_ReadEncoder, the counter is read now instead of at the
+ * last control period. Must be called from the TIM7 interrupt, which does
+ * not preempt the encoder overflow interrupts.
+ * @param motorId The ID of the motor
+ * @return The encoder position in counts
+ */
+int64_t DCMotor_SampleEncoder(uint32_t motorId)
+{
+    return (int64_t)Timer_ReadEncoder(motorId) + encoderOverflowCounter[motorId] * 0x10000;
+}
+
+/**
+ * @brief Get the wheel rotation of one encoder count
+ * @param motorId The ID of the motor
+ * @return The angle of one encoder count in rad
+ */
+float DCMotor_GetRadiansPerCount(uint32_t motorId)
+{
+    return radiansPerCount[motorId];
 }
 
 /**
@@ -113,28 +363,23 @@ float DCMotor_GetAngularSpeed(uint32_t motorId)
 }
 
 /**
- * @brief Get the encoder value of the motor
+ * @brief Get the target angular speed of the motor
  * @param motorId The ID of the motor
- * @return The encoder value in rounds
+ * @return The angular speed set by DCMotor_SetAngularSpeed in rad/s
  */
-inline float DCMotor_GetEncoderValue(uint32_t motorId)
+float DCMotor_GetTargetAngularSpeed(uint32_t motorId)
 {
-    return (float)encoderPosition[motorId] / (float)EDGE_PER_ROUND; // Convert encoder counts to rounds
+    return (float)pid[motorId].object;
 }
 
 /**
- * @brief Reset all motor encoders to zero
- * This function resets the encoder positions and overflow counters for all motors.
+ * @brief Get the encoder value of the motor
+ * @param motorId The ID of the motor
+ * @return The encoder value in rounds
  */
-void DCMotor_ResetEncoders(void)
+inline float DCMotor_GetEncoderValue(uint32_t motorId)
 {
-    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; ++i)
-    {
-        encoderOverflowCounter[i] = 0;
-        encoderPosition[i] = 0;
-        measuredAngularSpeed[i] = 0.0f;
-        KalmanFilter_Init(&filter[i], KALMAN_ESTIMATE_VARIANCE, KALMAN_MEASURE_VARIANCE, KALMAN_PROCESS_VARIANCE);
-    }
+    return (float)encoderPosition[motorId] * radiansPerCount[motorId] / (float)(2.0 * PI); // Convert encoder counts to rounds
 }
 
 /**
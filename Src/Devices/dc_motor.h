@@ -1,10 +1,38 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "data_store.h"
+
+/**
+ * @brief Receiver of the encoder deltas of a control period
+ * @param deltaCounts counts of each motor since the last period
+ * @param timestamp DWT cycle counter when the encoders were read
+ */
+typedef void (*DCMotor_EncoderCallback_t)(const int32_t* deltaCounts, uint32_t timestamp);
+
+/**
+ * @brief Configuration of one wheel motor, changeable while running
+ */
+typedef struct {
+    DataStore_MotorGains_t gains;
+    DataStore_MotorFilter_t filter;
+    uint32_t encoderResolution;     // Encoder edges per wheel revolution, both phases
+} DCMotor_Config_t;
 
 void DCMotor_Init();
 int64_t DCMotor_ReadEncoder(uint32_t motorId);
 void DCMotor_SetAngularSpeed(uint32_t motorId, float angularSpeed);
 float DCMotor_GetAngularSpeed(uint32_t motorId);
+float DCMotor_GetTargetAngularSpeed(uint32_t motorId);
 float DCMotor_GetEncoderValue(uint32_t motorId);
-void DCMotor_ResetEncoders(void);
\ No newline at end of file
+bool DCMotor_GetConfig(uint32_t motorId, DCMotor_Config_t* config);
+bool DCMotor_SetConfig(uint32_t motorId, const DCMotor_Config_t* config);
+bool DCMotor_SetGains(uint32_t motorId, const DataStore_MotorGains_t* gains);
+void DCMotor_SetTuningMode(uint32_t motorId, bool tuning);
+bool DCMotor_Park(void);
+void DCMotor_Resume(void);
+int64_t DCMotor_SampleEncoder(uint32_t motorId);
+float DCMotor_GetRadiansPerCount(uint32_t motorId);
+bool DCMotor_RegisterEncoderCallback(DCMotor_EncoderCallback_t callback);
@@ -0,0 +1,297 @@
+/**
+ * @file dc_motor_tuning.c
+ * @brief Identification of the wheel motors and computation of their gains
+ *
+ * @details
+ *  - Excitation: the TIM7 tick callback drives the duty of each selected
+ *    motor, first SETTLE_SAMPLES ms at the bias to reach a steady speed, then
+ *    a 63 bit maximum length sequence (6 bit LFSR) of BIT_SAMPLES ms per bit,
+ *    bias +/- amplitude. The encoder is read every ms. The duty stays of one
+ *    sign so the friction acts as a constant offset.
+ *  - Fit: output error. The counts are summed over FIT_DECIMATION ms to get
+ *    the speed. For each time constant T and dead time d of a grid, the duty
+ *    is simulated through the model from rest; gain K and friction enter
+ *    linearly and are solved by least squares. The pair with the smallest
+ *    error wins. Fitting the simulated output instead of a difference
+ *    equation keeps the encoder quantisation out of the regressors, where
+ *    it would bias the time constant.
+ *  - Cost: 76 time constants x 11 dead times, each a pass over the 604
+ *    samples. The normal equations are summed in double, which the M4 does
+ *    in software: about 80 M cycles, half a second per motor at 168 MHz.
+ *    In float, the cancellation in sww - p sxw - q syw blurs the residuals
+ *    enough to pick a worse grid point (friction off by 10 % in simulation).
+ *  - The counts of each ms are kept as int16, a ms of encoder edges stays far
+ *    below its range at any wheel speed: 2 motors x 604 samples x 2 bytes,
+ *    2.4 KB of static RAM instead of 4.8 KB in int32, for a buffer the whole
+ *    identification needs at once.
+ *  - Gains: SIMC rules for a PI on a first order plus dead time plant, with
+ *    the dead time increased by the 20 ms control period and the filtering
+ *    (1.5 periods). Closed loop time constant equal to that dead time.
+ *    Feed-forward Kv = 1 / K, Ka = T / K, Ks = friction.
+ *
+ * @dependencies dc_motor, timer, data_store
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "dc_motor_tuning.h"
+
+#include "main.h"
+#include "dc_motor.h"
+#include "timer.h"
+#include "system_config.h"
+
+#include <math.h>
+#include <string.h>
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define SETTLE_SAMPLES      100     // ms at the bias before the sequence
+#define BIT_SAMPLES         8       // ms per bit of the sequence
+#define SEQUENCE_BITS       63      // Length of the 6 bit maximum length sequence
+#define TOTAL_SAMPLES       (SETTLE_SAMPLES + SEQUENCE_BITS * BIT_SAMPLES)
+#define FIT_DECIMATION      4       // ms summed per speed sample of the fit
+#define MAX_DEAD_TIME       10      // Longest dead time tried, in ms
+#define MIN_TIME_CONSTANT   0.01f   // Time constants tried, in s, from ...
+#define MAX_TIME_CONSTANT   0.4f    // ... to ...
+#define TIME_CONSTANT_STEP  1.05f   // ... in steps of 5 %
+#define SAMPLE_PERIOD_S     0.001f  // TIM7 tick
+#define CONTROL_PERIOD_S    0.02f   // Period of the wheel PID
+#define CONTROL_DELAY_S     (1.5f * CONTROL_PERIOD_S)   // Sample and hold plus speed filter, added to the dead time
+
+typedef enum {
+    TUNING_IDLE = 0,
+    TUNING_RUNNING,
+    TUNING_DONE,
+} TuningState_t;
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static volatile TuningState_t state = TUNING_IDLE;
+static uint32_t activeMask;
+static float bias, amplitude;
+static uint64_t sequence;                   // Bit i is the level of the sequence bit i
+static uint32_t sampleIndex;
+static int64_t lastPosition[TOTAL_MOTOR_NUMBER];
+static int16_t counts[TOTAL_MOTOR_NUMBER][TOTAL_SAMPLES];   // Encoder counts of each ms, clamped to int16
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static void TickCallback(uint32_t tick);
+static float Duty(uint32_t sample);
+static bool Fit(uint32_t motorId, float timeConstant, uint32_t deadTime, DataStore_MotorModel_t *model, double *residual, double *variance);
+
+/**
+ * @brief Initialize the tuning routine
+ * This function registers the excitation on the TIM7 tick.
+ * @return true if successful, false otherwise
+ */
+bool DCMotorTuning_Init(void)
+{
+    // x^6 + x^5 + 1, maximum length 63
+    uint32_t lfsr = 0x3F;
+    sequence = 0;
+    for (uint32_t i = 0; i < SEQUENCE_BITS; i++)
+    {
+        if (lfsr & 1U) sequence |= 1ULL << i;
+        uint32_t bit = ((lfsr >> 0) ^ (lfsr >> 1)) & 1U;
+        lfsr = (lfsr >> 1) | (bit << 5);
+    }
+    return Timer_RegisterTickCallback(TickCallback);
+}
+
+/**
+ * @brief Start the excitation of the selected motors
+ * The motors must be at rest with a zero target. The routine takes about
+ * 0.6 s, then the motors are stopped and given back to their PID.
+ * @param motorMask one bit per motor, bit 0 for motor 0
+ * @param newBias duty the excitation is centred on, 0 for the default
+ * @param newAmplitude duty added or removed by the excitation, 0 for the default
+ * @return true if started, false if busy, a motor is moving or the arguments are invalid
+ */
+bool DCMotorTuning_Start(uint32_t motorMask, float newBias, float newAmplitude)
+{
+    motorMask &= (1U << TOTAL_MOTOR_NUMBER) - 1;
+    if (motorMask == 0 || state == TUNING_RUNNING) return false;
+    if (newBias == 0.0f) newBias = DC_MOTOR_TUNING_DEFAULT_BIAS;
+    if (newAmplitude == 0.0f) newAmplitude = DC_MOTOR_TUNING_DEFAULT_AMPLITUDE;
+    // Keep the duty of one sign and inside the PWM range
+    if (fabsf(newAmplitude) >= fabsf(newBias) || fabsf(newBias) + fabsf(newAmplitude) > 1.0f) return false;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (DCMotor_GetTargetAngularSpeed(i) != 0.0f) return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    activeMask = motorMask;
+    bias = newBias;
+    amplitude = fabsf(newAmplitude);
+    sampleIndex = 0;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!(motorMask & (1U << i))) continue;
+        DCMotor_SetTuningMode(i, true);
+        lastPosition[i] = DCMotor_SampleEncoder(i);
+        Timer_PWM_SetDuty(i, Duty(0));
+    }
+    state = TUNING_RUNNING;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Check whether the excitation is running
+ * @return true while the motors are driven by the routine
+ */
+bool DCMotorTuning_IsRunning(void)
+{
+    return state == TUNING_RUNNING;
+}
+
+/**
+ * @brief Fit the model of a motor and compute its gains
+ * Must be called from a thread once the excitation is over.
+ * @param motorId The ID of the motor
+ * @param result Pointer to the result to fill
+ * @return true if the result is valid, false otherwise
+ */
+bool DCMotorTuning_GetResult(uint32_t motorId, DCMotorTuning_Result_t *result)
+{
+    if (result == NULL) return false;
+    memset(result, 0, sizeof(DCMotorTuning_Result_t));
+    if (motorId >= TOTAL_MOTOR_NUMBER || state != TUNING_DONE || !(activeMask & (1U << motorId))) return false;
+
+    // Grid search of the time constant and the dead time, gain and friction are linear
+    double bestResidual = -1.0, variance = 0.0;
+    DataStore_MotorModel_t *model = &result->model;
+    for (float timeConstant = MIN_TIME_CONSTANT; timeConstant <= MAX_TIME_CONSTANT; timeConstant *= TIME_CONSTANT_STEP)
+    {
+        for (uint32_t d = 0; d <= MAX_DEAD_TIME; d++)
+        {
+            DataStore_MotorModel_t candidate;
+            double residual;
+            if (!Fit(motorId, timeConstant, d, &candidate, &residual, &variance)) continue;
+            if (bestResidual >= 0.0 && residual >= bestResidual) continue;
+            *model = candidate;
+            bestResidual = residual;
+        }
+    }
+    if (bestResidual < 0.0 || variance <= 0.0) return false;
+    result->fitQuality = (float)(1.0 - bestResidual / variance);
+    if (model->gain <= 0.0f || result->fitQuality < DC_MOTOR_TUNING_MIN_FIT_QUALITY) return false;
+
+    // SIMC PI tuning with the control delay, tight closed loop time constant equal to the delay
+    float theta = model->deadTime + CONTROL_DELAY_S;
+    float tauC = theta;
+    float kc = model->timeConstant / (model->gain * (tauC + theta));
+    float tauI = fminf(model->timeConstant, 4.0f * (tauC + theta));
+    DataStore_MotorGains_t *gains = &result->gains;
+    gains->kP = kc;
+    gains->kI = kc * CONTROL_PERIOD_S / tauI;
+    gains->kD = 0.0f;
+    gains->ffKs = model->friction > 0.0f ? model->friction : 0.0f;
+    gains->ffKv = 1.0f / model->gain;
+    gains->ffKa = model->timeConstant / model->gain;
+    result->isValid = true;
+    return true;
+}
+
+/**
+ * @brief TIM7 tick callback
+ * This function runs in the TIM7 interrupt every ms, records the encoder
+ * counts of the last ms and sets the duty of the next one.
+ * @param tick number of ms since the tick started, not used
+ */
+void TickCallback(uint32_t tick)
+{
+    (void)tick;
+    if (state != TUNING_RUNNING) return;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!(activeMask & (1U << i))) continue;
+        int64_t position = DCMotor_SampleEncoder(i);
+        int64_t delta = position - lastPosition[i];
+        lastPosition[i] = position;
+        counts[i][sampleIndex] = (int16_t)(delta > INT16_MAX ? INT16_MAX : (delta < INT16_MIN ? INT16_MIN : delta));
+    }
+    sampleIndex++;
+    bool isOver = sampleIndex >= TOTAL_SAMPLES;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!(activeMask & (1U << i))) continue;
+        if (isOver) DCMotor_SetTuningMode(i, false);
+        else Timer_PWM_SetDuty(i, Duty(sampleIndex));
+    }
+    if (isOver) state = TUNING_DONE;
+}
+
+/**
+ * @brief Duty applied during a sample
+ * @param sample index of the sample, in ms from the start
+ * @return the duty
+ */
+float Duty(uint32_t sample)
+{
+    if (sample < SETTLE_SAMPLES) return bias;
+    uint32_t bit = (sample - SETTLE_SAMPLES) / BIT_SAMPLES;
+    if (bit >= SEQUENCE_BITS) return 0.0f;
+    return (sequence & (1ULL << bit)) ? bias + amplitude : bias - amplitude;
+}
+
+/**
+ * @brief Output error of a first order plus dead time model
+ * The model speed is w = K x - K f y, where x is the duty and y a unit step,
+ * both passed through the dead time and the first order lag from rest at the
+ * start of the excitation. K and the friction f enter linearly and are solved
+ * by least squares; the error is measured on the speed of each interval of
+ * FIT_DECIMATION ms, so the encoder quantisation only acts as output noise.
+ * @param motorId The ID of the motor
+ * @param timeConstant time constant of the model in s
+ * @param deadTime dead time of the model in ms
+ * @param model returns the gain and the friction of the best fit
+ * @param residual returns the sum of the squared errors
+ * @param variance returns the sum of the squared deviations of the speed from its mean
+ * @return true if the system could be solved, false otherwise
+ */
+bool Fit(uint32_t motorId, float timeConstant, uint32_t deadTime, DataStore_MotorModel_t *model, double *residual, double *variance)
+{
+    const float speedScale = DCMotor_GetRadiansPerCount(motorId) / (FIT_DECIMATION * SAMPLE_PERIOD_S);
+    const float alpha = 1.0f - expf(-SAMPLE_PERIOD_S / timeConstant);
+    float x = 0.0f, y = 0.0f, sumX = 0.0f, sumY = 0.0f;
+    double sxx = 0, sxy = 0, syy = 0, sxw = 0, syw = 0, sw = 0, sww = 0;
+    uint32_t n = 0;
+
+    // Normal equations of w = p x + q y over the intervals, p = K and q = -K f
+    for (uint32_t sample = 0; sample < TOTAL_SAMPLES; sample++)
+    {
+        float u = sample >= deadTime ? Duty(sample - deadTime) : 0.0f;
+        float step = sample >= deadTime ? 1.0f : 0.0f;
+        if (bias < 0.0f) u = -u;   // Fit magnitudes for a negative bias
+        x += alpha * (u - x);
+        y += alpha * (step - y);
+        sumX += x;
+        sumY += y;
+        if ((sample + 1) % FIT_DECIMATION != 0) continue;
+        int32_t count = 0;
+        for (uint32_t j = sample + 1 - FIT_DECIMATION; j <= sample; j++) count += counts[motorId][j];
+        double w = (bias < 0.0f ? -count : count) * speedScale;
+        double mx = sumX / FIT_DECIMATION, my = sumY / FIT_DECIMATION;
+        sumX = sumY = 0.0f;
+        sxx += mx * mx; sxy += mx * my; syy += my * my;
+        sxw += mx * w; syw += my * w;
+        sw += w; sww += w * w;
+        n++;
+    }
+    double det = sxx * syy - sxy * sxy;
+    if (n == 0 || det <= 1e-9 * sxx * syy) return false;
+    double p = (sxw * syy - syw * sxy) / det;
+    double q = (syw * sxx - sxw * sxy) / det;
+    // Sum of the squared errors from the normal equations
+    double sse = sww - p * sxw - q * syw;
+    *residual = sse > 0.0 ? sse : 0.0;
+    *variance = sww - sw * sw / n;
+    model->gain = (float)p;
+    model->friction = p != 0.0 ? (float)(-q / p) : 0.0f;
+    model->timeConstant = timeConstant;
+    model->deadTime = deadTime * SAMPLE_PERIOD_S;
+    return true;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file dc_motor_tuning.h
+ * @brief Identification of the wheel motors and computation of their gains
+ *
+ * @details Declares the API of the on-board tuning routine. With the robot on
+ * blocks, each selected motor is driven in open loop by a pseudo-random
+ * binary sequence around a bias duty, from the 1 ms TIM7 tick. A first order
+ * plus dead time model is fitted to the recorded speed by least squares, and
+ * the PI gains and the feed-forward terms are computed from the model.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "data_store.h"
+
+#define DC_MOTOR_TUNING_DEFAULT_BIAS        0.4f    // Duty the excitation is centred on
+#define DC_MOTOR_TUNING_DEFAULT_AMPLITUDE   0.2f    // Duty added or removed by the excitation
+#define DC_MOTOR_TUNING_MIN_FIT_QUALITY     0.8f    // Share of the speed variance the model must explain
+
+/**
+ * @brief Result of the identification of one motor
+ */
+typedef struct {
+    bool isValid;                   // Model fitted and gains computed
+    float fitQuality;               // Share of the speed variance explained by the model, 1 is perfect
+    DataStore_MotorModel_t model;   // Identified model
+    DataStore_MotorGains_t gains;   // Gains computed from the model
+} DCMotorTuning_Result_t;
+
+/**
+ * @brief Initialize the tuning routine
+ * This function registers the excitation on the TIM7 tick.
+ * @return true if successful, false otherwise
+ */
+bool DCMotorTuning_Init(void);
+
+/**
+ * @brief Start the excitation of the selected motors
+ * The motors must be at rest with a zero target. The routine takes about
+ * 0.6 s, then the motors are stopped and given back to their PID.
+ * @param motorMask one bit per motor, bit 0 for motor 0
+ * @param bias duty the excitation is centred on, 0 for the default
+ * @param amplitude duty added or removed by the excitation, 0 for the default
+ * @return true if started, false if busy, a motor is moving or the arguments are invalid
+ */
+bool DCMotorTuning_Start(uint32_t motorMask, float bias, float amplitude);
+
+/**
+ * @brief Check whether the excitation is running
+ * @return true while the motors are driven by the routine
+ */
+bool DCMotorTuning_IsRunning(void);
+
+/**
+ * @brief Fit the model of a motor and compute its gains
+ * Must be called from a thread once the excitation is over.
+ * @param motorId The ID of the motor
+ * @param result Pointer to the result to fill
+ * @return true if the result is valid, false otherwise
+ */
+bool DCMotorTuning_GetResult(uint32_t motorId, DCMotorTuning_Result_t *result);
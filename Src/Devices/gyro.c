@@ -0,0 +1,70 @@
+/**
+ * @file gyro.c
+ * @brief Yaw-rate gyro samples for the odometry
+ *
+ * @details Integrates the samples pushed by the bus driver into the angle
+ * turned, by the trapezoidal rule between two sample timestamps; the
+ * odometry takes the sum at each update, so no sample between two updates
+ * is lost. A gap longer than GYRO_MAX_SAMPLE_AGE is not bridged. The state
+ * is changed with interrupts masked, the driver interrupt may preempt the
+ * control interrupt.
+ *
+ * @dependencies system_config (GYRO_MAX_SAMPLE_AGE)
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "gyro.h"
+
+#include "main.h"
+#include "system_config.h"
+
+#include <stddef.h>
+
+/* ---------------------- Static Variables ------------------------------ */
+static bool hasSample = false;
+static float lastRate;
+static uint32_t lastTimestamp;
+static float gatheredTurn;  // Angle integrated since the last take, in rad
+
+/**
+ * @brief Push a gyro sample
+ * Safe in interrupts of any priority.
+ * @param rate Yaw rate in rad/s, counterclockwise positive seen from above
+ * @param timestamp DWT cycle counter when the sample was taken
+ */
+void Gyro_PushSample(float rate, uint32_t timestamp)
+{
+    const uint32_t maxAge = GYRO_MAX_SAMPLE_AGE * (SystemCoreClock / 1000U);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t interval = timestamp - lastTimestamp;
+    if (hasSample && interval <= maxAge) gatheredTurn += 0.5f * (rate + lastRate) * (float)interval / (float)SystemCoreClock;
+    lastRate = rate;
+    lastTimestamp = timestamp;
+    hasSample = true;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Take the angle turned since the last take
+ * The angle gathered so far is cleared, also when it is not returned.
+ * @param turn Pointer to store the angle in radians, counterclockwise positive
+ * @param now DWT cycle counter the age of the last sample is taken against
+ * @return true if a sample not older than GYRO_MAX_SAMPLE_AGE exists, false otherwise
+ */
+bool Gyro_TakeTurn(float* turn, uint32_t now)
+{
+    if (turn == NULL) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = hasSample;
+    float angle = gatheredTurn;
+    uint32_t timestamp = lastTimestamp;
+    gatheredTurn = 0.0f;
+    __set_PRIMASK(primask);
+    // A sample taken after now is fresh too, the difference is then negative
+    if (!valid || (int32_t)(now - timestamp) > (int32_t)(GYRO_MAX_SAMPLE_AGE * (SystemCoreClock / 1000U))) return false;
+    *turn = angle;
+    return true;
+}
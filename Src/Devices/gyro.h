@@ -0,0 +1,40 @@
+/**
+ * @file gyro.h
+ * @brief Yaw-rate gyro samples for the odometry
+ *
+ * @details The bus driver of the gyro reads it by DMA, at the control rate or
+ * faster, and pushes each sample from its transfer complete interrupt. The
+ * samples are integrated into the angle turned; the odometry takes the angle
+ * gathered since its last update in the TIM7 interrupt. Without a sample in
+ * the last GYRO_MAX_SAMPLE_AGE the odometry falls back to the wheels.
+ * Recorded samples are pushed the same way to replay a run
+ * (Tools/HostCheck/heading_fusion_check.c).
+ *
+ * No gyro is fitted on this board and no driver calls Gyro_PushSample yet:
+ * Gyro_TakeTurn returns false and the heading comes from the wheels alone.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Push a gyro sample
+ * Safe in interrupts of any priority.
+ * @param rate Yaw rate in rad/s, counterclockwise positive seen from above
+ * @param timestamp DWT cycle counter when the sample was taken
+ */
+void Gyro_PushSample(float rate, uint32_t timestamp);
+
+/**
+ * @brief Take the angle turned since the last take
+ * The angle gathered so far is cleared, also when it is not returned.
+ * @param turn Pointer to store the angle in radians, counterclockwise positive
+ * @param now DWT cycle counter the age of the last sample is taken against
+ * @return true if a sample not older than GYRO_MAX_SAMPLE_AGE exists, false otherwise
+ */
+bool Gyro_TakeTurn(float* turn, uint32_t now);
@@ -14,6 +14,8 @@
 #include "usart.h"
 #include "s_bus.h"
 #include "usart.h"
+#include "flight_recorder.h"
+#include "rtx_os.h"
 
 /* ----------------- Definitions -------------------- */
 #define RECEIVER_NO_SIGNAL_TIMEOUT  100
@@ -22,6 +24,16 @@
 
 /* ----------------- Static variables -------------------- */
 static osThreadId_t threadID;
+static uint64_t threadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t threadControlBlock;
+static const osThreadAttr_t threadAttr = {
+    .name = "ThreadRcReceiver",
+    .cb_mem = &threadControlBlock,
+    .cb_size = sizeof(threadControlBlock),
+    .stack_mem = threadStack,
+    .stack_size = sizeof(threadStack),
+    .priority = THREAD_PRIORITY_INGRESS,
+};
 static osMessageQueueId_t messageQueue;
 static ReceiverValues_t receiverValue;
 static RC_Receiver_Callback_t callbackList[MAX_CALLBACK_NUMBER];
@@ -30,6 +42,7 @@ static uint32_t callbackCount;
 /* ----------------- Static functions -------------------- */
 static void RC_Receiver_Process(void* arg);
 static void UART_Callback(uint8_t*);
+static void RecordFailsafeTransition(uint32_t flags);
 
 /**
  * @brief Initialize the RC Receiver
@@ -39,7 +52,7 @@ static void UART_Callback(uint8_t*);
 void RC_Receiver_Init(void)
 {
     USART_Init();
-    threadID = osThreadNew(RC_Receiver_Process, NULL, NULL);
+    threadID = osThreadNew(RC_Receiver_Process, NULL, &threadAttr);
     messageQueue = osMessageQueueNew(MESSAGE_QUEUE_SIZE, S_BUS_MESSAGE_SIZE, NULL);
     USART_Register_Callback(UART_Callback);
 }
@@ -55,7 +68,11 @@ static void RC_Receiver_Process(void* arg)
     for(;;)
     {
         osStatus_t status = osMessageQueueGet(messageQueue, msg, NULL, RECEIVER_NO_SIGNAL_TIMEOUT);
-        if(status != osOK) continue;
+        if(status != osOK)
+        {
+            RecordFailsafeTransition(FLIGHT_RECORD_RC_NO_SIGNAL_FLAG);
+            continue;
+        }
         if(S_BUS_Parse(msg, &receiverChannel))
         {
             #ifdef RECEIVER_TYPE_WFLY
@@ -63,6 +80,8 @@ static void RC_Receiver_Process(void* arg)
             #elif defined(RECEIVER_TYPE_HT8A)
             Get_HT8A_Receiver_Values(&receiverValue, &receiverChannel);
             #endif
+            RecordFailsafeTransition((receiverValue.failSafe ? FLIGHT_RECORD_RC_FAILSAFE_FLAG : 0) |
+                                     (receiverValue.frameLost ? FLIGHT_RECORD_RC_FRAME_LOST_FLAG : 0));
             // Call registered callbacks
             for(uint32_t i = 0; i < callbackCount; i++)
             {
@@ -101,3 +120,18 @@ bool RC_Receiver_Register_Callback(RC_Receiver_Callback_t callback)
     callbackList[callbackCount++] = callback;
     return true;
 }
+
+/**
+ * @brief Log a failsafe transition in the flight recorder
+ * Only changes of the flags are recorded, steady states cost nothing.
+ * @param flags FLIGHT_RECORD_RC_* flags of the current frame
+ */
+static void RecordFailsafeTransition(uint32_t flags)
+{
+    static uint32_t lastFlags;
+    if(flags == lastFlags) return;
+    lastFlags = flags;
+    FlightRecordRcFailsafe_t record = { .flags = flags };
+    FlightRecorder_Log(FLIGHT_RECORD_RC_FAILSAFE, &record, sizeof(record));
+    FlightRecorder_Flush();
+}
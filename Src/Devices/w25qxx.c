@@ -8,7 +8,11 @@
  *  - Status register read / write
  *  - Sector erase (4KB) and full chip erase commands (chip erase wrapper TBD)
  *  - Page program (256-byte pages) with automatic sector erase handling
+ *  - Raw program of pre-erased areas and explicit sector erase, for
+ *    append-only storage layers that manage erasing themselves
  *  - Linear read API for arbitrary address/length
+ *  - LRU cache of recently read pages, kept coherent on program and erase,
+ *    with a mapped accessor returning a pointer into the cached page
  *
  * The module internally maintains a singleton instance (W25QXX_t) initialized
  * on first call to W25QXX_Init(). Write operations perform necessary sector
@@ -18,10 +22,21 @@
  * Safety / Usage Notes:
  *  - Only single SPI mode supported (no dual/quad fast read acceleration here).
  *  - Ensure SPI bus is initialized before calling any API.
- *  - Concurrent access is not protected; serialize calls at a higher layer if
- *    multiple tasks may use the flash simultaneously.
+ *  - Calls are serialized by a recursive mutex. A program or erase holds it
+ *    from the write enable until the busy bit clears, so no other thread
+ *    reads or programs the chip while it is busy.
  *  - Erase cycles are finite; avoid frequent small writes that force whole-sector erases.
  *
+ * Page cache:
+ *  - Reads of at most one page are served from W25QXX_CACHE_PAGES cached
+ *    pages, a miss reads the whole page once. Larger reads bypass the cache.
+ *  - Programmed bytes are ANDed into the cached page and erased sectors set
+ *    to 0xFF, so the cache always matches the flash. A failed operation drops
+ *    the pages it touched instead.
+ *  - The flash does not answer reads while busy. Programs and erases wait
+ *    for the busy bit before they start and hold the mutex until it clears,
+ *    so a page is never filled from a busy chip.
+ *
  * @dependencies w25qxx.h, spi.h, main.h, CMSIS-RTOS (for osDelay)
  * @author Young.W <com.wang@hotmail.com>
  * @date 2025-09-25
@@ -32,6 +47,8 @@
 #include "spi.h"
 #include "main.h"
 
+#include <string.h>
+
 /* ------------------------------ Static variables ------------------------------ */
 /**
  * @brief W25QXX flash control commands definition
@@ -72,12 +89,35 @@ static const uint32_t SECTOR_SIZE = 4096;
 static const uint32_t PAGE_SIZE = 256;
 static const uint32_t SECTOR_MASK = 0xFFFFF000U;
 static const uint32_t PAGE_MASK = 0xFFFFFF00U;
-static W25QXX_t w25qxx = {0, 0, 0, 0};
+static W25QXX_t w25qxx = {0, 0, 0, 0, 0, 0, 0, 0};
 static osMutexId_t w25qxxMutex = NULL;
+static const osMutexAttr_t w25qxxMutexAttr = {
+    .name = "W25QXX",
+    .attr_bits = osMutexRecursive | osMutexPrioInherit,  // Taken again by the transactions of a sequence
+};
+
+#define W25QXX_CACHE_PAGES  8       // Pages held by the read cache
+#define W25QXX_PAGE_SIZE    256
+
+/**
+ * @brief Cached flash page
+ */
+typedef struct
+{
+    uint8_t data[W25QXX_PAGE_SIZE]; // First, so mapped words are aligned as in flash
+    uint32_t address;   // Page address
+    uint32_t lastUse;   // Value of cacheClock at the last access, for LRU eviction
+    uint16_t pins;      // Number of Map calls not yet unmapped
+    bool valid;         // True if data matches the flash page
+} W25QXX_CachePage_t;
+
+static W25QXX_CachePage_t cachePages[W25QXX_CACHE_PAGES];
+static uint32_t cacheClock = 0;     // Incremented on every cache access
 
 /* ------------------------------- Static functions --------------------------- */
 static bool Read(uint8_t *, uint32_t, uint32_t);
 static bool Write(uint8_t *, uint32_t, uint32_t);
+static bool Program(uint8_t *, uint32_t, uint32_t);
 static uint8_t ReadSR(void);
 static bool WriteSR(uint8_t);
 static bool EnableWrite(void);
@@ -86,6 +126,12 @@ static uint16_t ReadID(void);
 static void WaitBusyBit(uint32_t);
 static bool EraseSector(uint32_t sectorAddr);
 static bool ProgramPage(uint8_t *buffer, uint32_t address, uint32_t size);
+static const uint8_t *Map(uint8_t *scratch, uint32_t addr, uint32_t size);
+static void Unmap(const uint8_t *data);
+static bool ReadFlash(uint8_t *buffer, uint32_t addr, uint32_t size);
+static W25QXX_CachePage_t *LookupPage(uint32_t pageAddr);
+static void UpdateCachedPage(const uint8_t *buffer, uint32_t address, uint32_t size, bool result);
+static void UpdateCachedSector(uint32_t sectorAddr, bool result);
 
 /**
  * @brief Initialize W25QXX flash interface
@@ -106,7 +152,11 @@ W25QXX_t *W25QXX_Init(uint32_t chipType)
         w25qxx.Read = Read;
         w25qxx.Write = Write;
         w25qxx.ReadID = ReadID;
-        w25qxxMutex = osMutexNew(NULL);
+        w25qxx.Program = Program;
+        w25qxx.EraseSector = EraseSector;
+        w25qxx.Map = Map;
+        w25qxx.Unmap = Unmap;
+        w25qxxMutex = osMutexNew(&w25qxxMutexAttr);
         assert_param(w25qxxMutex != NULL);
     }
     return &w25qxx;
@@ -182,25 +232,191 @@ uint16_t ReadID(void)
 
 /**
  * @brief Read datas from flash
- * This function reads data from the flash memory.
+ * This function reads data from the flash memory. Reads of at most one page
+ * go through the page cache, larger ones are read from the flash directly.
  * @param buffer pointer to the buffer to store the read data
  * @param addr flash address to be read, 24 bits address
  * @param size data length in bytes
  * @return true if the operation was successful, false otherwise
  */
 bool Read(uint8_t *buffer, uint32_t addr, uint32_t size)
+{
+    bool result = true;
+    osMutexAcquire(w25qxxMutex, osWaitForever);
+    if (size > PAGE_SIZE)
+    {
+        result = ReadFlash(buffer, addr, size);
+        osMutexRelease(w25qxxMutex);
+        return result;
+    }
+    while (size && result)
+    {
+        uint32_t pageOffset = addr & (~PAGE_MASK);
+        uint32_t readSize = PAGE_SIZE - pageOffset;
+        if (readSize > size) readSize = size;
+        W25QXX_CachePage_t *page = LookupPage(addr & PAGE_MASK);
+        if (page != NULL)
+            memcpy(buffer, page->data + pageOffset, readSize);
+        else
+            result = ReadFlash(buffer, addr, readSize);
+        buffer += readSize;
+        addr += readSize;
+        size -= readSize;
+    }
+    osMutexRelease(w25qxxMutex);
+    return result;
+}
+
+/**
+ * @brief Map a small area of flash for reading
+ * This function returns a pointer into the cached page when the area lies in
+ * one page, and pins the page until Unmap. Otherwise the area is read into
+ * the scratch buffer.
+ * @param scratch pointer to a buffer of at least size bytes, used when the
+ * area cannot be served from the cache
+ * @param addr flash address to be read, 24 bits address
+ * @param size data length in bytes
+ * @return pointer to the data, NULL if the read failed
+ */
+const uint8_t *Map(uint8_t *scratch, uint32_t addr, uint32_t size)
+{
+    const uint8_t *data = NULL;
+    osMutexAcquire(w25qxxMutex, osWaitForever);
+    uint32_t pageOffset = addr & (~PAGE_MASK);
+    W25QXX_CachePage_t *page = NULL;
+    if (size > 0 && pageOffset + size <= PAGE_SIZE) page = LookupPage(addr & PAGE_MASK);
+    if (page != NULL)
+    {
+        page->pins++;
+        data = page->data + pageOffset;
+    }
+    else if (ReadFlash(scratch, addr, size))
+    {
+        data = scratch;
+    }
+    osMutexRelease(w25qxxMutex);
+    return data;
+}
+
+/**
+ * @brief Release an area mapped by Map
+ * Pointers into the scratch buffer are ignored.
+ * @param data pointer returned by Map
+ */
+void Unmap(const uint8_t *data)
+{
+    if (data == NULL) return;
+    osMutexAcquire(w25qxxMutex, osWaitForever);
+    for (uint32_t i = 0; i < W25QXX_CACHE_PAGES; i++)
+    {
+        W25QXX_CachePage_t *page = &cachePages[i];
+        if (data >= page->data && data < page->data + W25QXX_PAGE_SIZE)
+        {
+            if (page->pins > 0) page->pins--;
+            break;
+        }
+    }
+    osMutexRelease(w25qxxMutex);
+}
+
+/**
+ * @brief Read datas from flash without the cache
+ * @param buffer pointer to the buffer to store the read data
+ * @param addr flash address to be read, 24 bits address
+ * @param size data length in bytes
+ * @return true if the operation was successful, false otherwise
+ * @note The caller holds w25qxxMutex.
+ */
+bool ReadFlash(uint8_t *buffer, uint32_t addr, uint32_t size)
 {
     uint8_t txBuff[4] = {W25QXX_READ_DATA, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
     bool result;
-    osMutexAcquire(w25qxxMutex, osWaitForever);
     SPI_SetChipSelectLow();
     result = SPI_Transmit(txBuff, sizeof(txBuff));
     result |= SPI_Receive(buffer, size);
     SPI_SetChipSelectHigh();
-    osMutexRelease(w25qxxMutex);
     return result;
 }
 
+/**
+ * @brief Look up a page in the cache, filling it on a miss
+ * The least recently used page which is not pinned is replaced.
+ * @param pageAddr page address
+ * @return pointer to the cached page, NULL if it cannot be cached now
+ * @note The caller holds w25qxxMutex.
+ */
+W25QXX_CachePage_t *LookupPage(uint32_t pageAddr)
+{
+    W25QXX_CachePage_t *victim = NULL;
+    cacheClock++;
+    for (uint32_t i = 0; i < W25QXX_CACHE_PAGES; i++)
+    {
+        W25QXX_CachePage_t *page = &cachePages[i];
+        if (page->valid && page->address == pageAddr)
+        {
+            page->lastUse = cacheClock;
+            return page;
+        }
+        if (page->pins > 0) continue;
+        if (victim == NULL || !page->valid || (victim->valid && (int32_t)(page->lastUse - victim->lastUse) < 0))
+            victim = page;
+    }
+    if (victim == NULL) return NULL;
+    victim->valid = false;
+    if (!ReadFlash(victim->data, pageAddr, W25QXX_PAGE_SIZE)) return NULL;
+    victim->address = pageAddr;
+    victim->lastUse = cacheClock;
+    victim->valid = true;
+    return victim;
+}
+
+/**
+ * @brief Apply a programmed area to the cached page holding it
+ * Programming only clears bits, so the data is ANDed into the cache.
+ * @param buffer pointer to the programmed data
+ * @param address flash address of the data, inside one page
+ * @param size data length in bytes
+ * @param result result of the program operation, the page is dropped on failure
+ */
+void UpdateCachedPage(const uint8_t *buffer, uint32_t address, uint32_t size, bool result)
+{
+    osMutexAcquire(w25qxxMutex, osWaitForever);
+    for (uint32_t i = 0; i < W25QXX_CACHE_PAGES; i++)
+    {
+        W25QXX_CachePage_t *page = &cachePages[i];
+        if (!page->valid || page->address != (address & PAGE_MASK)) continue;
+        if (!result)
+        {
+            page->valid = false;
+            break;
+        }
+        uint8_t *dst = page->data + (address & (~PAGE_MASK));
+        for (uint32_t j = 0; j < size; j++) dst[j] &= buffer[j];
+        break;
+    }
+    osMutexRelease(w25qxxMutex);
+}
+
+/**
+ * @brief Apply an erased sector to the cached pages inside it
+ * @param sectorAddr sector address
+ * @param result result of the erase operation, the pages are dropped on failure
+ */
+void UpdateCachedSector(uint32_t sectorAddr, bool result)
+{
+    osMutexAcquire(w25qxxMutex, osWaitForever);
+    for (uint32_t i = 0; i < W25QXX_CACHE_PAGES; i++)
+    {
+        W25QXX_CachePage_t *page = &cachePages[i];
+        if (!page->valid || (page->address & SECTOR_MASK) != sectorAddr) continue;
+        if (result)
+            memset(page->data, 0xFF, W25QXX_PAGE_SIZE);
+        else
+            page->valid = false;
+    }
+    osMutexRelease(w25qxxMutex);
+}
+
 /**
  * @brief Write datas to flash
  * This function writes data to the flash memory, handling necessary sector erasures.
@@ -226,7 +442,23 @@ bool Write(uint8_t *buffer, uint32_t address, uint32_t size)
         startSectorAddr += SECTOR_SIZE;
     }
 
-    // Writing data
+    result &= Program(buffer, address, size);
+    return result;
+}
+
+/**
+ * @brief Program datas to erased flash
+ * This function writes data page by page without erasing any sector, so the
+ * target area must have been erased before. It is used by log-structured
+ * storage which appends records to a sector erased in advance.
+ * @param buffer pointer to the data to be written
+ * @param address flash address to be written, 24 bits address
+ * @param size data length in bytes
+ * @return true if the operation was successful, false otherwise
+ */
+bool Program(uint8_t *buffer, uint32_t address, uint32_t size)
+{
+    bool result = true;
     uint32_t remainSize = size, writeAddress = address, pageRemainSize;
     uint8_t *readPtr = buffer;
     while (remainSize)
@@ -291,29 +523,37 @@ void WaitBusyBit(uint32_t period)
 
 /**
  * @brief Erase sector
- * This function erases a sector of the flash memory.
+ * This function erases a sector of the flash memory. The driver mutex is
+ * held until the erase completes.
  * @param sectorAddr Sector address in 24bits
  * @return true if the operation was successful, false otherwise
  */
 bool EraseSector(uint32_t sectorAddr)
 {
+    sectorAddr &= SECTOR_MASK;
     const uint32_t BUSY_WAIT_TIME = 5;
     uint8_t txBuff[] = {W25QXX_SECTOR_ERASE, (uint8_t)(sectorAddr >> 16), (uint8_t)(sectorAddr >> 8), (uint8_t)sectorAddr};
     bool result;
-    if (!EnableWrite()) return false;
-    WaitBusyBit(BUSY_WAIT_TIME);
     osMutexAcquire(w25qxxMutex, osWaitForever);
+    WaitBusyBit(BUSY_WAIT_TIME);    // The chip ignores a write enable while busy
+    if (!EnableWrite())
+    {
+        osMutexRelease(w25qxxMutex);
+        return false;
+    }
     SPI_SetChipSelectLow();
     result = SPI_Transmit(txBuff, sizeof(txBuff));
     SPI_SetChipSelectHigh();
-    osMutexRelease(w25qxxMutex);
     WaitBusyBit(BUSY_WAIT_TIME);
+    UpdateCachedSector(sectorAddr, result);
+    osMutexRelease(w25qxxMutex);
     return result;
 }
 
 /**
  * @brief Program a page, 256 bytes length
- * Write a page, only one page can be written at a time.
+ * Write a page, only one page can be written at a time. The driver mutex is
+ * held until the program completes.
  * @param buffer Pointer to the datas to be written.
  * @param address Flash address to be written
  * @param size Data length in bytes
@@ -324,13 +564,19 @@ bool ProgramPage(uint8_t *buffer, uint32_t address, uint32_t size)
     const uint32_t BUSY_WAIT_TIME = 1;
     uint8_t txBuff[] = {W25QXX_PAGE_PROGRAM, (uint8_t)(address >> 16), (uint8_t)(address >> 8), (uint8_t)address};
     bool result;
-    if (!EnableWrite()) return false;
     osMutexAcquire(w25qxxMutex, osWaitForever);
+    WaitBusyBit(BUSY_WAIT_TIME);    // The chip ignores a write enable while busy
+    if (!EnableWrite())
+    {
+        osMutexRelease(w25qxxMutex);
+        return false;
+    }
     SPI_SetChipSelectLow();
     result = SPI_Transmit(txBuff, sizeof(txBuff));
     result |= SPI_Transmit(buffer, size);
     SPI_SetChipSelectHigh();
-    osMutexRelease(w25qxxMutex);
     WaitBusyBit(BUSY_WAIT_TIME);
+    UpdateCachedPage(buffer, address, size, result);
+    osMutexRelease(w25qxxMutex);
     return result;
 }
@@ -8,7 +8,11 @@
  *  - Status register read / write
  *  - Sector erase (4KB) and full chip erase commands (chip erase wrapper TBD)
  *  - Page program (256-byte pages) with automatic sector erase handling
+ *  - Raw program of pre-erased areas and explicit sector erase, for
+ *    append-only storage layers that manage erasing themselves
  *  - Linear read API for arbitrary address/length
+ *  - LRU cache of recently read pages, kept coherent on program and erase,
+ *    with a mapped accessor returning a pointer into the cached page
  *
  * The module internally maintains a singleton instance (W25QXX_t) initialized
  * on first call to W25QXX_Init(). Write operations perform necessary sector
@@ -18,8 +22,9 @@
  * Safety / Usage Notes:
  *  - Only single SPI mode supported (no dual/quad fast read acceleration here).
  *  - Ensure SPI bus is initialized before calling any API.
- *  - Concurrent access is not protected; serialize calls at a higher layer if
- *    multiple tasks may use the flash simultaneously.
+ *  - Calls are serialized by a recursive mutex. A program or erase holds it
+ *    from the write enable until the busy bit clears, so no other thread
+ *    reads or programs the chip while it is busy.
  *  - Erase cycles are finite; avoid frequent small writes that force whole-sector erases.
  *
  * @author Young.W <com.wang@hotmail.com>
@@ -76,6 +81,41 @@ typedef struct
      * Note: This function handles necessary sector erasures automatically.
      */
     bool (* Write)(uint8_t*, uint32_t, uint32_t);
+
+    /**
+     * @brief Program data into already erased flash memory
+     * @param buffer Pointer to the buffer containing data to write
+     * @param addr 24-bit flash address to write to
+     * @param size Number of bytes to write
+     * @return true if the operation was successful, false otherwise
+     * Note: No sector is erased, the target area must be blank (0xFF).
+     */
+    bool (* Program)(uint8_t*, uint32_t, uint32_t);
+
+    /**
+     * @brief Erase the 4KB sector containing the given address
+     * @param addr 24-bit flash address inside the sector
+     * @return true if the operation was successful, false otherwise
+     */
+    bool (* EraseSector)(uint32_t);
+
+    /**
+     * @brief Map a small area of flash memory for reading
+     * The area is served from the page cache without copying when it lies in
+     * one page, otherwise it is read into the scratch buffer.
+     * @param scratch Pointer to a buffer of at least size bytes, used on a cache miss
+     * @param addr 24-bit flash address to read from
+     * @param size Number of bytes to map
+     * @return pointer to the data, NULL if the read failed
+     * Note: The pointer stays valid until Unmap, the cached page is not evicted meanwhile.
+     */
+    const uint8_t* (* Map)(uint8_t*, uint32_t, uint32_t);
+
+    /**
+     * @brief Release an area mapped by Map
+     * @param data Pointer returned by Map, NULL is ignored
+     */
+    void (* Unmap)(const uint8_t*);
 } W25QXX_t;
 
 /**
@@ -0,0 +1,153 @@
+/**
+ * @file chassis_kinematic.c
+ * @brief Implementation of the forward and inverse kinematics of the chassis
+ * This module builds the kinematic matrices of the chassis selected by
+ * DEFAULT_CHASSIS_TYPE and applies them with CMSIS-DSP. Only the builder of
+ * the selected chassis is compiled; the matrices have the size of its wheels.
+ *  - inverse: wheelSpeed = J * twist, CHASSIS_WHEEL_NUMBER x 3
+ *  - forward: twist = F * wheelSpeed, 3 x CHASSIS_WHEEL_NUMBER, F J = I on
+ *    the degrees of freedom of the chassis
+ * The divisions by the geometry are done once, when the matrices are built.
+ * @date 2026-10-17
+ * @author Young.R <com.wang@hotmail.com>
+ * @version 1.0
+ * @note This module is part of the Motion Control system.
+ */
+#include "chassis_kinematic.h"
+#include "main.h"
+#include "data_store.h"
+#include "arm_math.h"
+#include <stdlib.h>
+
+/* ---------------------- Static Variables ------------------------------ */
+static float32_t inverseData[CHASSIS_WHEEL_NUMBER * CHASSIS_TWIST_SIZE];
+static float32_t forwardData[CHASSIS_TWIST_SIZE * CHASSIS_WHEEL_NUMBER];
+static arm_matrix_instance_f32 inverseMatrix;
+static arm_matrix_instance_f32 forwardMatrix;
+
+/* ---------------------- Static Functions ------------------------------ */
+static void BuildMatrices(float wheelRadius, float trackWidth, float wheelBase);
+static void SetInverseRow(uint32_t wheel, float vx, float vy, float omega);
+
+/**
+ * @brief Initialize the kinematics
+ * This function builds the matrices from the geometry in the data store.
+ */
+void ChassisKinematic_Init(void)
+{
+    arm_mat_init_f32(&inverseMatrix, CHASSIS_WHEEL_NUMBER, CHASSIS_TWIST_SIZE, inverseData);
+    arm_mat_init_f32(&forwardMatrix, CHASSIS_TWIST_SIZE, CHASSIS_WHEEL_NUMBER, forwardData);
+    bool result = ChassisKinematic_SetGeometry(DataStore_GetWheelRadius(), DataStore_GetTrackWidth(), DataStore_GetWheelBase());
+    assert_param(result);
+}
+
+/**
+ * @brief Rebuild the matrices for a new geometry.
+ * Not locked: call it from the thread which evaluates the kinematics.
+ * @param wheelRadius Wheel radius in meters.
+ * @param trackWidth Distance between the left and right wheels in meters,
+ *                   diameter of the wheel circle for CHASSIS_TYPE_OMNI3.
+ * @param wheelBase Distance between the front and rear axles in meters, used by CHASSIS_TYPE_MECANUM.
+ * @return true if the geometry is valid, false otherwise; the matrices are kept then.
+ */
+bool ChassisKinematic_SetGeometry(float wheelRadius, float trackWidth, float wheelBase)
+{
+    // Written so that NaN fails too
+    if (!(wheelRadius > 0.0f) || !(trackWidth > 0.0f) || !(wheelBase >= 0.0f)) return false;
+    BuildMatrices(wheelRadius, trackWidth, wheelBase);
+    return true;
+}
+
+/**
+ * @brief Inverse kinematics
+ * This function calculates the wheel angular speeds which achieve a twist.
+ * @param[in] twist Array [CHASSIS_TWIST_SIZE] of the desired twist.
+ * @param[out] wheelSpeed Array [CHASSIS_WHEEL_NUMBER] to store the wheel angular speeds in rad/s.
+ */
+void ChassisKinematic_Inverse(const float* twist, float* wheelSpeed)
+{
+    if (twist == NULL || wheelSpeed == NULL) return;
+    arm_mat_vec_mult_f32(&inverseMatrix, twist, wheelSpeed);
+}
+
+/**
+ * @brief Forward kinematics
+ * This function calculates the twist of the chassis from the wheel angular
+ * speeds, in the least squares sense for the chassis with more wheels than
+ * degrees of freedom. Applied to wheel rotations in radians, it gives the
+ * displacement of the chassis.
+ * @param[in] wheelSpeed Array [CHASSIS_WHEEL_NUMBER] of the wheel angular speeds in rad/s.
+ * @param[out] twist Array [CHASSIS_TWIST_SIZE] to store the twist.
+ */
+void ChassisKinematic_Forward(const float* wheelSpeed, float* twist)
+{
+    if (wheelSpeed == NULL || twist == NULL) return;
+    arm_mat_vec_mult_f32(&forwardMatrix, wheelSpeed, twist);
+}
+
+/**
+ * @brief Set the row of a wheel in the inverse matrix
+ * @param wheel index of the wheel
+ * @param vx wheel speed per m/s of vx
+ * @param vy wheel speed per m/s of vy
+ * @param omega wheel speed per rad/s of omega
+ */
+void SetInverseRow(uint32_t wheel, float vx, float vy, float omega)
+{
+    inverseData[wheel * CHASSIS_TWIST_SIZE + 0] = vx;
+    inverseData[wheel * CHASSIS_TWIST_SIZE + 1] = vy;
+    inverseData[wheel * CHASSIS_TWIST_SIZE + 2] = omega;
+}
+
+/**
+ * @brief Build the matrices of the selected chassis
+ * @param wheelRadius Wheel radius in meters.
+ * @param trackWidth Distance between the left and right wheels in meters.
+ * @param wheelBase Distance between the front and rear axles in meters.
+ */
+void BuildMatrices(float wheelRadius, float trackWidth, float wheelBase)
+{
+    float k = 1.0f / wheelRadius;
+    float *vx = &forwardData[0 * CHASSIS_WHEEL_NUMBER];    // Rows of the forward matrix
+    float *vy = &forwardData[1 * CHASSIS_WHEEL_NUMBER];
+    float *omega = &forwardData[2 * CHASSIS_WHEEL_NUMBER];
+#if DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_DIFF || DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_SKID
+    (void)wheelBase;
+    // Every wheel of a side runs at the speed of the side, left wheels have even indices
+    float h = trackWidth / 2.0f;
+    for (uint32_t i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+    {
+        float side = (i & 1U) ? 1.0f : -1.0f;
+        SetInverseRow(i, k, 0.0f, side * h * k);
+        vx[i] = wheelRadius / CHASSIS_WHEEL_NUMBER;
+        vy[i] = 0.0f;
+        omega[i] = side * wheelRadius / (trackWidth * (CHASSIS_WHEEL_NUMBER / 2));
+    }
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_MECANUM
+    // Roller at 45 degrees: a wheel turns for vx, -+vy and its distance to the centre along both axes
+    float l = (trackWidth + wheelBase) / 2.0f;
+    static const float lateral[CHASSIS_WHEEL_NUMBER] = { -1.0f, 1.0f, 1.0f, -1.0f };
+    static const float turn[CHASSIS_WHEEL_NUMBER] = { -1.0f, 1.0f, -1.0f, 1.0f };
+    for (uint32_t i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+    {
+        SetInverseRow(i, k, lateral[i] * k, turn[i] * l * k);
+        vx[i] = wheelRadius / 4.0f;
+        vy[i] = lateral[i] * wheelRadius / 4.0f;
+        omega[i] = turn[i] * wheelRadius / (4.0f * l);
+    }
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_OMNI3
+    (void)wheelBase;
+    // Wheel i sits at the angle 120 * i degrees around the centre and pushes along the tangent
+    float l = trackWidth / 2.0f;
+    for (uint32_t i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+    {
+        float angle = (float)i * (2.0f * (float)PI / 3.0f);
+        float sinA = arm_sin_f32(angle);
+        float cosA = arm_cos_f32(angle);
+        SetInverseRow(i, -sinA * k, cosA * k, l * k);
+        vx[i] = -2.0f / 3.0f * sinA * wheelRadius;
+        vy[i] = 2.0f / 3.0f * cosA * wheelRadius;
+        omega[i] = wheelRadius / (3.0f * l);
+    }
+#endif
+}
@@ -0,0 +1,78 @@
+/**
+ * @file chassis_kinematic.h
+ * @brief Forward and inverse kinematics of the chassis
+ * This header defines the kinematics of the chassis selected at compile time
+ * by DEFAULT_CHASSIS_TYPE. Both directions are constant matrices, rebuilt
+ * when the geometry changes and applied as a matrix-vector product.
+ *
+ * Twist: { vx in m/s, vy in m/s, omega in rad/s }, x forward, y to the left.
+ * Wheel order, speeds in rad/s, positive moving the chassis forward:
+ *  - CHASSIS_TYPE_DIFF: left, right
+ *  - CHASSIS_TYPE_SKID, CHASSIS_TYPE_MECANUM: front left, front right, rear left, rear right
+ *  - CHASSIS_TYPE_OMNI3: front, rear left, rear right; each wheel pushes
+ *    counterclockwise around the centre, the front wheel to the left
+ * The differential and skid-steer chassis cannot move sideways, vy is ignored.
+ * @date 2026-10-17
+ * @author Young.R <com.wang@hotmail.com>
+ * @version 1.0
+ * @note This module is part of the Motion Control system.
+ * @see chassis_kinematic.c
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "system_config.h"
+
+#define CHASSIS_TWIST_SIZE  3   // vx, vy, omega
+
+#if DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_DIFF
+#define CHASSIS_WHEEL_NUMBER 2
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_SKID || DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_MECANUM
+#define CHASSIS_WHEEL_NUMBER 4
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_OMNI3
+#define CHASSIS_WHEEL_NUMBER 3
+#else
+#error "Unknown DEFAULT_CHASSIS_TYPE"
+#endif
+
+#if CHASSIS_WHEEL_NUMBER > TOTAL_MOTOR_NUMBER
+#error "The chassis has more wheels than the board has motors"
+#endif
+
+/**
+ * @brief Initialize the kinematics
+ * This function builds the matrices from the geometry in the data store.
+ */
+void ChassisKinematic_Init(void);
+
+/**
+ * @brief Rebuild the matrices for a new geometry.
+ * Not locked: call it from the thread which evaluates the kinematics.
+ * @param wheelRadius Wheel radius in meters.
+ * @param trackWidth Distance between the left and right wheels in meters,
+ *                   diameter of the wheel circle for CHASSIS_TYPE_OMNI3.
+ * @param wheelBase Distance between the front and rear axles in meters, used by CHASSIS_TYPE_MECANUM.
+ * @return true if the geometry is valid, false otherwise; the matrices are kept then.
+ */
+bool ChassisKinematic_SetGeometry(float wheelRadius, float trackWidth, float wheelBase);
+
+/**
+ * @brief Inverse kinematics
+ * This function calculates the wheel angular speeds which achieve a twist.
+ * @param[in] twist Array [CHASSIS_TWIST_SIZE] of the desired twist.
+ * @param[out] wheelSpeed Array [CHASSIS_WHEEL_NUMBER] to store the wheel angular speeds in rad/s.
+ */
+void ChassisKinematic_Inverse(const float* twist, float* wheelSpeed);
+
+/**
+ * @brief Forward kinematics
+ * This function calculates the twist of the chassis from the wheel angular
+ * speeds, in the least squares sense for the chassis with more wheels than
+ * degrees of freedom. Applied to wheel rotations in radians, it gives the
+ * displacement of the chassis.
+ * @param[in] wheelSpeed Array [CHASSIS_WHEEL_NUMBER] of the wheel angular speeds in rad/s.
+ * @param[out] twist Array [CHASSIS_TWIST_SIZE] to store the twist.
+ */
+void ChassisKinematic_Forward(const float* wheelSpeed, float* twist);
@@ -3,8 +3,12 @@
  *  This module is responsible for controlling the motion of the robot
  *  It handles the communication with the DC motors, processes messages from the
  *  RC receiver, and interfaces with the ROS system.
- *  It uses a message queue to receive motion commands and a periodic timer to read
- *  receiver values.
+ *  It uses a message queue to receive motion commands and is activated
+ *  periodically from the TIM7 tick to apply them through the kinematics of
+ *  the chassis type built in. The odometry is updated in the TIM7 interrupt
+ *  with the encoder deltas of the motor PID.
+ *  At rest without upper machine the chassis parks: the TIM7 tick is stopped
+ *  until a command, the upper machine or the receiver wakes it.
  * @file motion_control.c
  * @date 2023-10-01
  * @author Young.R com.wang@hotmail.com
@@ -15,49 +19,79 @@
 #include "motion_control.h"
 
 #include "rl_net.h" // Keil.MDK-Plus::Network:CORE
+#include "rtx_os.h"
 
 #include "main.h"
 #include "dc_motor.h"
+#include "gyro.h"
 #include "rc_receiver.h"
 #include "ros_interface.h"
 #include "system_config.h"
 #include "data_store.h"
 #include "two_wheel_odometry.h"
-#include "two_wheel_kinematic.h"
-#include "two_wheel_differential.h"
+#include "chassis_kinematic.h"
+#include "motion_profiler.h"
+#include "flight_recorder.h"
+#include "activation.h"
+#include "cpu_load.h"
+#include "timer.h"
+
+#include <string.h>
+#include <math.h>
+
 
 /* ------------------ Definitions --------------------*/
 #define MESSAGE_QUEUE_SIZE 16
 #define MOTION_CONTROL_INTERVAL 20 // 20ms
-#define MIN_UPDATE_ODOMETRY_INTERVAL 5 // Minimum 5ms interval
 
 /**
  * @brief Motion Control Flags
  * These flags are used to indicate the type of motion control operation.
  */
 #define FLAG_MOTION_MOVE        0x0001    // Move command flag
-#define FLAG_UPDATE_ODOMETRY    0x0002    // Update odometry flag
+#define FLAG_MOTION_GEOMETRY    0x0002    // Chassis geometry changed flag
+#define FLAG_MOTION_LIMITS      0x0004    // Speed or acceleration limits changed flag
+#define FLAG_MOTION_WAKE        0x0008    // Wake from park flag
 
 /* --------------- Static variables ---------------- */
 static osThreadId_t threadId;
+static uint64_t threadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t threadControlBlock;
+static const osThreadAttr_t threadAttr = {
+    .name = "ThreadMotionControl",
+    .cb_mem = &threadControlBlock,
+    .cb_size = sizeof(threadControlBlock),
+    .stack_mem = threadStack,
+    .stack_size = sizeof(threadStack),
+    .priority = THREAD_PRIORITY_CONTROL,
+};
 static bool isAutoPilotMode = true; // Flag to indicate if the robot is in manual mode
 
 static float maxVelocity, maxOmega; // Maximum velocity and angular velocity
 static float wheelRadius;
 
-static float velocity, omega; // Current velocity and angular velocity
+static volatile float targetVelocity, targetOmega; // Commanded velocity and angular velocity
 static float remoteVelocity, remoteOmega; // Receiver velocity and angular velocity
 
 static GearMode_t currentGearMode = GEAR_MODE_DRIVE; // Current gear mode
 
-static uint32_t updateOdometryInterval = 20; // Interval for updating odometry in ms
+static uint32_t lastEncoderTimestamp; // DWT cycle counter of the last odometry update, 0 before the first
+
+static volatile bool isParked;          // TIM7 tick stopped, see UpdatePark
+static volatile bool isWakeRequested;   // A wake-up is pending, its latency is measured
+static volatile uint32_t wakeRequestCycles; // DWT cycle counter of the pending wake request
+static uint32_t restTime;               // ms at rest without upper machine
+static uint32_t parkStartTime;          // Kernel tick count at the start of the park
+static MotionControl_ParkStats_t parkStats;
 
 /* --------------- Static functions ---------------- */
 static void ReceiverCallback(ReceiverValues_t* receiverValue);
-static void UpdateOdometry(void);
+static void EncoderCallback(const int32_t* deltaCounts, uint32_t timestamp);
 static void MotionControl_Process(void *);
-static void UpdateOdometryTimerCallback(void *arg);
-static void MotionControlTimerCallback(void *arg);
+static void RecordMotion(void);
+static void ApplyMotion(float velocity, float omega);
+static void UpdatePark(float velocity, float omega, float profiledVelocity, float profiledOmega);
+static void Unpark(void);
 
 /**
  * @brief Initialize the Motion Control System
@@ -71,27 +105,43 @@ void MotionControl_Init(void)
     maxOmega = DataStore_GetMaxOmega();
 	wheelRadius = DataStore_GetWheelRadius();
 
-    ChassisTwoWheelDifferential_Init();
-    TwoWheelDifferentialKinematic_Init();
+    ChassisKinematic_Init();
+    MotionProfiler_Init();
     TwoWheelOdometry_Init();
 
-    threadId = osThreadNew(MotionControl_Process, NULL, NULL);
+    threadId = osThreadNew(MotionControl_Process, NULL, &threadAttr);
     assert_param(threadId != NULL);
 
-    // Set up periodic timer to update odometry
-    osTimerId_t updateOdometryTimer = osTimerNew(UpdateOdometryTimerCallback, osTimerPeriodic, NULL, NULL);
-    assert_param(updateOdometryTimer != NULL);
-    updateOdometryInterval = (uint32_t)(1000.0f / DataStore_GetOdometryFeedbackFrequency());
-    if (updateOdometryInterval < MIN_UPDATE_ODOMETRY_INTERVAL)
-        updateOdometryInterval = MIN_UPDATE_ODOMETRY_INTERVAL; // Minimum 5ms interval
-    osTimerStart(updateOdometryTimer, updateOdometryInterval);
+    // Take a new geometry without reboot, the thread rebuilds what depends on it
+    const uint64_t geometryKeys = DATA_STORE_KEY_MASK(DATA_STORE_KEY_WHEEL_RADIUS) |
+                                  DATA_STORE_KEY_MASK(DATA_STORE_KEY_TRACK_WIDTH) |
+                                  DATA_STORE_KEY_MASK(DATA_STORE_KEY_WHEEL_BASE) |
+                                  DATA_STORE_KEY_MASK(DATA_STORE_KEY_ODOMETRY_NOISE);
+    bool result = DataStore_Subscribe(geometryKeys, threadId, FLAG_MOTION_GEOMETRY);
+    assert_param(result);
+    const uint64_t limitKeys = DATA_STORE_KEY_MASK(DATA_STORE_KEY_MAX_VELOCITY) |
+                               DATA_STORE_KEY_MASK(DATA_STORE_KEY_MAX_OMEGA) |
+                               DATA_STORE_KEY_MASK(DATA_STORE_KEY_MAX_LINEAR_ACCELERATION) |
+                               DATA_STORE_KEY_MASK(DATA_STORE_KEY_MAX_ANGULAR_ACCELERATION);
+    result = DataStore_Subscribe(limitKeys, threadId, FLAG_MOTION_LIMITS);
+    assert_param(result);
 
-    // Set up periodic timer to read receiver values
-    osTimerId_t motionControlTimer = osTimerNew(MotionControlTimerCallback, osTimerPeriodic, NULL, NULL);
-    assert_param(motionControlTimer != NULL);
-    osTimerStart(motionControlTimer, MOTION_CONTROL_INTERVAL);
+    // Integrate the odometry in the control period, from the encoder deltas of the PID
+    result = DCMotor_RegisterEncoderCallback(EncoderCallback);
+    assert_param(result);
+
+    // Activate the motion control periodically, its wake-up latency is measured
+    const Activation_Task_t motionTask = {
+        .thread = threadId,
+        .flags = FLAG_MOTION_MOVE,
+        .period = MOTION_CONTROL_INTERVAL,
+        .phase = ACTIVATION_PHASE_MOTION,
+        .isLatencyProbe = true,
+    };
+    result = Activation_Register(&motionTask);
+    assert_param(result);
 
-    bool result = RC_Receiver_Register_Callback(ReceiverCallback);
+    result = RC_Receiver_Register_Callback(ReceiverCallback);
     assert_param(result);
 }
 
@@ -106,70 +156,206 @@ static void MotionControl_Process(void *arg)
 {
     while (true)
     {
-        uint32_t flags = osThreadFlagsWait(FLAG_MOTION_MOVE | FLAG_UPDATE_ODOMETRY, osFlagsWaitAny, osWaitForever);
-        if (flags & FLAG_UPDATE_ODOMETRY)
+        uint32_t flags = osThreadFlagsWait(FLAG_MOTION_MOVE | FLAG_MOTION_GEOMETRY | FLAG_MOTION_LIMITS | FLAG_MOTION_WAKE, osFlagsWaitAny, osWaitForever);
+        if (flags & FLAG_MOTION_WAKE) Unpark();
+        if (flags & FLAG_MOTION_LIMITS)
+        {
+            maxVelocity = DataStore_GetMaxVelocity();
+            maxOmega = DataStore_GetMaxOmega();
+            MotionProfiler_ReloadLimits();
+        }
+        if (flags & FLAG_MOTION_GEOMETRY)
         {
-            UpdateOdometry();
+            // Rebuilt in this thread, the only user of the kinematics; the pose is kept
+            wheelRadius = DataStore_GetWheelRadius();
+            ChassisKinematic_SetGeometry(wheelRadius, DataStore_GetTrackWidth(), DataStore_GetWheelBase());
+            TwoWheelOdometry_ReloadParameters();
         }
-        if (flags & FLAG_MOTION_MOVE)
+        if ((flags & FLAG_MOTION_MOVE) && !isParked)
         {
-            if (!isAutoPilotMode)
+            CpuLoad_WakeRun();
+            float velocity = isAutoPilotMode ? targetVelocity : remoteVelocity;
+            float omega = isAutoPilotMode ? targetOmega : remoteOmega;
+            float profiledVelocity, profiledOmega;
+            // Ramp the command with limited acceleration and jerk before the inverse kinematics
+            MotionProfiler_Update(velocity, omega, MOTION_CONTROL_INTERVAL / 1000.0f, &profiledVelocity, &profiledOmega);
+            ApplyMotion(profiledVelocity, profiledOmega);
+            if (isWakeRequested)
             {
-                velocity = remoteVelocity;
-                omega = remoteOmega;
+                // First period after a wake-up: the wheels are driven again
+                uint32_t latency = DWT->CYCCNT - wakeRequestCycles;
+                isWakeRequested = false;
+                if (latency > parkStats.wakeLatencyMax) parkStats.wakeLatencyMax = latency;
             }
-            ChassisTwoWheelDifferential_SetMotion(velocity, omega);
+            RecordMotion();
+            UpdatePark(velocity, omega, profiledVelocity, profiledOmega);
         }
     }
 }
 
 /**
- * @brief Initialize the System
- * This function initializes the motion control system components.
- * It initializes the two-wheel differential chassis and sets initial motion parameters.
- * @return None
+ * @brief Move the robot with specified velocity and angular velocity
+ * This function stores the command, the motion control process ramps to it
+ * at its next period.
+ * @param velocity linear velocity in m/s
+ * @param omega angular velocity in rad/s
  */
-void UpdateOdometryTimerCallback(void *arg)
+void MotionControl_Move(float velocity, float omega)
 {
-    (void)arg;
-    osThreadFlagsSet(threadId, FLAG_UPDATE_ODOMETRY);
+    targetVelocity = velocity;
+    targetOmega = omega;
+    if (velocity != 0.0f || omega != 0.0f) MotionControl_Wake();
 }
 
 /**
- * @brief Motion Control Timer Callback
- * This function is called periodically by the motion control timer.
- * It sets a flag to indicate that a motion move operation should be performed.
- * @param arg pointer to argument (not used)
+ * @brief Wake the chassis from park
+ * The TIM7 tick is restarted by the motion control process, the delay to
+ * its first period is measured. Nothing is done if not parked. The reason
+ * to wake must be visible before the call, the park is checked against it.
  */
-void MotionControlTimerCallback(void *arg)
+void MotionControl_Wake(void)
 {
-    (void)arg;
-    osThreadFlagsSet(threadId, FLAG_MOTION_MOVE);
+    if (!isParked) return;
+    if (!isWakeRequested)
+    {
+        wakeRequestCycles = DWT->CYCCNT;
+        isWakeRequested = true;
+    }
+    osThreadFlagsSet(threadId, FLAG_MOTION_WAKE);
 }
 
 /**
- * @brief Move the robot with specified velocity and angular velocity
- * This function sends a message to the motion control process to move the robot.
- * @param velocity linear velocity in m/s
- * @param omega angular velocity in rad/s
+ * @brief Check whether the chassis is parked
+ * @return true while the TIM7 tick is stopped by the park
  */
-void MotionControl_Move(float velocity, float omega)
+bool MotionControl_IsParked(void)
 {
-    velocity = velocity;
-    omega = omega;
-    osThreadFlagsSet(threadId, FLAG_MOTION_MOVE);
+    return isParked;
 }
 
 /**
- * @brief Reset odometry and motor encoder counters to zero.
- * This function resets the odometry state and motor encoder values.
+ * @brief Get the park statistics
+ * The maximum wake-up latency restarts from zero after each read.
+ * @param stats pointer to the statistics to fill
+ * @return true if successful, false otherwise
+ */
+bool MotionControl_GetParkStats(MotionControl_ParkStats_t *stats)
+{
+    if (stats == NULL) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = parkStats;
+    if (isParked) stats->parkTime += osKernelGetTickCount() - parkStartTime;
+    parkStats.wakeLatencyMax = 0;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Park the chassis once it rests without upper machine
+ * Called every motion period. At rest means no command, the profiler
+ * settled and every wheel slower than MOTION_PARK_SPEED. After
+ * MOTION_PARK_DELAY at rest the motors are released and the TIM7 tick is
+ * stopped: the PID, the odometry and the periodic activations stop with it,
+ * the core sleeps until the next kernel timeout or interrupt.
+ * @param velocity commanded linear velocity in m/s
+ * @param omega commanded angular velocity in rad/s
+ * @param profiledVelocity linear velocity out of the profiler in m/s
+ * @param profiledOmega angular velocity out of the profiler in rad/s
+ */
+void UpdatePark(float velocity, float omega, float profiledVelocity, float profiledOmega)
+{
+    bool isAtRest = velocity == 0.0f && omega == 0.0f && profiledVelocity == 0.0f && profiledOmega == 0.0f &&
+                    !ROS_Interface_IsUpperMachineAlive();
+    for (int i = 0; i < TOTAL_MOTOR_NUMBER && isAtRest; i++)
+    {
+        if (fabsf(DCMotor_GetAngularSpeed(i)) > MOTION_PARK_SPEED) isAtRest = false;
+    }
+    restTime = isAtRest ? restTime + MOTION_CONTROL_INTERVAL : 0;
+    if (restTime < MOTION_PARK_DELAY) return;
+    restTime = 0;
+
+    // From here MotionControl_Wake signals; a reason to wake set before is caught below
+    isParked = true;
+    bool isCommanded = isAutoPilotMode ? (targetVelocity != 0.0f || targetOmega != 0.0f)
+                                       : (remoteVelocity != 0.0f || remoteOmega != 0.0f);
+    if (isCommanded || ROS_Interface_IsUpperMachineAlive())
+    {
+        isParked = false;
+        return;
+    }
+    Timer_StopTick();
+    if (!DCMotor_Park())
+    {
+        // The identification routine needs the control period
+        Timer_StartTick();
+        isParked = false;
+        return;
+    }
+    CpuLoad_WakeSuspend();
+    parkStartTime = osKernelGetTickCount();
+    parkStats.parkCount++;
+}
+
+/**
+ * @brief Restart the control period after a park
+ * The motor controllers and the profiler restart from rest. The odometry
+ * takes the interval of its first update as nominal, the last timestamp is
+ * older than the cycle counter wrap.
+ */
+void Unpark(void)
+{
+    if (!isParked)
+    {
+        // The park was called off after the request
+        isWakeRequested = false;
+        return;
+    }
+    DCMotor_Resume();
+    MotionProfiler_Reset(0.0f, 0.0f);
+    lastEncoderTimestamp = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    parkStats.parkTime += osKernelGetTickCount() - parkStartTime;
+    isParked = false;
+    __set_PRIMASK(primask);
+    Timer_StartTick();
+}
+
+/**
+ * @brief Reset odometry to zero.
+ * This function resets the odometry state. The geometry needs no reset, its
+ * changes are taken by the motion control process as they are stored.
+ * The odometry only uses encoder deltas, the encoders keep counting.
  */
 void MotionControl_ResetOdometry(void)
 {
-    DCMotor_ResetEncoders();
     TwoWheelOdometry_Reset();
 }
 
+/**
+ * @brief Drive the wheels for a chassis motion
+ * The motion is clamped to the speed limits and turned into wheel speeds by
+ * the inverse kinematics.
+ * @param velocity linear velocity in m/s
+ * @param omega angular velocity in rad/s
+ */
+void ApplyMotion(float velocity, float omega)
+{
+    if (velocity > maxVelocity) velocity = maxVelocity;
+    else if (velocity < -maxVelocity) velocity = -maxVelocity;
+    if (omega > maxOmega) omega = maxOmega;
+    else if (omega < -maxOmega) omega = -maxOmega;
+
+    const float twist[CHASSIS_TWIST_SIZE] = { velocity, 0.0f, omega };
+    float wheelSpeed[CHASSIS_WHEEL_NUMBER];
+    ChassisKinematic_Inverse(twist, wheelSpeed);
+    for (uint32_t i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+    {
+        DCMotor_SetAngularSpeed(i, wheelSpeed[i]);
+    }
+}
+
 /**
  * @brief Receiver Callback
  * This function is called when new receiver values are available.
@@ -182,21 +368,58 @@ void ReceiverCallback(ReceiverValues_t* receiverValue)
     isAutoPilotMode = receiverValue->autoMode;
     remoteVelocity = receiverValue->throttle * maxVelocity;
     remoteOmega = receiverValue->steering * maxOmega;
+    if (!isAutoPilotMode && (remoteVelocity != 0.0f || remoteOmega != 0.0f)) MotionControl_Wake();
 }
 
 /**
  * @brief Update the odometry of the robot
- * This function reads the wheel positions from the motors and updates the odometry.
+ * This function runs in the TIM7 interrupt at every control period with the
+ * encoder deltas read by the PID. The interval is measured between two
+ * encoder samplings instead of assumed, and the integer deltas keep their
+ * resolution however large the encoder counts grow. The heading is fused
+ * with the angle the gyro turned since the last period while it delivers
+ * samples.
+ * @param deltaCounts counts of each wheel since the last period
+ * @param timestamp DWT cycle counter when the encoders were read
  */
-void UpdateOdometry(void)
+void EncoderCallback(const int32_t* deltaCounts, uint32_t timestamp)
 {
-    static float wheelPositionArray[TOTAL_MOTOR_NUMBER];
-    // Read wheel positions from motors
+    float wheelDeltaArray[TOTAL_MOTOR_NUMBER];
     for (int i = 0; i < TOTAL_MOTOR_NUMBER; i++)
     {
-        wheelPositionArray[i] = DCMotor_GetEncoderValue(i) * (2*PI);
+        wheelDeltaArray[i] = (float)deltaCounts[i] * DCMotor_GetRadiansPerCount(i);
     }
-    TwoWheelOdometry_Update(wheelPositionArray, (float)updateOdometryInterval / 1000.0f);
+    float dt = MOTION_CONTROL_INTERVAL / 1000.0f;
+    if (lastEncoderTimestamp != 0) dt = (float)(timestamp - lastEncoderTimestamp) / (float)SystemCoreClock;
+    lastEncoderTimestamp = timestamp;
+    // Wheels 0 and 1 are the left and right wheels of the odometry, a front pair on a skid-steer chassis
+    float gyroTurn;
+    bool hasGyro = Gyro_TakeTurn(&gyroTurn, timestamp);
+    TwoWheelOdometry_Update(wheelDeltaArray, hasGyro ? &gyroTurn : NULL, dt, timestamp);
+}
+
+/**
+ * @brief Record odometry and wheel speeds in the flight recorder
+ * Samples are decimated to one every FLIGHT_RECORDER_SAMPLE_PERIOD.
+ */
+void RecordMotion(void)
+{
+    static uint32_t lastRecordTime;
+    uint32_t now = osKernelGetTickCount();
+    if (now - lastRecordTime < FLIGHT_RECORDER_SAMPLE_PERIOD) return;
+    lastRecordTime = now;
+
+    FlightRecordOdometry_t odometry;
+    if (TwoWheelOdometry_GetOdometry(&odometry.posX, &odometry.posY, &odometry.theta, &odometry.velocity, &odometry.omega))
+        FlightRecorder_Log(FLIGHT_RECORD_ODOMETRY, &odometry, sizeof(odometry));
+
+    FlightRecordWheelSpeed_t wheelSpeed;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        wheelSpeed.commanded[i] = DCMotor_GetTargetAngularSpeed(i);
+        wheelSpeed.measured[i] = DCMotor_GetAngularSpeed(i);
+    }
+    FlightRecorder_Log(FLIGHT_RECORD_WHEEL_SPEED, &wheelSpeed, sizeof(wheelSpeed));
 }
 
 /**
@@ -212,6 +435,21 @@ inline bool MotionControl_GetOdometry(float* pX, float* pY, float* pTheta, float
     return TwoWheelOdometry_GetOdometry(pX, pY, pTheta, pVelocity, pOmega);
 }
 
+/**
+ * @brief Get the covariance of the odometry
+ * @param pPoseCovariance Array of 6 to store the upper triangle of the x, y, theta covariance.
+ * @param pTwistCovariance Array of 3 to store the upper triangle of the velocity, omega covariance.
+ * @return true if covariance retrieval is successful, false otherwise.
+ */
+bool MotionControl_GetOdometryCovariance(float* pPoseCovariance, float* pTwistCovariance)
+{
+    TwoWheelOdometry_Covariance_t covariance;
+    if (pPoseCovariance == NULL || pTwistCovariance == NULL || !TwoWheelOdometry_GetCovariance(&covariance)) return false;
+    memcpy(pPoseCovariance, covariance.pose, sizeof(covariance.pose));
+    memcpy(pTwistCovariance, covariance.twist, sizeof(covariance.twist));
+    return true;
+}
+
 /**
  * @brief Get the speed of a wheel
  * This function retrieves the angular speed of a motor and converts it to linear speed.
@@ -17,6 +17,15 @@
 
 #include "ros_messages.h"
 
+/**
+ * @brief Park statistics since boot
+ */
+typedef struct {
+    uint32_t parkCount;         // Number of parks
+    uint32_t parkTime;          // Time parked in ms, wraps
+    uint32_t wakeLatencyMax;    // Longest delay from a wake request to the wheels driven again, in cycles, since the last read
+} MotionControl_ParkStats_t;
+
 /**
  * @brief Initialize the Motion Control System
  * This function initializes the motion control system by creating a message queue,
@@ -27,12 +36,35 @@ void MotionControl_Init(void);
 
 /**
  * @brief Move the robot with specified velocity and angular velocity
- * This function sends a message to the motion control process to move the robot.
+ * This function stores the command, the motion control process ramps to it
+ * at its next period.
  * @param velocity linear velocity in m/s
  * @param omega angular velocity in rad/s
  */
 void MotionControl_Move(float velocity, float omega);
 
+/**
+ * @brief Wake the chassis from park
+ * The TIM7 tick is restarted by the motion control process, the delay to
+ * its first period is measured. Nothing is done if not parked. The reason
+ * to wake must be visible before the call, the park is checked against it.
+ */
+void MotionControl_Wake(void);
+
+/**
+ * @brief Check whether the chassis is parked
+ * @return true while the TIM7 tick is stopped by the park
+ */
+bool MotionControl_IsParked(void);
+
+/**
+ * @brief Get the park statistics
+ * The maximum wake-up latency restarts from zero after each read.
+ * @param stats pointer to the statistics to fill
+ * @return true if successful, false otherwise
+ */
+bool MotionControl_GetParkStats(MotionControl_ParkStats_t *stats);
+
 /**
  * @brief Get the speed of a wheel
  * This function retrieves the angular speed of a motor and converts it to linear speed.
@@ -58,6 +90,14 @@ bool MotionControl_IsAutoPilotMode(void);
  */
 bool MotionControl_GetOdometry(float* pX, float* pY, float* pTheta, float* pVelocity, float* pOmega);
 
+/**
+ * @brief Get the covariance of the odometry
+ * @param pPoseCovariance Array of 6 to store the upper triangle of the x, y, theta covariance.
+ * @param pTwistCovariance Array of 3 to store the upper triangle of the velocity, omega covariance.
+ * @return true if covariance retrieval is successful, false otherwise.
+ */
+bool MotionControl_GetOdometryCovariance(float* pPoseCovariance, float* pTwistCovariance);
+
 /**
  * @brief Get current gear mode
  * This function retrieves the current gear mode of the robot.
@@ -71,7 +111,8 @@ GearMode_t MotionControl_GetGearMode(void);
 void MotionControl_SetGearMode(GearMode_t gearMode);
 
 /**
- * @brief Reset odometry and motor encoder counters to zero.
- * This function resets the odometry state and motor encoder values.
+ * @brief Reset odometry to zero.
+ * This function resets the odometry state. The geometry needs no reset, its
+ * changes are taken by the motion control process as they are stored.
  */
 void MotionControl_ResetOdometry(void);
@@ -0,0 +1,183 @@
+/**
+ * @file motion_profiler.c
+ * @brief Jerk-limited velocity profiler for the chassis commands
+ * This module ramps the linear and angular velocities towards their commands
+ * with an S-curve: the acceleration itself changes at most by the jerk limit,
+ * and starts to fall early enough to reach the command without overshoot.
+ * Both axes get limits scaled to the same duration, so the pair (velocity,
+ * omega) moves on a straight line and the turning radius of the command is
+ * kept while the limits are active.
+ * @date 2026-10-17
+ * @author Young.R <com.wang@hotmail.com>
+ * @version 1.0
+ * @note This module is part of the Motion Control system.
+ */
+
+#include "motion_profiler.h"
+#include "data_store.h"
+#include <math.h>
+#include <stddef.h>
+
+/**
+ * @brief State of one profiled axis
+ */
+typedef struct {
+    float velocity;         // Profiled velocity
+    float acceleration;     // Current acceleration
+} ProfileAxis_t;
+
+/* ------------------------- Static Variables ------------------------- */
+static ProfileAxis_t linearAxis;
+static ProfileAxis_t angularAxis;
+// Limits of the data store, reloaded when they are stored
+static float maxVelocity, maxOmega;
+static float maxLinearAcceleration, maxAngularAcceleration;
+
+/* ------------------------- Static Functions ------------------------- */
+static float Clamp(float value, float limit);
+static void StepAxis(ProfileAxis_t* axis, float target, float maxAcceleration, float maxJerk, float dt);
+
+/**
+ * @brief Initialize the motion profiler
+ * This function loads the limits and starts the profile at rest.
+ */
+void MotionProfiler_Init(void)
+{
+    MotionProfiler_ReloadLimits();
+    MotionProfiler_Reset(0.0f, 0.0f);
+}
+
+/**
+ * @brief Reload the limits of the profiler
+ * This function reads the maximum velocities and accelerations from the data
+ * store, the next update uses them.
+ * Must be called from the thread which updates the profile.
+ */
+void MotionProfiler_ReloadLimits(void)
+{
+    maxVelocity = DataStore_GetMaxVelocity();
+    maxOmega = DataStore_GetMaxOmega();
+    maxLinearAcceleration = DataStore_GetMaxLinearAcceleration();
+    maxAngularAcceleration = DataStore_GetMaxAngularAcceleration();
+}
+
+/**
+ * @brief Reset the profile to a given motion
+ * The acceleration is cleared, the next update starts from this motion.
+ * @param velocity linear velocity in m/s
+ * @param omega angular velocity in rad/s
+ */
+void MotionProfiler_Reset(float velocity, float omega)
+{
+    linearAxis.velocity = velocity;
+    linearAxis.acceleration = 0.0f;
+    angularAxis.velocity = omega;
+    angularAxis.acceleration = 0.0f;
+}
+
+/**
+ * @brief Advance the profile by one control period
+ * The targets are clamped to the maximum velocities, then approached with
+ * the maximum accelerations and a jerk limit. Both axes
+ * are scaled to arrive together, which keeps the curvature of the command.
+ * A limit of zero or less leaves its axis unprofiled.
+ * @param[in] targetVelocity commanded linear velocity in m/s
+ * @param[in] targetOmega commanded angular velocity in rad/s
+ * @param[in] dt control period in seconds
+ * @param[out] velocity pointer to store the profiled linear velocity in m/s
+ * @param[out] omega pointer to store the profiled angular velocity in rad/s
+ */
+void MotionProfiler_Update(float targetVelocity, float targetOmega, float dt, float* velocity, float* omega)
+{
+    if (velocity == NULL || omega == NULL || dt <= 0.0f) return;
+
+    targetVelocity = Clamp(targetVelocity, maxVelocity);
+    targetOmega = Clamp(targetOmega, maxOmega);
+    float linearLimit = maxLinearAcceleration;
+    float angularLimit = maxAngularAcceleration;
+
+    // Unprofiled axes follow their command directly
+    if (linearLimit <= 0.0f) linearAxis = (ProfileAxis_t){ targetVelocity, 0.0f };
+    if (angularLimit <= 0.0f) angularAxis = (ProfileAxis_t){ targetOmega, 0.0f };
+
+    // Scale the limits so that both axes need the same time to reach their command
+    float linearDelta = fabsf(targetVelocity - linearAxis.velocity);
+    float angularDelta = fabsf(targetOmega - angularAxis.velocity);
+    float linearTime = linearLimit > 0.0f ? linearDelta / linearLimit : 0.0f;
+    float angularTime = angularLimit > 0.0f ? angularDelta / angularLimit : 0.0f;
+    float syncTime = fmaxf(linearTime, angularTime);
+    if (syncTime > 0.0f)
+    {
+        if (linearTime < syncTime && linearLimit > 0.0f)
+            linearLimit = fmaxf(linearDelta / syncTime, fabsf(linearAxis.acceleration));
+        if (angularTime < syncTime && angularLimit > 0.0f)
+            angularLimit = fmaxf(angularDelta / syncTime, fabsf(angularAxis.acceleration));
+    }
+
+    if (linearLimit > 0.0f)
+        StepAxis(&linearAxis, targetVelocity, linearLimit, linearLimit / MOTION_PROFILER_JERK_TIME, dt);
+    if (angularLimit > 0.0f)
+        StepAxis(&angularAxis, targetOmega, angularLimit, angularLimit / MOTION_PROFILER_JERK_TIME, dt);
+
+    *velocity = linearAxis.velocity;
+    *omega = angularAxis.velocity;
+}
+
+/**
+ * @brief Clamp a value to a symmetric limit
+ * @param value the value to clamp
+ * @param limit the limit, positive
+ * @return the clamped value
+ */
+float Clamp(float value, float limit)
+{
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+/**
+ * @brief Advance one axis by one period
+ * The acceleration moves towards the limit in the direction of the target,
+ * or towards zero once the velocity gained while it falls at the jerk limit
+ * would reach the target. The last step lands exactly on the target.
+ * @param axis the axis to advance
+ * @param target the target velocity
+ * @param maxAcceleration acceleration limit, positive
+ * @param maxJerk jerk limit, positive
+ * @param dt period in seconds
+ */
+void StepAxis(ProfileAxis_t* axis, float target, float maxAcceleration, float maxJerk, float dt)
+{
+    float error = target - axis->velocity;
+    float acceleration = axis->acceleration;
+    float jerkStep = maxJerk * dt;
+
+    // Close enough to stop within this period: land on the target
+    if (fabsf(error) <= fabsf(acceleration) * dt + 0.5f * jerkStep * dt && fabsf(acceleration) <= jerkStep)
+    {
+        axis->velocity = target;
+        axis->acceleration = 0.0f;
+        return;
+    }
+
+    // Velocity still gained while the acceleration falls to zero at the jerk limit
+    float stopping = acceleration * fabsf(acceleration) / (2.0f * maxJerk);
+    float desired = (error - stopping) > 0.0f ? maxAcceleration : -maxAcceleration;
+    if (fabsf(error - stopping) < 0.5f * jerkStep * dt) desired = 0.0f;
+
+    if (desired > acceleration + jerkStep) acceleration += jerkStep;
+    else if (desired < acceleration - jerkStep) acceleration -= jerkStep;
+    else acceleration = desired;
+    acceleration = Clamp(acceleration, maxAcceleration);
+
+    float velocity = axis->velocity + acceleration * dt;
+    // Never cross the target while the acceleration still points to it
+    if ((error > 0.0f && velocity > target) || (error < 0.0f && velocity < target))
+    {
+        velocity = target;
+        acceleration = 0.0f;
+    }
+    axis->velocity = velocity;
+    axis->acceleration = acceleration;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file motion_profiler.h
+ * @brief Jerk-limited velocity profiler for the chassis commands
+ * This header defines the interface of the stage between the motion commands
+ * and the inverse kinematics. The commanded linear and angular velocities are
+ * reached with limited acceleration and jerk instead of a step.
+ * @date 2026-10-17
+ * @author Young.R <com.wang@hotmail.com>
+ * @version 1.0
+ * @note This module is part of the Motion Control system.
+ * @see motion_profiler.c
+ */
+#pragma once
+
+// Time to build up the full acceleration, sets the jerk limit to acceleration / time
+#define MOTION_PROFILER_JERK_TIME   0.1f
+
+/**
+ * @brief Initialize the motion profiler
+ * This function loads the limits and starts the profile at rest.
+ */
+void MotionProfiler_Init(void);
+
+/**
+ * @brief Reload the limits of the profiler
+ * This function reads the maximum velocities and accelerations from the data
+ * store, the next update uses them.
+ * Must be called from the thread which updates the profile.
+ */
+void MotionProfiler_ReloadLimits(void);
+
+/**
+ * @brief Reset the profile to a given motion
+ * The acceleration is cleared, the next update starts from this motion.
+ * @param velocity linear velocity in m/s
+ * @param omega angular velocity in rad/s
+ */
+void MotionProfiler_Reset(float velocity, float omega);
+
+/**
+ * @brief Advance the profile by one control period
+ * The targets are clamped to the maximum velocities, then approached with
+ * the maximum accelerations and a jerk limit. Both axes
+ * are scaled to arrive together, which keeps the curvature of the command.
+ * A limit of zero or less leaves its axis unprofiled.
+ * @param[in] targetVelocity commanded linear velocity in m/s
+ * @param[in] targetOmega commanded angular velocity in rad/s
+ * @param[in] dt control period in seconds
+ * @param[out] velocity pointer to store the profiled linear velocity in m/s
+ * @param[out] omega pointer to store the profiled angular velocity in rad/s
+ */
+void MotionProfiler_Update(float targetVelocity, float targetOmega, float dt, float* velocity, float* omega);
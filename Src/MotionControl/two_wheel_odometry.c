@@ -4,25 +4,63 @@
  * This module provides functions to initialize, update, retrieve, and reset
  * the odometry of a two-wheel differential drive robot.
  * @date 2025-10-26
+ *       Modified on 2026-10-17: exact arc integration into fixed point
+ *       accumulators. The position is summed in int64 nanometres and the
+ *       heading in a uint32 binary angle, which wraps by itself; each step
+ *       is computed in float from the small wheel increments, so neither
+ *       the resolution nor the cost depends on the distance travelled.
+ *       Modified on 2026-10-17: updated from the TIM7 interrupt with the
+ *       encoder deltas of each control period and their measured interval.
+ *       Threads read a snapshot guarded by a sequence counter: the
+ *       interrupt makes it odd while it writes, a reader copies and retries
+ *       if the counter was odd or changed meanwhile. The interrupt never
+ *       waits and the threads never mask it.
+ *       Modified on 2026-10-17: covariance of the pose and of the twist,
+ *       propagated at every update with the usual differential drive error
+ *       model: the travel of each wheel has a variance proportional to its
+ *       length (slip), the measured wheel speeds have a constant variance
+ *       on top (encoder resolution). The symmetric matrices are kept as
+ *       their upper triangles and updated in closed form.
+ *       Modified on 2026-10-17: heading from a yaw-rate gyro when one is
+ *       fitted, fused with the wheels by heading_fusion. The wheels keep
+ *       the distance travelled; the heading no longer follows a slipping
+ *       wheel.
  * @author Young.R <com.wang@hotmail.com>
  * @version 1.0
  * @note This module is part of the Motion Control system.
  */
 #include "two_wheel_odometry.h"
 
-#include "arm_math.h"
+#include "main.h"
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "data_store.h"
+#include "heading_fusion.h"
+#include "system_config.h"
+
+/* ---------------------- Definitions ----------------------------------- */
+#define METERS_TO_NANOMETERS    1e9f
+#define NANOMETERS_TO_METERS    1e-9f
+#define RADIANS_TO_HEADING      (4294967296.0f / (2.0f * (float)PI))   // 2^32 per turn
+#define HEADING_TO_RADIANS      ((2.0f * (float)PI) / 4294967296.0f)
+#define SINC_SERIES_LIMIT       1e-2f   // Below this half angle sin(a)/a uses its series
 
 /* ---------------------- Static Variables ------------------------------ */
-static float lastPositionL = 0.0f;
-static float lastPositionR = 0.0f;
-static float x = 0.0f;      // X position in meters
-static float y = 0.0f;      // Y position in meters
-static float theta = 0.0f;  // Orientation in radians
-static float velocity = 0.0f; // Linear velocity in m/s
-static float omega = 0.0f; // Angular velocity in rad/s
+static TwoWheelOdometry_State_t state;  // Written by the update only
+static float headingResidual = 0.0f;    // Part of the heading steps not yet in the pose
+static float wheelRadius, trackWidth;   // Geometry, read from the data store out of the interrupt
+static DataStore_OdometryNoise_t noise; // Wheel noise model, read from the data store out of the interrupt
+static HeadingFusion_t headingFusion;   // Kept over resets, the gyro bias does not depend on the pose
+
+static volatile uint32_t snapshotSequence;  // Odd while the snapshot is written
+static TwoWheelOdometry_State_t snapshot;   // Copy of the state for the readers
+
+/* ---------------------- Static Functions ------------------------------ */
+static float Sinc(float a);
+static void PropagateCovariance(float dS, float varS, float varTheta, float covST, float cosTheta, float sinTheta);
+static void Publish(void);
 
 /**
  * @brief Initialize the Two Wheel Odometry System
@@ -30,6 +68,30 @@ static float omega = 0.0f; // Angular velocity in rad/s
  */
 void TwoWheelOdometry_Init(void)
 {
+    const HeadingFusion_Params_t params = { GYRO_RATE_VARIANCE, GYRO_BIAS_VARIANCE, GYRO_WHEEL_GAIN,
+                                            GYRO_SLIP_GATE, GYRO_STILL_TIME };
+    HeadingFusion_Init(&headingFusion, &params);
+    TwoWheelOdometry_Reset();
+}
+
+/**
+ * @brief Get the latest state of the odometry.
+ * Lock-free, may be called from any thread.
+ * @param result Pointer to the state to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetState(TwoWheelOdometry_State_t* result)
+{
+    if (result == NULL) return false;
+    uint32_t sequence;
+    do
+    {
+        sequence = snapshotSequence;
+        __DMB();
+        *result = snapshot;
+        __DMB();
+    } while ((sequence & 1U) || sequence != snapshotSequence);
+    return true;
 }
 
 /**
@@ -45,70 +107,246 @@ void TwoWheelOdometry_Init(void)
 bool TwoWheelOdometry_GetOdometry(float* pX, float* pY, float* pTheta, float* pVelocity, float* pOmega)
 {
     if (pX == NULL || pY == NULL || pTheta == NULL || pVelocity == NULL || pOmega == NULL) return false;
-    *pX = x;
-    *pY = y;
-    *pTheta = theta;
-    *pVelocity = velocity;
-    *pOmega = omega;
+    TwoWheelOdometry_State_t current;
+    TwoWheelOdometry_GetState(&current);
+    *pX = (float)current.pose.x * NANOMETERS_TO_METERS;
+    *pY = (float)current.pose.y * NANOMETERS_TO_METERS;
+    *pTheta = (float)(int32_t)current.pose.heading * HEADING_TO_RADIANS;  // -PI to PI
+    *pVelocity = current.velocity;
+    *pOmega = current.omega;
+    return true;
+}
+
+/**
+ * @brief Get the covariance of the odometry.
+ * The pose covariance grows with the distance travelled from the last reset,
+ * the twist covariance is the one of the last update.
+ * @param result Pointer to the covariance to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetCovariance(TwoWheelOdometry_Covariance_t* result)
+{
+    TwoWheelOdometry_State_t current;
+    if (result == NULL || !TwoWheelOdometry_GetState(&current)) return false;
+    *result = current.covariance;
+    return true;
+}
+
+/**
+ * @brief Get the pose accumulators of the chassis.
+ * @param result Pointer to the pose to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetPose(TwoWheelOdometry_Pose_t* result)
+{
+    TwoWheelOdometry_State_t current;
+    if (result == NULL || !TwoWheelOdometry_GetState(&current)) return false;
+    *result = current.pose;
     return true;
 }
 
-/** @brief Update the odometry based on wheel position data.
- * This function updates the odometry of the chassis based on the provided wheel position data.
- * @param wheelPosArray Array containing the positions of the left and right wheels in radians.
- *                      wheelPosArray[0] is the left wheel position, wheelPosArray[1] is the right wheel position.
+/**
+ * @brief Get the motion between two poses in float.
+ * The difference is taken on the accumulators, so it keeps its resolution
+ * however far the chassis is from the origin.
+ * @param from Pointer to the earlier pose.
+ * @param to Pointer to the later pose.
+ * @param dX Pointer to store the x displacement in meters.
+ * @param dY Pointer to store the y displacement in meters.
+ * @param dTheta Pointer to store the rotation in radians, -PI to PI.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetPoseDelta(const TwoWheelOdometry_Pose_t* from, const TwoWheelOdometry_Pose_t* to, float* dX, float* dY, float* dTheta)
+{
+    if (from == NULL || to == NULL || dX == NULL || dY == NULL || dTheta == NULL) return false;
+    *dX = (float)(to->x - from->x) * NANOMETERS_TO_METERS;
+    *dY = (float)(to->y - from->y) * NANOMETERS_TO_METERS;
+    *dTheta = (float)(int32_t)(to->heading - from->heading) * HEADING_TO_RADIANS;
+    return true;
+}
+
+/** @brief Update the odometry based on wheel motion.
+ * This function updates the odometry of the chassis with the rotation of the
+ * wheels since the last update. The chassis is taken to follow an arc of
+ * constant curvature during the interval, which is exact for constant wheel
+ * speeds: the chord is dS * sin(dTheta/2) / (dTheta/2) long and points along
+ * the mean heading theta + dTheta/2. With a gyro, dTheta is the fused
+ * heading increment and the wheels only give dS.
+ * Called from the TIM7 interrupt only.
+ * @param wheelDeltaArray Array containing the rotations of the left and right wheels in radians.
+ *                        wheelDeltaArray[0] is the left wheel, wheelDeltaArray[1] is the right wheel.
+ * @param gyroTurn Pointer to the angle turned by the gyro since the last update in radians, NULL without a gyro.
  * @param dt Time interval in seconds since the last update.
+ * @param timestamp DWT cycle counter when the wheels were measured.
  * @return true if odometry update is successful, false otherwise.
  */
-bool TwoWheelOdometry_Update(float* wheelPosArray, float dt)
+bool TwoWheelOdometry_Update(const float* wheelDeltaArray, const float* gyroTurn, float dt, uint32_t timestamp)
 {
-    float wheelRadius = DataStore_GetWheelRadius();
-    float trackWidth = DataStore_GetTrackWidth();
-    
-    float positionL = wheelPosArray[0] * wheelRadius;
-    float positionR = wheelPosArray[1] * wheelRadius;
+    if (wheelDeltaArray == NULL || dt <= 0.0f) return false;
+    TwoWheelOdometry_Pose_t *pose = &state.pose;
 
-    float deltaL = positionL - lastPositionL;
-    float deltaR = positionR - lastPositionR;
-    lastPositionL = positionL;
-    lastPositionR = positionR;
+    float deltaL = wheelDeltaArray[0] * wheelRadius;
+    float deltaR = wheelDeltaArray[1] * wheelRadius;
 
     float dS = (deltaL + deltaR) / 2.0f;
     float dTheta = (deltaR - deltaL) / trackWidth;
 
-    if (dTheta < 1e-6f && dTheta > -1e-6f)
+    // Variances of the step from the slip of each wheel
+    float inverseWidth = 1.0f / trackWidth;
+    float qL = noise.wheelSlip[0] * fabsf(deltaL);
+    float qR = noise.wheelSlip[1] * fabsf(deltaR);
+    float varS = (qL + qR) / 4.0f;
+    float varTheta = (qL + qR) * inverseWidth * inverseWidth;
+    float covST = (qR - qL) * inverseWidth / 2.0f;
+    if (gyroTurn != NULL)
     {
-        // Straight movement
-        x += dS * arm_cos_f32(theta);
-        y += dS * arm_sin_f32(theta);
+        bool isStill = wheelDeltaArray[0] == 0.0f && wheelDeltaArray[1] == 0.0f;
+        dTheta = HeadingFusion_Step(&headingFusion, dTheta, isStill, *gyroTurn, dt, &varTheta);
+        covST = 0.0f;
+    }
+
+    // Heading at the middle of the arc, from the accumulator
+    float halfTheta = dTheta / 2.0f;
+    float midTheta = (float)(int32_t)pose->heading * HEADING_TO_RADIANS + halfTheta;
+    float chord = dS * Sinc(halfTheta);
+    float cosTheta = cosf(midTheta);
+    float sinTheta = sinf(midTheta);
+    pose->x += llroundf(chord * cosTheta * METERS_TO_NANOMETERS);
+    pose->y += llroundf(chord * sinTheta * METERS_TO_NANOMETERS);
+    // The rounding of each step is carried over, a steady turn does not drift
+    float scaled = dTheta * RADIANS_TO_HEADING;
+    int32_t step = (int32_t)lroundf(scaled);
+    headingResidual += scaled - (float)step;
+    int32_t carry = (int32_t)lroundf(headingResidual);
+    headingResidual -= (float)carry;
+    pose->heading += (uint32_t)(step + carry);
+
+    state.velocity = dS / dt;
+    state.omega = dTheta / dt;
+    state.timestamp = timestamp;
+
+    PropagateCovariance(dS, varS, varTheta, covST, cosTheta, sinTheta);
+    // Twist of the step, the wheel speeds have their own variance on top of the slip
+    float speedL = noise.speedVariance[0], speedR = noise.speedVariance[1];
+    float *t = state.covariance.twist;
+    t[0] = varS / (dt * dt) + (speedL + speedR) / 4.0f;
+    if (gyroTurn != NULL)
+    {
+        t[1] = 0.0f;
+        t[2] = varTheta / (dt * dt);
     }
     else
     {
-        // Arc movement
-        x += dS * arm_cos_f32(theta + dTheta / 2.0f);
-        y += dS * arm_sin_f32(theta + dTheta / 2.0f);
-        theta += dTheta;
-        while (theta > PI) theta -= 2.0f * PI;
-        while (theta < -PI) theta += 2.0f * PI;
+        t[1] = covST / (dt * dt) + (speedR - speedL) * inverseWidth / 2.0f;
+        t[2] = varTheta / (dt * dt) + (speedL + speedR) * inverseWidth * inverseWidth;
     }
-
-    velocity = dS / dt;
-    omega = dTheta / dt;
-
+    Publish();
     return true;
 }
 
 /**
  * @brief Reset the odometry to the initial state.
- * This function resets the odometry of the chassis to the initial state.
+ * This function resets the odometry of the chassis to the initial state and
+ * reloads the wheel radius and the track width from the data store.
+ * Must be called from a thread.
  */
 void TwoWheelOdometry_Reset(void)
 {
-    lastPositionL = 0.0f;
-    lastPositionR = 0.0f;
-    x = 0.0f;
-    y = 0.0f;
-    theta = 0.0f;
-    velocity = 0.0f;
-    omega = 0.0f;
+    TwoWheelOdometry_ReloadParameters();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&state, 0, sizeof(state));
+    headingResidual = 0.0f;
+    Publish();
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Reload the parameters of the odometry.
+ * This function reloads the wheel radius, the track width and the wheel
+ * noise model from the data store, the pose is kept. The next update uses
+ * them.
+ * Must be called from a thread.
+ */
+void TwoWheelOdometry_ReloadParameters(void)
+{
+    float radius = DataStore_GetWheelRadius();
+    float width = DataStore_GetTrackWidth();
+    DataStore_OdometryNoise_t model;
+    DataStore_GetOdometryNoise(&model);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    wheelRadius = radius;
+    trackWidth = width;
+    noise = model;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Propagate the pose covariance over one update
+ * The pose moves by dS along the mean heading and turns by dTheta.
+ * Linearized around the step:
+ *     P' = F P F^T + G Q G^T,  Q = [varS covST; covST varTheta]
+ * F adds the heading error to the position, G maps the step to the pose.
+ * From the wheels alone dS = (dL + dR) / 2 and dTheta = (dR - dL) / b, the
+ * slip of each wheel makes both, so they are correlated. The chord of the
+ * arc is taken as dS, the step is short.
+ * @param dS distance travelled in meters
+ * @param varS variance of dS
+ * @param varTheta variance of the heading increment
+ * @param covST covariance of dS and of the heading increment
+ * @param cosTheta cosine of the mean heading of the step
+ * @param sinTheta sine of the mean heading of the step
+ */
+void PropagateCovariance(float dS, float varS, float varTheta, float covST, float cosTheta, float sinTheta)
+{
+    float *p = state.covariance.pose;
+
+    // F P F^T, F = [1 0 a; 0 1 c; 0 0 1]
+    float a = -dS * sinTheta;
+    float c = dS * cosTheta;
+    float pxt = p[2], pyt = p[4], ptt = p[5];
+    p[0] += a * (2.0f * pxt + a * ptt);
+    p[1] += a * pyt + c * pxt + a * c * ptt;
+    p[2] += a * ptt;
+    p[3] += c * (2.0f * pyt + c * ptt);
+    p[4] += c * ptt;
+
+    // G Q G^T, G = [cos a/2; sin c/2; 0 1]
+    float xs = cosTheta, xt = a / 2.0f;
+    float ys = sinTheta, yt = c / 2.0f;
+    p[0] += xs * xs * varS + 2.0f * xs * xt * covST + xt * xt * varTheta;
+    p[1] += xs * ys * varS + (xs * yt + xt * ys) * covST + xt * yt * varTheta;
+    p[2] += xs * covST + xt * varTheta;
+    p[3] += ys * ys * varS + 2.0f * ys * yt * covST + yt * yt * varTheta;
+    p[4] += ys * covST + yt * varTheta;
+    p[5] += varTheta;
+}
+
+/**
+ * @brief Copy the state to the snapshot of the readers
+ * Interrupts must be disabled or the caller be the TIM7 interrupt.
+ */
+void Publish(void)
+{
+    snapshotSequence++;
+    __DMB();
+    snapshot = state;
+    __DMB();
+    snapshotSequence++;
+}
+
+/**
+ * @brief sin(a) / a, 1 at 0
+ * @param a angle in radians
+ * @return sin(a) / a
+ */
+float Sinc(float a)
+{
+    if (fabsf(a) < SINC_SERIES_LIMIT)
+    {
+        float a2 = a * a;
+        return 1.0f - a2 / 6.0f * (1.0f - a2 / 20.0f);
+    }
+    return sinf(a) / a;
 }
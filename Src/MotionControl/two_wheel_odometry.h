@@ -12,6 +12,37 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Pose accumulators of the chassis
+ * Fixed point, so the resolution is the same everywhere: the position wraps
+ * after 9.2e9 m and the heading wraps at every turn, as a heading should.
+ */
+typedef struct {
+    int64_t x;          // X position in nanometers
+    int64_t y;          // Y position in nanometers
+    uint32_t heading;   // Orientation, 2^32 per turn, 0 along the x axis
+} TwoWheelOdometry_Pose_t;
+
+/**
+ * @brief Covariance of the odometry, upper triangles of the symmetric matrices
+ */
+typedef struct {
+    float pose[6];      // x, y, theta: xx, xy, xTheta, yy, yTheta, thetaTheta in m^2, m*rad, rad^2
+    float twist[3];     // velocity, omega: vv, vOmega, omegaOmega over the last update
+} TwoWheelOdometry_Covariance_t;
+
+/**
+ * @brief State of the odometry after an update
+ */
+typedef struct {
+    TwoWheelOdometry_Pose_t pose;
+    float velocity;     // Linear velocity in m/s over the last update
+    float omega;        // Angular velocity in rad/s over the last update
+    uint32_t timestamp; // DWT cycle counter when the wheels were measured
+    TwoWheelOdometry_Covariance_t covariance;
+} TwoWheelOdometry_State_t;
 
 /**
  * @brief Initialize the Two Wheel Odometry System
@@ -19,6 +50,14 @@
  */
 void TwoWheelOdometry_Init(void);
 
+/**
+ * @brief Get the latest state of the odometry.
+ * Lock-free, may be called from any thread.
+ * @param result Pointer to the state to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetState(TwoWheelOdometry_State_t* result);
+
 /**
  * @brief Get the current odometry of the chassis.
  * This function retrieves the current odometry of the chassis.
@@ -31,17 +70,63 @@ void TwoWheelOdometry_Init(void);
  */
 bool TwoWheelOdometry_GetOdometry(float* x, float* y, float* theta, float* velocity, float* omega);
 
-/** @brief Update the odometry based on wheel position data.
- * This function updates the odometry of the chassis based on the provided wheel position data.
- * @param wheelPosArray Array containing the positions of the left and right wheels in radians.
- *                      wheelPosArray[0] is the left wheel position, wheelPosArray[1] is the right wheel position.
+/**
+ * @brief Get the covariance of the odometry.
+ * The pose covariance grows with the distance travelled from the last reset,
+ * the twist covariance is the one of the last update.
+ * @param result Pointer to the covariance to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetCovariance(TwoWheelOdometry_Covariance_t* result);
+
+/**
+ * @brief Get the pose accumulators of the chassis.
+ * @param result Pointer to the pose to fill.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetPose(TwoWheelOdometry_Pose_t* result);
+
+/**
+ * @brief Get the motion between two poses in float.
+ * The difference is taken on the accumulators, so it keeps its resolution
+ * however far the chassis is from the origin.
+ * @param from Pointer to the earlier pose.
+ * @param to Pointer to the later pose.
+ * @param dX Pointer to store the x displacement in meters.
+ * @param dY Pointer to store the y displacement in meters.
+ * @param dTheta Pointer to store the rotation in radians, -PI to PI.
+ * @return true if successful, false otherwise.
+ */
+bool TwoWheelOdometry_GetPoseDelta(const TwoWheelOdometry_Pose_t* from, const TwoWheelOdometry_Pose_t* to, float* dX, float* dY, float* dTheta);
+
+/** @brief Update the odometry based on wheel motion.
+ * This function updates the odometry of the chassis with the rotation of the
+ * wheels since the last update, integrated along an arc of constant curvature.
+ * With a gyro sample the heading is fused from the gyro and the wheels.
+ * Called from the TIM7 interrupt only.
+ * @param wheelDeltaArray Array containing the rotations of the left and right wheels in radians.
+ *                        wheelDeltaArray[0] is the left wheel, wheelDeltaArray[1] is the right wheel.
+ * @param gyroTurn Pointer to the angle turned by the gyro since the last update in radians, NULL without a gyro.
  * @param dt Time interval in seconds since the last update.
+ * @param timestamp DWT cycle counter when the wheels were measured.
  * @return true if odometry update is successful, false otherwise.
  */
-bool TwoWheelOdometry_Update(float* wheelPosArray, float dt);
+bool TwoWheelOdometry_Update(const float* wheelDeltaArray, const float* gyroTurn, float dt, uint32_t timestamp);
 
 /**
  * @brief Reset the odometry to the initial state.
- * This function resets the odometry of the chassis to the initial state.
+ * This function resets the odometry of the chassis and its covariance to the
+ * initial state and reloads the wheel radius, the track width and the wheel
+ * noise model from the data store.
+ * Must be called from a thread.
  */
 void TwoWheelOdometry_Reset(void);
+
+/**
+ * @brief Reload the parameters of the odometry.
+ * This function reloads the wheel radius, the track width and the wheel
+ * noise model from the data store, the pose is kept. The next update uses
+ * them.
+ * Must be called from a thread.
+ */
+void TwoWheelOdometry_ReloadParameters(void);
@@ -11,6 +11,8 @@
 
 #include "main.h"
 #include "io.h"
+#include "system_config.h"
+#include "rtx_os.h"
 
 typedef struct {
     GPIO_TypeDef *Port;
@@ -19,6 +21,16 @@ typedef struct {
 
 /* -------------------- Static variables ---------------------- */
 static osThreadId_t appIoInputThreadId;
+static uint64_t appIoInputThreadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t appIoInputThreadControlBlock;
+static const osThreadAttr_t appIoInputThreadAttr = {
+    .name = "ThreadIoInput",
+    .cb_mem = &appIoInputThreadControlBlock,
+    .cb_size = sizeof(appIoInputThreadControlBlock),
+    .stack_mem = appIoInputThreadStack,
+    .stack_size = sizeof(appIoInputThreadStack),
+    .priority = THREAD_PRIORITY_INGRESS,
+};
 // IO output ports map
 static IO_t IO_Output[] = {
     {OUT0_GPIO_Port, OUT0_Pin},
@@ -76,7 +88,7 @@ bool IO_Read(uint16_t ioPort)
 void IO_Init(void)
 {
     for (int i = 0; i < IO_INPUT_NUMBER; ++i) ioInputCallback[i] = NULL;
-    appIoInputThreadId = osThreadNew(AppIoInputThread, NULL, NULL);
+    appIoInputThreadId = osThreadNew(AppIoInputThread, NULL, &appIoInputThreadAttr);
     // osThreadSetPriority(appIoInputThreadId, osPriorityBelowNormal);
 }
 
@@ -1,6 +1,8 @@
 #include "timer.h"
 
 #define TOTAL_ENCODER_NUMBER    2
+#define TICKS_PER_PERIOD        20      // TIM7 ticks every 1ms, the period callback runs every 20ms
+#define MAX_TICK_CALLBACKS      2       // Periodic activations and motor identification
 #define TOTAL_MOTOR_NUMBER  TOTAL_ENCODER_NUMBER
 
 typedef struct pwm_channel {
@@ -18,6 +20,9 @@ extern TIM_HandleTypeDef htim7;     // For motor's pid control period
 
 /* --------------------- Static variables --------------------------------- */
 static Timer_PeriodCallback_t PerioidCallback;
+static Timer_TickCallback_t TickCallback[MAX_TICK_CALLBACKS];
+static uint32_t tickCount;
+static bool isTickStarted;
 static Timer_EncoderOverflowCallback_t EncoderOverflowCallback[TOTAL_ENCODER_NUMBER];
 static Timer_InputCaptureCallback_t InputCaptureCallback;
 static TIM_HandleTypeDef encoderDictionary[TOTAL_ENCODER_NUMBER];
@@ -43,7 +48,6 @@ void Timer_TimersForMotorInit(void)
     pwmChannel[1].pwmChannel0 = TIM_CHANNEL_1;
     pwmChannel[1].pwmChannel1 = TIM_CHANNEL_2;
 
-    HAL_TIM_RegisterCallback(&htim7, HAL_TIM_PERIOD_ELAPSED_CB_ID, Timer7_PeriodElapsedCallback);
     HAL_TIM_RegisterCallback(&htim3, HAL_TIM_PERIOD_ELAPSED_CB_ID, Timer3_PeriodElapsedCallback);
     HAL_TIM_RegisterCallback(&htim4, HAL_TIM_PERIOD_ELAPSED_CB_ID, Timer4_PeriodElapsedCallback);
 
@@ -55,18 +59,51 @@ void Timer_TimersForMotorInit(void)
         HAL_TIM_PWM_Start(&pwmChannel[i].pwmTimer, pwmChannel[i].pwmChannel0);
         HAL_TIM_PWM_Start(&pwmChannel[i].pwmTimer, pwmChannel[i].pwmChannel1);
     }
+    Timer_StartTick();
+}
+
+/**
+ * @brief Start the 1ms TIM7 tick
+ * 
+ * Safe to call more than once, the timer is started the first time.
+ * After Timer_StopTick the count goes on from the next period boundary,
+ * the motor control period runs at the first tick.
+ */
+void Timer_StartTick(void)
+{
+    if (isTickStarted) return;
+    isTickStarted = true;
+    if (tickCount % TICKS_PER_PERIOD != 0) tickCount += TICKS_PER_PERIOD - tickCount % TICKS_PER_PERIOD;
+    HAL_TIM_RegisterCallback(&htim7, HAL_TIM_PERIOD_ELAPSED_CB_ID, Timer7_PeriodElapsedCallback);
+    __HAL_TIM_SET_COUNTER(&htim7, 0);
     HAL_TIM_Base_Start_IT(&htim7);
 }
 
+/**
+ * @brief Stop the 1ms TIM7 tick
+ * 
+ * The motor control period and the tick callbacks stop with it until the
+ * next Timer_StartTick. The PWM outputs keep their duty.
+ */
+void Timer_StopTick(void)
+{
+    if (!isTickStarted) return;
+    HAL_TIM_Base_Stop_IT(&htim7);
+    isTickStarted = false;
+}
+
 /**
  * @brief Timer7 Period Elapsed Callback
  * 
- * It is be used to handle encoder overflow.
+ * It drives the 1ms tick callback and the 20ms motor control period.
  */
 void Timer7_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     // This function is called every 1ms by TIM7
-    if(PerioidCallback != NULL) PerioidCallback();
+    if(tickCount % TICKS_PER_PERIOD == 0 && PerioidCallback != NULL) PerioidCallback();
+    for(int i = 0; i < MAX_TICK_CALLBACKS; i++)
+        if(TickCallback[i] != NULL) TickCallback[i](tickCount);
+    tickCount++;
 }
 
 /**
@@ -101,6 +138,17 @@ void Timer_RegisterPeriodCallback(Timer_PeriodCallback_t callback)
     if(PerioidCallback == NULL) PerioidCallback = callback;
 }
 
+bool Timer_RegisterTickCallback(Timer_TickCallback_t callback)
+{
+    for(int i = 0; i < MAX_TICK_CALLBACKS; i++)
+    {
+        if(TickCallback[i] != NULL) continue;
+        TickCallback[i] = callback;
+        return true;
+    }
+    return false;
+}
+
 void Timer_RegisterEncoderOverflowCallback(uint32_t encoderID, Timer_EncoderOverflowCallback_t callback)
 {
     if (encoderID >= TOTAL_ENCODER_NUMBER)
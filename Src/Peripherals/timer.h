@@ -2,11 +2,17 @@
 
 #include "main.h"
 
+#include <stdbool.h>
+
 typedef void (*Timer_PeriodCallback_t)(void);
+typedef void (*Timer_TickCallback_t)(uint32_t);
 typedef void (*Timer_EncoderOverflowCallback_t)(void);
 typedef void (*Timer_InputCaptureCallback_t)(int32_t, int32_t, int32_t, int32_t, int32_t);
 
 void Timer_RegisterPeriodCallback(Timer_PeriodCallback_t);
+bool Timer_RegisterTickCallback(Timer_TickCallback_t);
+void Timer_StartTick(void);
+void Timer_StopTick(void);
 void Timer_RegisterEncoderOverflowCallback(uint32_t, Timer_EncoderOverflowCallback_t);
 void Timer_TimersForMotorInit(void);
 uint32_t Timer_ReadEncoder(uint32_t encoderID);
@@ -3,10 +3,10 @@
  * @brief Implements ROS heartbeat receive/monitor logic.
  * @details
  *  - Registers an incoming callback for ROS_HEART_BEAT frames.
- *  - Maintains last heartbeat tick; a periodic RTOS timer checks for timeout.
+ *  - Maintains last heartbeat tick; the ROS feedback thread checks for timeout
+ *    at every feedback tick.
  *  - On timeout (no frame within HEARTBEAT_TIMEOUT_PERIOD) marks interface inactive.
  *  - Echoes received heartbeat back (ack) and updates ROS interface status.
- *  - Uses CMSIS-RTOS2 timer (osTimerNew / osTimerStart) for lightweight periodic checks.
  * @ingroup ros_interface
  * @author Young.W <com.wang@hotmail.com>
  * @date 2025-09-25
@@ -21,30 +21,23 @@
 #include <string.h>
 
 #define HEARTBEAT_TIMEOUT_PERIOD 200    // ms, if no heartbeat received in this period, consider the connection lost
-#define HEARTBEAT_CHECK_PERIOD 10       // ms, check heartbeat status every 10 ms
 
 /* --------------------- Static Variables ------------------------------ */
 static uint32_t lastHeartbeatTime;
-static osTimerId_t heartbeatTimerId;
 static ROS_Heartbeat_ResetRequestCallback_t resetRequestCallback;   // Callback for reset requests
 
 /* --------------------- Static Functions ------------------------------ */
 static void HeartBeatCallback(const uint8_t *data, uint32_t size);
-static void HeartBeatTimeoutCallback(void *arg);
 
 /**
  * @brief Initialize the Heartbeat mechanism
- * This function initializes the heartbeat mechanism by setting up a timer to
- * periodically check for heartbeat timeouts and registering a callback for
- * incoming heartbeat messages.
+ * This function initializes the heartbeat mechanism by registering a callback
+ * for incoming heartbeat messages.
  * @return true if initialization was successful, false otherwise
  */
 bool ROS_Heartbeat_Init(void)
 {
     lastHeartbeatTime = osKernelGetTickCount();
-    heartbeatTimerId = osTimerNew(HeartBeatTimeoutCallback, osTimerPeriodic, NULL, NULL);
-    assert_param(heartbeatTimerId != NULL);
-    osTimerStart(heartbeatTimerId, HEARTBEAT_CHECK_PERIOD);
     return ROS_Interface_RegisterIncomingCallback(ROS_HEART_BEAT, HeartBeatCallback);
 }
 
@@ -83,15 +76,13 @@ void HeartBeatCallback(const uint8_t *data, uint32_t size)
 }
 
 /**
- * @brief Heartbeat timeout callback
+ * @brief Check the heartbeat timeout
  * This function is called periodically to check if the heartbeat has timed out.
  * If the time since the last heartbeat exceeds HEARTBEAT_TIMEOUT_PERIOD, it updates
  * the heartbeat status to false.
- * @param arg pointer to argument (not used)
  */
-void HeartBeatTimeoutCallback(void *arg)
+void ROS_Heartbeat_CheckTimeout(void)
 {
-    (void)arg;
     uint32_t timeInterval = osKernelGetTickCount() - lastHeartbeatTime;
     if (timeInterval >= HEARTBEAT_TIMEOUT_PERIOD)
         ROS_Interface_UpdateHeartbeatStatus(false);
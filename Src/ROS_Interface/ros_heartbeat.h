@@ -7,13 +7,20 @@ typedef void (*ROS_Heartbeat_ResetRequestCallback_t)(void);
 
 /**
  * @brief Initialize the Heartbeat mechanism
- * This function initializes the heartbeat mechanism by setting up a timer to
- * periodically check for heartbeat timeouts and registering a callback for
- * incoming heartbeat messages.
+ * This function initializes the heartbeat mechanism by registering a callback
+ * for incoming heartbeat messages.
  * @return true if initialization was successful, false otherwise
  */
 bool ROS_Heartbeat_Init(void);
 
+/**
+ * @brief Check the heartbeat timeout
+ * This function is called periodically to check if the heartbeat has timed out.
+ * If the time since the last heartbeat exceeds HEARTBEAT_TIMEOUT_PERIOD, it updates
+ * the heartbeat status to false.
+ */
+void ROS_Heartbeat_CheckTimeout(void);
+
 /**
  * @brief Register a callback function for reset requests
  * This function allows registration of a callback that will be invoked
@@ -8,7 +8,11 @@
  *   registered incoming callbacks via a message queue.
  * - FeedbackTask: Periodically triggers registered feedback producers and sends
  *   their payloads over UDP.
- * Also tracks upper-machine heartbeat to detect timeouts.
+ * Also tracks upper-machine heartbeat to detect timeouts. While no upper machine
+ * is alive the FeedbackTask is parked: its activation is paused until a
+ * heartbeat arrives, so the core is not woken to poll.
+ * Feedback periods which come from the data store are read again by the
+ * FeedbackTask when the data store signals a change of their fields.
  *
  * @note Concurrency: Uses an osMessageQueue for ingress; callback implementations
  *       should protect shared resources if needed.
@@ -27,20 +31,30 @@
 #include "ros_interface.h"
 #include "ros_messages.h"
 #include "system_config.h"
+#include "rtx_os.h"
+#include "activation.h"
 #include "ros_heartbeat.h"
 #include "ros_service_io.h"
 #include "ros_parameters.h"
+#include "ros_service_log.h"
+#include "ros_service_ota.h"
+#include "ros_service_diagnostics.h"
+#include "ros_service_tuning.h"
 #include "ros_publisher_odom.h"
+#include "ros_publisher_cpu_load.h"
 #include "ros_publisher_chassis_state.h"
 #include "ros_subscriber_cmd_vel.h"
 #include "data_store.h"
+#include "flight_recorder.h"
+#include "motion_control.h"
 
 /* -------------- Definitions ----------------------- */
 #define ROS_INTERFACE_Q_LEN 16
-#define MAX_INCOMING_CALLBACKS 8
+#define MAX_INCOMING_CALLBACKS 12
 #define MAX_FEEDBACK_CALLBACKS 8
 #define CHECK_FEEDBACK_PERIOD  5 // ms, check if some feedbacks should be sent every 10ms
 #define FEEDBACK_TICK_FLAG 0x01U
+#define FEEDBACK_PERIOD_FLAG 0x02U  // A data store field of a feedback period changed
 
 /* -------------- Data type definitions ------------- */
 typedef struct {
@@ -52,6 +66,7 @@ typedef struct {
     uint32_t feedbackPeriod;    // in ms, should be a multiple of INFO_REPORT_PERIOD
     int32_t remainTime;         // in ms, time remaining to send the next feedback
     ROS_Interface_FeedbackCallback_t callback;
+    ROS_Interface_PeriodCallback_t periodCallback;  // NULL for a fixed period
 } ROS_Interface_FeedbackEntry_t;
 
 typedef struct {
@@ -63,20 +78,31 @@ typedef struct {
 static osMessageQueueId_t appRosInterfaceMsgQueueId;
 static osThreadId_t incomingThreadID;
 static osThreadId_t feedbackThreadID;
-static osTimerId_t feedbackTimerId;
 static uint16_t localUdpPort;
 
+static uint64_t incomingThreadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t incomingThreadControlBlock;
 static const osThreadAttr_t incomingThreadAttr = {
-    .priority = osPriorityNormal,
-    .stack_size = 1024
+    .name = "ThreadRosIncoming",
+    .cb_mem = &incomingThreadControlBlock,
+    .cb_size = sizeof(incomingThreadControlBlock),
+    .stack_mem = incomingThreadStack,
+    .stack_size = sizeof(incomingThreadStack),
+    .priority = THREAD_PRIORITY_INGRESS,
 };
 
+static uint64_t feedbackThreadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t feedbackThreadControlBlock;
 static const osThreadAttr_t feedbackThreadAttr = {
-    .priority = osPriorityNormal,
-    .stack_size = 1024
+    .name = "ThreadRosFeedback",
+    .cb_mem = &feedbackThreadControlBlock,
+    .cb_size = sizeof(feedbackThreadControlBlock),
+    .stack_mem = feedbackThreadStack,
+    .stack_size = sizeof(feedbackThreadStack),
+    .priority = THREAD_PRIORITY_EGRESS,
 };
 
-static bool isUpperMachineAlive; // Flag to indicate if the upper machine is alive
+static volatile bool isUpperMachineAlive; // Flag to indicate if the upper machine is alive
 static ROS_Interface_CallbackEntry_t incomingCallbackEntrys[MAX_INCOMING_CALLBACKS]; // Array of incoming message callbacks
 static ROS_Interface_FeedbackEntry_t feedbackCallbackEntrys[MAX_FEEDBACK_CALLBACKS]; // Array of feedback message callbacks
 static int rosInterfaceUdpSocket = -1; // UDP socket for ROS interface
@@ -85,7 +111,7 @@ static int rosInterfaceUdpSocket = -1; // UDP socket for ROS interface
 static void IncomingTask(void *);
 static void FeedbackTask(void *);
 static void UDP_Callback(const uint8_t *data, uint32_t size);
-static void FeedbackTimerCallback(void *arg);
+static void UpdateFeedbackPeriods(void);
 
 /** 
  * @brief Initialize the ROS Interface
@@ -99,26 +125,41 @@ void ROS_Interface_Init(void)
 	localUdpPort = DataStore_GetLocalUdpPort();
     appRosInterfaceMsgQueueId = osMessageQueueNew(ROS_INTERFACE_Q_LEN, sizeof(ROS_Interface_CommandMessage_t), NULL);
     assert_param(appRosInterfaceMsgQueueId != NULL);
-    feedbackTimerId = osTimerNew(FeedbackTimerCallback, osTimerPeriodic, NULL, NULL);
-    assert_param(feedbackTimerId != NULL);
     incomingThreadID = osThreadNew(IncomingTask, NULL, &incomingThreadAttr);
     assert_param(incomingThreadID != NULL);
     feedbackThreadID = osThreadNew(FeedbackTask, NULL, &feedbackThreadAttr);
     assert_param(feedbackThreadID != NULL);
-    osStatus_t timerStatus = osTimerStart(feedbackTimerId, CHECK_FEEDBACK_PERIOD);
-    assert_param(timerStatus == osOK);
+    const Activation_Task_t feedbackTask = {
+        .thread = feedbackThreadID,
+        .flags = FEEDBACK_TICK_FLAG,
+        .period = CHECK_FEEDBACK_PERIOD,
+        .phase = ACTIVATION_PHASE_FEEDBACK,
+    };
+    bool result = Activation_Register(&feedbackTask);
+    assert_param(result);
+    Activation_SetActive(feedbackThreadID, FEEDBACK_TICK_FLAG, false); // Parked until the first heartbeat
     rosInterfaceUdpSocket = UDP_RegisterListener(DEFAULT_LOCAL_UDP_PORT, UDP_Callback); // Register the UDP listener for ROS interface messages
 	assert_param(rosInterfaceUdpSocket >= 0);
-    bool result = ROS_Heartbeat_Init();
+    result = ROS_Heartbeat_Init();
     assert_param(result);
     result = ROS_ServiceIO_Init(); // Initialize the IO service
     assert_param(result);
     result = ROS_ServiceParameters_Init(); // Initialize the Parameters service
     assert_param(result);
+    result = ROS_ServiceLog_Init(); // Initialize the flight log dump service
+    assert_param(result);
+    result = ROS_ServiceOTA_Init(); // Initialize the firmware update service
+    assert_param(result);
+    result = ROS_ServiceDiagnostics_Init(); // Initialize the diagnostics service
+    assert_param(result);
+    result = ROS_ServiceTuning_Init(); // Initialize the motor tuning service
+    assert_param(result);
     result = ROS_PublisherOdom_Init(); // Initialize the odometry publisher
     assert_param(result);
     result = ROS_PublisherChassisState_Init(); // Initialize the chassis state publisher
     assert_param(result);
+    result = ROS_PublisherCpuLoad_Init(); // Initialize the CPU load publisher
+    assert_param(result);
     result = ROS_SubscriberCmdVel_Init(); // Initialize the velocity command subscriber
     assert_param(result);
 }
@@ -164,7 +205,10 @@ void FeedbackTask(void *arg)
     (void)arg;
     while (true)
     {
-        osThreadFlagsWait(FEEDBACK_TICK_FLAG, osFlagsWaitAll, osWaitForever);
+        uint32_t flags = osThreadFlagsWait(FEEDBACK_TICK_FLAG | FEEDBACK_PERIOD_FLAG, osFlagsWaitAny, osWaitForever);
+        if (flags & FEEDBACK_PERIOD_FLAG) UpdateFeedbackPeriods();
+        if (!(flags & FEEDBACK_TICK_FLAG)) continue;
+        ROS_Heartbeat_CheckTimeout(); // Updates isUpperMachineAlive
         if (!isUpperMachineAlive) continue; // Skip sending feedback if the upper machine is not alive
         for (int i = 0; i < MAX_FEEDBACK_CALLBACKS; i++)
         {
@@ -187,6 +231,22 @@ void FeedbackTask(void *arg)
     }
 }
 
+/**
+ * @brief Read again the feedback periods from the data store
+ * Called in the feedback task. A feedback due later than its new period
+ * is sent after the new period.
+ */
+void UpdateFeedbackPeriods(void)
+{
+    for (int i = 0; i < MAX_FEEDBACK_CALLBACKS; i++)
+    {
+        if (feedbackCallbackEntrys[i].periodCallback == NULL) continue;
+        uint32_t period = feedbackCallbackEntrys[i].periodCallback();
+        feedbackCallbackEntrys[i].feedbackPeriod = period;
+        if (feedbackCallbackEntrys[i].remainTime > (int32_t)period) feedbackCallbackEntrys[i].remainTime = (int32_t)period;
+    }
+}
+
 /**
  * @brief Callback function for UDP messages
  * This function is called when a UDP message is received. It puts the received data into the message queue
@@ -206,16 +266,6 @@ void UDP_Callback(const uint8_t *data, uint32_t size)
     osMessageQueuePut(appRosInterfaceMsgQueueId, (void *)&msg, 0, 0);
 }
 
-/**
- * @brief Timer callback to tick feedback scheduling.
- * @param arg unused
- */
-void FeedbackTimerCallback(void *arg)
-{
-    (void)arg;
-    osThreadFlagsSet(feedbackThreadID, FEEDBACK_TICK_FLAG);
-}
-
 /**
  * @brief Register an incoming callback
  * @param messageType the type of the incoming message
@@ -259,6 +309,34 @@ bool ROS_Interface_RegisterFeedbackCallback(uint32_t period, ROS_Interface_Feedb
     return false;
 }
 
+/**
+ * @brief Register a feedback callback with a period from the data store
+ * The period is read by periodCallback now and again in the feedback task
+ * every time a field of keyMask is set, it takes effect without reboot.
+ * @param keyMask DATA_STORE_KEY_MASK of the fields the period depends on
+ * @param periodCallback function returning the period in ms
+ * @param callback the feedback callback function
+ * @return true if the callback was registered successfully, false otherwise
+ */
+bool ROS_Interface_RegisterParameterFeedbackCallback(uint64_t keyMask, ROS_Interface_PeriodCallback_t periodCallback, ROS_Interface_FeedbackCallback_t callback)
+{
+    assert_param(callback != NULL && periodCallback != NULL);
+    for (int i = 0; i < MAX_FEEDBACK_CALLBACKS; i++)
+    {
+        if (feedbackCallbackEntrys[i].callback == NULL)
+        {
+            if (!DataStore_Subscribe(keyMask, feedbackThreadID, FEEDBACK_PERIOD_FLAG)) return false;
+            uint32_t period = periodCallback();
+            feedbackCallbackEntrys[i].feedbackPeriod = period;
+            feedbackCallbackEntrys[i].remainTime = period;
+            feedbackCallbackEntrys[i].periodCallback = periodCallback;
+            feedbackCallbackEntrys[i].callback = callback;
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief Update the heartbeat status
  * This function updates the status of the upper machine's heartbeat.
@@ -266,7 +344,28 @@ bool ROS_Interface_RegisterFeedbackCallback(uint32_t period, ROS_Interface_Feedb
  */
 void ROS_Interface_UpdateHeartbeatStatus(bool isAlive)
 {
+    if (isAlive != isUpperMachineAlive)
+    {
+        FlightRecordHeartbeat_t record = { .alive = isAlive };
+        FlightRecorder_Log(FLIGHT_RECORD_HEARTBEAT, &record, sizeof(record));
+        FlightRecorder_Flush();
+        // Without upper machine nothing is sent and no timeout is pending: park the feedback task
+        Activation_SetActive(feedbackThreadID, FEEDBACK_TICK_FLAG, isAlive);
+        // Its last velocity command must not outlive it, the profiler ramps the chassis down
+        if (!isAlive) MotionControl_Move(0.0f, 0.0f);
+    }
     isUpperMachineAlive = isAlive;
+    // A parked chassis restarts its control period for the upper machine
+    if (isAlive) MotionControl_Wake();
+}
+
+/**
+ * @brief Check if the upper machine is alive
+ * @return true if its heartbeat has not timed out, false otherwise
+ */
+bool ROS_Interface_IsUpperMachineAlive(void)
+{
+    return isUpperMachineAlive;
 }
 
 /**
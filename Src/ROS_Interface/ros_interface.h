@@ -6,6 +6,7 @@
 /* --------------- Callback types ---------------------- */
 typedef void (*ROS_Interface_IncomingCallback_t)(const uint8_t *data, uint32_t size);
 typedef void (*ROS_Interface_FeedbackCallback_t)(const void **data, uint32_t *size);
+typedef uint32_t (*ROS_Interface_PeriodCallback_t)(void);
 
 /* ---------------- Functions ---------------------------*/
 
@@ -34,6 +35,17 @@ bool ROS_Interface_RegisterIncomingCallback(uint32_t messageType, ROS_Interface_
  */
 bool ROS_Interface_RegisterFeedbackCallback(uint32_t period, ROS_Interface_FeedbackCallback_t callback);
 
+/**
+ * @brief Register a feedback callback with a period from the data store
+ * The period is read by periodCallback now and again in the feedback task
+ * every time a field of keyMask is set, it takes effect without reboot.
+ * @param keyMask DATA_STORE_KEY_MASK of the fields the period depends on
+ * @param periodCallback function returning the period in ms
+ * @param callback the feedback callback function
+ * @return true if the callback was registered successfully, false otherwise
+ */
+bool ROS_Interface_RegisterParameterFeedbackCallback(uint64_t keyMask, ROS_Interface_PeriodCallback_t periodCallback, ROS_Interface_FeedbackCallback_t callback);
+
 /**
  * @brief Update the heartbeat status
  * This function updates the status of the upper machine's heartbeat.
@@ -41,6 +53,12 @@ bool ROS_Interface_RegisterFeedbackCallback(uint32_t period, ROS_Interface_Feedb
  */
 void ROS_Interface_UpdateHeartbeatStatus(bool isAlive);
 
+/**
+ * @brief Check if the upper machine is alive
+ * @return true if its heartbeat has not timed out, false otherwise
+ */
+bool ROS_Interface_IsUpperMachineAlive(void);
+
 /**
  * @brief Send a message back to the upper machine
  * This function sends a message back to the upper machine via UDP.
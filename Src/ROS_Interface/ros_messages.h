@@ -26,6 +26,19 @@
  *      motion_state, chassis_odometry
  * @date 2025-08-25
  *       Modified on 2025-12-09 to add ParametersMessage_t and FeedbackParametersMessage_t
+ *       Modified on 2026-10-17 to add ReadLogMessage_t and LogDataMessage_t
+ *       Modified on 2026-10-17 to add the OTA messages
+ *       Modified on 2026-10-17 to add the memory pool statistics messages
+ *       Modified on 2026-10-17 to add ReadResourcesMessage_t and ResourcesMessage_t
+ *       Modified on 2026-10-17 to add CpuLoadMessage_t
+ *       Modified on 2026-10-17 to add the motion thread wake-up timing to CpuLoadMessage_t
+ *       Modified on 2026-10-17 to add the tickless idle statistics to CpuLoadMessage_t
+ *       Modified on 2026-10-17 to add the park statistics to CpuLoadMessage_t
+ *       Modified on 2026-10-17 to add MotorTuneMessage_t and MotorTuneResultMessage_t
+ *       Modified on 2026-10-17 to add MotorConfigMessage_t
+ *       Modified on 2026-10-17 to add OdometryCovarianceMessage_t
+ *       Modified on 2026-10-17 to replace ParametersMessage_t by ParameterListMessage_t
+ *       Modified on 2026-10-17 to add ReadStorageStatsMessage_t and StorageStatsMessage_t
  * @author Young.W <com.wang@hotmail.com>
  * @copyright Young
  * @version 1.0
@@ -48,7 +61,25 @@ typedef enum MessageType : uint32_t
     ROS_FEEDBACK_STATE,
     ROS_FEEDBACK_ODOMETRY,
     ROS_FEEDBACK_BATTERY,
-    ROS_HEART_BEAT
+    ROS_HEART_BEAT,
+    ROS_CMD_READ_LOG,
+    ROS_FEEDBACK_LOG_DATA,
+    ROS_CMD_OTA_BEGIN,
+    ROS_CMD_OTA_DATA,
+    ROS_CMD_OTA_END,
+    ROS_FEEDBACK_OTA_STATUS,
+    ROS_CMD_READ_MEMPOOL_STATS,
+    ROS_FEEDBACK_MEMPOOL_STATS,
+    ROS_CMD_READ_RESOURCES,
+    ROS_FEEDBACK_RESOURCES,
+    ROS_FEEDBACK_CPU_LOAD,
+    ROS_CMD_MOTOR_TUNE,
+    ROS_FEEDBACK_MOTOR_TUNE,
+    ROS_CMD_MOTOR_CONFIG,
+    ROS_FEEDBACK_MOTOR_CONFIG,
+    ROS_FEEDBACK_ODOMETRY_COVARIANCE,
+    ROS_CMD_READ_STORAGE_STATS,
+    ROS_FEEDBACK_STORAGE_STATS
 } MessageType_t;
 
 /** @brief Enumeration of gear modes */
@@ -103,6 +134,25 @@ typedef struct OdometryMessage
     float omega;
 } OdometryMessage_t;
 
+/**
+ * @brief Odometry message with covariance, sent in place of OdometryMessage_t
+ * Starts with the fields of OdometryMessage_t. The covariances are the upper
+ * triangles of the symmetric matrices, row by row; the ROS node mirrors them
+ * into nav_msgs/Odometry, pose in the odometry frame, twist in the chassis frame.
+ */
+typedef struct OdometryCovarianceMessage
+{
+    enum MessageType messageType;
+
+    float posX;
+    float posY;
+    float theta;
+    float velocity;
+    float omega;
+    float poseCovariance[6];    // x, y, theta: xx, xy, xTheta, yy, yTheta, thetaTheta
+    float twistCovariance[3];   // velocity, omega: vv, vOmega, omegaOmega
+} OdometryCovarianceMessage_t;
+
 /** @brief Battery message structure */
 typedef struct BatteryMessage
 {
@@ -165,30 +215,320 @@ typedef struct ChassisStateMessage
     uint32_t error_code;
 } ChassisStateMessage_t;
 
-/** @brief Parameters message structure */
-typedef struct ParametersMessage
+#define MAX_PARAMETERS_PER_MESSAGE  16
+
+/** @brief Status of a parameter in a ParameterListMessage_t feedback */
+#define PARAMETER_STATUS_OK             0   // Read, or set as requested
+#define PARAMETER_STATUS_UNKNOWN_KEY    1   // Not a scalar parameter of the data store
+#define PARAMETER_STATUS_WRONG_TYPE     2   // Type differs from the one of the parameter
+#define PARAMETER_STATUS_OUT_OF_RANGE   3   // Value refused, the stored value is returned
+
+/** @brief One parameter of the data store registry */
+typedef struct ParameterValue
 {
+    uint16_t key;       // DataStoreKey_t of the parameter
+    uint8_t type;       // DataStore_Type_t: 0 float, 1 uint32, 2 uint16
+    uint8_t status;     // PARAMETER_STATUS_*, in the feedback only
+    uint32_t value;     // IEEE 754 bits of a float, or the integer
+} ParameterValue_t;
+
+/**
+ * @brief Parameter list message structure
+ * ROS_CMD_PARAMETERS with count 0 reads every parameter, with count > 0 sets
+ * the listed ones. ROS_FEEDBACK_PARAMETERS answers with the values in use and
+ * the status of each; success is 1 when every status is PARAMETER_STATUS_OK.
+ * The message may be cut after the last valid parameter.
+ */
+typedef struct ParameterListMessage
+{
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t count;     // Number of valid parameters
+    ParameterValue_t parameters[MAX_PARAMETERS_PER_MESSAGE];
+} ParameterListMessage_t;
+
+#define LOG_PAGE_SIZE               256
+#define MAX_LOG_PAGES_PER_MESSAGE   4
+
+/** @brief Read flight log message structure */
+typedef struct ReadLogMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t page;          // Index of the first page, 0 is the oldest page
+    uint32_t pageCount;     // Number of pages, at most MAX_LOG_PAGES_PER_MESSAGE
+} ReadLogMessage_t;
+
+/** @brief Flight log data message structure, only pageCount pages are sent */
+typedef struct LogDataMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t page;          // Index of the first page
+    uint32_t pageCount;     // Number of pages in data
+    uint32_t totalPages;    // Number of pages held by the log
+    uint8_t data[MAX_LOG_PAGES_PER_MESSAGE * LOG_PAGE_SIZE];
+} LogDataMessage_t;
+
+#define OTA_PAGE_SIZE               256
+
+/**
+ * @brief OTA messages, exchanged on DEFAULT_OTA_UDP_PORT
+ * Every OTA message is answered with an OtaStatusMessage_t. The upper machine
+ * keeps up to windowPages pages in flight after nextPage and resends the pages
+ * whose bit is clear in pendingMask.
+ */
+typedef struct OtaBeginMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t imageSize;     // Size of the image in bytes
+    uint32_t imageCRC;      // CRC32 of the image, STM32 CRC unit flavour
+    uint32_t version;       // Version of the image
+} OtaBeginMessage_t;
+
+/** @brief OTA data message structure, only length bytes of data are sent */
+typedef struct OtaDataMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t page;          // Index of the page
+    uint32_t length;        // OTA_PAGE_SIZE except for the last page
+    uint8_t data[OTA_PAGE_SIZE];
+} OtaDataMessage_t;
+
+/** @brief OTA end message structure */
+typedef struct OtaEndMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t reboot;        // Reboot into the bootloader once the image is verified
+} OtaEndMessage_t;
+
+/** @brief OTA status message structure */
+typedef struct OtaStatusMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;       // Result of the answered message
+
+    uint32_t nextPage;      // First page not yet verified
+    uint32_t pendingMask;   // Bit n set when page nextPage + n is stored
+    uint32_t windowPages;   // Pages accepted from nextPage on
+    uint32_t runningCRC;    // CRC32 over the pages before nextPage
+} OtaStatusMessage_t;
+
+#define MAX_MEMPOOL_CLASSES             6
+#define MAX_MEMPOOL_BLOCKS_PER_MESSAGE  16
+
+/** @brief Read memory pool statistics message structure */
+typedef struct ReadMemPoolStatsMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t firstBlock;    // Allocated blocks to skip in the leak report
+} ReadMemPoolStatsMessage_t;
+
+/** @brief Statistics of one memory pool size class */
+typedef struct MemPoolClassInfo {
+    uint32_t blockSize;     // Size of the blocks in bytes
+    uint32_t blockCount;    // Number of blocks in the class
+    uint32_t inUse;         // Blocks currently allocated
+    uint32_t highWater;     // Maximum of inUse since boot
+    uint32_t exhausted;     // Requests which found the class empty
+} MemPoolClassInfo_t;
+
+/** @brief Allocated memory pool block, leak candidate when old */
+typedef struct MemPoolBlockInfo {
+    uint32_t owner;         // Return address of the allocating call
+    uint32_t blockSize;     // Size of the block in bytes
+    uint32_t age;           // ms since the allocation
+} MemPoolBlockInfo_t;
+
+/** @brief Memory pool statistics message structure, only blockCount blocks are sent */
+typedef struct MemPoolStatsMessage {
     MessageType_t messageType;
     uint32_t messageID;
     uint32_t success;
 
-    uint32_t stateFeedbackFrequency;
-    uint32_t odometryFeedbackFrequency;
-    uint32_t batteryFeedbackFrequency;
-    float wheelDiameter;
-    float trackWidth;
-    float maxLinearAcceleration;
-    float maxAngularAcceleration;
-    float maxLinearVelocity;
-    float maxAngularVelocity;
-} ParametersMessage_t;
+    uint32_t classCount;        // Number of valid entries in classes
+    uint32_t failures;          // Allocations which failed in every class
+    uint32_t allocatedBlocks;   // Number of allocated blocks
+    uint32_t firstBlock;        // Index of blocks[0] among the allocated blocks
+    uint32_t blockCount;        // Number of entries in blocks
+    MemPoolClassInfo_t classes[MAX_MEMPOOL_CLASSES];
+    MemPoolBlockInfo_t blocks[MAX_MEMPOOL_BLOCKS_PER_MESSAGE];
+} MemPoolStatsMessage_t;
+
+#define MAX_RESOURCE_THREADS        16
+#define RESOURCE_THREAD_NAME_SIZE   20
 
-/** @brief Feedback Parameters message structure */
-typedef struct FeedbackParametersMessage {
+/** @brief Read resources message structure */
+typedef struct ReadResourcesMessage {
     MessageType_t messageType;
     uint32_t messageID;
     uint32_t success;
-} FeedbackParametersMessage_t;
+} ReadResourcesMessage_t;
+
+/** @brief Stack usage of one thread */
+typedef struct ThreadResourceInfo {
+    char name[RESOURCE_THREAD_NAME_SIZE];   // Name of the thread, empty if not named
+    uint32_t stackSize;     // Size of the stack in bytes
+    uint32_t stackUsed;     // Bytes of the stack ever used
+    int32_t priority;       // osPriority_t of the thread
+    int32_t state;          // osThreadState_t of the thread
+} ThreadResourceInfo_t;
+
+/** @brief Resources message structure, only threadCount threads are sent */
+typedef struct ResourcesMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t heapSize;          // RTX dynamic memory in bytes
+    uint32_t heapUsed;          // Bytes allocated now
+    uint32_t heapPeak;          // Maximum of heapUsed seen by the reports
+    uint32_t poolSize;          // Memory pool blocks in bytes, all classes
+    uint32_t poolUsed;          // Bytes of the allocated blocks
+    uint32_t poolPeak;          // Sum of the class high-water marks in bytes
+    uint32_t threadCount;       // Number of entries in threads
+    ThreadResourceInfo_t threads[MAX_RESOURCE_THREADS];
+} ResourcesMessage_t;
+
+/** @brief Read storage statistics message structure */
+typedef struct ReadStorageStatsMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+} ReadStorageStatsMessage_t;
+
+/** @brief Storage statistics message structure, counters since boot */
+typedef struct StorageStatsMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t pending;           // 1 if parameter changes wait for their commit
+    uint32_t saveRequests;      // Parameter save requests
+    uint32_t commits;           // Parameter commits which wrote to flash
+    uint32_t records;           // Records appended to the parameter log
+    uint32_t erases;            // Sectors of the parameter log erased
+} StorageStatsMessage_t;
+
+#define MAX_CPU_LOAD_ISRS       5   // TIM7, TIM3, TIM4, USART3, ETH
+
+/** @brief Time spent in one interrupt handler during the window */
+typedef struct IsrLoadInfo {
+    uint32_t cycles;        // Cycles spent in the handler, nested interrupts included
+    uint32_t count;         // Number of times the handler ran
+    uint32_t maxCycles;     // Longest single run of the handler
+} IsrLoadInfo_t;
+
+/** @brief Time spent in one thread during the window */
+typedef struct ThreadLoadInfo {
+    char name[RESOURCE_THREAD_NAME_SIZE];   // Name of the thread, empty if not named or for the other threads
+    uint32_t cycles;        // Cycles spent in the thread, interrupts excluded
+} ThreadLoadInfo_t;
+
+/** @brief CPU load message structure, published periodically, only threadCount threads are sent */
+typedef struct CpuLoadMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t cpuFrequency;      // Core clock in Hz, cycles per second
+    uint32_t windowCycles;      // Length of the measurement window in cycles
+    uint32_t idleCycles;        // Cycles spent in the idle thread
+    uint32_t isrCycles;         // Cycles spent in the instrumented interrupts
+    uint32_t load;              // CPU load in per mille
+    uint32_t wakeCount;         // Wake-ups of the motion control thread measured
+    uint32_t wakeLatencyMax;    // Longest delay from release to run of the motion thread, in cycles
+    uint32_t wakeLatencyMean;   // Mean delay from release to run of the motion thread, in cycles
+    uint32_t wakePeriodMin;     // Shortest interval between two motion wake-ups, in cycles
+    uint32_t wakePeriodMax;     // Longest interval between two motion wake-ups, in cycles
+    uint32_t sleepCount;        // Tickless sleeps since boot
+    uint32_t sleepTime;         // Time slept since boot in ms, wraps
+    uint32_t sleepWakeLatencyMax;   // Longest delay from a sleep deadline to the idle thread, in us
+    uint32_t parkCount;         // Parks of the chassis since boot, TIM7 tick stopped
+    uint32_t parkTime;          // Time parked since boot in ms, wraps
+    uint32_t parkWakeLatencyMax;    // Longest delay from a wake request to the wheels driven again, in cycles
+    IsrLoadInfo_t isr[MAX_CPU_LOAD_ISRS];
+    uint32_t threadCount;       // Number of entries in threads
+    ThreadLoadInfo_t threads[MAX_RESOURCE_THREADS];
+} CpuLoadMessage_t;
+
+#define MAX_TUNING_MOTORS       2   // Left and right wheel
+
+/** @brief Motor tuning request, the wheels must be off the ground */
+typedef struct MotorTuneMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t motorMask;     // One bit per motor to identify, bit 0 for motor 0
+    float bias;             // Duty the excitation is centred on, 0 for the default
+    float amplitude;        // Duty added or removed by the excitation, 0 for the default
+    uint32_t save;          // Non-zero to apply and store the gains of the valid results
+} MotorTuneMessage_t;
+
+/** @brief Identified model and computed gains of one motor */
+typedef struct MotorTuneResult {
+    uint32_t valid;         // Non-zero if the model fits and the gains are computed
+    float gain;             // Steady state speed per duty, rad/s
+    float timeConstant;     // s
+    float deadTime;         // s
+    float friction;         // Duty needed to overcome the friction
+    float fitQuality;       // Share of the speed variance explained by the model, 1 is perfect
+    float kP;
+    float kI;
+    float kD;
+    float ffKs;             // Feed-forward duty against the friction
+    float ffKv;             // Feed-forward duty per rad/s
+    float ffKa;             // Feed-forward duty per rad/s^2
+} MotorTuneResult_t;
+
+/** @brief Motor tuning result message, sent once the identification is over */
+typedef struct MotorTuneResultMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t motorCount;    // Number of entries in motors
+    MotorTuneResult_t motors[MAX_TUNING_MOTORS];
+} MotorTuneResultMessage_t;
+
+/**
+ * @brief Motor configuration message structure
+ * Sent with ROS_CMD_MOTOR_CONFIG to read or write the configuration of one
+ * motor, answered with ROS_FEEDBACK_MOTOR_CONFIG and the configuration in use.
+ */
+typedef struct MotorConfigMessage {
+    MessageType_t messageType;
+    uint32_t messageID;
+    uint32_t success;
+
+    uint32_t motorId;           // 0 for the left wheel, 1 for the right wheel
+    uint32_t write;             // Non-zero to apply the values below, 0 to only read them
+    uint32_t save;              // Non-zero to also store the values in flash
+    float kP;
+    float kI;
+    float kD;
+    float ffKs;                 // Feed-forward duty against the friction
+    float ffKv;                 // Feed-forward duty per rad/s
+    float ffKa;                 // Feed-forward duty per rad/s^2
+    float derivativeAlpha;      // Smoothing of the PID derivative, 0 to 1, 1 for no filter
+    float antiWindupGain;       // Back-calculation gain of the PID integral, 0 to 1
+    float measureVariance;      // Kalman variance of the measured speed
+    float processVariance;      // Kalman variance of the speed change per control period
+    uint32_t encoderResolution; // Encoder edges per wheel revolution, both phases
+} MotorConfigMessage_t;
 
 /** @brief Unknown message structure for unrecognized messages */
 typedef struct UnknownMessage
@@ -207,10 +547,23 @@ typedef struct UnknownMessage
     _MAX(sizeof(MotionMessage_t),                                     \
     _MAX(sizeof(VelocityMessage_t),                                   \
     _MAX(sizeof(LightMessage_t),                                      \
-    _MAX(sizeof(ParametersMessage_t),                                 \
-    _MAX(sizeof(SetIoMessage_t), sizeof(ReadIoMessage_t))))))
+    _MAX(sizeof(ParameterListMessage_t),                              \
+    _MAX(sizeof(ReadLogMessage_t),                                    \
+    _MAX(sizeof(ReadMemPoolStatsMessage_t),                           \
+    _MAX(sizeof(MotorTuneMessage_t),                                  \
+    _MAX(sizeof(MotorConfigMessage_t),                                \
+    _MAX(sizeof(ReadStorageStatsMessage_t),                           \
+    _MAX(sizeof(SetIoMessage_t), sizeof(ReadIoMessage_t)))))))))))
 #define ROS_MAX_FEEDBACK_MESSAGE_SIZE                                 \
     _MAX(sizeof(OdometryMessage_t),                                   \
+    _MAX(sizeof(OdometryCovarianceMessage_t),                         \
     _MAX(sizeof(BatteryMessage_t),                                    \
-    _MAX(sizeof(FeedbackParametersMessage_t),                         \
-    _MAX(sizeof(LightMessage_t), sizeof(ChassisStateMessage_t)))))
+    _MAX(sizeof(ParameterListMessage_t),                              \
+    _MAX(sizeof(LogDataMessage_t),                                    \
+    _MAX(sizeof(MemPoolStatsMessage_t),                               \
+    _MAX(sizeof(ResourcesMessage_t),                                  \
+    _MAX(sizeof(CpuLoadMessage_t),                                    \
+    _MAX(sizeof(MotorTuneResultMessage_t),                            \
+    _MAX(sizeof(MotorConfigMessage_t),                                \
+    _MAX(sizeof(StorageStatsMessage_t),                               \
+    _MAX(sizeof(LightMessage_t), sizeof(ChassisStateMessage_t)))))))))))))
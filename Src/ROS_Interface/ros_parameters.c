@@ -2,9 +2,14 @@
  * @file ros_parameters.c
  * @brief ROS interface handler for parameter set commands.
  * @details This file contains the handler functions for setting parameters 
- *          in the ROS interface.
+ *          in the ROS interface. The scalar parameters of the data store are
+ *          read all at once or set by key, several per message. The motor
+ *          configuration (gains, filters and
+ *          encoder resolution) is read and written per motor; the control
+ *          period adopts a new configuration without a reboot.
  * @author Young.W <com.wang@hotmail.com>
  * @date 2025-09-02
+ *       Modified on 2026-10-17 to read and set the parameters by key
  */
 
 #include "ros_parameters.h"
@@ -13,12 +18,21 @@
 #include "ros_messages.h"
 #include "data_store.h"
 #include "motion_control.h"
+#include "dc_motor.h"
+#include "system_config.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
 /* ----------------------------------- Static Functions ---------------------------------------- */
-static void SetParametersCallback(const uint8_t *data, uint32_t size);
+static void ParametersCallback(const uint8_t *data, uint32_t size);
+static uint8_t SetParameter(const ParameterValue_t *parameter);
+static bool GetParameter(uint16_t key, ParameterValue_t *parameter);
+static void MotorConfigCallback(const uint8_t *data, uint32_t size);
+static bool IsMotorConfigValid(const DCMotor_Config_t *config);
+
+_Static_assert(DATA_STORE_PARAMETER_NUMBER <= MAX_PARAMETERS_PER_MESSAGE, "Every parameter must fit in one ParameterListMessage_t");
 
 /**
  * @brief Initialize the Parameters service
@@ -26,44 +40,204 @@ static void SetParametersCallback(const uint8_t *data, uint32_t size);
  */
 bool ROS_ServiceParameters_Init(void)
 {
-    return ROS_Interface_RegisterIncomingCallback(ROS_CMD_PARAMETERS, SetParametersCallback);
+    bool result = ROS_Interface_RegisterIncomingCallback(ROS_CMD_PARAMETERS, ParametersCallback);
+    result &= ROS_Interface_RegisterIncomingCallback(ROS_CMD_MOTOR_CONFIG, MotorConfigCallback);
+    return result;
 }
 
 /**
- * @brief Callback for setting parameters
- * This function processes incoming parameter set messages.
+ * @brief Callback for parameter list messages
+ * This function reads every parameter when the list is empty, or sets the
+ * listed parameters, and sends back their values in use.
  * @param data pointer to the received data
  * @param size size of the received data
  * @note This function should be fast and non-blocking.
  */
-void SetParametersCallback(const uint8_t *data, uint32_t size)
+void ParametersCallback(const uint8_t *data, uint32_t size)
 {
-    if (data == NULL || size < sizeof(ParametersMessage_t))
+    const uint32_t headerSize = offsetof(ParameterListMessage_t, parameters);
+    if (data == NULL || size < headerSize)
         return;
 
-    const ParametersMessage_t *msg = (const ParametersMessage_t *)data;
-    if (msg->messageType != ROS_CMD_PARAMETERS)
+    ParameterListMessage_t msg;
+    memset(&msg, 0, sizeof(msg));
+    memcpy(&msg, data, size < sizeof(msg) ? size : sizeof(msg));
+    if (msg.messageType != ROS_CMD_PARAMETERS || msg.count > MAX_PARAMETERS_PER_MESSAGE ||
+        size < headerSize + msg.count * sizeof(ParameterValue_t))
         return;
 
-    // Reset odometry and encoders
-    MotionControl_ResetOdometry();
-
-    // Process the parameters command
-    DataStore_SetStateFeedbackFrequency(msg->stateFeedbackFrequency);
-    DataStore_SetOdometryFeedbackFrequency(msg->odometryFeedbackFrequency);
-    DataStore_SetWheelRadius(msg->wheelDiameter/2.0f);
-    DataStore_SetTrackWidth(msg->trackWidth);
-    DataStore_SetMaxVelocity(msg->maxLinearVelocity);
-    DataStore_SetMaxOmega(msg->maxAngularVelocity);
-    DataStore_SetMaxLinearAcceleration(msg->maxLinearAcceleration);
-    DataStore_SetMaxAngularAcceleration(msg->maxAngularAcceleration);
-
-    // Send acknowledgment
-    FeedbackParametersMessage_t feedback;
+    ParameterListMessage_t feedback;
+    memset(&feedback, 0, sizeof(feedback));
     feedback.messageType = ROS_FEEDBACK_PARAMETERS;
-    feedback.messageID = msg->messageID;
-    feedback.success = 1; // Indicate success
+    feedback.messageID = msg.messageID;
+    feedback.success = 1;
+    if (msg.count == 0)
+    {
+        // Read all: every key of the registry
+        for (uint16_t key = 0; key < DATA_STORE_KEY_NUMBER; key++)
+        {
+            if (GetParameter(key, &feedback.parameters[feedback.count])) feedback.count++;
+        }
+    }
+    else
+    {
+        bool isGeometryChanged = false;
+        for (uint32_t i = 0; i < msg.count; i++)
+        {
+            const ParameterValue_t *parameter = &msg.parameters[i];
+            uint8_t status = SetParameter(parameter);
+            if (status == PARAMETER_STATUS_OK &&
+                (parameter->key == DATA_STORE_KEY_WHEEL_RADIUS || parameter->key == DATA_STORE_KEY_TRACK_WIDTH ||
+                 parameter->key == DATA_STORE_KEY_WHEEL_BASE))
+                isGeometryChanged = true;
+            feedback.parameters[i].key = parameter->key;
+            GetParameter(parameter->key, &feedback.parameters[i]);
+            feedback.parameters[i].status = status;
+            if (status != PARAMETER_STATUS_OK) feedback.success = 0;
+        }
+        feedback.count = msg.count;
+        // The setters notify their subscribers, the new values apply without reboot.
+        // The odometry restarts from zero: a pose summed with two geometries means nothing
+        if (isGeometryChanged) MotionControl_ResetOdometry();
+        // Save the modified parameters to persistent storage
+        DataStore_SaveDataIfModified();
+    }
+    ROS_Interface_SendBackMessage((const uint8_t *)&feedback, headerSize + feedback.count * sizeof(ParameterValue_t));
+}
+
+/**
+ * @brief Set one parameter of a parameter list
+ * @param parameter pointer to the key, type and raw value
+ * @return PARAMETER_STATUS_* of the parameter
+ */
+uint8_t SetParameter(const ParameterValue_t *parameter)
+{
+    DataStore_Type_t type;
+    DataStore_Value_t value;
+    if (!DataStore_GetParameter((DataStoreKey_t)parameter->key, &type, &value)) return PARAMETER_STATUS_UNKNOWN_KEY;
+    if (parameter->type != type) return PARAMETER_STATUS_WRONG_TYPE;
+    switch (type)
+    {
+    case DATA_STORE_TYPE_F32:
+        memcpy(&value.F32, &parameter->value, sizeof(value.F32));
+        break;
+    case DATA_STORE_TYPE_U32:
+        value.U32 = parameter->value;
+        break;
+    case DATA_STORE_TYPE_U16:
+        if (parameter->value > UINT16_MAX) return PARAMETER_STATUS_OUT_OF_RANGE;
+        value.U16 = (uint16_t)parameter->value;
+        break;
+    default:
+        return PARAMETER_STATUS_WRONG_TYPE;
+    }
+    return DataStore_SetParameter((DataStoreKey_t)parameter->key, value) ? PARAMETER_STATUS_OK : PARAMETER_STATUS_OUT_OF_RANGE;
+}
+
+/**
+ * @brief Read one parameter into a parameter list
+ * @param key DataStoreKey_t of the parameter
+ * @param parameter pointer to the entry to fill, its status is set to OK
+ * @return true if the key is a scalar parameter, false otherwise; the entry
+ *         keeps its key with PARAMETER_STATUS_UNKNOWN_KEY then
+ */
+bool GetParameter(uint16_t key, ParameterValue_t *parameter)
+{
+    DataStore_Type_t type;
+    DataStore_Value_t value;
+    parameter->key = key;
+    if (!DataStore_GetParameter((DataStoreKey_t)key, &type, &value))
+    {
+        parameter->type = 0;
+        parameter->status = PARAMETER_STATUS_UNKNOWN_KEY;
+        parameter->value = 0;
+        return false;
+    }
+    parameter->type = (uint8_t)type;
+    parameter->status = PARAMETER_STATUS_OK;
+    switch (type)
+    {
+    case DATA_STORE_TYPE_F32:
+        memcpy(&parameter->value, &value.F32, sizeof(value.F32));
+        break;
+    case DATA_STORE_TYPE_U32:
+        parameter->value = value.U32;
+        break;
+    case DATA_STORE_TYPE_U16:
+        parameter->value = value.U16;
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief Callback for motor configuration messages
+ * This function applies the configuration of a motor if requested, stores it
+ * if requested, and sends back the configuration in use.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void MotorConfigCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(MotorConfigMessage_t))
+        return;
+
+    MotorConfigMessage_t msg;
+    memcpy(&msg, data, sizeof(MotorConfigMessage_t));
+    if (msg.messageType != ROS_CMD_MOTOR_CONFIG)
+        return;
+
+    bool success = msg.motorId < TOTAL_MOTOR_NUMBER;
+    if (success && msg.write)
+    {
+        DCMotor_Config_t config = {
+            .gains = { msg.kP, msg.kI, msg.kD, msg.ffKs, msg.ffKv, msg.ffKa },
+            .filter = { msg.derivativeAlpha, msg.antiWindupGain, msg.measureVariance, msg.processVariance },
+            .encoderResolution = msg.encoderResolution,
+        };
+        success = IsMotorConfigValid(&config);
+        if (success) success = DCMotor_SetConfig(msg.motorId, &config);
+        if (success && msg.save)
+        {
+            DataStore_SetMotorGains(msg.motorId, &config.gains);
+            DataStore_SetMotorFilter(msg.motorId, &config.filter);
+            DataStore_SetEncoderResolution(msg.motorId, config.encoderResolution);
+            DataStore_SaveDataIfModified();
+        }
+    }
+
+    DCMotor_Config_t config;
+    MotorConfigMessage_t feedback;
+    memset(&feedback, 0, sizeof(feedback));
+    feedback.messageType = ROS_FEEDBACK_MOTOR_CONFIG;
+    feedback.messageID = msg.messageID;
+    feedback.motorId = msg.motorId;
+    if (DCMotor_GetConfig(msg.motorId, &config))
+    {
+        feedback.kP = config.gains.kP;
+        feedback.kI = config.gains.kI;
+        feedback.kD = config.gains.kD;
+        feedback.ffKs = config.gains.ffKs;
+        feedback.ffKv = config.gains.ffKv;
+        feedback.ffKa = config.gains.ffKa;
+        feedback.derivativeAlpha = config.filter.derivativeAlpha;
+        feedback.antiWindupGain = config.filter.antiWindupGain;
+        feedback.measureVariance = config.filter.measureVariance;
+        feedback.processVariance = config.filter.processVariance;
+        feedback.encoderResolution = config.encoderResolution;
+    }
+    feedback.success = success;
     ROS_Interface_SendBackMessage((const uint8_t *)&feedback, sizeof(feedback));
-    // Save the modified parameters to persistent storage
-    DataStore_SaveDataIfModified();
+}
+
+/**
+ * @brief Check the values of a motor configuration
+ * The same checks as the data store applies to what it stores and loads.
+ * @param config pointer to the configuration
+ * @return true if the configuration can be applied, false otherwise
+ */
+bool IsMotorConfigValid(const DCMotor_Config_t *config)
+{
+    return DataStore_IsMotorGainsValid(&config->gains) && DataStore_IsMotorFilterValid(&config->filter) &&
+           config->encoderResolution > 0;
 }
@@ -6,7 +6,8 @@
  * @details Provides a feedback producer that packs a \ref ChassisStateMessage_t
  * into a static buffer and exposes it via a callback used by the ROS UDP
  * interface. The initialization function registers this callback so the
- * ROS interface can transmit the payload at a fixed period.
+ * ROS interface can transmit the payload at the state feedback frequency of
+ * the data store, followed when it is set.
  *
  * The message contains high-level chassis information such as battery and light
  * status. Serialization is done directly into an internal buffer to avoid
@@ -17,6 +18,7 @@
  *
  * @dependencies ros_interface.h, ros_messages.h
  * @date 2025-09-02
+ *       Modified on 2026-10-17 to follow the feedback frequency set at runtime
  * @author Young.W <com.wang@hotmail.com>
  */
 
@@ -37,18 +39,29 @@ static uint8_t sendBuffer[sizeof(ChassisStateMessage_t)] = {0};
 
 /* --------------------- Static Functions ------------------------- */
 void PrepareChassisStateMessage(const void **data, uint32_t *size);
+uint32_t GetChassisStatePublishInterval(void);
 
 /**
  * @brief Initialize the Chassis State Publisher
  * This function initializes the chassis state publisher by registering the
- * callback function for sending chassis state messages.
+ * callback function for sending chassis state messages, at the state
+ * feedback frequency of the data store.
  */
 bool ROS_PublisherChassisState_Init(void)
+{
+    return ROS_Interface_RegisterParameterFeedbackCallback(DATA_STORE_KEY_MASK(DATA_STORE_KEY_STATE_FREQUENCY),
+                                                           GetChassisStatePublishInterval, PrepareChassisStateMessage);
+}
+
+/**
+ * @brief Get the chassis state publish interval
+ * Called again by the ROS interface when the frequency is set.
+ * @return interval in ms
+ */
+uint32_t GetChassisStatePublishInterval(void)
 {
     float frequency = DataStore_GetStateFeedbackFrequency();
-    const uint32_t feedbackPeriod = (frequency > 0.0f) ? (uint32_t)(1000.0f / frequency) : DEFAULT_PUBLISH_INTERVAL_MS; // Default to 10 Hz if frequency is zero
-    // Initialization code for the chassis state publisher
-    return ROS_Interface_RegisterFeedbackCallback(feedbackPeriod, PrepareChassisStateMessage); // Register callback for chassis state messages
+    return (frequency > 0.0f) ? (uint32_t)(1000.0f / frequency) : DEFAULT_PUBLISH_INTERVAL_MS; // Default to 10 Hz if frequency is zero
 }
 
 /**
@@ -0,0 +1,100 @@
+/**
+ * @file ros_publisher_cpu_load.c
+ * @brief Publishes the CPU load over the ROS interface.
+ * @details
+ *  - Registers a periodic feedback callback with ROS_Interface, once per
+ *    CPU load window.
+ *  - Fills a CpuLoadMessage_t from the last complete window of CpuLoad:
+ *    total load, idle and interrupt time, each instrumented handler and each
+ *    thread by name. Nothing is sent before the first window completes.
+ *  - Adds the tickless idle and park statistics, the wake-up latency of a
+ *    parked chassis is the delay to its first motion period.
+ * @author Young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ * @version 1.0
+ * @ingroup ros_interface
+ * @copyright Young
+ */
+#include "ros_publisher_cpu_load.h"
+#include "ros_interface.h"
+#include "ros_messages.h"
+#include "cpu_load.h"
+#include "low_power.h"
+#include "motion_control.h"
+#include "cmsis_os2.h"
+#include "main.h"
+
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(MAX_CPU_LOAD_ISRS == CPU_LOAD_ISR_COUNT, "MAX_CPU_LOAD_ISRS must match the instrumented interrupts");
+
+/* ---------------- Static Variables -------------------- */
+static CpuLoadMessage_t cpuLoadMessage;
+static CpuLoad_Report_t cpuLoadReport;  // Too large for the feedback thread stack
+
+/* ---------------- Static Functions -------------------- */
+static void PrepareCpuLoadMessage(const void **data, uint32_t *size);
+
+/**
+ * @brief Initialize the CPU load publisher
+ * This function registers the callback for preparing CPU load messages.
+ */
+bool ROS_PublisherCpuLoad_Init(void)
+{
+    return ROS_Interface_RegisterFeedbackCallback(CPU_LOAD_WINDOW_MS, PrepareCpuLoadMessage);
+}
+
+/**
+ * @brief Prepare the CPU load message
+ * This function fills the message from the last complete window.
+ * @param data pointer to the data buffer to be sent
+ * @param size pointer to the size of the data buffer
+ */
+void PrepareCpuLoadMessage(const void **data, uint32_t *size)
+{
+    if (data == NULL || size == NULL) return;
+    if (!CpuLoad_GetReport(&cpuLoadReport)) return;
+
+    CpuLoadMessage_t *msg = &cpuLoadMessage;
+    msg->messageType = ROS_FEEDBACK_CPU_LOAD;
+    msg->messageID = 0;
+    msg->success = true;
+    msg->cpuFrequency = SystemCoreClock;
+    msg->windowCycles = cpuLoadReport.windowCycles;
+    msg->idleCycles = cpuLoadReport.idleCycles;
+    msg->isrCycles = cpuLoadReport.isrCycles;
+    msg->load = cpuLoadReport.load;
+    msg->wakeCount = cpuLoadReport.wakeCount;
+    msg->wakeLatencyMax = cpuLoadReport.wakeLatencyMax;
+    msg->wakeLatencyMean = cpuLoadReport.wakeLatencyMean;
+    msg->wakePeriodMin = cpuLoadReport.wakePeriodMin;
+    msg->wakePeriodMax = cpuLoadReport.wakePeriodMax;
+    LowPower_Stats_t sleepStats;
+    LowPower_GetStats(&sleepStats);
+    msg->sleepCount = sleepStats.sleepCount;
+    msg->sleepTime = sleepStats.sleepTime;
+    msg->sleepWakeLatencyMax = sleepStats.wakeLatencyMax;
+    MotionControl_ParkStats_t parkStats;
+    MotionControl_GetParkStats(&parkStats);
+    msg->parkCount = parkStats.parkCount;
+    msg->parkTime = parkStats.parkTime;
+    msg->parkWakeLatencyMax = parkStats.wakeLatencyMax;
+    for (uint32_t i = 0; i < MAX_CPU_LOAD_ISRS; i++)
+    {
+        msg->isr[i].cycles = cpuLoadReport.isr[i].cycles;
+        msg->isr[i].count = cpuLoadReport.isr[i].count;
+        msg->isr[i].maxCycles = cpuLoadReport.isr[i].maxCycles;
+    }
+    msg->threadCount = cpuLoadReport.threadCount < MAX_RESOURCE_THREADS ? cpuLoadReport.threadCount : MAX_RESOURCE_THREADS;
+    for (uint32_t i = 0; i < msg->threadCount; i++)
+    {
+        const char *name = cpuLoadReport.threads[i].thread != NULL ? osThreadGetName(cpuLoadReport.threads[i].thread) : NULL;
+        memset(msg->threads[i].name, 0, RESOURCE_THREAD_NAME_SIZE);
+        if (name != NULL) strncpy(msg->threads[i].name, name, RESOURCE_THREAD_NAME_SIZE - 1);
+        msg->threads[i].cycles = cpuLoadReport.threads[i].cycles;
+    }
+
+    *data = msg;
+    *size = offsetof(CpuLoadMessage_t, threads) + msg->threadCount * sizeof(ThreadLoadInfo_t);
+}
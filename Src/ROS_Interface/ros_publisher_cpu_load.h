@@ -0,0 +1,22 @@
+/**
+ * @file ros_publisher_cpu_load.h
+ * @brief Publishes the CPU load over the ROS interface.
+ * @details
+ *  - Registers a periodic feedback callback with ROS_Interface, once per
+ *    CPU load window.
+ *  - Fills a CpuLoadMessage_t from the last complete window of CpuLoad.
+ *  - Used by ROS_Interface to transmit ROS_FEEDBACK_CPU_LOAD frames.
+ * @author young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ * @ingroup ros_interface
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the CPU load publisher
+ * This function registers the callback for preparing CPU load messages.
+ */
+bool ROS_PublisherCpuLoad_Init(void);
@@ -2,12 +2,15 @@
  * @file ros_publisher_odom.c
  * @brief Publishes odometry feedback over the ROS interface.
  * @details
- *  - Registers a periodic feedback callback with ROS_Interface (50 ms).
- *  - Fills an OdometryMessage_t using ChassisOdometry and returns its buffer.
- *  - Used by ROS_Interface to transmit ROS_FEEDBACK_ODOMETRY frames.
+ *  - Registers a periodic feedback callback with ROS_Interface at the odometry
+ *    feedback frequency of the data store, followed when it is set.
+ *  - Fills an OdometryCovarianceMessage_t using ChassisOdometry and returns its buffer.
+ *  - Used by ROS_Interface to transmit ROS_FEEDBACK_ODOMETRY_COVARIANCE frames.
  * @author Young <com.wang@hotmail.com>
  * @date 2025-08-25
  *      Modified on 2025-12-9 to use MotionControl_GetOdometry()
+ *      Modified on 2026-10-17 to send the covariance of the odometry
+ *      Modified on 2026-10-17 to follow the feedback frequency set at runtime
  * @version 1.0
  * @ingroup ros_interface
  * @copyright Young
@@ -20,21 +23,35 @@
 
 #include <stdlib.h>
 
+#define DEFAULT_PUBLISH_INTERVAL_MS 20 // Default publish interval in milliseconds (50 Hz)
+
 /* ---------------- Static Variables -------------------- */
-static uint8_t odomBuffer[sizeof(OdometryMessage_t)] = {0};
+static uint8_t odomBuffer[sizeof(OdometryCovarianceMessage_t)] = {0};
 
 /* ---------------- Static Functions -------------------- */
 void PrepareOdomMessage(const void **data, uint32_t *size);
+uint32_t GetOdomPublishInterval(void);
 
 /**
  * @brief Initialize the Odometry publisher
- * This function registers the callback for preparing odometry messages.
+ * This function registers the callback for preparing odometry messages, at
+ * the odometry feedback frequency of the data store.
  */
 bool ROS_PublisherOdom_Init(void)
 {
-    // Register callback for odometry messages every 20ms
-    uint32_t publishInterval = (uint32_t)(1000.0f / DataStore_GetOdometryFeedbackFrequency());
-    return ROS_Interface_RegisterFeedbackCallback(publishInterval, PrepareOdomMessage);
+    return ROS_Interface_RegisterParameterFeedbackCallback(DATA_STORE_KEY_MASK(DATA_STORE_KEY_ODOMETRY_FREQUENCY),
+                                                           GetOdomPublishInterval, PrepareOdomMessage);
+}
+
+/**
+ * @brief Get the odometry publish interval
+ * Called again by the ROS interface when the frequency is set.
+ * @return interval in ms
+ */
+uint32_t GetOdomPublishInterval(void)
+{
+    float frequency = DataStore_GetOdometryFeedbackFrequency();
+    return (frequency > 0.0f) ? (uint32_t)(1000.0f / frequency) : DEFAULT_PUBLISH_INTERVAL_MS; // Default to 50 Hz if frequency is zero
 }
 
 /**
@@ -46,14 +63,15 @@ bool ROS_PublisherOdom_Init(void)
 void PrepareOdomMessage(const void **data, uint32_t *size)
 {
     if (data == NULL || size == NULL) return;
-    OdometryMessage_t *msg = (OdometryMessage_t *)odomBuffer;
-    msg->messageType = ROS_FEEDBACK_ODOMETRY;
-    if (!MotionControl_GetOdometry(&msg->posX, &msg->posY, &msg->theta, &msg->velocity, &msg->omega))
+    OdometryCovarianceMessage_t *msg = (OdometryCovarianceMessage_t *)odomBuffer;
+    msg->messageType = ROS_FEEDBACK_ODOMETRY_COVARIANCE;
+    if (!MotionControl_GetOdometry(&msg->posX, &msg->posY, &msg->theta, &msg->velocity, &msg->omega) ||
+        !MotionControl_GetOdometryCovariance(msg->poseCovariance, msg->twistCovariance))
     {
         *data = NULL;
         *size = 0;
         return;
     }
     *data = odomBuffer;
-    *size = sizeof(OdometryMessage_t);
+    *size = sizeof(OdometryCovarianceMessage_t);
 }
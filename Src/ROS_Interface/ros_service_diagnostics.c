@@ -0,0 +1,188 @@
+/**
+ * @file ros_service_diagnostics.c
+ * @brief ROS interface service handler for diagnostics requests.
+ * @details
+ *  - Registers the incoming callback for ROS_CMD_READ_MEMPOOL_STATS.
+ *  - Answers with the statistics of every memory pool size class and a page
+ *    of the allocated blocks with their owner and age. The upper machine
+ *    pages through the allocated blocks with firstBlock; blocks of the same
+ *    owner getting older across reports are leak candidates.
+ *  - Registers the incoming callback for ROS_CMD_READ_RESOURCES.
+ *  - Answers with the RAM budget: RTX heap, memory pools and the stack
+ *    watermark of every thread.
+ *  - Registers the incoming callback for ROS_CMD_READ_STORAGE_STATS.
+ *  - Answers with the parameter persistence state: pending save, save
+ *    requests, commits, records and erased sectors since boot.
+ * @author young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ *       Modified on 2026-10-17 to add the storage statistics
+ * @ingroup ros_interface
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "cmsis_os2.h"
+#include "ros_service_diagnostics.h"
+#include "ros_interface.h"
+#include "ros_messages.h"
+#include "mem_pool.h"
+#include "resource_monitor.h"
+#include "data_store.h"
+
+#if MAX_MEMPOOL_CLASSES != MEMPOOL_CLASSES
+#error "MAX_MEMPOOL_CLASSES must match the memory pool classes"
+#endif
+#if RESOURCE_THREAD_NAME_SIZE != RESOURCE_MONITOR_NAME_SIZE
+#error "RESOURCE_THREAD_NAME_SIZE must match the resource monitor name size"
+#endif
+
+/* -------------------- Static Variables --------------------- */
+static union {
+    MemPoolStatsMessage_t memPoolStats;
+    ResourcesMessage_t resources;
+} response;     // Too large for the incoming thread stack, one request is handled at a time
+static ResourceMonitor_ThreadInfo_t threads[MAX_RESOURCE_THREADS];
+
+/* -------------------- Static Functions --------------------- */
+static void ReadMemPoolStatsCallback(const uint8_t *data, uint32_t size);
+static void ReadResourcesCallback(const uint8_t *data, uint32_t size);
+static void ReadStorageStatsCallback(const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Initialize the diagnostics service
+ * This function registers the callbacks for handling diagnostics requests.
+ */
+bool ROS_ServiceDiagnostics_Init(void)
+{
+    bool result = ROS_Interface_RegisterIncomingCallback(ROS_CMD_READ_MEMPOOL_STATS, ReadMemPoolStatsCallback);
+    result &= ROS_Interface_RegisterIncomingCallback(ROS_CMD_READ_RESOURCES, ReadResourcesCallback);
+    result &= ROS_Interface_RegisterIncomingCallback(ROS_CMD_READ_STORAGE_STATS, ReadStorageStatsCallback);
+    return result;
+}
+
+/**
+ * @brief Callback for ReadMemPoolStats messages
+ * This function collects the memory pool statistics and sends them back.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void ReadMemPoolStatsCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(ReadMemPoolStatsMessage_t)) return;
+
+    ReadMemPoolStatsMessage_t msg;
+    memcpy(&msg, data, sizeof(ReadMemPoolStatsMessage_t));
+    if (msg.messageType != ROS_CMD_READ_MEMPOOL_STATS) return;
+
+    MemPoolStatsMessage_t *report = &response.memPoolStats;
+    report->messageType = ROS_FEEDBACK_MEMPOOL_STATS;
+    report->messageID = msg.messageID;
+    report->success = true;
+    report->classCount = MEMPOOL_CLASSES;
+    for (uint32_t i = 0; i < MEMPOOL_CLASSES; i++)
+    {
+        MemPool_ClassStats_t stats;
+        MemPool_GetClassStats(i, &stats);
+        report->classes[i].blockSize = stats.blockSize;
+        report->classes[i].blockCount = stats.blockCount;
+        report->classes[i].inUse = stats.inUse;
+        report->classes[i].highWater = stats.highWater;
+        report->classes[i].exhausted = stats.exhausted;
+    }
+    report->failures = MemPool_GetFailureCount();
+    report->allocatedBlocks = MemPool_GetAllocatedCount();
+    report->firstBlock = msg.firstBlock;
+
+    MemPool_BlockInfo_t blocks[MAX_MEMPOOL_BLOCKS_PER_MESSAGE];
+    report->blockCount = MemPool_GetAllocatedBlocks(msg.firstBlock, blocks, MAX_MEMPOOL_BLOCKS_PER_MESSAGE);
+    uint32_t now = osKernelGetTickCount();
+    uint32_t tickFreq = osKernelGetTickFreq();
+    for (uint32_t i = 0; i < report->blockCount; i++)
+    {
+        report->blocks[i].owner = blocks[i].owner;
+        report->blocks[i].blockSize = blocks[i].blockSize;
+        report->blocks[i].age = (uint32_t)((uint64_t)(now - blocks[i].allocTick) * 1000 / tickFreq);
+    }
+
+    uint32_t responseSize = offsetof(MemPoolStatsMessage_t, blocks) + report->blockCount * sizeof(MemPoolBlockInfo_t);
+    ROS_Interface_SendBackMessage((const uint8_t *)report, responseSize);
+}
+
+/**
+ * @brief Callback for ReadResources messages
+ * This function collects the heap, pool and stack usage and sends them back.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void ReadResourcesCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(ReadResourcesMessage_t)) return;
+
+    ReadResourcesMessage_t msg;
+    memcpy(&msg, data, sizeof(ReadResourcesMessage_t));
+    if (msg.messageType != ROS_CMD_READ_RESOURCES) return;
+
+    ResourcesMessage_t *resources = &response.resources;
+    resources->messageType = ROS_FEEDBACK_RESOURCES;
+    resources->messageID = msg.messageID;
+
+    ResourceMonitor_HeapInfo_t heap;
+    resources->success = ResourceMonitor_GetHeap(&heap);
+    resources->heapSize = resources->success ? heap.size : 0;
+    resources->heapUsed = resources->success ? heap.used : 0;
+    resources->heapPeak = resources->success ? heap.peak : 0;
+
+    resources->poolSize = 0;
+    resources->poolUsed = 0;
+    resources->poolPeak = 0;
+    for (uint32_t i = 0; i < MEMPOOL_CLASSES; i++)
+    {
+        MemPool_ClassStats_t stats;
+        MemPool_GetClassStats(i, &stats);
+        resources->poolSize += stats.blockSize * stats.blockCount;
+        resources->poolUsed += stats.blockSize * stats.inUse;
+        resources->poolPeak += stats.blockSize * stats.highWater;
+    }
+
+    resources->threadCount = ResourceMonitor_GetThreads(threads, MAX_RESOURCE_THREADS);
+    for (uint32_t i = 0; i < resources->threadCount; i++)
+    {
+        memcpy(resources->threads[i].name, threads[i].name, RESOURCE_THREAD_NAME_SIZE);
+        resources->threads[i].stackSize = threads[i].stackSize;
+        resources->threads[i].stackUsed = threads[i].stackUsed;
+        resources->threads[i].priority = threads[i].priority;
+        resources->threads[i].state = threads[i].state;
+    }
+
+    uint32_t responseSize = offsetof(ResourcesMessage_t, threads) + resources->threadCount * sizeof(ThreadResourceInfo_t);
+    ROS_Interface_SendBackMessage((const uint8_t *)resources, responseSize);
+}
+
+/**
+ * @brief Callback for ReadStorageStats messages
+ * This function collects the parameter persistence statistics and sends them back.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void ReadStorageStatsCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(ReadStorageStatsMessage_t)) return;
+
+    ReadStorageStatsMessage_t msg;
+    memcpy(&msg, data, sizeof(ReadStorageStatsMessage_t));
+    if (msg.messageType != ROS_CMD_READ_STORAGE_STATS) return;
+
+    DataStore_PersistenceStats_t stats;
+    DataStore_GetPersistenceStats(&stats);
+    StorageStatsMessage_t report;
+    report.messageType = ROS_FEEDBACK_STORAGE_STATS;
+    report.messageID = msg.messageID;
+    report.success = true;
+    report.pending = stats.isPending;
+    report.saveRequests = stats.requestCount;
+    report.commits = stats.commitCount;
+    report.records = stats.recordCount;
+    report.erases = stats.eraseCount;
+    ROS_Interface_SendBackMessage((const uint8_t *)&report, sizeof(report));
+}
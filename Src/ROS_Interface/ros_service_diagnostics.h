@@ -0,0 +1,15 @@
+/** 
+ * @file ros_service_diagnostics.h
+ * @brief ROS interface handler for diagnostics requests.
+ * @details This file contains the handlers which report the resource usage
+ *          of the firmware to the upper machine.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the diagnostics service
+ * This function registers the callbacks for handling diagnostics requests.
+ */
+bool ROS_ServiceDiagnostics_Init(void);
@@ -0,0 +1,69 @@
+/**
+ * @file ros_service_log.c
+ * @brief ROS interface service handler for the flight log dump.
+ * @details
+ *  - Registers the incoming callback for ROS_CMD_READ_LOG.
+ *  - Answers each request with up to MAX_LOG_PAGES_PER_MESSAGE raw pages of
+ *    the flight recorder, oldest page first, plus the number of pages held.
+ *  - The upper machine dumps the whole log by requesting consecutive pages,
+ *    keeping several requests in flight, and checks each page CRC itself.
+ * @author young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ * @ingroup ros_interface
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "ros_service_log.h"
+#include "ros_interface.h"
+#include "ros_messages.h"
+#include "flight_recorder.h"
+
+#if LOG_PAGE_SIZE != FLIGHT_RECORDER_PAGE_SIZE
+#error "LOG_PAGE_SIZE must match the flight recorder page size"
+#endif
+
+/* -------------------- Static Variables --------------------- */
+static LogDataMessage_t response;   // Too large for the incoming thread stack
+
+/* -------------------- Static Functions --------------------- */
+static void ReadLogCallback(const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Initialize the flight log service
+ * This function registers the callback for handling read log messages.
+ */
+bool ROS_ServiceLog_Init(void)
+{
+    return ROS_Interface_RegisterIncomingCallback(ROS_CMD_READ_LOG, ReadLogCallback);
+}
+
+/**
+ * @brief Callback for ReadLog messages
+ * This function reads the requested pages and sends them back at once.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ * @note Reading four pages takes well below a millisecond.
+ */
+void ReadLogCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(ReadLogMessage_t)) return;
+
+    ReadLogMessage_t msg;
+    memcpy(&msg, data, sizeof(ReadLogMessage_t));
+    if (msg.messageType != ROS_CMD_READ_LOG) return;
+
+    uint32_t pageCount = msg.pageCount;
+    if (pageCount > MAX_LOG_PAGES_PER_MESSAGE) pageCount = MAX_LOG_PAGES_PER_MESSAGE;
+
+    response.messageType = ROS_FEEDBACK_LOG_DATA;
+    response.messageID = msg.messageID;
+    response.page = msg.page;
+    response.totalPages = FlightRecorder_GetPageCount();
+    response.pageCount = FlightRecorder_ReadPages(msg.page, response.data, pageCount);
+    response.success = (response.pageCount > 0 || pageCount == 0);
+
+    uint32_t responseSize = offsetof(LogDataMessage_t, data) + response.pageCount * LOG_PAGE_SIZE;
+    ROS_Interface_SendBackMessage((const uint8_t *)&response, responseSize);
+}
@@ -0,0 +1,15 @@
+/** 
+ * @file ros_service_log.h
+ * @brief ROS interface handler for flight log dump requests.
+ * @details This file contains the handler which reads pages of the flight
+ *          recorder and sends them back to the upper machine.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the flight log service
+ * This function registers the callback for handling read log messages.
+ */
+bool ROS_ServiceLog_Init(void);
@@ -0,0 +1,197 @@
+/**
+ * @file ros_service_ota.c
+ * @brief ROS interface service handler for firmware updates.
+ * @details
+ *  - Listens on DEFAULT_OTA_UDP_PORT, so a transfer never competes with the
+ *    motion commands in the ROS interface queue.
+ *  - The UDP callback copies each datagram into a free receive slot and hands
+ *    the slot to the update thread, pages are programmed from that slot.
+ *  - Every message is answered with an OtaStatusMessage_t. The upper machine
+ *    keeps up to windowPages pages in flight after nextPage (sliding window)
+ *    and resends the pages whose bit is clear in pendingMask after a timeout.
+ *  - OTA_BEGIN with the image of an interrupted transfer resumes it from the
+ *    last checkpoint, nextPage of the answer tells where.
+ *  - OTA_END programs the apply flag once the image CRC is verified and may
+ *    reboot into the bootloader.
+ * @author young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ * @ingroup ros_interface
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os2.h"
+#include "udp.h"
+#include "ros_service_ota.h"
+#include "ros_messages.h"
+#include "update_file.h"
+#include "data_store.h"
+#include "system_config.h"
+#include "rtx_os.h"
+
+#if OTA_PAGE_SIZE != UPDATE_FILE_PAGE_SIZE
+#error "OTA_PAGE_SIZE must match the update file page size"
+#endif
+
+/* -------------------- Definitions -------------------------- */
+#define OTA_SLOT_NUMBER     8       // Receive slots, a few pages in flight on top of the one being programmed
+#define OTA_REBOOT_DELAY    100     // ms, lets the last status message leave before the reset
+#define OTA_MAX_MESSAGE_SIZE sizeof(OtaDataMessage_t)
+
+/* -------------------- Data Type Definitions ---------------- */
+typedef struct {
+    uint32_t size;
+    union {
+        uint32_t messageType;   // Aligns data, first word of every message
+        uint8_t data[OTA_MAX_MESSAGE_SIZE];
+    };
+} OTA_Slot_t;
+
+/* -------------------- Static Variables --------------------- */
+static UpdateFile_t updateFile;
+static OTA_Slot_t slots[OTA_SLOT_NUMBER];
+static osMessageQueueId_t freeSlotQueueId;  // Indices of the free slots
+static osMessageQueueId_t workSlotQueueId;  // Indices of the received slots
+static osThreadId_t otaThreadID;
+static int otaUdpSocket = -1;
+
+static uint64_t otaThreadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t otaThreadControlBlock;
+static const osThreadAttr_t otaThreadAttr = {
+    .name = "ThreadOta",
+    .cb_mem = &otaThreadControlBlock,
+    .cb_size = sizeof(otaThreadControlBlock),
+    .stack_mem = otaThreadStack,
+    .stack_size = sizeof(otaThreadStack),
+    .priority = THREAD_PRIORITY_PERSISTENCE,
+};
+
+/* -------------------- Static Functions --------------------- */
+static void OtaTask(void *arg);
+static void UDP_Callback(const uint8_t *data, uint32_t size);
+static bool HandleMessage(const OTA_Slot_t *slot, uint32_t *messageID, bool *reboot);
+static void SendStatus(uint32_t messageID, bool success);
+
+/**
+ * @brief Initialize the firmware update service
+ * This function restores an interrupted transfer, starts the update thread
+ * and registers the UDP listener of the OTA port.
+ * @return true if initialization was successful, false otherwise
+ */
+bool ROS_ServiceOTA_Init(void)
+{
+    if (!UpdateFile_Init(&updateFile, EXT_FLASH_OTA_FILE_ADDRESS, EXT_FLASH_OTA_FILE_SIZE)) return false;
+    freeSlotQueueId = osMessageQueueNew(OTA_SLOT_NUMBER, sizeof(uint32_t), NULL);
+    workSlotQueueId = osMessageQueueNew(OTA_SLOT_NUMBER, sizeof(uint32_t), NULL);
+    if (freeSlotQueueId == NULL || workSlotQueueId == NULL) return false;
+    for (uint32_t i = 0; i < OTA_SLOT_NUMBER; i++)
+        osMessageQueuePut(freeSlotQueueId, &i, 0, 0);
+    otaThreadID = osThreadNew(OtaTask, NULL, &otaThreadAttr);
+    if (otaThreadID == NULL) return false;
+    otaUdpSocket = UDP_RegisterListener(DEFAULT_OTA_UDP_PORT, UDP_Callback);
+    return otaUdpSocket >= 0;
+}
+
+/**
+ * @brief OTA Task
+ * This function programs the received messages into the update file and
+ * answers each of them with the transfer status.
+ * @param arg pointer to argument (not used)
+ */
+void OtaTask(void *arg)
+{
+    (void)arg;
+    uint32_t index;
+    while (true)
+    {
+        if (osMessageQueueGet(workSlotQueueId, &index, NULL, osWaitForever) != osOK) continue;
+        uint32_t messageID = 0;
+        bool reboot = false;
+        bool success = HandleMessage(&slots[index], &messageID, &reboot);
+        osMessageQueuePut(freeSlotQueueId, &index, 0, 0);
+        SendStatus(messageID, success);
+        if (success && reboot)
+        {
+            osDelay(OTA_REBOOT_DELAY);
+            DataStore_Flush();  // Parameter changes still in their debounce window
+            NVIC_SystemReset();
+        }
+    }
+}
+
+/**
+ * @brief Handle one OTA message
+ * @param slot pointer to the slot holding the message
+ * @param messageID returns the ID of the message
+ * @param reboot returns true if a reboot into the bootloader is requested
+ * @return true if the message was handled successfully, false otherwise
+ */
+bool HandleMessage(const OTA_Slot_t *slot, uint32_t *messageID, bool *reboot)
+{
+    switch (slot->messageType)
+    {
+    case ROS_CMD_OTA_BEGIN:
+    {
+        if (slot->size != sizeof(OtaBeginMessage_t)) return false;
+        const OtaBeginMessage_t *msg = (const OtaBeginMessage_t *)slot->data;
+        *messageID = msg->messageID;
+        return updateFile.Begin(&updateFile, msg->imageSize, msg->imageCRC, msg->version);
+    }
+    case ROS_CMD_OTA_DATA:
+    {
+        if (slot->size < offsetof(OtaDataMessage_t, data)) return false;
+        const OtaDataMessage_t *msg = (const OtaDataMessage_t *)slot->data;
+        *messageID = msg->messageID;
+        if (msg->length > OTA_PAGE_SIZE || slot->size != offsetof(OtaDataMessage_t, data) + msg->length) return false;
+        return updateFile.WritePage(&updateFile, msg->page, msg->data, msg->length);
+    }
+    case ROS_CMD_OTA_END:
+    {
+        if (slot->size != sizeof(OtaEndMessage_t)) return false;
+        const OtaEndMessage_t *msg = (const OtaEndMessage_t *)slot->data;
+        *messageID = msg->messageID;
+        *reboot = msg->reboot != 0;
+        return updateFile.Finish(&updateFile);
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Send the transfer status back to the upper machine
+ * @param messageID ID of the answered message
+ * @param success result of the answered message
+ */
+void SendStatus(uint32_t messageID, bool success)
+{
+    OtaStatusMessage_t status;
+    status.messageType = ROS_FEEDBACK_OTA_STATUS;
+    status.messageID = messageID;
+    status.success = success;
+    status.nextPage = updateFile.committedPages;
+    status.pendingMask = updateFile.pendingMask;
+    status.windowPages = UPDATE_FILE_WINDOW_PAGES;
+    status.runningCRC = updateFile.runningCRC;
+    UDP_SendData(otaUdpSocket, (const uint8_t *)&status, sizeof(status));
+}
+
+/**
+ * @brief Callback function for UDP messages on the OTA port
+ * This function runs in the network thread, it only copies the datagram into
+ * a free slot. The datagram is dropped if all slots are busy, the upper
+ * machine resends it.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void UDP_Callback(const uint8_t *data, uint32_t size)
+{
+    if (size < sizeof(uint32_t) || size > OTA_MAX_MESSAGE_SIZE) return;
+    uint32_t index;
+    if (osMessageQueueGet(freeSlotQueueId, &index, NULL, 0) != osOK) return;
+    slots[index].size = size;
+    memcpy(slots[index].data, data, size);
+    osMessageQueuePut(workSlotQueueId, &index, 0, 0);
+}
@@ -0,0 +1,18 @@
+/** 
+ * @file ros_service_ota.h
+ * @brief ROS interface handler for firmware updates.
+ * @details This file contains the handler which receives a firmware image on
+ *          DEFAULT_OTA_UDP_PORT and stores it in the OTA region of the
+ *          external flash for the bootloader.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the firmware update service
+ * This function restores an interrupted transfer, starts the update thread
+ * and registers the UDP listener of the OTA port.
+ * @return true if initialization was successful, false otherwise
+ */
+bool ROS_ServiceOTA_Init(void);
@@ -0,0 +1,181 @@
+/**
+ * @file ros_service_tuning.c
+ * @brief ROS interface service handler for the motor tuning requests.
+ * @details
+ *  - Registers the incoming callback for ROS_CMD_MOTOR_TUNE. The callback
+ *    keeps the request and wakes the tuning thread; a request received while
+ *    another one runs is answered with success 0.
+ *  - The tuning thread starts the excitation, waits for its end and fits the
+ *    model of every selected motor. The fit takes about half a second per
+ *    motor (836 grid points over 604 samples, sums in double precision done
+ *    in software), it runs at the persistence priority so the control loop
+ *    and the ROS feedback are not delayed; only the answer waits for it.
+ *  - The excitation runs in the TIM7 tick, which a parked chassis stops: the
+ *    thread wakes the chassis and waits for the tick first, and wakes it
+ *    again once the excitation runs in case it parked in between (it cannot
+ *    park any more after that).
+ *  - With save set, the gains of the valid results are applied to the motor
+ *    PID at once and stored in the data store with the model.
+ *  - Answers with a MotorTuneResultMessage_t; success is 1 if every selected
+ *    motor gave a valid result.
+ * @author young <com.wang@hotmail.com>
+ * @date 2026-10-17
+ * @ingroup ros_interface
+ */
+
+#include <string.h>
+
+#include "main.h"
+#include "cmsis_os2.h"
+#include "rtx_os.h"
+#include "ros_service_tuning.h"
+#include "ros_interface.h"
+#include "ros_messages.h"
+#include "dc_motor.h"
+#include "dc_motor_tuning.h"
+#include "motion_control.h"
+#include "data_store.h"
+#include "system_config.h"
+
+#if MAX_TUNING_MOTORS != TOTAL_MOTOR_NUMBER
+#error "MAX_TUNING_MOTORS must match the number of motors"
+#endif
+
+/* -------------------- Definitions -------------------------- */
+#define TUNING_REQUEST_FLAG     0x01U
+#define TUNING_POLL_PERIOD      10      // ms between two checks of the excitation
+#define TUNING_WAKE_TIMEOUT     200     // ms for the TIM7 tick to restart after a park
+
+/* -------------------- Static Variables --------------------- */
+static MotorTuneMessage_t request;
+static volatile bool isBusy = false;
+static osThreadId_t tuningThreadID;
+
+static uint64_t tuningThreadStack[1024 / sizeof(uint64_t)];
+static osRtxThread_t tuningThreadControlBlock;
+static const osThreadAttr_t tuningThreadAttr = {
+    .name = "ThreadTuning",
+    .cb_mem = &tuningThreadControlBlock,
+    .cb_size = sizeof(tuningThreadControlBlock),
+    .stack_mem = tuningThreadStack,
+    .stack_size = sizeof(tuningThreadStack),
+    .priority = THREAD_PRIORITY_PERSISTENCE,
+};
+
+/* -------------------- Static Functions --------------------- */
+static void TuningTask(void *arg);
+static void MotorTuneCallback(const uint8_t *data, uint32_t size);
+static bool RunTuning(const MotorTuneMessage_t *msg, MotorTuneResultMessage_t *response);
+
+/**
+ * @brief Initialize the motor tuning service
+ * This function starts the tuning thread and registers the callback for the
+ * tuning requests.
+ * @return true if initialization was successful, false otherwise
+ */
+bool ROS_ServiceTuning_Init(void)
+{
+    tuningThreadID = osThreadNew(TuningTask, NULL, &tuningThreadAttr);
+    if (tuningThreadID == NULL) return false;
+    return ROS_Interface_RegisterIncomingCallback(ROS_CMD_MOTOR_TUNE, MotorTuneCallback);
+}
+
+/**
+ * @brief Callback for MotorTune messages
+ * This function hands the request to the tuning thread.
+ * @param data pointer to the received data
+ * @param size size of the received data
+ */
+void MotorTuneCallback(const uint8_t *data, uint32_t size)
+{
+    if (data == NULL || size != sizeof(MotorTuneMessage_t)) return;
+
+    MotorTuneMessage_t msg;
+    memcpy(&msg, data, sizeof(MotorTuneMessage_t));
+    if (msg.messageType != ROS_CMD_MOTOR_TUNE) return;
+
+    if (isBusy)
+    {
+        MotorTuneResultMessage_t response;
+        memset(&response, 0, sizeof(MotorTuneResultMessage_t));
+        response.messageType = ROS_FEEDBACK_MOTOR_TUNE;
+        response.messageID = msg.messageID;
+        response.success = false;
+        ROS_Interface_SendBackMessage((const uint8_t *)&response, sizeof(MotorTuneResultMessage_t));
+        return;
+    }
+    request = msg;
+    isBusy = true;
+    osThreadFlagsSet(tuningThreadID, TUNING_REQUEST_FLAG);
+}
+
+/**
+ * @brief Tuning Task
+ * This function runs each request and sends its result back.
+ * @param arg pointer to argument (not used)
+ */
+void TuningTask(void *arg)
+{
+    (void)arg;
+    static MotorTuneResultMessage_t response;
+    while (true)
+    {
+        osThreadFlagsWait(TUNING_REQUEST_FLAG, osFlagsWaitAny, osWaitForever);
+        memset(&response, 0, sizeof(MotorTuneResultMessage_t));
+        response.messageType = ROS_FEEDBACK_MOTOR_TUNE;
+        response.messageID = request.messageID;
+        response.success = RunTuning(&request, &response);
+        isBusy = false;
+        ROS_Interface_SendBackMessage((const uint8_t *)&response, sizeof(MotorTuneResultMessage_t));
+    }
+}
+
+/**
+ * @brief Identify the selected motors and apply their gains if requested
+ * @param msg pointer to the request
+ * @param response pointer to the response to fill
+ * @return true if every selected motor gave a valid result, false otherwise
+ */
+bool RunTuning(const MotorTuneMessage_t *msg, MotorTuneResultMessage_t *response)
+{
+    // The excitation is sampled and ended by the TIM7 tick, stopped while parked
+    MotionControl_Wake();
+    for (uint32_t waited = 0; MotionControl_IsParked(); waited += TUNING_POLL_PERIOD)
+    {
+        if (waited >= TUNING_WAKE_TIMEOUT) return false;
+        osDelay(TUNING_POLL_PERIOD);
+    }
+    if (!DCMotorTuning_Start(msg->motorMask, msg->bias, msg->amplitude)) return false;
+    // A park between the wait and the start is undone, DCMotor_Park refuses from here
+    MotionControl_Wake();
+    while (DCMotorTuning_IsRunning()) osDelay(TUNING_POLL_PERIOD);
+
+    bool success = true;
+    bool isModified = false;
+    response->motorCount = TOTAL_MOTOR_NUMBER;
+    for (uint32_t i = 0; i < TOTAL_MOTOR_NUMBER; i++)
+    {
+        if (!(msg->motorMask & (1U << i))) continue;
+        DCMotorTuning_Result_t result;
+        if (!DCMotorTuning_GetResult(i, &result)) success = false;
+        MotorTuneResult_t *motor = &response->motors[i];
+        motor->valid = result.isValid;
+        motor->gain = result.model.gain;
+        motor->timeConstant = result.model.timeConstant;
+        motor->deadTime = result.model.deadTime;
+        motor->friction = result.model.friction;
+        motor->fitQuality = result.fitQuality;
+        motor->kP = result.gains.kP;
+        motor->kI = result.gains.kI;
+        motor->kD = result.gains.kD;
+        motor->ffKs = result.gains.ffKs;
+        motor->ffKv = result.gains.ffKv;
+        motor->ffKa = result.gains.ffKa;
+        if (!result.isValid || !msg->save) continue;
+        DCMotor_SetGains(i, &result.gains);
+        isModified |= DataStore_SetMotorGains(i, &result.gains);
+        isModified |= DataStore_SetMotorModel(i, &result.model);
+    }
+    if (isModified) DataStore_SaveDataIfModified();
+    return success;
+}
@@ -0,0 +1,17 @@
+/** 
+ * @file ros_service_tuning.h
+ * @brief ROS interface handler for the motor tuning requests.
+ * @details This file contains the handler which identifies the wheel motors
+ *          on request and applies the gains computed from their model.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the motor tuning service
+ * This function starts the tuning thread and registers the callback for the
+ * tuning requests.
+ * @return true if initialization was successful, false otherwise
+ */
+bool ROS_ServiceTuning_Init(void);
@@ -5,21 +5,24 @@
  *
  * @details Registers a callback for CMD_VELOCITY messages, validates payload size and
  * message type, then updates the latest commanded linear velocity (velocity) and
- * angular velocity (omega). A helper function exposes the most recent values to
- * other modules.
+ * angular velocity (omega) and hands them to the motion control, which ramps to
+ * them through the motion profiler. A helper function exposes the most recent
+ * values to other modules.
  *
  * @note Callback is intended to run in the ROS interface incoming task context and
  * should remain fast and non-blocking.
  *
- * @dependencies ros_interface.h, ros_messages.h
+ * @dependencies ros_interface.h, ros_messages.h, motion_control.h
  * @date 2025-09-02
  * @author Young.W <com.wang@hotmail.com>
  */
 
 #include <stdlib.h>
+#include <math.h>
 #include "ros_subscriber_cmd_vel.h"
 #include "ros_interface.h"
 #include "ros_messages.h"
+#include "motion_control.h"
 
 /* ------------------------- Static Variables --------------------------- */
 static float velocity, omega;
@@ -52,10 +55,13 @@ void CmdVelCallback(const uint8_t *data, uint32_t size)
     const VelocityMessage_t *msg = (const VelocityMessage_t *)data;
     if (msg->messageType != ROS_CMD_VELOCITY)
         return;
+    if (!isfinite(msg->velocity) || !isfinite(msg->omega))
+        return;
 
     // Process the velocity command
     velocity = msg->velocity;
     omega = msg->omega;
+    MotionControl_Move(velocity, omega);
 }
 
 /**
@@ -0,0 +1,107 @@
+/**
+ * @file activation.c
+ * @brief Periodic thread activation from the TIM7 hardware tick.
+ *
+ * @details
+ *  - TIM7 interrupts every ms; the tick callback counts ticks and sets the
+ *    thread flags of every task whose phase is reached. osThreadFlagsSet is
+ *    allowed in interrupts, RTX completes it in PendSV.
+ *  - The work of a tick is bounded by ACTIVATION_MAX_TASKS comparisons; the
+ *    threads run according to their priority once the interrupt returns.
+ *  - A paused task is skipped, which lets a thread stop polling while
+ *    nothing needs it and lets the core sleep longer.
+ *  - The motor PID still runs in the same interrupt every 20 ms at tick 0,
+ *    phases give the other tasks their own ticks, see system_config.h.
+ *
+ * @dependencies activation.h, timer.h, cpu_load.h
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "activation.h"
+
+#include "main.h"
+#include "timer.h"
+#include "cpu_load.h"
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static Activation_Task_t tasks[ACTIVATION_MAX_TASKS];
+static volatile bool isActive[ACTIVATION_MAX_TASKS];
+static volatile uint32_t taskCount = 0;
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static void TickCallback(uint32_t tick);
+
+/**
+ * @brief Initialize the activation service
+ * This function starts the TIM7 tick.
+ * @return true if successful, false otherwise
+ */
+bool Activation_Init(void)
+{
+    if (!Timer_RegisterTickCallback(TickCallback)) return false;
+    Timer_StartTick();
+    return true;
+}
+
+/**
+ * @brief Register a periodic task
+ * The task is activated at every tick where the tick count modulo the period
+ * equals the phase. It is active once registered.
+ * @param task pointer to the task description, copied
+ * @return true if the task is registered, false if invalid or the table is full
+ */
+bool Activation_Register(const Activation_Task_t *task)
+{
+    if (task == NULL || task->thread == NULL || task->flags == 0) return false;
+    if (task->period == 0 || task->phase >= task->period) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool result = taskCount < ACTIVATION_MAX_TASKS;
+    if (result)
+    {
+        tasks[taskCount] = *task;
+        isActive[taskCount] = true;
+        taskCount++;
+    }
+    __set_PRIMASK(primask);
+    return result;
+}
+
+/**
+ * @brief Pause or resume a registered task
+ * A paused task keeps its place and phase but its flags are not set.
+ * @param thread thread of the task
+ * @param flags thread flags of the task
+ * @param active true to resume, false to pause
+ * @return true if the task was found, false otherwise
+ */
+bool Activation_SetActive(osThreadId_t thread, uint32_t flags, bool active)
+{
+    for (uint32_t i = 0; i < taskCount; i++)
+    {
+        if (tasks[i].thread != thread || tasks[i].flags != flags) continue;
+        isActive[i] = active;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief TIM7 tick callback
+ * This function runs in the TIM7 interrupt every ms and activates the tasks
+ * whose phase is reached.
+ * @param tick number of ms since the tick started, the PID runs when a multiple of 20
+ */
+void TickCallback(uint32_t tick)
+{
+    for (uint32_t i = 0; i < taskCount; i++)
+    {
+        const Activation_Task_t *task = &tasks[i];
+        if (!isActive[i]) continue;
+        if (tick % task->period != task->phase) continue;
+        if (task->isLatencyProbe) CpuLoad_WakeRelease();
+        osThreadFlagsSet(task->thread, task->flags);
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * @file activation.h
+ * @brief Periodic thread activation from the TIM7 hardware tick.
+ *
+ * @details Declares the service which wakes periodic threads from the 1 ms
+ * TIM7 update interrupt instead of RTX software timers. Each registered task
+ * gets its thread flags set once per period, at a fixed phase inside the
+ * period, so tasks sharing a period can be spread over different ticks.
+ * Activations never wait in the RTX timer thread or its callback queue.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+
+#define ACTIVATION_MAX_TASKS        8       // Maximum number of periodic tasks
+#define ACTIVATION_TICK_FREQUENCY   1000    // Frequency of the TIM7 tick in Hz, one tick per ms
+
+/**
+ * @brief Periodic task to activate
+ */
+typedef struct {
+    osThreadId_t thread;    // Thread to wake
+    uint32_t flags;         // Thread flags set at each activation
+    uint32_t period;        // Period in ms
+    uint32_t phase;         // Offset of the activation inside the period in ms, less than period
+    bool isLatencyProbe;    // Mark the activation for the CPU load wake-up latency probe
+} Activation_Task_t;
+
+/**
+ * @brief Initialize the activation service
+ * This function starts the TIM7 tick.
+ * @return true if successful, false otherwise
+ */
+bool Activation_Init(void);
+
+/**
+ * @brief Register a periodic task
+ * The task is activated at every tick where the tick count modulo the period
+ * equals the phase. It is active once registered.
+ * @param task pointer to the task description, copied
+ * @return true if the task is registered, false if invalid or the table is full
+ */
+bool Activation_Register(const Activation_Task_t *task);
+
+/**
+ * @brief Pause or resume a registered task
+ * A paused task keeps its place and phase but its flags are not set.
+ * @param thread thread of the task
+ * @param flags thread flags of the task
+ * @param isActive true to resume, false to pause
+ * @return true if the task was found, false otherwise
+ */
+bool Activation_SetActive(osThreadId_t thread, uint32_t flags, bool isActive);
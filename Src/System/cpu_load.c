@@ -0,0 +1,299 @@
+/**
+ * @file cpu_load.c
+ * @brief Run-time accounting of the CPU: threads, interrupts and idle time.
+ *
+ * @details
+ *  - The DWT cycle counter is read at every thread switch. RTX reports the
+ *    switches through EvrRtxThreadSwitched, a weak event function of the
+ *    RTX source variant (OS_EVR_THREAD) which is overridden here; it runs in
+ *    the SVC/PendSV handler when the next thread is selected.
+ *  - The elapsed cycles minus the cycles spent in instrumented interrupts
+ *    meanwhile are charged to the thread which was running.
+ *  - Instrumented handlers call CpuLoad_IsrEnter/CpuLoad_IsrExit. Nested
+ *    interrupts are counted in both handlers but once in the total.
+ *  - The control thread is timed from its release (CpuLoad_WakeRelease) to
+ *    the moment it runs (CpuLoad_WakeRun): delay and interval between
+ *    wake-ups show the scheduler latency and jitter of the control loop.
+ *  - The tickless idle keeps the cycle counter running in Sleep mode
+ *    (DBG_SLEEP). Cycles it still finds missing after a sleep are given
+ *    back with CpuLoad_AddIdleCycles, charged to the idle thread, and
+ *    lengthen the window.
+ *  - An RTX timer closes the window every CPU_LOAD_WINDOW_MS and keeps its
+ *    result for the report. The counter wraps after 25 s at 168 MHz, well
+ *    above the window.
+ *
+ * @dependencies cpu_load.h, cmsis_os2, rtx_os (osRtxInfo), rtx_evr
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "cpu_load.h"
+
+#include "main.h"
+#include "cmsis_os2.h"
+#include "rtx_os.h"
+#include "rtx_evr.h"
+
+#include <string.h>
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static volatile bool isStarted = false;
+static osTimerId_t windowTimerId = NULL;
+
+static osThreadId_t runningThread = NULL;   // Thread charged at the next switch
+static uint32_t lastSwitchCycles = 0;       // Cycle counter at the last switch
+static uint32_t lastSwitchIsrCycles = 0;    // isrCycles at the last switch
+static volatile uint32_t isrCycles = 0;     // Cycles of the outermost instrumented interrupts, wraps
+static volatile uint32_t isrNesting = 0;    // Depth of the instrumented interrupts running
+
+static uint32_t windowStartCycles = 0;
+static uint32_t windowStartIsrCycles = 0;
+static uint32_t windowSleepCycles = 0;      // Cycles slept during the window, missed by the counter
+static CpuLoad_IsrInfo_t isrInfo[CPU_LOAD_ISR_COUNT];
+static uint32_t threadCount = 0;
+static CpuLoad_ThreadInfo_t threadInfo[CPU_LOAD_MAX_THREADS];
+
+static volatile bool isWakeReleased = false;
+static uint32_t wakeReleaseCycles = 0;      // Cycle counter at the last release
+static uint32_t lastWakeCycles = 0;         // Cycle counter at the last wake-up, 0 before the first
+static uint32_t wakeCount = 0;
+static uint32_t wakeLatencyMax = 0;
+static uint32_t wakeLatencyTotal = 0;
+static uint32_t wakePeriodMin = UINT32_MAX;
+static uint32_t wakePeriodMax = 0;
+
+static bool isReportValid = false;
+static CpuLoad_Report_t report;             // Last complete window
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static void ChargeRunningThread(uint32_t now);
+static CpuLoad_ThreadInfo_t* FindThread(osThreadId_t thread);
+static void WindowTimerCallback(void *arg);
+
+/**
+ * @brief Initialize the CPU load accounting
+ * This function starts the DWT cycle counter and the window timer. Must be
+ * called from a thread once the kernel runs.
+ * @return true if successful, false otherwise
+ */
+bool CpuLoad_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    windowTimerId = osTimerNew(WindowTimerCallback, osTimerPeriodic, NULL, NULL);
+    if (windowTimerId == NULL) return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    runningThread = osThreadGetId();
+    lastSwitchCycles = DWT->CYCCNT;
+    lastSwitchIsrCycles = isrCycles;
+    windowStartCycles = lastSwitchCycles;
+    windowStartIsrCycles = lastSwitchIsrCycles;
+    isStarted = true;
+    __set_PRIMASK(primask);
+
+    return osTimerStart(windowTimerId, CPU_LOAD_WINDOW_MS * osKernelGetTickFreq() / 1000) == osOK;
+}
+
+/**
+ * @brief Mark the entry of an instrumented interrupt handler
+ * @return cycle counter at the entry, to pass to CpuLoad_IsrExit
+ */
+uint32_t CpuLoad_IsrEnter(void)
+{
+    isrNesting++;   // Nested handlers restore the value before returning
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Mark the exit of an instrumented interrupt handler
+ * @param isr the handler which exits
+ * @param start value returned by CpuLoad_IsrEnter in the same handler
+ */
+void CpuLoad_IsrExit(CpuLoad_Isr_t isr, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+    if (--isrNesting == 0) isrCycles += cycles;
+    if (!isStarted || isr >= CPU_LOAD_ISR_COUNT) return;
+    CpuLoad_IsrInfo_t *info = &isrInfo[isr];
+    info->cycles += cycles;
+    info->count++;
+    if (cycles > info->maxCycles) info->maxCycles = cycles;
+}
+
+/**
+ * @brief Account cycles the counter missed while the core slept
+ * Called by the idle thread with interrupts disabled, after a sleep.
+ * @param cycles core cycles of the sleep not seen by the cycle counter
+ */
+void CpuLoad_AddIdleCycles(uint32_t cycles)
+{
+    if (!isStarted) return;
+    FindThread(runningThread)->cycles += cycles;
+    windowSleepCycles += cycles;
+}
+
+/**
+ * @brief Mark the release of the control thread
+ * Called where the control thread is signalled to run its period.
+ */
+void CpuLoad_WakeRelease(void)
+{
+    wakeReleaseCycles = DWT->CYCCNT;
+    isWakeReleased = true;
+}
+
+/**
+ * @brief Mark the start of the control thread after a release
+ * Called by the control thread when it wakes up; ignored without a release.
+ */
+void CpuLoad_WakeRun(void)
+{
+    if (!isStarted || !isWakeReleased) return;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    isWakeReleased = false;
+    uint32_t latency = now - wakeReleaseCycles;
+    wakeCount++;
+    wakeLatencyTotal += latency;
+    if (latency > wakeLatencyMax) wakeLatencyMax = latency;
+    if (lastWakeCycles != 0)
+    {
+        uint32_t period = now - lastWakeCycles;
+        if (period < wakePeriodMin) wakePeriodMin = period;
+        if (period > wakePeriodMax) wakePeriodMax = period;
+    }
+    lastWakeCycles = now;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Mark a pause of the control thread releases
+ * The interval across the pause is not taken as a wake-up period.
+ */
+void CpuLoad_WakeSuspend(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    isWakeReleased = false;
+    lastWakeCycles = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Get the result of the last complete window
+ * @param result pointer to the report to fill
+ * @return true if a window is complete, false otherwise
+ */
+bool CpuLoad_GetReport(CpuLoad_Report_t *result)
+{
+    if (result == NULL) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = isReportValid;
+    if (valid) memcpy(result, &report, sizeof(CpuLoad_Report_t));
+    __set_PRIMASK(primask);
+    return valid;
+}
+
+/**
+ * @brief RTX thread switch event
+ * Overrides the weak event function of RTX. Called in handler mode when
+ * the next thread to run is selected.
+ * @param thread_id the thread which runs next
+ */
+void EvrRtxThreadSwitched(osThreadId_t thread_id)
+{
+    if (!isStarted) return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ChargeRunningThread(DWT->CYCCNT);
+    runningThread = thread_id;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Charge the cycles since the last switch to the running thread
+ * Interrupts must be disabled.
+ * @param now current value of the cycle counter
+ */
+void ChargeRunningThread(uint32_t now)
+{
+    uint32_t isr = isrCycles;
+    uint32_t elapsed = (now - lastSwitchCycles) - (isr - lastSwitchIsrCycles);
+    CpuLoad_ThreadInfo_t *info = FindThread(runningThread);
+    info->cycles += elapsed;
+    lastSwitchCycles = now;
+    lastSwitchIsrCycles = isr;
+}
+
+/**
+ * @brief Find the entry of a thread, adding it when first seen
+ * @param thread the thread
+ * @return pointer to the entry, the overflow entry if the table is full
+ */
+CpuLoad_ThreadInfo_t* FindThread(osThreadId_t thread)
+{
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        if (threadInfo[i].thread == thread) return &threadInfo[i];
+    }
+    if (threadCount < CPU_LOAD_MAX_THREADS - 1)
+    {
+        threadInfo[threadCount].thread = thread;
+        threadInfo[threadCount].cycles = 0;
+        return &threadInfo[threadCount++];
+    }
+    threadCount = CPU_LOAD_MAX_THREADS;
+    threadInfo[CPU_LOAD_MAX_THREADS - 1].thread = NULL;
+    return &threadInfo[CPU_LOAD_MAX_THREADS - 1];
+}
+
+/**
+ * @brief Close the measurement window
+ * This function runs in the RTX timer thread every CPU_LOAD_WINDOW_MS.
+ * @param arg not used
+ */
+void WindowTimerCallback(void *arg)
+{
+    (void)arg;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = DWT->CYCCNT;
+    ChargeRunningThread(now);
+
+    report.windowCycles = now - windowStartCycles + windowSleepCycles;
+    windowSleepCycles = 0;
+    report.isrCycles = isrCycles - windowStartIsrCycles;
+    report.idleCycles = 0;
+    memcpy(report.isr, isrInfo, sizeof(isrInfo));
+    memset(isrInfo, 0, sizeof(isrInfo));
+    report.threadCount = threadCount;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        report.threads[i] = threadInfo[i];
+        if (threadInfo[i].thread == (osThreadId_t)osRtxInfo.thread.idle) report.idleCycles = threadInfo[i].cycles;
+        threadInfo[i].cycles = 0;
+    }
+    report.load = report.windowCycles > 0 ? 1000 - (uint32_t)((uint64_t)report.idleCycles * 1000 / report.windowCycles) : 0;
+    report.wakeCount = wakeCount;
+    report.wakeLatencyMax = wakeLatencyMax;
+    report.wakeLatencyMean = wakeCount > 0 ? wakeLatencyTotal / wakeCount : 0;
+    report.wakePeriodMin = wakeCount > 1 ? wakePeriodMin : 0;
+    report.wakePeriodMax = wakePeriodMax;
+    wakeCount = 0;
+    wakeLatencyMax = 0;
+    wakeLatencyTotal = 0;
+    wakePeriodMin = UINT32_MAX;
+    wakePeriodMax = 0;
+    isReportValid = true;
+
+    windowStartCycles = now;
+    windowStartIsrCycles = isrCycles;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file cpu_load.h
+ * @brief Run-time accounting of the CPU: threads, interrupts and idle time.
+ *
+ * @details Declares the API which measures where the cycles of the core go.
+ * Time is taken from the DWT cycle counter at every thread switch and around
+ * the instrumented interrupt handlers, and summed over a fixed window. The
+ * CPU load is the part of the window not spent in the RTX idle thread.
+ * The wake-up latency of the control thread is measured over the same window.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CPU_LOAD_MAX_THREADS    24      // Threads accounted separately, more are summed in the last entry
+#define CPU_LOAD_WINDOW_MS      1000    // Length of a measurement window in milliseconds
+
+/**
+ * @brief Instrumented interrupt handlers
+ */
+typedef enum {
+    CPU_LOAD_ISR_TIM7 = 0,      // Control period timer
+    CPU_LOAD_ISR_TIM3,          // Encoder capture
+    CPU_LOAD_ISR_TIM4,          // Encoder capture
+    CPU_LOAD_ISR_USART3,        // RC receiver
+    CPU_LOAD_ISR_ETH,           // Ethernet MAC
+    CPU_LOAD_ISR_COUNT
+} CpuLoad_Isr_t;
+
+/**
+ * @brief Time spent in one interrupt handler during the window
+ */
+typedef struct {
+    uint32_t cycles;        // Cycles spent in the handler, nested interrupts included
+    uint32_t count;         // Number of times the handler ran
+    uint32_t maxCycles;     // Longest single run of the handler
+} CpuLoad_IsrInfo_t;
+
+/**
+ * @brief Time spent in one thread during the window
+ */
+typedef struct {
+    void *thread;           // osThreadId_t of the thread, NULL for the overflow entry
+    uint32_t cycles;        // Cycles spent in the thread, interrupts excluded
+} CpuLoad_ThreadInfo_t;
+
+/**
+ * @brief Result of the last complete window
+ */
+typedef struct {
+    uint32_t windowCycles;  // Length of the window in cycles
+    uint32_t idleCycles;    // Cycles spent in the RTX idle thread
+    uint32_t isrCycles;     // Cycles spent in the instrumented interrupts, nesting counted once
+    uint32_t load;          // CPU load in per mille, 1000 - idle share of the window
+    uint32_t wakeCount;     // Wake-ups of the control thread measured
+    uint32_t wakeLatencyMax;    // Longest delay from release to run, in cycles
+    uint32_t wakeLatencyMean;   // Mean delay from release to run, in cycles
+    uint32_t wakePeriodMin;     // Shortest interval between two wake-ups, in cycles
+    uint32_t wakePeriodMax;     // Longest interval between two wake-ups, in cycles
+    CpuLoad_IsrInfo_t isr[CPU_LOAD_ISR_COUNT];
+    uint32_t threadCount;   // Number of entries in threads
+    CpuLoad_ThreadInfo_t threads[CPU_LOAD_MAX_THREADS];
+} CpuLoad_Report_t;
+
+/**
+ * @brief Initialize the CPU load accounting
+ * This function starts the DWT cycle counter and the window timer. Must be
+ * called from a thread once the kernel runs.
+ * @return true if successful, false otherwise
+ */
+bool CpuLoad_Init(void);
+
+/**
+ * @brief Mark the entry of an instrumented interrupt handler
+ * @return cycle counter at the entry, to pass to CpuLoad_IsrExit
+ */
+uint32_t CpuLoad_IsrEnter(void);
+
+/**
+ * @brief Mark the exit of an instrumented interrupt handler
+ * @param isr the handler which exits
+ * @param start value returned by CpuLoad_IsrEnter in the same handler
+ */
+void CpuLoad_IsrExit(CpuLoad_Isr_t isr, uint32_t start);
+
+/**
+ * @brief Account cycles the counter missed while the core slept
+ * Called by the idle thread with interrupts disabled, after a sleep.
+ * @param cycles core cycles of the sleep not seen by the cycle counter
+ */
+void CpuLoad_AddIdleCycles(uint32_t cycles);
+
+/**
+ * @brief Mark the release of the control thread
+ * Called where the control thread is signalled to run its period.
+ */
+void CpuLoad_WakeRelease(void);
+
+/**
+ * @brief Mark the start of the control thread after a release
+ * Called by the control thread when it wakes up; ignored without a release.
+ */
+void CpuLoad_WakeRun(void);
+
+/**
+ * @brief Mark a pause of the control thread releases
+ * The interval across the pause is not taken as a wake-up period.
+ */
+void CpuLoad_WakeSuspend(void);
+
+/**
+ * @brief Get the result of the last complete window
+ * @param result pointer to the report to fill
+ * @return true if a window is complete, false otherwise
+ */
+bool CpuLoad_GetReport(CpuLoad_Report_t *result);
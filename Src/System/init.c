@@ -20,17 +20,26 @@
 
 #include "main.h"
 #include "dc_motor.h"
+#include "dc_motor_tuning.h"
 #include "motion_control.h"
 #include "data_store.h"
 #include "ros_interface.h"
 #include "rc_receiver.h"
 #include "battery.h"
 #include "mem_pool.h"
+#include "flight_recorder.h"
+#include "cpu_load.h"
+#include "activation.h"
+#include "low_power.h"
 
 #include "rl_net.h"
 
 static void ThreadSystemInit(void* arg);
 
+static const osThreadAttr_t threadAttrSystemInit = {
+    .name = "ThreadSystemInit",
+};
+
 /**
  * @brief System initialization function
  */
@@ -38,7 +47,7 @@ void System_Init(void)
 {
     osKernelInitialize(); // Initialize the OS kernel
 	osThreadId_t threadID;
-	threadID = osThreadNew(ThreadSystemInit, NULL, NULL);
+	threadID = osThreadNew(ThreadSystemInit, NULL, &threadAttrSystemInit);
 	assert_param(threadID);
     osKernelStart();      // Start the OS kernel
 }
@@ -46,10 +55,19 @@ void System_Init(void)
 void ThreadSystemInit(void* arg)
 {
     (void)arg; // Unused parameter
+    bool result = CpuLoad_Init(); // Start the CPU time accounting first
+    assert_param(result);
+    result = Activation_Init();   // Start the TIM7 tick which activates the periodic threads
+    assert_param(result);
+    result = LowPower_Init();     // Let the idle thread sleep until the next kernel timeout
+    assert_param(result);
     MemPool_Init();             // Initialize memory pool for dynamic allocations
+    FlightRecorder_Init();      // Initialize the flight recorder before anything logs
     DataStore_Init();           // Initialize the data store with default configuration
     RC_Receiver_Init();         // Initialize remote controller interface
     DCMotor_Init();             // Initialize motor control interface
+    result = DCMotorTuning_Init();  // Register the motor identification on the TIM7 tick
+    assert_param(result);
     MotionControl_Init();       // Initialize motion control subsystem
 	osDelay(500);
 	netStatus status = netInitialize();
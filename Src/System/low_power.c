@@ -0,0 +1,182 @@
+/**
+ * @file low_power.c
+ * @brief Tickless idle: the core sleeps until the next kernel timeout.
+ *
+ * @details
+ *  - osRtxIdleThread (weak in RTX_Config.c) is replaced. It suspends the
+ *    kernel with osKernelSuspend, which returns the ticks until the next
+ *    timeout, and resumes it with the ticks really slept.
+ *  - TIM5 (32 bits, 1 MHz) runs freely. Its compare channel 1 is armed at the
+ *    deadline and its interrupt wakes the core; the counter gives the sleep
+ *    length whatever interrupt woke the core. The fraction of a tick left is
+ *    carried to the next sleep so the kernel time does not drift.
+ *  - The core sleeps with WFI and interrupts masked: a pending interrupt ends
+ *    the sleep, the accounting is done, then the interrupt is served.
+ *  - Sleep mode only (no SLEEPDEEP): clocks, Ethernet and timers keep
+ *    running and the wake-up costs a few cycles. The HAL tick (TIM14) is
+ *    paused during the sleep and advanced afterwards.
+ *  - DBGMCU_CR.DBG_SLEEP keeps the core clock running in Sleep mode, so the
+ *    DWT cycle counter keeps counting: the odometry and gyro intervals, the
+ *    wake-up latencies and the CPU load read it across sleeps. It costs the
+ *    gated core clock of the sleep, a few mA. Should the counter still lag
+ *    the sleep measured by TIM5, the difference is given to the CPU load
+ *    accounting as idle time.
+ *  - The 1 ms TIM7 activation tick would end every sleep within a ms. It is
+ *    stopped while the chassis is parked (motion_control.c), then the sleeps
+ *    last until the next kernel timeout.
+ *
+ * @dependencies low_power.h, cmsis_os2, cpu_load.h, HAL TIM
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "low_power.h"
+
+#include "main.h"
+#include "cmsis_os2.h"
+#include "cpu_load.h"
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define WAKE_TIMER_FREQUENCY    1000000U    // TIM5 counts us
+#define MAX_SLEEP_US            0x7FFFFFFFU // Half the counter range, the deadline stays ahead of the counter
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static TIM_HandleTypeDef wakeTimer;
+static volatile bool isStarted = false;
+static uint32_t usPerTick = 1000;           // Length of a kernel tick in us
+static uint32_t carryUs = 0;                // Part of a tick slept and not yet given to the kernel
+static LowPower_Stats_t stats;
+
+/* -------------------------------------- Static functions ------------------------------------- */
+static uint32_t Sleep(uint32_t ticks);
+
+/**
+ * @brief Initialize the tickless idle
+ * This function starts TIM5 as a free running 1 MHz counter used to wake
+ * the core and to measure the sleep. Until then the idle thread only waits
+ * for interrupts with the kernel tick running.
+ * @return true if successful, false otherwise
+ */
+bool LowPower_Init(void)
+{
+    // APB1 timers run at twice PCLK1 when APB1 is divided
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) clock *= 2;
+
+    __HAL_RCC_TIM5_CLK_ENABLE();
+    wakeTimer.Instance = TIM5;
+    wakeTimer.Init.Prescaler = clock / WAKE_TIMER_FREQUENCY - 1;
+    wakeTimer.Init.CounterMode = TIM_COUNTERMODE_UP;
+    wakeTimer.Init.Period = 0xFFFFFFFFU;
+    wakeTimer.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    wakeTimer.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_Base_Init(&wakeTimer) != HAL_OK) return false;
+    if (HAL_TIM_Base_Start(&wakeTimer) != HAL_OK) return false;
+    HAL_NVIC_SetPriority(TIM5_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+
+    // The cycle counter times the control loop, it must not stop in the sleeps
+    DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
+
+    usPerTick = WAKE_TIMER_FREQUENCY / osKernelGetTickFreq();
+    isStarted = true;
+    return true;
+}
+
+/**
+ * @brief Get the sleep statistics
+ * The maximum wake-up latency restarts from zero after each read.
+ * @param result pointer to the statistics to fill
+ * @return true if successful, false otherwise
+ */
+bool LowPower_GetStats(LowPower_Stats_t *result)
+{
+    if (result == NULL) return false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *result = stats;
+    stats.wakeLatencyMax = 0;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief RTX idle thread
+ * Overrides the weak idle thread of RTX_Config.c. Runs when no other thread
+ * is ready.
+ * @param argument not used
+ */
+__NO_RETURN void osRtxIdleThread(void *argument)
+{
+    (void)argument;
+    for (;;)
+    {
+        uint32_t ticks = isStarted ? osKernelSuspend() : 0;
+        if (ticks >= LOW_POWER_MIN_SLEEP_TICKS)
+        {
+            osKernelResume(Sleep(ticks));
+            continue;
+        }
+        if (isStarted) osKernelResume(0);
+        __WFI(); // Woken by the kernel tick at the latest, the cycle counter runs on (DBG_SLEEP)
+    }
+}
+
+/**
+ * @brief Sleep with the kernel suspended
+ * @param ticks kernel ticks until the next timeout, osWaitForever if none
+ * @return kernel ticks slept
+ */
+uint32_t Sleep(uint32_t ticks)
+{
+    uint32_t sleepUs = (ticks >= MAX_SLEEP_US / usPerTick) ? MAX_SLEEP_US : ticks * usPerTick - carryUs;
+
+    __disable_irq();
+    HAL_SuspendTick();
+    uint32_t startCycles = DWT->CYCCNT;
+    uint32_t start = __HAL_TIM_GET_COUNTER(&wakeTimer);
+    uint32_t deadline = start + sleepUs;
+    __HAL_TIM_SET_COMPARE(&wakeTimer, TIM_CHANNEL_1, deadline);
+    __HAL_TIM_CLEAR_FLAG(&wakeTimer, TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_IT(&wakeTimer, TIM_IT_CC1);
+
+    __DSB();
+    __WFI();
+
+    uint32_t now = __HAL_TIM_GET_COUNTER(&wakeTimer);
+    uint32_t sleptCycles = DWT->CYCCNT - startCycles;
+    __HAL_TIM_DISABLE_IT(&wakeTimer, TIM_IT_CC1);
+    __HAL_TIM_CLEAR_FLAG(&wakeTimer, TIM_FLAG_CC1);
+    HAL_NVIC_ClearPendingIRQ(TIM5_IRQn);
+
+    uint32_t elapsedUs = now - start;
+    uint32_t totalUs = elapsedUs + carryUs;
+    uint32_t sleptTicks = totalUs / usPerTick;
+    carryUs = totalUs % usPerTick;
+    uwTick += elapsedUs / 1000U;    // HAL tick in ms, its own fraction is lost
+    HAL_ResumeTick();
+
+    stats.sleepCount++;
+    stats.sleepTime += elapsedUs / 1000U;
+    if (elapsedUs >= sleepUs)
+    {
+        uint32_t latency = elapsedUs - sleepUs;
+        stats.timerWakeCount++;
+        if (latency > stats.wakeLatencyMax) stats.wakeLatencyMax = latency;
+    }
+    uint32_t expectedCycles = (uint32_t)((uint64_t)elapsedUs * (SystemCoreClock / WAKE_TIMER_FREQUENCY));
+    if (expectedCycles > sleptCycles) CpuLoad_AddIdleCycles(expectedCycles - sleptCycles);
+    __enable_irq();
+    return sleptTicks;
+}
+
+/**
+ * @brief TIM5 interrupt handler
+ * The wake-up compare is handled by the idle thread; only clear what is left.
+ */
+void TIM5_IRQHandler(void)
+{
+    __HAL_TIM_DISABLE_IT(&wakeTimer, TIM_IT_CC1);
+    __HAL_TIM_CLEAR_FLAG(&wakeTimer, TIM_FLAG_CC1);
+}
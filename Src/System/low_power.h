@@ -0,0 +1,49 @@
+/**
+ * @file low_power.h
+ * @brief Tickless idle: the core sleeps until the next kernel timeout.
+ *
+ * @details Declares the API of the RTX idle thread replacement. When no
+ * thread is ready, the kernel tick is suspended, TIM5 is armed to wake the
+ * core at the next kernel timeout and the core waits for an interrupt in
+ * Sleep mode. Peripherals keep running, so any interrupt (Ethernet, UART,
+ * TIM7 activations) wakes it as well. The kernel and HAL ticks are advanced
+ * by the time really slept.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOW_POWER_MIN_SLEEP_TICKS   2       // Shorter idle periods keep the kernel tick running
+
+/**
+ * @brief Sleep statistics since boot
+ */
+typedef struct {
+    uint32_t sleepCount;        // Number of tickless sleeps
+    uint32_t sleepTime;         // Time spent in tickless sleeps in ms, wraps
+    uint32_t timerWakeCount;    // Sleeps ended by the wake-up timer
+    uint32_t wakeLatencyMax;    // Longest delay from the wake-up deadline to the idle thread, in us, since the last read
+} LowPower_Stats_t;
+
+/**
+ * @brief Initialize the tickless idle
+ * This function starts TIM5 as a free running 1 MHz counter used to wake
+ * the core and to measure the sleep. Until then the idle thread only waits
+ * for interrupts with the kernel tick running.
+ * @return true if successful, false otherwise
+ */
+bool LowPower_Init(void);
+
+/**
+ * @brief Get the sleep statistics
+ * The maximum wake-up latency restarts from zero after each read.
+ * @param stats pointer to the statistics to fill
+ * @return true if successful, false otherwise
+ */
+bool LowPower_GetStats(LowPower_Stats_t *stats);
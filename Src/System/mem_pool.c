@@ -1,4 +1,5 @@
 #include "mem_pool.h"
+#include "main.h"
 #include "cmsis_os2.h"
 
 /* ----------------------- Definitions ----------------------- */
@@ -10,16 +11,65 @@
 #define MEMPOOL_1024_OBJECTS 4
 #define MEMPOOL_2048_OBJECTS 2
 
-#define MEMPOOL_TYPES 6
+#define MEMPOOL_TYPES MEMPOOL_CLASSES
+#define MEMPOOL_MIN_SHIFT 6     // log2 of the smallest block size, 64 bytes
+#define MEMPOOL_OWNER_MAGAZINE 1    // Owner of the blocks cached in a magazine
+#define MEMPOOL_TOTAL_OBJECTS (MEMPOOL_64_OBJECTS + MEMPOOL_128_OBJECTS + MEMPOOL_256_OBJECTS + \
+                               MEMPOOL_512_OBJECTS + MEMPOOL_1024_OBJECTS + MEMPOOL_2048_OBJECTS)
 
 /* ----------------------- Static Variables ----------------------- */
+// Block memory of each pool, static so the owning pool of a pointer is found by its address
+static uint32_t memPool64[MEMPOOL_64_OBJECTS * 64 / sizeof(uint32_t)];
+static uint32_t memPool128[MEMPOOL_128_OBJECTS * 128 / sizeof(uint32_t)];
+static uint32_t memPool256[MEMPOOL_256_OBJECTS * 256 / sizeof(uint32_t)];
+static uint32_t memPool512[MEMPOOL_512_OBJECTS * 512 / sizeof(uint32_t)];
+static uint32_t memPool1024[MEMPOOL_1024_OBJECTS * 1024 / sizeof(uint32_t)];
+static uint32_t memPool2048[MEMPOOL_2048_OBJECTS * 2048 / sizeof(uint32_t)];
+
 static struct _MEM_POOL
 {
     osMemoryPoolId_t memPoolId;
     uint32_t memPoolObjects;
     uint32_t memSize;
+    uint8_t* memory;        // First block of the pool
+    uint32_t firstBlock;    // Index of the first block in blockOwners
+    uint32_t inUse;
+    uint32_t highWater;
+    uint32_t exhausted;
 } memPool[MEMPOOL_TYPES];
 
+static uint32_t blockOwners[MEMPOOL_TOTAL_OBJECTS];     // Caller of MemPool_Alloc, 0 when free
+static uint32_t blockTicks[MEMPOOL_TOTAL_OBJECTS];      // Kernel tick of the allocation
+static uint32_t failureCount;
+
+/* ----------------------- Static Functions ----------------------- */
+static int32_t FindOwnerPool(const uint8_t* ptr);
+static void* AllocFromPool(uint32_t index, uint32_t owner);
+static bool FreeToPool(uint32_t index, void* ptr);
+static void SetBlockOwner(void* ptr, uint32_t owner);
+
+/**
+ * @brief Index of a block in blockOwners
+ * @param index index of the pool owning the block
+ * @param ptr pointer to the block
+ * @return index of the block
+ */
+static inline uint32_t BlockIndex(uint32_t index, const void* ptr)
+{
+    return memPool[index].firstBlock + (uint32_t)((const uint8_t*)ptr - memPool[index].memory) / memPool[index].memSize;
+}
+
+/**
+ * @brief Size class of a request
+ * @param size requested size in bytes
+ * @return index of the smallest class whose blocks hold size bytes
+ */
+static inline uint32_t SizeClass(uint32_t size)
+{
+    if (size <= (1U << MEMPOOL_MIN_SHIFT)) return 0;
+    return 32 - __CLZ(size - 1) - MEMPOOL_MIN_SHIFT;   // ceil(log2(size)) - MEMPOOL_MIN_SHIFT
+}
+
 /**
  * @brief Initialize the memory pool system.
  * This function sets up the memory pools for different block sizes.
@@ -32,43 +82,338 @@ void MemPool_Init(void)
     memPool[3].memPoolObjects = MEMPOOL_512_OBJECTS;
     memPool[4].memPoolObjects = MEMPOOL_1024_OBJECTS;
     memPool[5].memPoolObjects = MEMPOOL_2048_OBJECTS;
-    uint32_t size = 128;
+    memPool[0].memory = (uint8_t*)memPool64;
+    memPool[1].memory = (uint8_t*)memPool128;
+    memPool[2].memory = (uint8_t*)memPool256;
+    memPool[3].memory = (uint8_t*)memPool512;
+    memPool[4].memory = (uint8_t*)memPool1024;
+    memPool[5].memory = (uint8_t*)memPool2048;
+    uint32_t size = 1U << MEMPOOL_MIN_SHIFT;
+    uint32_t firstBlock = 0;
     for (int i = 0; i < MEMPOOL_TYPES; ++i)
     {
         memPool[i].memSize = size;
+        memPool[i].firstBlock = firstBlock;
+        firstBlock += memPool[i].memPoolObjects;
         size <<= 1;
-        memPool[i].memPoolId = osMemoryPoolNew(memPool[i].memPoolObjects, memPool[i].memSize, NULL);
+        osMemoryPoolAttr_t attr = {0};
+        attr.mp_mem = memPool[i].memory;
+        attr.mp_size = memPool[i].memPoolObjects * memPool[i].memSize;
+        memPool[i].memPoolId = osMemoryPoolNew(memPool[i].memPoolObjects, memPool[i].memSize, &attr);
+        assert_param(memPool[i].memPoolId != NULL);
     }
 }
 
 /**
  * @brief Allocate a memory block from the pool.
+ * The smallest fitting class is computed with CLZ, a larger class is used
+ * when it is exhausted. Can be called from interrupts.
  * @param size The size of the memory block to allocate.
  * @return Pointer to the allocated memory block, or NULL if allocation failed.
  */
 void* MemPool_Alloc(uint32_t size)
 {
-    for (int i = 0; i < MEMPOOL_TYPES; ++i)
+    uint32_t owner = (uint32_t)(uintptr_t)__builtin_return_address(0);
+    for (uint32_t i = SizeClass(size); i < MEMPOOL_TYPES; ++i)
     {
-        if (size <= memPool[i].memSize)
-        {
-            return osMemoryPoolAlloc(memPool[i].memPoolId, 0);
-        }
+        void* ptr = AllocFromPool(i, owner);
+        if (ptr != NULL) return ptr;
     }
-    return NULL; // Requested size too large
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    failureCount++;
+    __set_PRIMASK(primask);
+    return NULL; // Requested size too large or all fitting classes exhausted
 }
 
 /**
  * @brief Free a previously allocated memory block back to the pool.
+ * The owning class is found from the address of the block.
  * @param ptr Pointer to the memory block to free.
  * @return true if the memory block was successfully freed, false otherwise.
  */
 bool MemPool_Free(void* ptr)
 {
-    for (int i = 0; i < MEMPOOL_TYPES; ++i)
+    int32_t i = FindOwnerPool(ptr);
+    if (i < 0) return false;
+    return FreeToPool(i, ptr);
+}
+
+/**
+ * @brief Allocate a memory block through a magazine
+ * The block is taken from the magazine without any kernel call. An empty
+ * magazine is refilled with half of its capacity from the pool first.
+ * @param magazine pointer to the magazine of the calling thread
+ * @param size The size of the memory block to allocate.
+ * @return Pointer to the allocated memory block, or NULL if allocation failed.
+ */
+void* MemPool_MagazineAlloc(MemPool_Magazine_t* magazine, uint32_t size)
+{
+    uint32_t owner = (uint32_t)(uintptr_t)__builtin_return_address(0);
+    uint32_t i = SizeClass(size);
+    if (i >= MEMPOOL_TYPES) return MemPool_Alloc(size);
+    if (magazine->count[i] == 0)
+    {
+        // Refill in one batch, the kernel is only touched here and on drain
+        while (magazine->count[i] < MEMPOOL_MAGAZINE_SIZE / 2)
+        {
+            void* ptr = AllocFromPool(i, MEMPOOL_OWNER_MAGAZINE);
+            if (ptr == NULL) break;
+            magazine->blocks[i][magazine->count[i]++] = ptr;
+        }
+        if (magazine->count[i] == 0)
+        {
+            void* ptr = MemPool_Alloc(size); // Class exhausted, a larger class serves it
+            if (ptr != NULL) SetBlockOwner(ptr, owner);
+            return ptr;
+        }
+    }
+    void* ptr = magazine->blocks[i][--magazine->count[i]];
+    SetBlockOwner(ptr, owner);
+    return ptr;
+}
+
+/**
+ * @brief Free a memory block through a magazine
+ * The block is kept in the magazine of its class. A full magazine first
+ * drains half of its capacity back to the pool.
+ * @param magazine pointer to the magazine of the calling thread
+ * @param ptr Pointer to the memory block to free.
+ * @return true if the memory block was successfully freed, false otherwise.
+ */
+bool MemPool_MagazineFree(MemPool_Magazine_t* magazine, void* ptr)
+{
+    int32_t i = FindOwnerPool(ptr);
+    if (i < 0) return false;
+    uint32_t block = BlockIndex(i, ptr);
+    if (blockOwners[block] == 0 || blockOwners[block] == MEMPOOL_OWNER_MAGAZINE) return false;  // Freed twice
+    if (magazine->count[i] == MEMPOOL_MAGAZINE_SIZE)
+    {
+        while (magazine->count[i] > MEMPOOL_MAGAZINE_SIZE / 2)
+            FreeToPool(i, magazine->blocks[i][--magazine->count[i]]);
+    }
+    blockOwners[block] = MEMPOOL_OWNER_MAGAZINE;
+    magazine->blocks[i][magazine->count[i]++] = ptr;
+    return true;
+}
+
+/**
+ * @brief Return every block held by a magazine to the pool
+ * @param magazine pointer to the magazine
+ */
+void MemPool_MagazineFlush(MemPool_Magazine_t* magazine)
+{
+    for (uint32_t i = 0; i < MEMPOOL_TYPES; ++i)
+    {
+        while (magazine->count[i] > 0)
+            FreeToPool(i, magazine->blocks[i][--magazine->count[i]]);
+    }
+}
+
+/**
+ * @brief Initialize a lock-free block stack
+ * The blocks are taken from the pool once and stay owned by the stack.
+ * @param stack pointer to the stack
+ * @param size size of each block in bytes, at least the size of a pointer
+ * @param count number of blocks to preload
+ * @return true if all blocks were allocated, false otherwise
+ */
+bool MemPool_StackInit(MemPool_Stack_t* stack, uint32_t size, uint32_t count)
+{
+    uint32_t owner = (uint32_t)(uintptr_t)__builtin_return_address(0);
+    stack->head = 0;
+    if (size < sizeof(void*)) size = sizeof(void*);
+    for (uint32_t n = 0; n < count; ++n)
+    {
+        void* ptr = MemPool_Alloc(size);
+        if (ptr == NULL) return false;
+        SetBlockOwner(ptr, owner);
+        MemPool_StackPush(stack, ptr);
+    }
+    return true;
+}
+
+/**
+ * @brief Pop a block from a lock-free stack
+ * Safe in interrupts: the exclusive monitor is cleared by any exception in
+ * between, so a block popped and pushed back meanwhile makes the store fail.
+ * @param stack pointer to the stack
+ * @return pointer to the block, NULL if the stack is empty
+ */
+void* MemPool_StackPop(MemPool_Stack_t* stack)
+{
+    uint32_t head;
+    do {
+        head = __LDREXW(&stack->head);
+        if (head == 0)
+        {
+            __CLREX();
+            return NULL;
+        }
+    } while (__STREXW(*(uint32_t*)(uintptr_t)head, &stack->head) != 0);
+    __DMB();
+    return (void*)(uintptr_t)head;
+}
+
+/**
+ * @brief Push a block onto a lock-free stack
+ * Safe in interrupts.
+ * @param stack pointer to the stack
+ * @param ptr pointer to a block popped from this stack
+ */
+void MemPool_StackPush(MemPool_Stack_t* stack, void* ptr)
+{
+    uint32_t* next = (uint32_t*)ptr;
+    do {
+        *next = __LDREXW(&stack->head);
+        __DMB();    // Link the block before publishing it
+    } while (__STREXW((uint32_t)(uintptr_t)ptr, &stack->head) != 0);
+}
+
+/**
+ * @brief Get the statistics of a size class
+ * @param index index of the class, 0 is the smallest
+ * @param stats pointer to the statistics to fill
+ * @return true if the class exists, false otherwise
+ */
+bool MemPool_GetClassStats(uint32_t index, MemPool_ClassStats_t* stats)
+{
+    if (index >= MEMPOOL_TYPES || stats == NULL) return false;
+    stats->blockSize = memPool[index].memSize;
+    stats->blockCount = memPool[index].memPoolObjects;
+    stats->inUse = memPool[index].inUse;
+    stats->highWater = memPool[index].highWater;
+    stats->exhausted = memPool[index].exhausted;
+    return true;
+}
+
+/**
+ * @brief Get the number of allocations which failed in every class
+ * @return number of failed allocations since boot
+ */
+uint32_t MemPool_GetFailureCount(void)
+{
+    return failureCount;
+}
+
+/**
+ * @brief List the allocated blocks, smallest class first
+ * Blocks held for a long time by the same owner are leak candidates.
+ * @param first number of allocated blocks to skip
+ * @param blocks pointer to the array to fill
+ * @param count capacity of the array
+ * @return number of entries filled
+ */
+uint32_t MemPool_GetAllocatedBlocks(uint32_t first, MemPool_BlockInfo_t* blocks, uint32_t count)
+{
+    uint32_t filled = 0;
+    for (uint32_t i = 0; i < MEMPOOL_TYPES && filled < count; ++i)
+    {
+        for (uint32_t j = 0; j < memPool[i].memPoolObjects && filled < count; ++j)
+        {
+            uint32_t block = memPool[i].firstBlock + j;
+            uint32_t owner = blockOwners[block];
+            if (owner == 0) continue;
+            if (first > 0)
+            {
+                first--;
+                continue;
+            }
+            blocks[filled].owner = owner;
+            blocks[filled].blockSize = memPool[i].memSize;
+            blocks[filled].allocTick = blockTicks[block];
+            filled++;
+        }
+    }
+    return filled;
+}
+
+/**
+ * @brief Get the number of allocated blocks in every class
+ * @return number of allocated blocks
+ */
+uint32_t MemPool_GetAllocatedCount(void)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < MEMPOOL_TYPES; ++i)
+        count += memPool[i].inUse;
+    return count;
+}
+
+/**
+ * @brief Allocate a block from one pool and account for it
+ * @param index index of the pool
+ * @param owner owner recorded for the leak report
+ * @return pointer to the block, NULL if the pool is exhausted
+ */
+void* AllocFromPool(uint32_t index, uint32_t owner)
+{
+    uint8_t* ptr = osMemoryPoolAlloc(memPool[index].memPoolId, 0);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (ptr == NULL)
+    {
+        memPool[index].exhausted++;
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+    uint32_t block = BlockIndex(index, ptr);
+    blockOwners[block] = owner;
+    blockTicks[block] = osKernelGetTickCount();
+    if (++memPool[index].inUse > memPool[index].highWater) memPool[index].highWater = memPool[index].inUse;
+    __set_PRIMASK(primask);
+    return ptr;
+}
+
+/**
+ * @brief Free a block to its pool and account for it
+ * @param index index of the pool owning the block
+ * @param ptr pointer to the block
+ * @return true if the block was freed, false if it was not allocated
+ */
+bool FreeToPool(uint32_t index, void* ptr)
+{
+    uint32_t block = BlockIndex(index, ptr);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (blockOwners[block] == 0)
+    {
+        __set_PRIMASK(primask);
+        return false;   // Not allocated, freed twice
+    }
+    blockOwners[block] = 0;
+    memPool[index].inUse--;
+    __set_PRIMASK(primask);
+    return osMemoryPoolFree(memPool[index].memPoolId, ptr) == osOK;
+}
+
+/**
+ * @brief Record a new owner of an allocated block
+ * @param ptr pointer to the block
+ * @param owner owner recorded for the leak report
+ */
+void SetBlockOwner(void* ptr, uint32_t owner)
+{
+    int32_t i = FindOwnerPool(ptr);
+    if (i < 0) return;
+    uint32_t block = BlockIndex(i, ptr);
+    blockOwners[block] = owner;
+    blockTicks[block] = osKernelGetTickCount();
+}
+
+/**
+ * @brief Find the pool owning a block
+ * @param ptr pointer to the block
+ * @return index of the pool, -1 if the pointer is not the start of a block
+ */
+int32_t FindOwnerPool(const uint8_t* ptr)
+{
+    for (int32_t i = 0; i < MEMPOOL_TYPES; ++i)
     {
-        if (osMemoryPoolFree(memPool[i].memPoolId, ptr) == osOK)
-            return true;
+        const uint8_t* memory = memPool[i].memory;
+        if (ptr < memory || ptr >= memory + memPool[i].memPoolObjects * memPool[i].memSize) continue;
+        if ((uint32_t)(ptr - memory) % memPool[i].memSize != 0) return -1;
+        return i;
     }
-    return false;
+    return -1;
 }
@@ -3,6 +3,49 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define MEMPOOL_CLASSES 6   // Number of size classes, 64 to 2048 bytes
+#define MEMPOOL_MAGAZINE_SIZE 8     // Blocks cached per class by a magazine
+
+/**
+ * @brief Per-thread block cache in front of the pools
+ * A magazine belongs to one thread, which declares it and passes it to every
+ * call; it is not locked. Blocks cached in a magazine show up in the leak
+ * report with owner 1.
+ */
+typedef struct {
+    uint32_t count[MEMPOOL_CLASSES];
+    void* blocks[MEMPOOL_CLASSES][MEMPOOL_MAGAZINE_SIZE];
+} MemPool_Magazine_t;
+
+/**
+ * @brief Lock-free stack of equally sized blocks
+ * Preloaded from the pool, then popped and pushed by threads and interrupts
+ * without any kernel call. The first word of a stacked block links the next one.
+ */
+typedef struct {
+    volatile uint32_t head; // Address of the top block, 0 when empty
+} MemPool_Stack_t;
+
+/**
+ * @brief Statistics of one size class
+ */
+typedef struct {
+    uint32_t blockSize;     // Size of the blocks in bytes
+    uint32_t blockCount;    // Number of blocks in the class
+    uint32_t inUse;         // Blocks currently allocated
+    uint32_t highWater;     // Maximum of inUse since boot
+    uint32_t exhausted;     // Requests which found the class empty, served by a larger class or failed
+} MemPool_ClassStats_t;
+
+/**
+ * @brief Allocated block, as listed by the leak report
+ */
+typedef struct {
+    uint32_t owner;         // Return address of the MemPool_Alloc caller
+    uint32_t blockSize;     // Size of the block in bytes
+    uint32_t allocTick;     // Kernel tick of the allocation
+} MemPool_BlockInfo_t;
+
 /**
  * @brief Initialize the memory pool system.
  * This function sets up the memory pools for different block sizes.
@@ -11,6 +54,8 @@ void MemPool_Init(void);
 
 /**
  * @brief Allocate a memory block from the pool.
+ * The smallest fitting class is computed with CLZ, a larger class is used
+ * when it is exhausted. Can be called from interrupts.
  * @param size The size of the memory block to allocate.
  * @return Pointer to the allocated memory block, or NULL if allocation failed.
  */
@@ -18,7 +63,88 @@ void* MemPool_Alloc(uint32_t size);
 
 /**
  * @brief Free a previously allocated memory block back to the pool.
+ * The owning class is found from the address of the block.
  * @param ptr Pointer to the memory block to free.
  * @return true if the memory block was successfully freed, false otherwise.
  */
 bool MemPool_Free(void* ptr);
+
+/**
+ * @brief Get the statistics of a size class
+ * @param index index of the class, 0 is the smallest
+ * @param stats pointer to the statistics to fill
+ * @return true if the class exists, false otherwise
+ */
+bool MemPool_GetClassStats(uint32_t index, MemPool_ClassStats_t* stats);
+
+/**
+ * @brief Get the number of allocations which failed in every class
+ * @return number of failed allocations since boot
+ */
+uint32_t MemPool_GetFailureCount(void);
+
+/**
+ * @brief List the allocated blocks, smallest class first
+ * Blocks held for a long time by the same owner are leak candidates.
+ * @param first number of allocated blocks to skip
+ * @param blocks pointer to the array to fill
+ * @param count capacity of the array
+ * @return number of entries filled
+ */
+uint32_t MemPool_GetAllocatedBlocks(uint32_t first, MemPool_BlockInfo_t* blocks, uint32_t count);
+
+/**
+ * @brief Get the number of allocated blocks in every class
+ * @return number of allocated blocks
+ */
+uint32_t MemPool_GetAllocatedCount(void);
+
+/**
+ * @brief Allocate a memory block through a magazine
+ * The block is taken from the magazine without any kernel call. An empty
+ * magazine is refilled with half of its capacity from the pool first.
+ * @param magazine pointer to the magazine of the calling thread, zero initialized before first use
+ * @param size The size of the memory block to allocate.
+ * @return Pointer to the allocated memory block, or NULL if allocation failed.
+ */
+void* MemPool_MagazineAlloc(MemPool_Magazine_t* magazine, uint32_t size);
+
+/**
+ * @brief Free a memory block through a magazine
+ * The block is kept in the magazine of its class. A full magazine first
+ * drains half of its capacity back to the pool.
+ * @param magazine pointer to the magazine of the calling thread
+ * @param ptr Pointer to the memory block to free.
+ * @return true if the memory block was successfully freed, false otherwise.
+ */
+bool MemPool_MagazineFree(MemPool_Magazine_t* magazine, void* ptr);
+
+/**
+ * @brief Return every block held by a magazine to the pool
+ * @param magazine pointer to the magazine
+ */
+void MemPool_MagazineFlush(MemPool_Magazine_t* magazine);
+
+/**
+ * @brief Initialize a lock-free block stack
+ * The blocks are taken from the pool once and stay owned by the stack.
+ * @param stack pointer to the stack
+ * @param size size of each block in bytes, at least the size of a pointer
+ * @param count number of blocks to preload
+ * @return true if all blocks were allocated, false otherwise
+ */
+bool MemPool_StackInit(MemPool_Stack_t* stack, uint32_t size, uint32_t count);
+
+/**
+ * @brief Pop a block from a lock-free stack, safe in interrupts
+ * @param stack pointer to the stack
+ * @return pointer to the block, NULL if the stack is empty
+ */
+void* MemPool_StackPop(MemPool_Stack_t* stack);
+
+/**
+ * @brief Push a block onto a lock-free stack, safe in interrupts
+ * @param stack pointer to the stack
+ * @param ptr pointer to a block popped from this stack
+ */
+void MemPool_StackPush(MemPool_Stack_t* stack, void* ptr);
@@ -0,0 +1,81 @@
+/**
+ * @file resource_monitor.c
+ * @brief Runtime report of the RAM budget: kernel heap and thread stacks.
+ *
+ * @details
+ *  - The heap figures read the header RTX keeps at the start of its dynamic
+ *    memory (OS_DYNAMIC_MEM_SIZE): total size and bytes in use. The peak is
+ *    the highest value seen by the reports.
+ *  - Thread stacks are filled with a pattern at creation when
+ *    OS_STACK_WATERMARK is enabled, osThreadGetStackSpace then returns the
+ *    part never touched. Stacks given as static memory are covered as well.
+ *
+ * @dependencies resource_monitor.h, cmsis_os2, rtx_os (osRtxConfig)
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#include "resource_monitor.h"
+
+#include "cmsis_os2.h"
+#include "rtx_os.h"
+
+#include <string.h>
+
+/* -------------------------------------- Data Type Definitions -------------------------------- */
+#define RESOURCE_MONITOR_MAX_THREADS    24
+
+/**
+ * @brief Header of the RTX memory allocator (rtx_memory.c), at the start of its memory
+ */
+typedef struct {
+    uint32_t size;          // Size of the memory block in bytes
+    uint32_t used;          // Bytes allocated, headers included
+} RtxMemoryHead_t;
+
+/* -------------------------------------- Static variables ------------------------------------- */
+static uint32_t heapPeak = 0;
+
+/**
+ * @brief Get the usage of the RTX dynamic memory
+ * @param info pointer to the information to fill
+ * @return true if successful, false otherwise
+ */
+bool ResourceMonitor_GetHeap(ResourceMonitor_HeapInfo_t *info)
+{
+    if (info == NULL) return false;
+    const RtxMemoryHead_t *head = (const RtxMemoryHead_t *)osRtxConfig.mem.common_addr;
+    if (head == NULL) return false;
+    info->size = head->size;
+    info->used = head->used;
+    if (info->used > heapPeak) heapPeak = info->used;
+    info->peak = heapPeak;
+    return true;
+}
+
+/**
+ * @brief Get the stack usage of the threads
+ * @param info pointer to the array to fill
+ * @param count capacity of the array
+ * @return number of entries filled
+ */
+uint32_t ResourceMonitor_GetThreads(ResourceMonitor_ThreadInfo_t *info, uint32_t count)
+{
+    if (info == NULL) return 0;
+    osThreadId_t threads[RESOURCE_MONITOR_MAX_THREADS];
+    uint32_t number = osThreadEnumerate(threads, RESOURCE_MONITOR_MAX_THREADS);
+    if (number > count) number = count;
+    for (uint32_t i = 0; i < number; i++)
+    {
+        const char *name = osThreadGetName(threads[i]);
+        memset(info[i].name, 0, RESOURCE_MONITOR_NAME_SIZE);
+        if (name != NULL) strncpy(info[i].name, name, RESOURCE_MONITOR_NAME_SIZE - 1);
+        info[i].stackSize = osThreadGetStackSize(threads[i]);
+        uint32_t space = osThreadGetStackSpace(threads[i]);
+        info[i].stackUsed = info[i].stackSize > space ? info[i].stackSize - space : 0;
+        info[i].priority = osThreadGetPriority(threads[i]);
+        info[i].state = osThreadGetState(threads[i]);
+    }
+    return number;
+}
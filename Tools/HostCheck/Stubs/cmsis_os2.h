@@ -0,0 +1,147 @@
+/**
+ * @file cmsis_os2.h
+ * @brief Host stand-in for the CMSIS-RTOS2 API
+ *
+ * @details The types and the subset of functions used by the modules under
+ * check. host_os.c runs the threads cooperatively in the host process: a
+ * thread runs once osKernelStart is called, until it blocks in a kernel call
+ * or readies a higher priority one. The kernel tick count is a variable
+ * which jumps to the next timeout when every thread is blocked, so delays
+ * and timeouts cost no host time. The check itself is a thread of
+ * osPriorityNormal, its id is NULL.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ---------------------- Types ----------------------------------------- */
+typedef void *osThreadId_t;
+typedef void *osTimerId_t;
+typedef void *osEventFlagsId_t;
+typedef void *osMutexId_t;
+typedef void *osSemaphoreId_t;
+typedef void *osMemoryPoolId_t;
+typedef void *osMessageQueueId_t;
+
+typedef enum {
+    osOK = 0,
+    osError = -1,
+    osErrorTimeout = -2,
+    osErrorResource = -3,
+    osErrorParameter = -4,
+    osErrorNoMemory = -5,
+    osErrorISR = -6,
+} osStatus_t;
+
+typedef enum {
+    osPriorityNone = 0,
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityRealtime = 48,
+    osPriorityISR = 56,
+} osPriority_t;
+
+typedef enum {
+    osTimerOnce = 0,
+    osTimerPeriodic = 1,
+} osTimerType_t;
+
+typedef void (*osThreadFunc_t)(void *argument);
+typedef void (*osTimerFunc_t)(void *argument);
+
+typedef struct {
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+    void *stack_mem;
+    uint32_t stack_size;
+    osPriority_t priority;
+    uint32_t tz_module;
+    uint32_t reserved;
+} osThreadAttr_t;
+
+typedef struct {
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+} osTimerAttr_t, osEventFlagsAttr_t, osMutexAttr_t, osSemaphoreAttr_t;
+
+typedef struct {
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+    void *mp_mem;
+    uint32_t mp_size;
+} osMemoryPoolAttr_t;
+
+typedef struct {
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+    void *mq_mem;
+    uint32_t mq_size;
+} osMessageQueueAttr_t;
+
+#define osWaitForever         0xFFFFFFFFU
+#define osFlagsWaitAny        0x00000000U
+#define osFlagsWaitAll        0x00000001U
+#define osFlagsNoClear        0x00000002U
+#define osFlagsError          0x80000000U
+#define osFlagsErrorUnknown   0xFFFFFFFFU
+#define osFlagsErrorTimeout   0xFFFFFFFEU
+#define osFlagsErrorResource  0xFFFFFFFDU
+#define osFlagsErrorParameter 0xFFFFFFFCU
+#define osMutexRecursive      0x00000001U
+#define osMutexPrioInherit    0x00000002U
+
+/* ---------------------- Host control ---------------------------------- */
+extern uint32_t HostOs_TickCount;       // Kernel ticks in ms
+extern int32_t HostOs_MutexDepth;       // Acquires minus releases of all mutexes
+extern uint32_t HostOs_PoolCalls;       // Memory pool allocs and frees, each an SVC on the target
+uint32_t HostOs_GetThreadFlags(osThreadId_t thread_id);    // Flags of a thread not consumed yet
+
+/* ---------------------- Kernel ---------------------------------------- */
+osStatus_t osKernelStart(void);
+uint32_t osKernelGetTickCount(void);
+uint32_t osKernelGetTickFreq(void);
+
+/* ---------------------- Threads --------------------------------------- */
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr);
+osThreadId_t osThreadGetId(void);
+osStatus_t osThreadYield(void);
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags);
+uint32_t osThreadFlagsClear(uint32_t flags);
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout);
+osStatus_t osDelay(uint32_t ticks);
+
+/* ---------------------- Mutexes --------------------------------------- */
+osMutexId_t osMutexNew(const osMutexAttr_t *attr);
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+osStatus_t osMutexRelease(osMutexId_t mutex_id);
+
+/* ---------------------- Event flags ----------------------------------- */
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr);
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags);
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags);
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id);
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout);
+
+/* ---------------------- Memory pools ---------------------------------- */
+osMemoryPoolId_t osMemoryPoolNew(uint32_t block_count, uint32_t block_size, const osMemoryPoolAttr_t *attr);
+void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout);
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block);
+uint32_t osMemoryPoolGetCount(osMemoryPoolId_t mp_id);
+uint32_t osMemoryPoolGetSpace(osMemoryPoolId_t mp_id);
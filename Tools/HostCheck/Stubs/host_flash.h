@@ -0,0 +1,46 @@
+/**
+ * @file host_flash.h
+ * @brief Control of the simulated W25Q128 behind the host spi.h
+ *
+ * @details host_spi_flash.c answers the SPI transactions of w25qxx.c like
+ * the chip: commands, write enable latch, page wrap, busy time of programs
+ * and erases in kernel ticks. A check reads and presets the memory here and
+ * cuts the power in the middle of a program or erase: the interrupted page
+ * keeps half of its new bytes and the interrupted sector is left half
+ * erased. The chip lives in shared memory. Firmware run through
+ * HostFlash_RunPowered stops at the cut with all of its RAM, like the
+ * target, and the next run boots from the flash alone. Elsewhere every
+ * transaction fails after the cut until HostFlash_PowerOn.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define HOST_FLASH_SIZE             0x1000000U  // W25Q128, 16 MB
+#define HOST_FLASH_PROGRAM_TICKS    1U          // Busy time of a page program
+#define HOST_FLASH_ERASE_TICKS      45U         // Busy time of a sector erase
+#define HOST_FLASH_POWER_CUT        200         // Result of HostFlash_RunPowered when the power was cut
+
+/**
+ * @brief State of the chip a check reads and presets
+ */
+typedef struct {
+    uint8_t memory[HOST_FLASH_SIZE];
+    uint32_t programCount;      // Page programs done
+    uint32_t eraseCount;        // Sectors erased
+    int32_t cutAfter;           // Programs and erases left before the power cut, -1 for none
+} HostFlash_t;
+
+/* ---------------------- Host control ---------------------------------- */
+extern HostFlash_t *HostFlash;
+
+void HostFlash_Erase(void);
+bool HostFlash_IsPowerLost(void);
+void HostFlash_PowerOn(void);
+int HostFlash_RunPowered(int (*part)(void *argument), void *argument);
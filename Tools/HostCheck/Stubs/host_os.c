@@ -0,0 +1,471 @@
+/**
+ * @file host_os.c
+ * @brief Host implementation of the stand-ins of cmsis_os2.h and main.h
+ *
+ * @details The check runs in the main context, at osPriorityNormal. Threads
+ * created with osThreadNew run once osKernelStart is called, each on its
+ * own ucontext stack. Scheduling is by priority and cooperative: the highest
+ * priority ready context runs until it blocks in a kernel call or makes a
+ * higher priority one ready, contexts of equal priority take turns when one
+ * blocks or yields. When every context is blocked the kernel tick jumps to
+ * the earliest timeout, so a check waits seconds in no time. Linked into
+ * every host check by Tools/host_check.py.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "main.h"
+#include "cmsis_os2.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define HOST_OS_MAX_THREADS     16
+#define HOST_OS_MAX_MUTEXES     32
+#define HOST_OS_MAX_EVENT_FLAGS 16
+#define HOST_OS_MAX_POOLS       16
+#define HOST_OS_STACK_SIZE      (256 * 1024)    // Host stack of each thread, the target sizes do not apply
+
+/**
+ * @brief Execution context, the check or a thread
+ */
+typedef struct {
+    ucontext_t context;
+    osThreadFunc_t func;
+    void *argument;
+    osPriority_t priority;
+    uint32_t flags;         // Thread flags
+    uint32_t wakeTick;      // Tick of the timeout of a blocked context
+    bool isTimed;           // Blocked with a timeout
+    bool isBlocked;         // Waiting for a kernel object or a delay
+    bool isDelayed;         // Blocked in osDelay, kernel objects do not wake it
+    bool isFinished;        // The thread function returned
+} HostContext_t;
+
+typedef struct {
+    uint32_t owner;         // Context holding the mutex
+    uint32_t count;         // Nested acquires, 0 when free
+} HostMutex_t;
+
+typedef struct {
+    uint8_t *memory;
+    uint32_t blockSize;
+    uint32_t blockCount;
+    uint32_t freeCount;
+    void **freeList;
+} HostPool_t;
+
+/* ---------------------- Core ------------------------------------------ */
+DWT_Type HostDwt;
+uint32_t SystemCoreClock = 168000000U;
+
+/**
+ * @brief Stop the check at a failed assert_param
+ * @param file Source file of the assertion
+ * @param line Line of the assertion
+ */
+void HostCheck_AssertFailed(const char *file, int line)
+{
+    fprintf(stderr, "assert_param failed at %s:%d\n", file, line);
+    exit(2);
+}
+
+/* ---------------------- Kernel ---------------------------------------- */
+uint32_t HostOs_TickCount;
+int32_t HostOs_MutexDepth;
+uint32_t HostOs_PoolCalls;
+
+static HostContext_t contexts[HOST_OS_MAX_THREADS + 1];    // 0 is the check, threads are 1, 2, ...
+static uint32_t threadCount;
+static uint32_t current;
+static bool isKernelRunning;
+
+static HostMutex_t mutexes[HOST_OS_MAX_MUTEXES];
+static uint32_t mutexCount;
+static uint32_t eventFlags[HOST_OS_MAX_EVENT_FLAGS];
+static uint32_t eventFlagsCount;
+static HostPool_t pools[HOST_OS_MAX_POOLS];
+static uint32_t poolCount;
+
+static void Schedule(void);
+
+/**
+ * @brief Whether a context may run now
+ */
+static bool IsReady(uint32_t index)
+{
+    const HostContext_t *context = &contexts[index];
+    if (context->isFinished || context->isBlocked) return false;
+    return index == 0 || isKernelRunning;
+}
+
+/**
+ * @brief Switch to another context
+ * @param index context to run
+ */
+static void SwitchTo(uint32_t index)
+{
+    if (index == current) return;
+    uint32_t previous = current;
+    current = index;
+    swapcontext(&contexts[previous].context, &contexts[index].context);
+}
+
+/**
+ * @brief Entry of every thread context
+ */
+static void ThreadEntry(void)
+{
+    HostContext_t *self = &contexts[current];
+    self->func(self->argument);
+    self->isFinished = true;
+    Schedule();
+}
+
+/**
+ * @brief Run the highest priority ready context
+ * Equal priorities are taken in turn from the one after the running
+ * context. With no context ready the tick jumps to the earliest timeout.
+ */
+static void Schedule(void)
+{
+    for (;;)
+    {
+        int32_t next = -1;
+        for (uint32_t n = 1; n <= threadCount + 1; n++)
+        {
+            uint32_t i = (current + n) % (threadCount + 1);
+            if (IsReady(i) && (next < 0 || contexts[i].priority > contexts[next].priority)) next = (int32_t)i;
+        }
+        if (next >= 0)
+        {
+            SwitchTo((uint32_t)next);
+            return;
+        }
+        bool hasTimeout = false;
+        uint32_t wakeTick = 0;
+        for (uint32_t i = 0; i <= threadCount; i++)
+        {
+            const HostContext_t *context = &contexts[i];
+            if (!context->isBlocked || !context->isTimed || (i != 0 && !isKernelRunning)) continue;
+            if (!hasTimeout || (int32_t)(context->wakeTick - wakeTick) < 0) wakeTick = context->wakeTick;
+            hasTimeout = true;
+        }
+        if (!hasTimeout)
+        {
+            fprintf(stderr, "host kernel: every thread waits forever\n");
+            exit(3);
+        }
+        HostOs_TickCount = wakeTick;
+        for (uint32_t i = 0; i <= threadCount; i++)
+        {
+            HostContext_t *context = &contexts[i];
+            if (context->isBlocked && context->isTimed && (int32_t)(context->wakeTick - HostOs_TickCount) <= 0)
+                context->isBlocked = false;
+        }
+    }
+}
+
+/**
+ * @brief Run a higher priority context made ready by the running one
+ */
+static void Preempt(void)
+{
+    for (uint32_t i = 0; i <= threadCount; i++)
+    {
+        if (IsReady(i) && contexts[i].priority > contexts[current].priority)
+        {
+            Schedule();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Wake the contexts waiting for a kernel object, they check it again
+ */
+static void WakeWaiters(void)
+{
+    for (uint32_t i = 0; i <= threadCount; i++)
+    {
+        if (contexts[i].isBlocked && !contexts[i].isDelayed) contexts[i].isBlocked = false;
+    }
+    Preempt();
+}
+
+/**
+ * @brief Block the running context until a kernel object changes
+ * @param timeout timeout of the kernel call
+ * @param start tick count when the call began
+ * @return true to check the object again, false when the timeout expired
+ */
+static bool WaitForChange(uint32_t timeout, uint32_t start)
+{
+    HostContext_t *self = &contexts[current];
+    if (timeout == 0) return false;
+    self->isTimed = timeout != osWaitForever;
+    self->wakeTick = start + timeout;
+    if (self->isTimed && (int32_t)(self->wakeTick - HostOs_TickCount) <= 0) return false;
+    self->isBlocked = true;
+    self->isDelayed = false;
+    Schedule();
+    return true;
+}
+
+/**
+ * @brief Start running the threads
+ * On the target this call does not return; here it returns to the check,
+ * which goes on as a thread of osPriorityNormal.
+ */
+osStatus_t osKernelStart(void)
+{
+    contexts[0].priority = osPriorityNormal;
+    isKernelRunning = true;
+    Preempt();
+    return osOK;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+    return HostOs_TickCount;
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return 1000U;
+}
+
+/* ---------------------- Threads --------------------------------------- */
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
+{
+    if (func == NULL || threadCount >= HOST_OS_MAX_THREADS) return NULL;
+    contexts[0].priority = osPriorityNormal;
+    HostContext_t *context = &contexts[++threadCount];
+    memset(context, 0, sizeof(HostContext_t));
+    context->func = func;
+    context->argument = argument;
+    context->priority = (attr != NULL && attr->priority != osPriorityNone) ? attr->priority : osPriorityNormal;
+    getcontext(&context->context);
+    context->context.uc_stack.ss_sp = malloc(HOST_OS_STACK_SIZE);
+    context->context.uc_stack.ss_size = HOST_OS_STACK_SIZE;
+    context->context.uc_link = NULL;
+    makecontext(&context->context, ThreadEntry, 0);
+    if (isKernelRunning) Preempt();
+    return (osThreadId_t)(uintptr_t)threadCount;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+    return (osThreadId_t)(uintptr_t)current;
+}
+
+osStatus_t osThreadYield(void)
+{
+    Schedule();
+    return osOK;
+}
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    uint32_t index = (uint32_t)(uintptr_t)thread_id;
+    if (index > threadCount || (flags & osFlagsError)) return osFlagsErrorParameter;
+    contexts[index].flags |= flags;
+    uint32_t result = contexts[index].flags;
+    WakeWaiters();
+    return result;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags)
+{
+    uint32_t previous = contexts[current].flags;
+    contexts[current].flags &= ~flags;
+    return previous;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    uint32_t start = HostOs_TickCount;
+    bool isWaiting = true;
+    for (;;)
+    {
+        uint32_t value = contexts[current].flags;
+        uint32_t set = value & flags;
+        if ((options & osFlagsWaitAll) ? set == flags : set != 0)
+        {
+            if (!(options & osFlagsNoClear)) contexts[current].flags &= ~set;
+            return value;
+        }
+        if (!isWaiting) return timeout == 0 ? osFlagsErrorResource : osFlagsErrorTimeout;
+        isWaiting = WaitForChange(timeout, start);
+    }
+}
+
+uint32_t HostOs_GetThreadFlags(osThreadId_t thread_id)
+{
+    uint32_t index = (uint32_t)(uintptr_t)thread_id;
+    return index <= threadCount ? contexts[index].flags : 0;
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    HostContext_t *self = &contexts[current];
+    if (ticks == 0) return osOK;
+    self->isTimed = true;
+    self->wakeTick = HostOs_TickCount + ticks;
+    self->isBlocked = true;
+    self->isDelayed = true;
+    Schedule();
+    self->isDelayed = false;
+    return osOK;
+}
+
+/* ---------------------- Mutexes --------------------------------------- */
+osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+    (void)attr;
+    if (mutexCount >= HOST_OS_MAX_MUTEXES) return NULL;
+    return &mutexes[mutexCount++];
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    HostMutex_t *mutex = mutex_id;
+    uint32_t start = HostOs_TickCount;
+    bool isWaiting = true;
+    if (mutex == NULL) return osErrorParameter;
+    for (;;)
+    {
+        if (mutex->count == 0 || mutex->owner == current)
+        {
+            mutex->owner = current;
+            mutex->count++;
+            HostOs_MutexDepth++;
+            return osOK;
+        }
+        if (!isWaiting) return timeout == 0 ? osErrorResource : osErrorTimeout;
+        isWaiting = WaitForChange(timeout, start);
+    }
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    HostMutex_t *mutex = mutex_id;
+    if (mutex == NULL) return osErrorParameter;
+    if (mutex->count == 0 || mutex->owner != current) return osErrorResource;
+    HostOs_MutexDepth--;
+    if (--mutex->count == 0) WakeWaiters();
+    return osOK;
+}
+
+/* ---------------------- Event flags ----------------------------------- */
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+    (void)attr;
+    if (eventFlagsCount >= HOST_OS_MAX_EVENT_FLAGS) return NULL;
+    return &eventFlags[eventFlagsCount++];
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    uint32_t *value = ef_id;
+    if (value == NULL || (flags & osFlagsError)) return osFlagsErrorParameter;
+    *value |= flags;
+    uint32_t result = *value;
+    WakeWaiters();
+    return result;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    uint32_t *value = ef_id;
+    if (value == NULL) return osFlagsErrorParameter;
+    uint32_t previous = *value;
+    *value &= ~flags;
+    return previous;
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+    const uint32_t *value = ef_id;
+    return value != NULL ? *value : 0;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    uint32_t *value = ef_id;
+    uint32_t start = HostOs_TickCount;
+    bool isWaiting = true;
+    if (value == NULL) return osFlagsErrorParameter;
+    for (;;)
+    {
+        uint32_t previous = *value;
+        uint32_t set = previous & flags;
+        if ((options & osFlagsWaitAll) ? set == flags : set != 0)
+        {
+            if (!(options & osFlagsNoClear)) *value &= ~set;
+            return previous;
+        }
+        if (!isWaiting) return timeout == 0 ? osFlagsErrorResource : osFlagsErrorTimeout;
+        isWaiting = WaitForChange(timeout, start);
+    }
+}
+
+/* ---------------------- Memory pools ---------------------------------- */
+osMemoryPoolId_t osMemoryPoolNew(uint32_t block_count, uint32_t block_size, const osMemoryPoolAttr_t *attr)
+{
+    if (poolCount >= HOST_OS_MAX_POOLS || block_count == 0 || block_size == 0) return NULL;
+    HostPool_t *pool = &pools[poolCount++];
+    pool->blockSize = (block_size + 3U) & ~3U;
+    pool->blockCount = block_count;
+    pool->memory = (attr != NULL && attr->mp_mem != NULL) ? attr->mp_mem : malloc(block_count * pool->blockSize);
+    pool->freeList = malloc(block_count * sizeof(void *));
+    for (uint32_t i = 0; i < block_count; i++)
+        pool->freeList[i] = pool->memory + (block_count - 1 - i) * pool->blockSize;
+    pool->freeCount = block_count;
+    return pool;
+}
+
+void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout)
+{
+    HostPool_t *pool = mp_id;
+    uint32_t start = HostOs_TickCount;
+    bool isWaiting = true;
+    HostOs_PoolCalls++;
+    if (pool == NULL) return NULL;
+    for (;;)
+    {
+        if (pool->freeCount > 0) return pool->freeList[--pool->freeCount];
+        if (!isWaiting) return NULL;
+        isWaiting = WaitForChange(timeout, start);
+    }
+}
+
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block)
+{
+    HostPool_t *pool = mp_id;
+    HostOs_PoolCalls++;
+    if (pool == NULL || block == NULL) return osErrorParameter;
+    uint8_t *address = block;
+    if (address < pool->memory || address >= pool->memory + pool->blockCount * pool->blockSize ||
+        (uint32_t)(address - pool->memory) % pool->blockSize != 0 || pool->freeCount >= pool->blockCount)
+        return osErrorParameter;
+    pool->freeList[pool->freeCount++] = block;
+    WakeWaiters();
+    return osOK;
+}
+
+uint32_t osMemoryPoolGetCount(osMemoryPoolId_t mp_id)
+{
+    const HostPool_t *pool = mp_id;
+    return pool != NULL ? pool->blockCount - pool->freeCount : 0;
+}
+
+uint32_t osMemoryPoolGetSpace(osMemoryPoolId_t mp_id)
+{
+    const HostPool_t *pool = mp_id;
+    return pool != NULL ? pool->freeCount : 0;
+}
@@ -0,0 +1,320 @@
+/**
+ * @file host_spi_flash.c
+ * @brief W25Q128 model behind the functions of spi.h
+ *
+ * @details Each byte exchanged while the chip select is low goes through
+ * the command decoder of the chip. Programs and erases are done when the
+ * chip select goes high, if the write enable latch is set, and keep the chip
+ * busy for their typical duration. Commands other than read status are
+ * ignored while busy, like the chip does. See host_flash.h for the power
+ * cut. Linked by the checks of the flash storage.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "host_flash.h"
+
+#include "spi.h"
+#include "cmsis_os2.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define COMMAND_WRITE_ENABLE        0x06
+#define COMMAND_WRITE_DISABLE       0x04
+#define COMMAND_READ_STATUS         0x05
+#define COMMAND_READ_DATA           0x03
+#define COMMAND_FAST_READ           0x0B
+#define COMMAND_PAGE_PROGRAM        0x02
+#define COMMAND_SECTOR_ERASE        0x20
+#define COMMAND_BLOCK_ERASE         0xD8
+#define COMMAND_CHIP_ERASE          0xC7
+#define COMMAND_MANUFACTURER_ID     0x90
+
+#define STATUS_BUSY     0x01
+#define STATUS_WEL      0x02
+#define PAGE_SIZE       256U
+#define SECTOR_SIZE     4096U
+#define BLOCK_SIZE      65536U
+
+/* ---------------------- Host control ---------------------------------- */
+HostFlash_t *HostFlash;         // Mapped by MapFlash before main
+
+/* ---------------------- Chip state ------------------------------------ */
+static bool isPowerLost;
+static bool isPowered;              // Running in a child of HostFlash_RunPowered
+static bool isSelected;
+static bool isWriteEnabled;
+static uint32_t busyUntil;          // Kernel tick when the running program or erase ends
+static uint8_t command;
+static uint32_t position;           // Bytes exchanged since the chip select went low
+static uint32_t address;
+static uint8_t pageData[PAGE_SIZE]; // Bytes of a page program, by column
+static bool pageMask[PAGE_SIZE];
+
+/**
+ * @brief Whether a program or erase is running
+ */
+static bool IsBusy(void)
+{
+    return (int32_t)(busyUntil - osKernelGetTickCount()) > 0;
+}
+
+/**
+ * @brief Map the chip in memory shared with the powered children
+ */
+__attribute__((constructor)) static void MapFlash(void)
+{
+    HostFlash = mmap(NULL, sizeof(HostFlash_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (HostFlash == MAP_FAILED)
+    {
+        perror("host flash");
+        exit(3);
+    }
+    HostFlash->cutAfter = -1;
+}
+
+/**
+ * @brief Count a program or erase against the power cut
+ * @return true if the power goes during this operation
+ */
+static bool IsCut(void)
+{
+    if (HostFlash->cutAfter < 0) return false;
+    if (HostFlash->cutAfter-- > 0) return false;
+    return true;
+}
+
+/**
+ * @brief Cut the power after the interrupted operation left its mark
+ */
+static void CutPower(void)
+{
+    isPowerLost = true;
+    if (isPowered) _exit(HOST_FLASH_POWER_CUT);
+}
+
+/**
+ * @brief Program the collected bytes into their page
+ */
+static void ProgramPage(void)
+{
+    uint32_t page = address & ~(PAGE_SIZE - 1U) & (HOST_FLASH_SIZE - 1U);
+    uint32_t count = 0, total = 0;
+    for (uint32_t i = 0; i < PAGE_SIZE; i++) total += pageMask[i];
+    bool isCut = IsCut();
+    for (uint32_t i = 0; i < PAGE_SIZE; i++)
+    {
+        if (!pageMask[i]) continue;
+        if (isCut && ++count > total / 2) break;
+        HostFlash->memory[page + i] &= pageData[i];
+    }
+    if (isCut) CutPower();
+    HostFlash->programCount++;
+    busyUntil = osKernelGetTickCount() + HOST_FLASH_PROGRAM_TICKS;
+}
+
+/**
+ * @brief Erase an area aligned on its size
+ * @param size size of the area in bytes
+ */
+static void EraseArea(uint32_t size)
+{
+    uint32_t start = address & ~(size - 1U) & (HOST_FLASH_SIZE - 1U);
+    if (IsCut())
+    {
+        for (uint32_t i = 0; i < size / 2; i += 7) HostFlash->memory[start + i] = 0xFF;
+        CutPower();
+        return;
+    }
+    memset(&HostFlash->memory[start], 0xFF, size);
+    HostFlash->eraseCount += size / SECTOR_SIZE;
+    busyUntil = osKernelGetTickCount() + HOST_FLASH_ERASE_TICKS * (size / SECTOR_SIZE);
+}
+
+/**
+ * @brief Exchange one byte with the chip
+ * @param tx byte sent by the controller
+ * @return byte returned by the chip
+ */
+static uint8_t Exchange(uint8_t tx)
+{
+    uint32_t index = position++;
+    if (index == 0)
+    {
+        command = tx;
+        return 0xFF;
+    }
+    if (command == COMMAND_READ_STATUS)
+        return (uint8_t)((IsBusy() ? STATUS_BUSY : 0) | (isWriteEnabled ? STATUS_WEL : 0));
+    if (IsBusy()) return 0xFF;
+    if (index <= 3)
+    {
+        address = (address << 8 | tx) & 0xFFFFFFU;
+        if (index == 3 && command == COMMAND_PAGE_PROGRAM) memset(pageMask, 0, sizeof(pageMask));
+        return 0xFF;
+    }
+    switch (command)
+    {
+    case COMMAND_READ_DATA:
+        return HostFlash->memory[(address + index - 4) & (HOST_FLASH_SIZE - 1U)];
+    case COMMAND_FAST_READ:
+        return index == 4 ? 0xFF : HostFlash->memory[(address + index - 5) & (HOST_FLASH_SIZE - 1U)];
+    case COMMAND_MANUFACTURER_ID:
+        return (index & 1U) ? 0x17 : 0xEF;
+    case COMMAND_PAGE_PROGRAM:
+    {
+        // The column wraps inside the page, later bytes replace earlier ones
+        uint32_t column = (address + index - 4) & (PAGE_SIZE - 1U);
+        pageData[column] = tx;
+        pageMask[column] = true;
+        return 0xFF;
+    }
+    default:
+        return 0xFF;
+    }
+}
+
+/**
+ * @brief Execute the command ended by the chip select going high
+ */
+static void Execute(void)
+{
+    if (IsBusy()) return;
+    switch (command)
+    {
+    case COMMAND_WRITE_ENABLE:
+        isWriteEnabled = true;
+        return;
+    case COMMAND_WRITE_DISABLE:
+        isWriteEnabled = false;
+        return;
+    case COMMAND_PAGE_PROGRAM:
+        if (!isWriteEnabled || position < 5) return;
+        ProgramPage();
+        break;
+    case COMMAND_SECTOR_ERASE:
+        if (!isWriteEnabled || position != 4) return;
+        EraseArea(SECTOR_SIZE);
+        break;
+    case COMMAND_BLOCK_ERASE:
+        if (!isWriteEnabled || position != 4) return;
+        EraseArea(BLOCK_SIZE);
+        break;
+    case COMMAND_CHIP_ERASE:
+        if (!isWriteEnabled || position != 1) return;
+        address = 0;
+        EraseArea(HOST_FLASH_SIZE);
+        break;
+    default:
+        return;
+    }
+    isWriteEnabled = false;
+}
+
+/* ---------------------- spi.h ----------------------------------------- */
+void SPI_SetChipSelectLow(void)
+{
+    isSelected = true;
+    position = 0;
+}
+
+void SPI_SetChipSelectHigh(void)
+{
+    if (isSelected && !isPowerLost && position > 0) Execute();
+    isSelected = false;
+}
+
+bool SPI_TransmitReceive(const uint8_t *txBuff, uint8_t *rxBuff, uint32_t size)
+{
+    if (isPowerLost || !isSelected)
+    {
+        memset(rxBuff, 0, size);    // Nothing drives the data line
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) rxBuff[i] = Exchange(txBuff[i]);
+    return true;
+}
+
+bool SPI_Transmit(const uint8_t *txBuff, uint32_t size)
+{
+    if (isPowerLost || !isSelected) return false;
+    for (uint32_t i = 0; i < size; i++) Exchange(txBuff[i]);
+    return true;
+}
+
+bool SPI_Receive(uint8_t *rxBuff, uint32_t size)
+{
+    if (isPowerLost || !isSelected)
+    {
+        memset(rxBuff, 0, size);
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) rxBuff[i] = Exchange(0xFF);
+    return true;
+}
+
+/* ---------------------- Host control ---------------------------------- */
+/**
+ * @brief Erase the whole chip at once, as delivered
+ */
+void HostFlash_Erase(void)
+{
+    memset(HostFlash->memory, 0xFF, sizeof(HostFlash->memory));
+    HostFlash->programCount = 0;
+    HostFlash->eraseCount = 0;
+}
+
+/**
+ * @brief Whether the power was cut
+ */
+bool HostFlash_IsPowerLost(void)
+{
+    return isPowerLost;
+}
+
+/**
+ * @brief Run a part of the firmware until it returns or the power is cut
+ * The part runs in a child process: the RAM of every module, the page cache
+ * of the flash driver included, is lost at the cut and the next part boots
+ * from the flash alone. The part initializes what it uses.
+ * @param part the firmware to run, returns 0 to 127
+ * @param argument passed to the part
+ * @return the value returned by the part, HOST_FLASH_POWER_CUT if the power was cut
+ */
+int HostFlash_RunPowered(int (*part)(void *argument), void *argument)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        isPowered = true;
+        int result = part(argument);
+        fflush(stdout);
+        _exit(result & 0x7F);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+    {
+        fprintf(stderr, "host flash: powered part did not exit\n");
+        exit(3);
+    }
+    return WEXITSTATUS(status);
+}
+
+/**
+ * @brief Power the chip on again, no cut is pending
+ */
+void HostFlash_PowerOn(void)
+{
+    isPowerLost = false;
+    isWriteEnabled = false;
+    busyUntil = osKernelGetTickCount();
+    HostFlash->cutAfter = -1;
+}
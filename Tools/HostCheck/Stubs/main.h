@@ -0,0 +1,50 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for the CubeMX main.h of the firmware
+ *
+ * @details Gives the host checks what the modules use of the HAL and CMSIS
+ * core headers: the DWT cycle counter, SystemCoreClock, interrupt masking
+ * and assert_param. Interrupts do not exist on the host, masking them does
+ * nothing; a check calls the interrupt handlers of a module itself. The
+ * cycle counter is a plain variable the check sets to simulate time. The
+ * exclusive access pair always succeeds, the threads of host_os.c do not
+ * switch inside it.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cmsis_os2.h"
+
+/* ---------------------- Core ------------------------------------------ */
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+extern DWT_Type HostDwt;            // Cycle counter, advanced by the check
+#define DWT (&HostDwt)
+
+extern uint32_t SystemCoreClock;    // 168 MHz like the target
+
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __ISB(void) {}
+static inline uint32_t __CLZ(uint32_t value) { return value ? (uint32_t)__builtin_clz(value) : 32U; }
+static inline uint32_t __LDREXW(volatile uint32_t *address) { return *address; }
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *address) { *address = value; return 0; }
+static inline void __CLREX(void) {}
+
+/* ---------------------- Assertions ------------------------------------ */
+void HostCheck_AssertFailed(const char *file, int line);
+#define assert_param(expr) ((expr) ? (void)0 : HostCheck_AssertFailed(__FILE__, __LINE__))
@@ -0,0 +1,19 @@
+/**
+ * @file rtx_os.h
+ * @brief Host stand-in for the RTX5 kernel definitions
+ *
+ * @details Only the control block types the modules allocate statically.
+ * host_os.c keeps its own thread records and ignores the block.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+/* ---------------------- Control blocks -------------------------------- */
+typedef struct {
+    uint8_t memory[80];     // Size of the RTX5 thread control block on the target
+} osRtxThread_t;
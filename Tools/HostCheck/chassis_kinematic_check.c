@@ -0,0 +1,231 @@
+/**
+ * @file chassis_kinematic_check.c
+ * @brief Kinematic matrices of every chassis type against a model of the wheels
+ *
+ * @details Built once per chassis type by Tools/host_check.py, with
+ * DEFAULT_CHASSIS_TYPE and TOTAL_MOTOR_NUMBER given on the command line, so
+ * the builders this board does not compile are checked too.
+ *  - Inverse: the speed of every wheel is compared with a model of the
+ *    wheel alone, from its position, its drive direction and the direction
+ *    its rollers cannot slide in: speed = (v . n) / (r * (d . n)), v the
+ *    velocity of the chassis at the contact point.
+ *  - Round trip: forward(inverse(twist)) gives the twist back on the degrees
+ *    of freedom of the chassis, vy is dropped by the chassis that cannot
+ *    move sideways.
+ *  - Least squares: for random wheel speeds the forward twist leaves a
+ *    wheel residual orthogonal to every degree of freedom.
+ *  - A second geometry rebuilds the matrices, an invalid one keeps them.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "chassis_kinematic.h"
+#include "data_store.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define TOLERANCE       1e-5    // Relative to the largest value compared
+#define RANDOM_WHEELS   1000
+
+/**
+ * @brief Wheel of the model
+ */
+typedef struct {
+    float x, y;         // Position from the centre in m, x forward, y to the left
+    float driveX, driveY;   // Direction the wheel pushes when it turns forward
+    float normalX, normalY; // Direction the rollers cannot slide in
+} Wheel_t;
+
+typedef struct {
+    float radius;
+    float track;
+    float base;
+} Geometry_t;
+
+static const Geometry_t geometries[] = {
+    { (float)DEFAULT_WHEEL_RADIUS, (float)DEFAULT_TRACK_WIDTH, (float)DEFAULT_WHEEL_BASE },
+    { 0.05f, 0.3f, 0.25f },
+};
+
+static Geometry_t geometry = { (float)DEFAULT_WHEEL_RADIUS, (float)DEFAULT_TRACK_WIDTH, (float)DEFAULT_WHEEL_BASE };
+static double worstError;
+
+/* ---------------------- Data store stand-ins -------------------------- */
+float DataStore_GetWheelRadius(void) { return geometry.radius; }
+float DataStore_GetTrackWidth(void) { return geometry.track; }
+float DataStore_GetWheelBase(void) { return geometry.base; }
+
+/* ---------------------- Model ----------------------------------------- */
+#if DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_DIFF
+static const char *chassisName = "differential";
+static const bool isHolonomic = false;
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_SKID
+static const char *chassisName = "skid-steer";
+static const bool isHolonomic = false;
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_MECANUM
+static const char *chassisName = "mecanum";
+static const bool isHolonomic = true;
+#else
+static const char *chassisName = "omni, 3 wheels";
+static const bool isHolonomic = true;
+#endif
+
+/**
+ * @brief Wheels of the selected chassis in the order of chassis_kinematic.h
+ */
+static void BuildWheels(const Geometry_t *g, Wheel_t *wheels)
+{
+    float h = g->track / 2.0f;
+#if DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_DIFF
+    wheels[0] = (Wheel_t){ 0, h, 1, 0, 1, 0 };
+    wheels[1] = (Wheel_t){ 0, -h, 1, 0, 1, 0 };
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_SKID
+    // The tyres slip sideways when the chassis turns, only the forward speed is driven
+    float b = g->base / 2.0f;
+    wheels[0] = (Wheel_t){ b, h, 1, 0, 1, 0 };
+    wheels[1] = (Wheel_t){ b, -h, 1, 0, 1, 0 };
+    wheels[2] = (Wheel_t){ -b, h, 1, 0, 1, 0 };
+    wheels[3] = (Wheel_t){ -b, -h, 1, 0, 1, 0 };
+#elif DEFAULT_CHASSIS_TYPE == CHASSIS_TYPE_MECANUM
+    // Rollers in X seen from above: front left and rear right roll along x = y
+    float b = g->base / 2.0f;
+    wheels[0] = (Wheel_t){ b, h, 1, 0, 1, -1 };
+    wheels[1] = (Wheel_t){ b, -h, 1, 0, 1, 1 };
+    wheels[2] = (Wheel_t){ -b, h, 1, 0, 1, 1 };
+    wheels[3] = (Wheel_t){ -b, -h, 1, 0, 1, -1 };
+#else
+    // Front, rear left, rear right, on a circle of the track width, pushing counterclockwise
+    for (int i = 0; i < 3; i++)
+    {
+        double angle = i * 2.0 * M_PI / 3.0;
+        float c = (float)cos(angle), s = (float)sin(angle);
+        wheels[i] = (Wheel_t){ h * c, h * s, -s, c, -s, c };
+    }
+#endif
+}
+
+/**
+ * @brief Speed of a wheel for a twist, from the model
+ */
+static double ModelSpeed(const Wheel_t *wheel, const float *twist, float radius)
+{
+    double vx = twist[0] - twist[2] * wheel->y, vy = twist[1] + twist[2] * wheel->x;
+    double across = vx * wheel->normalX + vy * wheel->normalY;
+    return across / (radius * (wheel->driveX * wheel->normalX + wheel->driveY * wheel->normalY));
+}
+
+/**
+ * @brief Compare two vectors, keep the worst relative error
+ * @param scale smallest value the error is relative to
+ * @return true if they match within TOLERANCE
+ */
+static bool IsClose(const double *a, const double *b, int count, double scale)
+{
+    double error = 0;
+    for (int i = 0; i < count; i++) scale = fmax(scale, fmax(fabs(a[i]), fabs(b[i])));
+    for (int i = 0; i < count; i++) error = fmax(error, fabs(a[i] - b[i]) / scale);
+    if (error > worstError) worstError = error;
+    return error <= TOLERANCE;
+}
+
+/* ---------------------- Check ----------------------------------------- */
+/**
+ * @brief Check the matrices built for a geometry
+ * @return number of failed checks
+ */
+static int CheckGeometry(const Geometry_t *g)
+{
+    static const float twists[][CHASSIS_TWIST_SIZE] = {
+        { 0.5f, 0, 0 }, { 0, 0.3f, 0 }, { 0, 0, 1.2f }, { -0.4f, 0.2f, -0.7f }, { 1.0f, -0.5f, 3.0f },
+    };
+    Wheel_t wheels[CHASSIS_WHEEL_NUMBER];
+    int failures = 0;
+    BuildWheels(g, wheels);
+
+    for (size_t t = 0; t < sizeof(twists) / sizeof(twists[0]); t++)
+    {
+        float speeds[CHASSIS_WHEEL_NUMBER], back[CHASSIS_TWIST_SIZE];
+        double model[CHASSIS_WHEEL_NUMBER], actual[CHASSIS_WHEEL_NUMBER];
+        ChassisKinematic_Inverse(twists[t], speeds);
+        for (int i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+        {
+            actual[i] = speeds[i];
+            model[i] = ModelSpeed(&wheels[i], twists[t], g->radius);
+        }
+        if (!IsClose(actual, model, CHASSIS_WHEEL_NUMBER, 1e-6))
+        {
+            printf("  inverse of twist %zu differs from the wheel model\n", t);
+            failures++;
+        }
+        ChassisKinematic_Forward(speeds, back);
+        double expected[CHASSIS_TWIST_SIZE] = { twists[t][0], isHolonomic ? twists[t][1] : 0.0, twists[t][2] };
+        double result[CHASSIS_TWIST_SIZE] = { back[0], back[1], back[2] };
+        if (!IsClose(result, expected, CHASSIS_TWIST_SIZE, 1e-6))
+        {
+            printf("  round trip of twist %zu: %.6f %.6f %.6f\n", t, back[0], back[1], back[2]);
+            failures++;
+        }
+    }
+
+    // Normal equations: J^T (J F w - w) = 0 on the degrees of freedom, scaled to the wheel speeds
+    srand(1);
+    for (int n = 0; n < RANDOM_WHEELS; n++)
+    {
+        float speeds[CHASSIS_WHEEL_NUMBER], twist[CHASSIS_TWIST_SIZE];
+        for (int i = 0; i < CHASSIS_WHEEL_NUMBER; i++) speeds[i] = (float)(rand() / (double)RAND_MAX * 40.0 - 20.0);
+        ChassisKinematic_Forward(speeds, twist);
+        double residual[CHASSIS_WHEEL_NUMBER], zero[CHASSIS_TWIST_SIZE] = { 0 }, projection[CHASSIS_TWIST_SIZE] = { 0 };
+        for (int i = 0; i < CHASSIS_WHEEL_NUMBER; i++) residual[i] = ModelSpeed(&wheels[i], twist, g->radius) - speeds[i];
+        for (int axis = 0; axis < CHASSIS_TWIST_SIZE; axis++)
+        {
+            if (axis == 1 && !isHolonomic) continue;
+            float unit[CHASSIS_TWIST_SIZE] = { 0 };
+            unit[axis] = 1.0f;
+            for (int i = 0; i < CHASSIS_WHEEL_NUMBER; i++)
+                projection[axis] += residual[i] * ModelSpeed(&wheels[i], unit, g->radius) * g->radius / 20.0;
+        }
+        if (!IsClose(projection, zero, CHASSIS_TWIST_SIZE, 1.0))
+        {
+            printf("  forward is not the least squares twist of wheels %d\n", n);
+            failures++;
+            break;
+        }
+    }
+    return failures;
+}
+
+int main(void)
+{
+    int failures = 0;
+    ChassisKinematic_Init();
+    printf("%s chassis, %d wheels\n", chassisName, CHASSIS_WHEEL_NUMBER);
+    for (size_t g = 0; g < sizeof(geometries) / sizeof(geometries[0]); g++)
+    {
+        if (g > 0 && !ChassisKinematic_SetGeometry(geometries[g].radius, geometries[g].track, geometries[g].base))
+        {
+            printf("  geometry %zu refused\n", g);
+            failures++;
+            continue;
+        }
+        int geometryFailures = CheckGeometry(&geometries[g]);
+        printf("geometry r=%.3f track=%.3f base=%.3f: %s\n", geometries[g].radius, geometries[g].track,
+               geometries[g].base, geometryFailures ? "FAILED" : "inverse, round trip and least squares hold");
+        failures += geometryFailures;
+    }
+
+    // An invalid geometry is refused and the matrices stay
+    const Geometry_t *last = &geometries[sizeof(geometries) / sizeof(geometries[0]) - 1];
+    bool isRefused = !ChassisKinematic_SetGeometry(0.0f, 0.2f, 0.2f) && !ChassisKinematic_SetGeometry(0.05f, NAN, 0.2f) &&
+                     !ChassisKinematic_SetGeometry(0.05f, 0.2f, -1.0f);
+    int keptFailures = CheckGeometry(last);
+    printf("invalid geometries: %s, matrices %s\n", isRefused ? "refused" : "NOT refused", keptFailures ? "NOT kept" : "kept");
+    if (!isRefused || keptFailures) failures++;
+
+    printf("worst relative error %.1e\n", worstError);
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file data_store_check.c
+ * @brief Coalescing of the parameter saves of the data store
+ *
+ * @details The data store runs over the real key/value store, flash driver
+ * and memory pools, the SPI flash is simulated. The check is a tool thread
+ * setting parameters while the data store thread commits them:
+ *  - A burst of 20 requests inside DATA_STORE_SAVE_DEBOUNCE gives one commit.
+ *  - Requests at 10 Hz right after a commit wait for
+ *    DATA_STORE_SAVE_MIN_INTERVAL, and a flush commits them at once.
+ *  - A single request right after a commit waits the minimum interval.
+ *  - A tool writing at 10 Hz for a minute, compared with one commit per
+ *    request like before the coalescing.
+ *  - The gains of the last motor notify its own key and are stored under
+ *    it, also built with TOTAL_MOTOR_NUMBER=4 by Tools/host_check.py.
+ * Times are kernel ticks of the simulation, programs and erases take the
+ * busy time of the chip.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "data_store.h"
+#include "kv_store.h"
+#include "flight_recorder.h"
+#include "mem_pool.h"
+#include "host_flash.h"
+#include "system_config.h"
+#include "cmsis_os2.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define TOOL_PERIOD     100     // ms between two writes of a tool at 10 Hz
+#define LONG_RUN        60000   // ms of the long run
+#define CHANGE_FLAG     0x0001U
+
+static int failures;
+
+/* ---------------------- Flight recorder stand-ins --------------------- */
+static uint32_t parameterRecords;   // Parameter changes logged
+
+bool FlightRecorder_Log(FlightRecordType_t type, const void *payload, uint32_t size)
+{
+    (void)payload; (void)size;
+    if (type == FLIGHT_RECORD_PARAMETER) parameterRecords++;
+    return true;
+}
+
+void FlightRecorder_Flush(void) {}
+
+/* ---------------------- Check ----------------------------------------- */
+/**
+ * @brief Print the persistence statistics and check them
+ * @param what step of the check
+ * @param start tick count at the start of the step
+ * @param commits expected commits since boot
+ * @param isPending expected pending flag
+ */
+static void Expect(const char *what, uint32_t start, uint32_t commits, bool isPending)
+{
+    DataStore_PersistenceStats_t stats;
+    DataStore_GetPersistenceStats(&stats);
+    bool isMet = stats.commitCount == commits && stats.isPending == isPending;
+    printf("%-44s +%5u ms  requests %4u  commits %3u  records %4u  pending %d%s\n", what,
+           (unsigned)(osKernelGetTickCount() - start), (unsigned)stats.requestCount, (unsigned)stats.commitCount,
+           (unsigned)stats.recordCount, stats.isPending, isMet ? "" : "  <- FAIL");
+    if (!isMet) failures++;
+}
+
+/**
+ * @brief Read a float parameter back from the flash
+ * @param key key of the parameter
+ * @return the stored value, -1 if absent
+ */
+static float ReadBack(uint16_t key)
+{
+    KVStore_t store;
+    float value = -1.0f;
+    KVStore_Init(&store, EXT_FLASH_PARAMETER_KV_ADDRESS, EXT_FLASH_PARAMETER_KV_SIZE);
+    store.Read(&store, key, &value, sizeof(value));
+    return value;
+}
+
+int main(void)
+{
+    HostFlash_Erase();
+    MemPool_Init();
+    DataStore_Init();
+    osKernelStart();
+    DataStore_PersistenceStats_t stats;
+    DataStore_GetPersistenceStats(&stats);
+    uint32_t bootRecords = stats.recordCount;  // First boot, every parameter written
+    osDelay(100);
+
+    // A: a burst inside the debounce window
+    uint32_t start = osKernelGetTickCount();
+    for (int i = 0; i < 20; i++)
+    {
+        DataStore_SetMaxVelocity(1.0f + i * 0.01f);
+        DataStore_SaveDataIfModified();
+        osDelay(10);
+    }
+    Expect("A: 20 requests in 200 ms", start, 0, true);
+    osDelay(DATA_STORE_SAVE_DEBOUNCE);
+    Expect("A: after the debounce window", start, 1, false);
+    DataStore_GetPersistenceStats(&stats);
+    if (stats.recordCount != bootRecords + 1) failures++;
+
+    // B: a tool at 10 Hz right after the commit
+    start = osKernelGetTickCount();
+    for (int i = 0; i < 30; i++)
+    {
+        DataStore_SetMaxOmega(1.0f + i * 0.01f);
+        DataStore_SaveDataIfModified();
+        osDelay(TOOL_PERIOD);
+    }
+    Expect("B: 30 requests at 10 Hz", start, 1, true);
+
+    // C: a flush ends the minimum interval
+    uint32_t flushStart = osKernelGetTickCount();
+    bool isFlushed = DataStore_Flush();
+    uint32_t flushTicks = osKernelGetTickCount() - flushStart;
+    Expect("C: flush", start, 2, false);
+    printf("   flush returned %d after %u ms, max omega in flash %.2f\n", isFlushed, (unsigned)flushTicks,
+           ReadBack(DATA_STORE_KEY_MAX_OMEGA));
+    if (!isFlushed || flushTicks >= DATA_STORE_FLUSH_TIMEOUT || ReadBack(DATA_STORE_KEY_MAX_OMEGA) != 1.0f + 29 * 0.01f)
+        failures++;
+
+    // D: a single request right after a commit
+    start = osKernelGetTickCount();
+    DataStore_SetWheelBase(0.2f);
+    DataStore_SaveDataIfModified();
+    osDelay(DATA_STORE_SAVE_MIN_INTERVAL - 1000);
+    Expect("D: 4 s after a request", start, 2, true);
+    osDelay(1200);
+    Expect("D: 5.2 s after a request", start, 3, false);
+
+    // E: a tool at 10 Hz for a minute
+    DataStore_GetPersistenceStats(&stats);
+    uint32_t requests = stats.requestCount, commits = stats.commitCount, records = stats.recordCount;
+    uint32_t programs = HostFlash->programCount, logged = parameterRecords;
+    start = osKernelGetTickCount();
+    for (int i = 0; i < LONG_RUN / TOOL_PERIOD; i++)
+    {
+        DataStore_SetMaxVelocity(2.0f + (i % 50) * 0.01f);
+        DataStore_SaveDataIfModified();
+        osDelay(TOOL_PERIOD);
+    }
+    DataStore_Flush();
+    DataStore_GetPersistenceStats(&stats);
+    requests = stats.requestCount - requests;
+    commits = stats.commitCount - commits;
+    records = stats.recordCount - records;
+    printf("E: 10 Hz for %u s: %u requests, %u commits, %u records, %u page programs, %u flight records\n",
+           LONG_RUN / 1000U, (unsigned)requests, (unsigned)commits, (unsigned)records,
+           (unsigned)(HostFlash->programCount - programs), (unsigned)(parameterRecords - logged));
+    printf("   one commit per request would have written %u records\n", (unsigned)requests);
+    if (commits > LONG_RUN / DATA_STORE_SAVE_MIN_INTERVAL + 1) failures++;
+    if (ReadBack(DATA_STORE_KEY_MAX_VELOCITY) != 2.0f + ((LONG_RUN / TOOL_PERIOD - 1) % 50) * 0.01f) failures++;
+
+    // F: the keys of the last motor
+    uint32_t motorId = TOTAL_MOTOR_NUMBER - 1;
+    DataStoreKey_t key = DATA_STORE_MOTOR_KEY(DATA_STORE_MOTOR_GAINS, motorId);
+    DataStore_MotorGains_t gains, stored = { 0 };
+    DataStore_GetMotorGains(motorId, &gains);
+    gains.kP += 0.5f;
+    DataStore_Subscribe(DATA_STORE_KEY_MASK(key), osThreadGetId(), CHANGE_FLAG);
+    DataStore_SetMotorGains(motorId, &gains);
+    bool isNotified = (osThreadFlagsWait(CHANGE_FLAG, osFlagsWaitAny, 0) & CHANGE_FLAG) != 0;
+    DataStore_SaveDataIfModified();
+    DataStore_Flush();
+    KVStore_t store;
+    KVStore_Init(&store, EXT_FLASH_PARAMETER_KV_ADDRESS, EXT_FLASH_PARAMETER_KV_SIZE);
+    bool isStored = store.Read(&store, key, &stored, sizeof(stored)) == (int32_t)sizeof(stored) &&
+                    memcmp(&stored, &gains, sizeof(gains)) == 0;
+    printf("F: gains of motor %u under key %u: %s, %s\n", (unsigned)motorId, (unsigned)key,
+           isNotified ? "notified" : "NOT notified", isStored ? "stored" : "NOT stored");
+    if (!isNotified || !isStored) failures++;
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
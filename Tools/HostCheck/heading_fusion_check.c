@@ -0,0 +1,230 @@
+/**
+ * @file heading_fusion_check.c
+ * @brief Heading error of the wheel odometry alone and fused with a gyro
+ *
+ * @details
+ *  - Gyro: samples of a varying rate pushed at 1 kHz must add up to the
+ *    angle turned between two takes, and a gyro silent for longer than
+ *    GYRO_MAX_SAMPLE_AGE must not be used.
+ *  - Slip scenarios: 300 s runs after a 2 s park, the encoders quantised to
+ *    1560 edges per turn and slipping as described by each scenario. The
+ *    simulated MEMS gyro has a 0.01 rad/s bias, a 0.5 % scale error and
+ *    0.003 rad/s of noise; it reports the mean rate of each 5 ms, pushed
+ *    like its DMA complete interrupt would, and the odometry takes the angle
+ *    gathered at each 20 ms control period like EncoderCallback does.
+ *  - Passes if the fused heading beats the wheels in every scenario and its
+ *    RMS error stays under 10 degrees.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "two_wheel_odometry.h"
+#include "gyro.h"
+#include "data_store.h"
+#include "main.h"
+#include "system_config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define STEP_S          0.02    // Control period
+#define GYRO_SAMPLES    4       // Gyro samples per control period, 200 Hz
+#define RESOLUTION      1560    // Encoder edges per wheel turn
+#define RADIUS          0.032   // Wheel radius in m
+#define TRACK           0.164   // Track width in m
+#define RUN_S           300.0
+#define PARK_S          2.0     // Standing still at the start, the bias is measured
+#define GYRO_BIAS       0.01    // rad/s
+#define GYRO_SCALE      1.005
+#define GYRO_NOISE      0.003   // rad/s
+#define MAX_FUSED_RMS   10.0    // degrees
+
+static const char *scenarioNames[] = {
+    "weave, wet patches under one wheel",
+    "spin in place on carpet",
+    "random slip bursts",
+    "wheel spin at acceleration",
+};
+
+static uint64_t cycles;     // Simulated time, continued over the runs
+
+/* ---------------------- Data store stand-ins -------------------------- */
+float DataStore_GetWheelRadius(void) { return (float)RADIUS; }
+float DataStore_GetTrackWidth(void) { return (float)TRACK; }
+bool DataStore_GetOdometryNoise(DataStore_OdometryNoise_t *noise)
+{
+    noise->wheelSlip[0] = noise->wheelSlip[1] = 1e-4f;
+    noise->speedVariance[0] = noise->speedVariance[1] = 1e-5f;
+    return true;
+}
+
+/* ---------------------- Simulation ------------------------------------ */
+static double Gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static double Uniform(void)
+{
+    return rand() / (double)RAND_MAX;
+}
+
+static void Advance(double seconds)
+{
+    cycles += (uint64_t)llround(seconds * SystemCoreClock);
+    HostDwt.CYCCNT = (uint32_t)cycles;
+}
+
+/**
+ * @brief Commanded body speeds and slip of each wheel at time t
+ * The slip is the measured over the true travel of the wheel, minus one.
+ */
+static void Scenario(int scenario, double t, double *v, double *w, double *slipL, double *slipR)
+{
+    static double burstL, burstR;
+    *slipL = *slipR = 0.0;
+    *v = *w = 0.0;
+    if (t < PARK_S) return;
+    switch (scenario)
+    {
+    case 0:     // Weaving on a floor with wet patches under the left wheel
+        *v = 0.6;
+        *w = 0.3 * sin(0.2 * t);
+        if (fmod(t, 6.0) < 0.8) *slipL = 0.35;
+        break;
+    case 1:     // Spinning in place on carpet, both wheels over-rotate
+        *w = fmod(t, 20.0) < 10.0 ? 1.5 : -1.5;
+        *slipL = *slipR = 0.12;
+        break;
+    case 2:     // Random slip bursts on both wheels
+        *v = 0.5 + 0.3 * sin(0.1 * t);
+        *w = 0.8 * sin(0.35 * t);
+        if (Uniform() < 0.01) { burstL = Uniform() * 0.5; burstR = Uniform() * 0.5; }
+        if (Uniform() < 0.05) burstL = burstR = 0.0;
+        *slipL = burstL;
+        *slipR = burstR;
+        break;
+    default:    // Straight runs with hard accelerations, the drive wheel spins
+    {
+        double phase = fmod(t, 30.0);
+        *v = phase < 25.0 ? 0.8 : 0.0;
+        if (phase < 0.6 || (phase > 25.0 && phase < 25.4)) { *slipL = 0.6; *slipR = 0.2; }
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Run a scenario
+ * @param scenario index of the scenario
+ * @param useGyro true to feed the gyro to the odometry
+ * @param rms returns the RMS heading error in degrees
+ * @param final returns the heading error at the end in degrees
+ */
+static void Run(int scenario, bool useGyro, double *rms, double *final)
+{
+    srand(7);
+    TwoWheelOdometry_Init();
+    float flushed;
+    Gyro_TakeTurn(&flushed, HostDwt.CYCCNT);
+
+    double x = 0.0, y = 0.0, theta = 0.0, angleL = 0.0, angleR = 0.0, sum = 0.0, error = 0.0;
+    long long lastL = 0, lastR = 0;
+    long steps = (long)(RUN_S / STEP_S);
+    for (long k = 0; k < steps; k++)
+    {
+        double t = k * STEP_S, v, w, slipL, slipR;
+        Scenario(scenario, t, &v, &w, &slipL, &slipR);
+        // True motion of the step, an arc
+        double dL = (v - w * TRACK / 2.0) * STEP_S, dR = (v + w * TRACK / 2.0) * STEP_S;
+        double dS = (dL + dR) / 2.0, dTheta = (dR - dL) / TRACK, half = dTheta / 2.0;
+        double sinc = fabs(half) < 1e-12 ? 1.0 : sin(half) / half;
+        x += dS * sinc * cos(theta + half);
+        y += dS * sinc * sin(theta + half);
+        theta += dTheta;
+
+        // Gyro samples during the step
+        for (int i = 0; i < GYRO_SAMPLES; i++)
+        {
+            Advance(STEP_S / GYRO_SAMPLES);
+            if (useGyro) Gyro_PushSample((float)(w * GYRO_SCALE + GYRO_BIAS + GYRO_NOISE * Gauss()), HostDwt.CYCCNT);
+        }
+
+        // Encoders at the end of the step, the wheel rotation includes the slip
+        angleL += dL * (1.0 + slipL) / RADIUS;
+        angleR += dR * (1.0 + slipR) / RADIUS;
+        long long countL = (long long)floor(angleL * RESOLUTION / (2.0 * M_PI));
+        long long countR = (long long)floor(angleR * RESOLUTION / (2.0 * M_PI));
+        const float radiansPerCount = (float)(2.0 * M_PI / RESOLUTION);
+        float delta[2] = { (float)(countL - lastL) * radiansPerCount, (float)(countR - lastR) * radiansPerCount };
+        lastL = countL;
+        lastR = countR;
+        float gyroTurn;
+        bool hasGyro = Gyro_TakeTurn(&gyroTurn, HostDwt.CYCCNT);
+        TwoWheelOdometry_Update(delta, hasGyro ? &gyroTurn : NULL, (float)STEP_S, HostDwt.CYCCNT);
+
+        TwoWheelOdometry_State_t state;
+        TwoWheelOdometry_GetState(&state);
+        double estimate = (int32_t)state.pose.heading * (2.0 * M_PI / 4294967296.0);
+        error = fabs(remainder(estimate - theta, 2.0 * M_PI));
+        sum += error * error;
+    }
+    *rms = sqrt(sum / steps) * 180.0 / M_PI;
+    *final = error * 180.0 / M_PI;
+}
+
+/**
+ * @brief Gyro samples faster than the control period all count
+ * @return number of failures
+ */
+static int CheckGyroTurn(void)
+{
+    int failures = 0;
+    float turn;
+    Gyro_TakeTurn(&turn, HostDwt.CYCCNT);
+    // 1 kHz samples of a rate swinging within each period, taken every 20 ms
+    double t = 0.0, trueTurn = 0.0, worst = 0.0;
+    for (int period = 0; period < 50; period++)
+    {
+        double start = t;
+        for (int i = 0; i < 20; i++)
+        {
+            Advance(0.001);
+            t += 0.001;
+            Gyro_PushSample((float)(2.0 * sin(2.0 * M_PI * 7.0 * t)), HostDwt.CYCCNT);
+        }
+        trueTurn = 2.0 * (cos(2.0 * M_PI * 7.0 * start) - cos(2.0 * M_PI * 7.0 * t)) / (2.0 * M_PI * 7.0);
+        if (!Gyro_TakeTurn(&turn, HostDwt.CYCCNT)) failures++;
+        else if (period > 0 && fabs(turn - trueTurn) > worst) worst = fabs(turn - trueTurn);
+    }
+    printf("gyro turn of 1 kHz samples over 20 ms: worst error %.2e rad\n", worst);
+    if (worst > 1e-3) failures++;
+
+    // A silent gyro is not used
+    Advance(GYRO_MAX_SAMPLE_AGE / 1000.0 + 0.01);
+    if (Gyro_TakeTurn(&turn, HostDwt.CYCCNT))
+    {
+        printf("stale gyro still used\n");
+        failures++;
+    }
+    return failures;
+}
+
+int main(void)
+{
+    int failures = CheckGyroTurn();
+    printf("%-38s %12s %12s %12s %12s\n", "scenario, 300 s", "wheels rms", "wheels end", "fused rms", "fused end");
+    for (int s = 0; s < 4; s++)
+    {
+        double wheelRms, wheelFinal, fusedRms, fusedFinal;
+        Run(s, false, &wheelRms, &wheelFinal);
+        Run(s, true, &fusedRms, &fusedFinal);
+        printf("%-38s %12.2f %12.2f %12.2f %12.2f\n", scenarioNames[s], wheelRms, wheelFinal, fusedRms, fusedFinal);
+        if (fusedRms >= wheelRms || fusedRms > MAX_FUSED_RMS) failures++;
+    }
+    return failures != 0;
+}
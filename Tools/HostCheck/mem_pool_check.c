@@ -0,0 +1,177 @@
+/**
+ * @file mem_pool_check.c
+ * @brief Alloc/free pairs per second of the pools, magazines and block stack
+ *
+ * @details
+ *  - Correctness: a million random allocs and frees of 1 to 900 bytes
+ *    through a magazine leave no block allocated after a flush, a block
+ *    freed twice is rejected, the block stack hands out exactly its
+ *    preloaded blocks in LIFO order.
+ *  - Benchmark: alloc/free pairs of 200 bytes, one at a time and in bursts
+ *    of 6 like a UDP frame batch, through MemPool_Alloc/Free, a magazine
+ *    and the block stack. Kernel calls are the memory pool calls counted
+ *    by host_os.c; each is an SVC with interrupts masked on the target.
+ *  - Passes if the magazine and the block stack make no kernel call once
+ *    warmed up, bursts included.
+ * The rates are those of the host build with the host pool stand-in, which
+ * costs little next to an SVC; the target gains at least the kernel calls
+ * saved per pair.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "mem_pool.h"
+#include "cmsis_os2.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define PAIRS           20000000L
+#define BURST           6           // Blocks held at once in the burst runs
+#define BLOCK_SIZE      200U
+#define STACK_BLOCKS    10U
+#define STACK_SIZE      100U        // Block size of the stack, another class than BLOCK_SIZE
+#define RANDOM_OPS      1000000
+
+static int failures;
+
+/**
+ * @brief Monotonic time in seconds
+ */
+static double Now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Print one benchmark line
+ * @param what front end and pattern
+ * @param pairs alloc/free pairs done
+ * @param seconds time taken
+ * @param calls kernel calls made
+ */
+static void Report(const char *what, long pairs, double seconds, uint32_t calls)
+{
+    printf("%-28s %7.1f M pairs/s  %.4f kernel calls/pair\n", what, pairs / seconds / 1e6, (double)calls / pairs);
+}
+
+/* ---------------------- Correctness ----------------------------------- */
+/**
+ * @brief Random allocs and frees through a magazine, then a double free
+ */
+static void CheckMagazine(MemPool_Magazine_t *magazine)
+{
+    void *held[100] = { 0 };
+    srand(1);
+    for (int i = 0; i < RANDOM_OPS; i++)
+    {
+        int k = rand() % 100;
+        if (held[k] != NULL)
+        {
+            if (!MemPool_MagazineFree(magazine, held[k])) failures++;
+            held[k] = NULL;
+        }
+        else
+        {
+            held[k] = MemPool_MagazineAlloc(magazine, 1U + (uint32_t)rand() % 900U);
+        }
+    }
+    for (int k = 0; k < 100; k++)
+    {
+        if (held[k] != NULL && !MemPool_MagazineFree(magazine, held[k])) failures++;
+    }
+    MemPool_MagazineFlush(magazine);
+    uint32_t leaked = MemPool_GetAllocatedCount();
+    void *block = MemPool_MagazineAlloc(magazine, 100U);
+    bool isFreed = MemPool_MagazineFree(magazine, block);
+    bool isDoubleFreeRejected = !MemPool_MagazineFree(magazine, block);
+    MemPool_MagazineFlush(magazine);
+    printf("magazine: %d random operations, %u blocks left after flush, double free %s\n", RANDOM_OPS,
+           (unsigned)leaked, isDoubleFreeRejected ? "rejected" : "NOT rejected");
+    if (leaked != 0 || !isFreed || !isDoubleFreeRejected) failures++;
+}
+
+/**
+ * @brief Drain, refill and drain again a preloaded block stack
+ */
+static void CheckStack(MemPool_Stack_t *stack)
+{
+    void *blocks[STACK_BLOCKS];
+    bool isMet = MemPool_StackInit(stack, STACK_SIZE, STACK_BLOCKS);
+    for (uint32_t i = 0; i < STACK_BLOCKS; i++)
+    {
+        blocks[i] = MemPool_StackPop(stack);
+        if (blocks[i] == NULL) isMet = false;
+    }
+    if (MemPool_StackPop(stack) != NULL) isMet = false;
+    for (uint32_t i = 0; i < STACK_BLOCKS; i++) MemPool_StackPush(stack, blocks[i]);
+    for (uint32_t i = 0; i < STACK_BLOCKS; i++)
+    {
+        void *block = MemPool_StackPop(stack);
+        if (block != blocks[STACK_BLOCKS - 1 - i]) isMet = false;
+        blocks[STACK_BLOCKS - 1 - i] = block;
+    }
+    for (uint32_t i = 0; i < STACK_BLOCKS; i++) MemPool_StackPush(stack, blocks[i]);
+    printf("block stack: %u blocks, empty when drained, LIFO %s\n", STACK_BLOCKS, isMet ? "kept" : "NOT kept");
+    if (!isMet) failures++;
+}
+
+/* ---------------------- Benchmark ------------------------------------- */
+int main(void)
+{
+    MemPool_Init();
+    MemPool_Magazine_t magazine = { 0 };
+    MemPool_Stack_t stack;
+    CheckMagazine(&magazine);
+    CheckStack(&stack);
+
+    void *burst[BURST];
+    uint32_t calls = HostOs_PoolCalls;
+    double start = Now();
+    for (long i = 0; i < PAIRS; i++) MemPool_Free(MemPool_Alloc(BLOCK_SIZE));
+    Report("pool, one at a time", PAIRS, Now() - start, HostOs_PoolCalls - calls);
+
+    MemPool_MagazineFree(&magazine, MemPool_MagazineAlloc(&magazine, BLOCK_SIZE));  // First refill
+    calls = HostOs_PoolCalls;
+    start = Now();
+    for (long i = 0; i < PAIRS; i++) MemPool_MagazineFree(&magazine, MemPool_MagazineAlloc(&magazine, BLOCK_SIZE));
+    uint32_t magazineCalls = HostOs_PoolCalls - calls;
+    Report("magazine, one at a time", PAIRS, Now() - start, magazineCalls);
+
+    calls = HostOs_PoolCalls;
+    start = Now();
+    for (long i = 0; i < PAIRS / BURST; i++)
+    {
+        for (int j = 0; j < BURST; j++) burst[j] = MemPool_Alloc(BLOCK_SIZE);
+        for (int j = 0; j < BURST; j++) MemPool_Free(burst[j]);
+    }
+    Report("pool, bursts of 6", PAIRS / BURST * BURST, Now() - start, HostOs_PoolCalls - calls);
+
+    calls = HostOs_PoolCalls;
+    start = Now();
+    for (long i = 0; i < PAIRS / BURST; i++)
+    {
+        for (int j = 0; j < BURST; j++) burst[j] = MemPool_MagazineAlloc(&magazine, BLOCK_SIZE);
+        for (int j = 0; j < BURST; j++) MemPool_MagazineFree(&magazine, burst[j]);
+    }
+    uint32_t burstCalls = HostOs_PoolCalls - calls;
+    Report("magazine, bursts of 6", PAIRS / BURST * BURST, Now() - start, burstCalls);
+
+    calls = HostOs_PoolCalls;
+    start = Now();
+    for (long i = 0; i < PAIRS; i++) MemPool_StackPush(&stack, MemPool_StackPop(&stack));
+    uint32_t stackCalls = HostOs_PoolCalls - calls;
+    Report("block stack, one at a time", PAIRS, Now() - start, stackCalls);
+
+    // The first burst refills the magazine once, it then holds the whole burst
+    if (magazineCalls != 0 || stackCalls != 0 || burstCalls > MEMPOOL_MAGAZINE_SIZE) failures++;
+    MemPool_MagazineFlush(&magazine);
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
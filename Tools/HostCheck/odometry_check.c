@@ -0,0 +1,201 @@
+/**
+ * @file odometry_check.c
+ * @brief Accuracy of the fixed point odometry against the old float odometry over hours
+ *
+ * @details Both integrate the same quantised encoder counts, 1560 edges per
+ * wheel turn at the 50 Hz of the control period, for three hours:
+ *  - weave at about 1 m/s, kilometres away from the origin;
+ *  - circle of 2 m radius at 0.5 m/s;
+ *  - random wheel speeds.
+ * The reference integrates exact arcs of the same counts in long double, so
+ * only the arithmetic of the odometry is measured, not the encoders. The
+ * old odometry of the firmware is kept here: float positions of the
+ * absolute counts, midpoint steps, float pose. It used arm_sin_f32 and
+ * arm_cos_f32, the host takes sinf and cosf.
+ * Passes if the new odometry stays within MAX_POSITION_ERROR and
+ * MAX_HEADING_ERROR of the reference and beats the old one in every run.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "two_wheel_odometry.h"
+#include "data_store.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define RESOLUTION          1560        // Encoder edges per wheel turn
+#define RADIUS              0.032f      // Wheel radius in m
+#define TRACK               0.164f      // Track width in m
+#define STEP_S              0.02
+#define RUN_HOURS           3.0
+#define SAMPLE_STEPS        500         // Errors sampled every 10 s
+#define MAX_POSITION_ERROR  0.02        // m
+#define MAX_HEADING_ERROR   1e-3        // rad
+#define PI_L                3.14159265358979323846264338327950288L
+
+static const char *scenarioNames[] = {
+    "weave at 1 m/s",
+    "circle r=2 m at 0.5 m/s",
+    "random wheel speeds",
+};
+
+/* ---------------------- Data store stand-ins -------------------------- */
+float DataStore_GetWheelRadius(void) { return RADIUS; }
+float DataStore_GetTrackWidth(void) { return TRACK; }
+bool DataStore_GetOdometryNoise(DataStore_OdometryNoise_t *noise)
+{
+    noise->wheelSlip[0] = noise->wheelSlip[1] = 1e-4f;
+    noise->speedVariance[0] = noise->speedVariance[1] = 1e-5f;
+    return true;
+}
+
+/* ---------------------- Old odometry ---------------------------------- */
+/**
+ * @brief Pose of the old odometry
+ */
+typedef struct {
+    float lastPositionL, lastPositionR;
+    float x, y, theta;
+} OldOdometry_t;
+
+/**
+ * @brief TwoWheelOdometry_Update of the old firmware
+ * @param odometry the pose
+ * @param wheelPosArray absolute wheel positions in radians
+ */
+static void OldOdometry_Update(OldOdometry_t *odometry, const float *wheelPosArray)
+{
+    float positionL = wheelPosArray[0] * RADIUS;
+    float positionR = wheelPosArray[1] * RADIUS;
+    float deltaL = positionL - odometry->lastPositionL;
+    float deltaR = positionR - odometry->lastPositionR;
+    odometry->lastPositionL = positionL;
+    odometry->lastPositionR = positionR;
+
+    float dS = (deltaL + deltaR) / 2.0f;
+    float dTheta = (deltaR - deltaL) / TRACK;
+    if (dTheta < 1e-6f && dTheta > -1e-6f)
+    {
+        odometry->x += dS * cosf(odometry->theta);
+        odometry->y += dS * sinf(odometry->theta);
+    }
+    else
+    {
+        odometry->x += dS * cosf(odometry->theta + dTheta / 2.0f);
+        odometry->y += dS * sinf(odometry->theta + dTheta / 2.0f);
+        odometry->theta += dTheta;
+        while (odometry->theta > (float)M_PI) odometry->theta -= 2.0f * (float)M_PI;
+        while (odometry->theta < -(float)M_PI) odometry->theta += 2.0f * (float)M_PI;
+    }
+}
+
+/* ---------------------- Reference ------------------------------------- */
+typedef struct {
+    long double x, y, theta;
+} Truth_t;
+
+/**
+ * @brief Move along the exact arc of two wheel rotations
+ */
+static void Truth_Update(Truth_t *truth, long double deltaL, long double deltaR)
+{
+    long double dS = (deltaL + deltaR) * RADIUS / 2, dTheta = (deltaR - deltaL) * RADIUS / TRACK;
+    long double half = dTheta / 2, chord = fabsl(half) < 1e-12L ? 1 : sinl(half) / half;
+    truth->x += dS * chord * cosl(truth->theta + half);
+    truth->y += dS * chord * sinl(truth->theta + half);
+    truth->theta += dTheta;
+}
+
+/* ---------------------- Check ----------------------------------------- */
+/**
+ * @brief Wheel speeds of a scenario in rad/s
+ */
+static void Scenario(int scenario, double t, double *speedL, double *speedR)
+{
+    switch (scenario)
+    {
+    case 0:
+        *speedL = 31.25 + 0.5 * sin(t * 0.05);
+        *speedR = 31.25 + 0.5 * sin(t * 0.05 + 1);
+        break;
+    case 1:
+        *speedL = (0.5 - 0.25 * TRACK / 2) / RADIUS;
+        *speedR = (0.5 + 0.25 * TRACK / 2) / RADIUS;
+        break;
+    default:
+        *speedL = fmin(35.0, fmax(-10.0, *speedL + (rand() / (double)RAND_MAX - 0.5) * 2));
+        *speedR = fmin(35.0, fmax(-10.0, *speedR + (rand() / (double)RAND_MAX - 0.5) * 2));
+        break;
+    }
+}
+
+/**
+ * @brief Heading difference in -PI to PI
+ */
+static double HeadingError(long double heading, long double reference)
+{
+    return (double)fabsl(remainderl(heading - reference, 2 * PI_L));
+}
+
+int main(void)
+{
+    int failures = 0;
+    printf("%-24s %9s %27s %25s\n", "", "distance", "max position error in mm", "final heading error");
+    printf("%-24s %9s %13s %13s %12s %12s\n", "", "from 0 m", "new", "old", "new", "old");
+    for (int scenario = 0; scenario < 3; scenario++)
+    {
+        srand(1);
+        TwoWheelOdometry_Init();
+        TwoWheelOdometry_Reset();
+        OldOdometry_t old = { 0 };
+        Truth_t truth = { 0 };
+        double angleL = 0, angleR = 0, speedL = 0, speedR = 0, maxNew = 0, maxOld = 0;
+        long long countL = 0, countR = 0;
+        const float radiansPerCount = (float)(2 * M_PI / RESOLUTION);
+        long steps = (long)(RUN_HOURS * 3600 / STEP_S);
+        for (long k = 0; k < steps; k++)
+        {
+            Scenario(scenario, k * STEP_S, &speedL, &speedR);
+            angleL += speedL * STEP_S;
+            angleR += speedR * STEP_S;
+            long long nextL = (long long)floor(angleL * RESOLUTION / (2 * M_PI));
+            long long nextR = (long long)floor(angleR * RESOLUTION / (2 * M_PI));
+            // UpdateOdometry of motion_control.c: increments of the 64-bit counts
+            float delta[2] = { (float)(nextL - countL) * radiansPerCount, (float)(nextR - countR) * radiansPerCount };
+            TwoWheelOdometry_Update(delta, NULL, (float)STEP_S, 0);
+            Truth_Update(&truth, (long double)(nextL - countL) * radiansPerCount,
+                         (long double)(nextR - countR) * radiansPerCount);
+            countL = nextL;
+            countR = nextR;
+            // The old firmware: DCMotor_GetEncoderValue in turns, times 2 PI in UpdateOdometry
+            float positions[2] = { (float)((float)countL * radiansPerCount / (float)(2.0 * M_PI) * (2 * M_PI)),
+                                   (float)((float)countR * radiansPerCount / (float)(2.0 * M_PI) * (2 * M_PI)) };
+            OldOdometry_Update(&old, positions);
+
+            if (k % SAMPLE_STEPS == 0 || k == steps - 1)
+            {
+                TwoWheelOdometry_Pose_t pose;
+                TwoWheelOdometry_GetPose(&pose);
+                double newError = (double)hypotl(pose.x * 1e-9L - truth.x, pose.y * 1e-9L - truth.y);
+                double oldError = (double)hypotl(old.x - truth.x, old.y - truth.y);
+                if (newError > maxNew) maxNew = newError;
+                if (oldError > maxOld) maxOld = oldError;
+            }
+        }
+        TwoWheelOdometry_Pose_t pose;
+        TwoWheelOdometry_GetPose(&pose);
+        double headingNew = HeadingError(pose.heading * (2 * PI_L / 4294967296.0L), truth.theta);
+        double headingOld = HeadingError(old.theta, truth.theta);
+        printf("%-24s %7.0f m %13.3f %13.3f %12.2e %12.2e\n", scenarioNames[scenario],
+               (double)hypotl(truth.x, truth.y), maxNew * 1e3, maxOld * 1e3, headingNew, headingOld);
+        if (maxNew > MAX_POSITION_ERROR || headingNew > MAX_HEADING_ERROR || maxNew >= maxOld || headingNew >= headingOld)
+            failures++;
+    }
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
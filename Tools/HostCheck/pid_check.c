@@ -0,0 +1,213 @@
+/**
+ * @file pid_check.c
+ * @brief Wheel speed control on a simulated motor, old PID against PID with feed-forward
+ *
+ * @details The wheel speed loop of dc_motor.c with the firmware PID and
+ * Kalman filter and the DEFAULT_MOTOR_* settings of system_config.h:
+ * output limited to +/-1 duty, anti-windup, filtered derivative, and the
+ * feed-forward kS*sign(w) + kV*w + kA*dw/dt.
+ *  - Plant: first order at 1 kHz, 30 rad/s per duty (13 % below the kV of
+ *    the model), 60 ms time constant, 0.07 duty of static friction. Full
+ *    duty reaches 27.9 rad/s.
+ *  - Encoder of 1560 edges per turn, counted every 20 ms control period.
+ *  - Reference 0 -> 15 -> 40 -> 10 -> 0 rad/s, 1 s per step, as raw steps
+ *    and through a 60 rad/s^2 ramp like the motion profiler. 40 rad/s is
+ *    out of reach, the reachable part of each step is the target.
+ *  - The old PID, integral bounded to 1000 in error units and no limit, is
+ *    kept here as the reference.
+ *  - A settle time of 1.00 s means the speed did not settle within the step.
+ *  - Passes if the new PID with feed-forward settles from 40 to 10 rad/s
+ *    within 10 % in under MAX_SETTLE s and its RMS error in the second half
+ *    of each step is under a quarter of the old one, with steps and ramps.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "pid.h"
+#include "kalman_filter.h"
+#include "system_config.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define PLANT_STEP      0.001       // Plant integration step in s
+#define CONTROL_STEPS   20          // Plant steps per control period
+#define PLANT_GAIN      30.0        // rad/s per duty
+#define PLANT_TAU       0.06        // s
+#define PLANT_FRICTION  0.07        // duty
+#define RESOLUTION      1560.0      // Encoder edges per wheel turn
+#define REACHABLE       (PLANT_GAIN * (1.0 - PLANT_FRICTION))
+#define RAMP_ACCEL      60.0        // rad/s^2 of the ramped reference
+#define STEP_S          1.0
+#define STEPS           4
+#define FF_MIN_SPEED    0.05f       // As dc_motor.c
+#define MAX_SETTLE      0.6         // s
+
+/**
+ * @brief Controllers compared
+ */
+typedef enum {
+    CONTROL_OLD_PID = 0,
+    CONTROL_PID,                    // New PID without feed-forward
+    CONTROL_PID_FF,
+} Control_t;
+
+/**
+ * @brief Old PID, before the output limits and the feed-forward
+ */
+typedef struct {
+    float kP, kI, kD;
+    double object, sumError, lastError;
+} OldPID_t;
+
+/**
+ * @brief Figures of a run
+ */
+typedef struct {
+    double settle[STEPS];   // Time after each step to stay within 10 % of it
+    double overshoot[STEPS];
+    double rmsError;        // Over the second half of each step
+} Result_t;
+
+static const float steps[STEPS] = { 15.0f, 40.0f, 10.0f, 0.0f };
+
+/**
+ * @brief PID_Calc of the old pid.c
+ */
+static float OldPID_Calc(OldPID_t *pid, float measurement)
+{
+    float error = pid->object - measurement;
+    float differentialError = error - pid->lastError;
+    pid->sumError += error;
+    if (pid->sumError > 1000) pid->sumError = 1000;
+    else if (pid->sumError < -1000) pid->sumError = -1000;
+    pid->lastError = error;
+    return pid->kP * error + pid->kI * pid->sumError + pid->kD * differentialError;
+}
+
+/* ---------------------- Simulation ------------------------------------ */
+/**
+ * @brief Reachable part of a step, the target of the figures
+ */
+static double Reachable(int step)
+{
+    if (step < 0) return 0;
+    return steps[step] > REACHABLE ? REACHABLE : steps[step];
+}
+
+/**
+ * @brief Advance the plant by one step
+ * @param speed wheel speed in rad/s
+ * @param duty applied duty
+ */
+static void Plant(double *speed, double duty)
+{
+    double drive;
+    if (fabs(*speed) < 1e-3 && fabs(duty) < PLANT_FRICTION) drive = 0;     // Stuck
+    else drive = duty - PLANT_FRICTION * (*speed > 0 ? 1 : *speed < 0 ? -1 : duty > 0 ? 1 : -1);
+    *speed += (PLANT_GAIN * drive - *speed) / PLANT_TAU * PLANT_STEP;
+}
+
+/**
+ * @brief Run the reference through a controller
+ * @param control the controller
+ * @param isRamped ramp the reference like the motion profiler
+ * @param result figures of the run
+ */
+static void Run(Control_t control, bool isRamped, Result_t *result)
+{
+    PID_t pid;
+    OldPID_t oldPid = { DEFAULT_MOTOR_KP, DEFAULT_MOTOR_KI, DEFAULT_MOTOR_KD, 0, 0, 0 };
+    KalmanFilter_t kalman;
+    PID_Init(&pid, DEFAULT_MOTOR_KP, DEFAULT_MOTOR_KI, DEFAULT_MOTOR_KD);
+    PID_SetOutputLimits(&pid, -1.0f, 1.0f, DEFAULT_MOTOR_ANTI_WINDUP);
+    PID_SetDerivativeFilter(&pid, DEFAULT_MOTOR_DERIVATIVE_ALPHA);
+    KalmanFilter_Init(&kalman, 8.0f, DEFAULT_MOTOR_MEASURE_VARIANCE, DEFAULT_MOTOR_PROCESS_VARIANCE);
+    for (int i = 0; i < STEPS; i++) result->settle[i] = result->overshoot[i] = 0;
+
+    double speed = 0, angle = 0, squares = 0, dt = PLANT_STEP * CONTROL_STEPS;
+    long lastCount = 0, samples = 0;
+    float reference = 0, lastReference = 0;
+    for (long k = 0; k < (long)(STEPS * STEP_S / PLANT_STEP); k += CONTROL_STEPS)
+    {
+        double t = k * PLANT_STEP;
+        int step = (int)(t / STEP_S);
+        long count = (long)floor(angle / (2 * M_PI) * RESOLUTION);
+        float measurement = KalmanFilter_Calc(&kalman, (float)((count - lastCount) * 2 * M_PI / RESOLUTION / dt));
+        lastCount = count;
+        if (!isRamped) reference = steps[step];
+        else if (fabsf(steps[step] - reference) < RAMP_ACCEL * dt) reference = steps[step];
+        else reference += (float)(steps[step] > reference ? RAMP_ACCEL * dt : -RAMP_ACCEL * dt);
+
+        float duty;
+        if (control == CONTROL_OLD_PID)
+        {
+            oldPid.object = reference;
+            duty = OldPID_Calc(&oldPid, measurement);
+        }
+        else
+        {
+            float feedForward = 0;
+            if (control == CONTROL_PID_FF)
+            {
+                // FeedForward of dc_motor.c
+                feedForward = DEFAULT_MOTOR_FF_KV * reference + DEFAULT_MOTOR_FF_KA * (reference - lastReference) / (float)dt;
+                if (reference > FF_MIN_SPEED) feedForward += DEFAULT_MOTOR_FF_KS;
+                else if (reference < -FF_MIN_SPEED) feedForward -= DEFAULT_MOTOR_FF_KS;
+            }
+            PID_SetFeedForward(&pid, feedForward);
+            PID_SetObject(&pid, reference);
+            duty = PID_Calc(&pid, measurement);
+        }
+        lastReference = reference;
+        if (duty > 1) duty = 1;         // Timer_PWM_SetDuty range
+        else if (duty < -1) duty = -1;
+
+        for (int j = 0; j < CONTROL_STEPS; j++)
+        {
+            double tj = (k + j) * PLANT_STEP, target = Reachable(step), previous = Reachable(step - 1);
+            if (fabs(speed - target) > 0.1 * fabs(target - previous)) result->settle[step] = tj - step * STEP_S;
+            double overshoot = target >= previous ? speed - target : target - speed;
+            if (overshoot > result->overshoot[step]) result->overshoot[step] = overshoot;
+            if (tj - step * STEP_S >= STEP_S / 2)
+            {
+                squares += (speed - target) * (speed - target);
+                samples++;
+            }
+            Plant(&speed, duty);
+            angle += speed * PLANT_STEP;
+        }
+    }
+    result->rmsError = sqrt(squares / samples);
+}
+
+/* ---------------------- Check ----------------------------------------- */
+int main(void)
+{
+    static const char *names[] = { "old PID", "new PID, no FF", "new PID + FF" };
+    Result_t results[2][3];
+    int failures = 0;
+
+    printf("%-26s %34s %30s %9s\n", "", "settle within 10 % in s after", "overshoot in rad/s", "RMS error");
+    printf("%-26s %8s %8s %8s %8s %7s %7s %7s %7s %9s\n", "", "0>15", "15>40", "40>10", "10>0",
+           "0>15", "15>40", "40>10", "10>0", "rad/s");
+    for (int ramped = 0; ramped <= 1; ramped++)
+    {
+        for (Control_t control = CONTROL_OLD_PID; control <= CONTROL_PID_FF; control++)
+        {
+            Result_t *result = &results[ramped][control];
+            Run(control, ramped, result);
+            printf("%-16s %-9s %8.2f %8.2f %8.2f %8.2f %7.2f %7.2f %7.2f %7.2f %9.2f\n", names[control],
+                   ramped ? "ramps" : "steps", result->settle[0], result->settle[1], result->settle[2], result->settle[3],
+                   result->overshoot[0], result->overshoot[1], result->overshoot[2], result->overshoot[3],
+                   result->rmsError);
+        }
+        const Result_t *old = &results[ramped][CONTROL_OLD_PID], *best = &results[ramped][CONTROL_PID_FF];
+        if (best->settle[2] > MAX_SETTLE || best->rmsError > old->rmsError / 4) failures++;
+    }
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
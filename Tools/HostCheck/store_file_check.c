@@ -0,0 +1,287 @@
+/**
+ * @file store_file_check.c
+ * @brief Power cuts during the commits of the store file
+ *
+ * @details The store file runs over the real flash driver and memory pools
+ * on the simulated W25Q128, in the parameter file region.
+ *  - Plain use: 1500 files of up to 400 KB, so both areas wrap around,
+ *    reopened and read back every 37 files.
+ *  - Power cuts: for each of 400 files of up to 250 KB, the power is cut at
+ *    every page program and sector erase of its commit in turn. After each
+ *    cut the next boot must find the previous file or the new one, the new
+ *    one if the commit had completed, and a further file must commit.
+ *  - An image of the older firmware is still read, and not rewritten. The
+ *    commit of the first new file is cut at every operation too: the next
+ *    boot must find the legacy file or the new one.
+ * Each boot runs in its own process through HostFlash_RunPowered, so no
+ * RAM survives a cut.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "store_file.h"
+#include "crc32.h"
+#include "mem_pool.h"
+#include "host_flash.h"
+#include "system_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define BASE            EXT_FLASH_PARAMETER_FILE_ADDRESS
+#define SIZE            EXT_FLASH_PARAMETER_FILE_SIZE
+#define MAX_FILE        400000U
+#define CHUNK           1000U       // Bytes per Write call
+#define PLAIN_FILES     1500
+#define CUT_FILES       400
+#define LEGACY_LENGTH   6000U       // Spans two sectors of the legacy data area
+
+/**
+ * @brief A file identified by the seed of its content
+ */
+typedef struct {
+    uint32_t seed;
+    uint32_t length;
+} File_t;
+
+/**
+ * @brief Arguments of the powered parts
+ */
+typedef struct {
+    File_t committed;   // Latest file known to be committed
+    File_t file;        // File being written
+    bool isComplete;    // The commit of file returned before the cut
+} Step_t;
+
+static uint8_t expected[MAX_FILE], content[MAX_FILE];
+static uint8_t snapshot[SIZE];
+
+/**
+ * @brief Content of a file
+ */
+static void Generate(uint8_t *buffer, uint32_t length, uint32_t seed)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        buffer[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+/**
+ * @brief Whether the file found by StoreFile_Init is the given one
+ */
+static bool IsFile(StoreFile_t *store, File_t file)
+{
+    if (store->length != file.length) return false;
+    Generate(expected, file.length, file.seed);
+    store->SetReadPos(store, 0);
+    if (file.length && store->Read(store, content, file.length) != (int32_t)file.length) return false;
+    if (memcmp(expected, content, file.length) != 0) return false;
+    return file.length == 0 || store->CalculateCRC(store) == store->ReadCRC(store);
+}
+
+/**
+ * @brief Write and commit a file
+ */
+static bool WriteFile(StoreFile_t *store, File_t file)
+{
+    if (!store->NewFile(store)) return false;
+    Generate(expected, file.length, file.seed);
+    for (uint32_t offset = 0; offset < file.length; offset += CHUNK)
+    {
+        uint32_t size = file.length - offset < CHUNK ? file.length - offset : CHUNK;
+        if (!store->Write(store, expected + offset, size)) return false;
+    }
+    return store->UpdateFileDescription(store);
+}
+
+/**
+ * @brief Boot and open the store file
+ */
+static void Boot(StoreFile_t *store)
+{
+    MemPool_Init();
+    StoreFile_Init(store, BASE, SIZE);
+}
+
+/* ---------------------- Powered parts --------------------------------- */
+/**
+ * @brief Commit files in a row, reopen and read back now and then
+ */
+static int PlainUse(void *argument)
+{
+    (void)argument;
+    StoreFile_t store;
+    Boot(&store);
+    srand(1);
+    for (int i = 1; i <= PLAIN_FILES; i++)
+    {
+        File_t file = { (uint32_t)i, (i % 50 == 0) ? 200000U + (uint32_t)rand() % 200000U : (uint32_t)rand() % 3000U };
+        if (!WriteFile(&store, file))
+        {
+            printf("plain use: file %d not committed\n", i);
+            return 1;
+        }
+        if (i % 37 == 0)
+        {
+            StoreFile_Init(&store, BASE, SIZE);
+            if (!IsFile(&store, file))
+            {
+                printf("plain use: file %d not found after reopening\n", i);
+                return 1;
+            }
+        }
+    }
+    printf("plain use: %d files, sequence %u, description at 0x%06X, file at 0x%06X\n", PLAIN_FILES,
+           (unsigned)store.sequence, (unsigned)store.fdbPos, (unsigned)store.filePos);
+    return 0;
+}
+
+/**
+ * @brief Boot and commit the file of the step
+ * @return 0 when the commit returned true
+ */
+static int Commit(void *argument)
+{
+    const Step_t *step = argument;
+    StoreFile_t store;
+    Boot(&store);
+    return WriteFile(&store, step->file) ? 0 : 1;
+}
+
+/**
+ * @brief Boot after a cut, find the old or the new file, commit another
+ * @return 0 if the recovery holds
+ */
+static int Recover(void *argument)
+{
+    const Step_t *step = argument;
+    StoreFile_t store;
+    Boot(&store);
+    bool isNew = IsFile(&store, step->file);
+    if (!isNew && (step->isComplete || !IsFile(&store, step->committed))) return 1;
+    File_t next = { step->file.seed + 7U, step->file.length % 5000U };
+    if (!WriteFile(&store, next)) return 2;
+    StoreFile_Init(&store, BASE, SIZE);
+    return IsFile(&store, next) ? 0 : 3;
+}
+
+/**
+ * @brief Read an image of the older firmware, refuse to rewrite it
+ */
+static int ReadLegacy(void *argument)
+{
+    (void)argument;
+    StoreFile_t store;
+    File_t legacy = { 5U, LEGACY_LENGTH }, next = { 9U, 300U };
+    Boot(&store);
+    if (!IsFile(&store, legacy)) return 1;
+    if (store.UpdateFileDescription(&store)) return 2;
+    if (!WriteFile(&store, next)) return 3;
+    StoreFile_Init(&store, BASE, SIZE);
+    return IsFile(&store, next) ? 0 : 4;
+}
+
+/* ---------------------- Check ----------------------------------------- */
+/**
+ * @brief Write an image of the older firmware: header, position, length, file CRC, FDB CRC
+ */
+static void WriteLegacyImage(void)
+{
+    HostFlash_Erase();
+    uint32_t descriptor[5] = { 0xA5A55A5AU, EXT_FLASH_SECTOR_SIZE, LEGACY_LENGTH, 0, 0 };
+    Generate(expected, LEGACY_LENGTH, 5U);
+    memcpy(&HostFlash->memory[BASE + EXT_FLASH_SECTOR_SIZE], expected, LEGACY_LENGTH);
+    descriptor[3] = Crc32(CRC32_INITIAL_VALUE, expected, LEGACY_LENGTH);
+    descriptor[4] = Crc32(CRC32_INITIAL_VALUE, descriptor, 16U);
+    memcpy(&HostFlash->memory[BASE], descriptor, sizeof(descriptor));
+}
+
+/**
+ * @brief Programs and erases of the commit of a file on the current flash
+ */
+static int32_t CountOperations(Step_t *step)
+{
+    uint32_t before = HostFlash->programCount + HostFlash->eraseCount;
+    if (HostFlash_RunPowered(Commit, step) != 0) return -1;
+    return (int32_t)(HostFlash->programCount + HostFlash->eraseCount - before);
+}
+
+int main(void)
+{
+    int failures = 0;
+    HostFlash_Erase();
+    if (HostFlash_RunPowered(PlainUse, NULL) != 0) failures++;
+
+    // The files of the plain use stay, the cuts start from a wrapped layout
+    Step_t step = { .committed = { PLAIN_FILES, 0 } };
+    srand(1);
+    for (int i = 1; i <= PLAIN_FILES; i++)
+        step.committed.length = (i % 50 == 0) ? 200000U + (uint32_t)rand() % 200000U : (uint32_t)rand() % 3000U;
+    long cuts = 0, cutFailures = 0;
+    srand(2);
+    for (int i = 0; i < CUT_FILES; i++)
+    {
+        step.file.seed = 100000U + (uint32_t)i;
+        step.file.length = (i % 40 == 0) ? 150000U + (uint32_t)rand() % 100000U : (uint32_t)rand() % 6000U;
+        memcpy(snapshot, &HostFlash->memory[BASE], SIZE);
+        int32_t operations = CountOperations(&step);
+        if (operations < 0)
+        {
+            printf("file %d not committed without a cut\n", i);
+            failures++;
+            break;
+        }
+        for (int32_t k = 0; k <= operations; k++)
+        {
+            memcpy(&HostFlash->memory[BASE], snapshot, SIZE);
+            HostFlash->cutAfter = k;
+            int result = HostFlash_RunPowered(Commit, &step);
+            HostFlash_PowerOn();
+            step.isComplete = result == 0;
+            int recovery = HostFlash_RunPowered(Recover, &step);
+            cuts++;
+            if (recovery != 0 && ++cutFailures <= 5)
+                printf("file %d, cut at operation %d of %d: recovery failed (%d)\n", i, (int)k, (int)operations, recovery);
+        }
+        // Go on from this file committed
+        memcpy(&HostFlash->memory[BASE], snapshot, SIZE);
+        CountOperations(&step);
+        step.committed = step.file;
+    }
+    printf("power cuts: %ld cuts over %d files, %ld failed recoveries\n", cuts, CUT_FILES, cutFailures);
+    if (cutFailures) failures++;
+
+    // Image of the older firmware
+    WriteLegacyImage();
+    int legacy = HostFlash_RunPowered(ReadLegacy, NULL);
+    printf("legacy image: %s\n", legacy == 0 ? "read, not rewritten, replaced by a new file" : "FAILED");
+    if (legacy != 0) failures++;
+
+    // Power cuts during the first commit over the legacy image
+    WriteLegacyImage();
+    Step_t first = { .committed = { 5U, LEGACY_LENGTH }, .file = { 11U, 5000U } };
+    memcpy(snapshot, &HostFlash->memory[BASE], SIZE);
+    int32_t operations = CountOperations(&first);
+    long legacyFailures = operations < 0 ? 1 : 0;
+    for (int32_t k = 0; k <= operations; k++)
+    {
+        memcpy(&HostFlash->memory[BASE], snapshot, SIZE);
+        HostFlash->cutAfter = k;
+        int result = HostFlash_RunPowered(Commit, &first);
+        HostFlash_PowerOn();
+        first.isComplete = result == 0;
+        int recovery = HostFlash_RunPowered(Recover, &first);
+        if (recovery != 0 && ++legacyFailures <= 5)
+            printf("legacy image, cut at operation %d of %d: recovery failed (%d)\n", (int)k, (int)operations, recovery);
+    }
+    printf("legacy power cuts: %d cuts, %ld failed recoveries\n", (int)operations + 1, legacyFailures);
+    if (legacyFailures) failures++;
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
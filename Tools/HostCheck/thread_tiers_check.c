@@ -0,0 +1,299 @@
+/**
+ * @file thread_tiers_check.c
+ * @brief Wake-up latency of the motion thread before and after the priority tiers
+ *
+ * @details A model of the RTX scheduler, not a measurement: it steps a
+ * 168 MHz core in microseconds through the thread set of the firmware with
+ * the priorities before the tiers (every application thread at
+ * osPriorityNormal) and with the THREAD_PRIORITY_* tiers of system_config.h.
+ *  - RTX policy: the highest priority ready thread runs, a thread made ready
+ *    or preempted goes behind the ready threads of its priority, and after
+ *    ROBIN_TICKS kernel ticks the running thread yields to the next ready
+ *    thread of its priority. Interrupts take the core from any thread, a
+ *    thread switch costs SWITCH_US.
+ *  - The TIM7 tick releases the motion thread every 20 ms at
+ *    ACTIVATION_PHASE_MOTION and the feedback thread every 5 ms; the PID
+ *    and the odometry run in TIM7 at phase 0.
+ *  - UDP load: frames to the ROS port arrive evenly spaced or in bursts at
+ *    the 100 Mbit/s line rate, one every FRAME_GAP_US. Each costs the
+ *    Ethernet interrupt, the network core thread and the ROS incoming thread.
+ *  - The delay from release to run and the interval between two runs are
+ *    taken like CpuLoad_WakeRelease/CpuLoad_WakeRun do on the target, where
+ *    the CpuLoad message reports the same figures.
+ * The costs of the work items are estimates for the target, see the table.
+ * Passes if with the tiers the motion thread runs within MAX_DELAY_US of its
+ * release under the heaviest load and the old priorities are worse.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "system_config.h"
+#include "cmsis_os2.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define RUN_US          10000000U   // Simulated time of each scenario
+#define TICK_US         1000U       // Kernel tick, OS_TICK_FREQ 1000
+#define ROBIN_TICKS     5U          // OS_ROBIN_TIMEOUT of RTX_Config.h
+#define SWITCH_US       1U          // Thread switch through PendSV
+#define MOTION_PERIOD   20U         // ms, MOTION_CONTROL_INTERVAL
+#define FEEDBACK_PERIOD 5U          // ms, CHECK_FEEDBACK_PERIOD
+#define MAX_DELAY_US    50U
+#define FRAME_GAP_US    7U          // Shortest frames back to back at 100 Mbit/s
+
+// Interrupt costs in us
+#define TIM7_US         3U          // Activation tick
+#define PID_US          40U         // Motor PID and odometry, TIM7 at phase 0
+#define SYSTICK_US      2U
+#define ETH_US          2U          // Ethernet receive interrupt per frame
+
+/**
+ * @brief Threads of the model
+ */
+typedef enum {
+    THREAD_MOTION = 0,
+    THREAD_NET,             // Network core thread
+    THREAD_INCOMING,        // ROS incoming
+    THREAD_FEEDBACK,        // ROS feedback
+    THREAD_RC,              // RC receiver
+    THREAD_IO,              // IO inputs
+    THREAD_DATA_STORE,
+    THREAD_RECORDER,        // Flight recorder
+    THREAD_COUNT
+} Thread_t;
+
+/**
+ * @brief A thread and its work
+ */
+typedef struct {
+    const char *name;
+    osPriority_t before;    // Priority before the tiers
+    osPriority_t after;     // Tier
+    uint32_t jobUs;         // Cost of one job
+    uint32_t periodMs;      // Period of its own releases, 0 if only released by another thread
+    uint32_t phaseMs;
+    // State of a run
+    osPriority_t priority;
+    uint32_t jobs;          // Jobs queued, the current one included
+    uint32_t left;          // us left of the current job
+    uint32_t readyOrder;    // Place among the ready threads of its priority
+} ThreadModel_t;
+
+static ThreadModel_t threads[THREAD_COUNT] = {
+    [THREAD_MOTION]     = { "motion control", osPriorityNormal, THREAD_PRIORITY_CONTROL, 150, MOTION_PERIOD, ACTIVATION_PHASE_MOTION },
+    [THREAD_NET]        = { "network core", osPriorityNormal, THREAD_PRIORITY_INGRESS, 15, 0, 0 },
+    [THREAD_INCOMING]   = { "ROS incoming", osPriorityNormal, THREAD_PRIORITY_INGRESS, 25, 0, 0 },
+    [THREAD_FEEDBACK]   = { "ROS feedback", osPriorityNormal, THREAD_PRIORITY_EGRESS, 300, FEEDBACK_PERIOD, ACTIVATION_PHASE_FEEDBACK },
+    [THREAD_RC]         = { "RC receiver", osPriorityNormal, THREAD_PRIORITY_INGRESS, 20, 14, 3 },
+    [THREAD_IO]         = { "IO inputs", osPriorityNormal, THREAD_PRIORITY_INGRESS, 10, 10, 4 },
+    [THREAD_DATA_STORE] = { "data store", osPriorityBelowNormal, THREAD_PRIORITY_PERSISTENCE, 200, 100, 7 },
+    [THREAD_RECORDER]   = { "flight recorder", osPriorityLow, THREAD_PRIORITY_LOGGING, 100, 20, 9 },
+};
+
+/**
+ * @brief UDP load of a scenario
+ */
+typedef struct {
+    uint32_t framesPerSecond;
+    uint32_t burst;         // Frames back to back, 1 for evenly spaced frames
+} Load_t;
+
+/**
+ * @brief Motion thread wake-ups of a run, as CpuLoad reports them
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t delayMax;
+    uint64_t delayTotal;
+    uint32_t periodMin;
+    uint32_t periodMax;
+    uint32_t load;          // Per mille of the time not idle
+} Wakeups_t;
+
+static uint32_t readyCounter;
+
+/* ---------------------- Scheduler model ------------------------------- */
+/**
+ * @brief Queue a job, the thread goes behind the ready threads of its priority
+ */
+static void Release(Thread_t index)
+{
+    ThreadModel_t *thread = &threads[index];
+    if (thread->jobs++ == 0)
+    {
+        thread->left = thread->jobUs;
+        thread->readyOrder = ++readyCounter;
+    }
+}
+
+/**
+ * @brief Highest priority ready thread, first in line among its priority
+ * @return the thread, THREAD_COUNT if only the idle thread is ready
+ */
+static Thread_t Pick(void)
+{
+    Thread_t best = THREAD_COUNT;
+    for (Thread_t i = 0; i < THREAD_COUNT; i++)
+    {
+        if (threads[i].jobs == 0) continue;
+        if (best == THREAD_COUNT || threads[i].priority > threads[best].priority ||
+            (threads[i].priority == threads[best].priority && threads[i].readyOrder < threads[best].readyOrder))
+            best = i;
+    }
+    return best;
+}
+
+/**
+ * @brief Whether another thread of the same priority is ready
+ */
+static bool IsPeerReady(Thread_t running)
+{
+    for (Thread_t i = 0; i < THREAD_COUNT; i++)
+    {
+        if (i != running && threads[i].jobs > 0 && threads[i].priority == threads[running].priority) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Run one scenario
+ * @param isTiered use the tiers, the old priorities otherwise
+ * @param load UDP frames to the ROS port
+ * @param result wake-ups of the motion thread
+ */
+static void Run(bool isTiered, Load_t load, Wakeups_t *result)
+{
+    for (Thread_t i = 0; i < THREAD_COUNT; i++)
+    {
+        threads[i].priority = isTiered ? threads[i].after : threads[i].before;
+        threads[i].jobs = 0;
+    }
+    memset(result, 0, sizeof(*result));
+    result->periodMin = UINT32_MAX;
+    uint32_t isrLeft = 0, switchLeft = 0, idleUs = 0, robinTicks = 0;
+    uint32_t releaseUs = 0, lastRunUs = 0;
+    bool isReleased = false;
+    Thread_t running = THREAD_COUNT;
+    uint32_t burstPeriod = load.framesPerSecond ? 1000000U * load.burst / load.framesPerSecond : 0;
+
+    for (uint32_t now = 0; now < RUN_US; now++)
+    {
+        // Interrupts of this microsecond
+        if (now % TICK_US == 0)
+        {
+            uint32_t ms = now / TICK_US;
+            isrLeft += SYSTICK_US + TIM7_US;
+            if (ms % MOTION_PERIOD == 0) isrLeft += PID_US;
+            for (Thread_t i = 0; i < THREAD_COUNT; i++)
+            {
+                if (threads[i].periodMs != 0 && ms % threads[i].periodMs == threads[i].phaseMs) Release(i);
+            }
+            if (ms % MOTION_PERIOD == ACTIVATION_PHASE_MOTION)
+            {
+                releaseUs = now;
+                isReleased = true;
+            }
+            // Round-robin inside a priority
+            if (running != THREAD_COUNT && ++robinTicks >= ROBIN_TICKS && IsPeerReady(running))
+            {
+                threads[running].readyOrder = ++readyCounter;
+                robinTicks = 0;
+            }
+        }
+        if (burstPeriod != 0 && now % burstPeriod < load.burst * FRAME_GAP_US && now % burstPeriod % FRAME_GAP_US == 0)
+        {
+            isrLeft += ETH_US;
+            Release(THREAD_NET);
+        }
+
+        if (isrLeft > 0)
+        {
+            isrLeft--;
+            continue;
+        }
+        Thread_t next = Pick();
+        if (next != running)
+        {
+            // A preempted thread goes behind the ready threads of its priority
+            if (running != THREAD_COUNT && threads[running].jobs > 0) threads[running].readyOrder = ++readyCounter;
+            running = next;
+            robinTicks = 0;
+            switchLeft = SWITCH_US;
+        }
+        if (switchLeft > 0)
+        {
+            switchLeft--;
+            continue;
+        }
+        if (running == THREAD_COUNT)
+        {
+            idleUs++;
+            continue;
+        }
+        if (running == THREAD_MOTION && isReleased)
+        {
+            uint32_t delay = now - releaseUs;
+            isReleased = false;
+            result->count++;
+            result->delayTotal += delay;
+            if (delay > result->delayMax) result->delayMax = delay;
+            if (result->count > 1)
+            {
+                if (now - lastRunUs < result->periodMin) result->periodMin = now - lastRunUs;
+                if (now - lastRunUs > result->periodMax) result->periodMax = now - lastRunUs;
+            }
+            lastRunUs = now;
+        }
+        ThreadModel_t *thread = &threads[running];
+        if (--thread->left > 0) continue;
+        // Job done, a frame handled by the network core goes on to the ROS incoming thread
+        if (running == THREAD_NET) Release(THREAD_INCOMING);
+        if (--thread->jobs > 0) thread->left = thread->jobUs;
+    }
+    result->load = 1000U - (uint32_t)((uint64_t)idleUs * 1000U / RUN_US);
+}
+
+/* ---------------------- Check ----------------------------------------- */
+int main(void)
+{
+    static const Load_t loads[] = { { 0, 1 }, { 5000, 1 }, { 15000, 1 }, { 5000, 50 }, { 15000, 50 }, { 15000, 200 } };
+    uint32_t worstBefore = 0, worstAfter = 0;
+    int failures = 0;
+
+    printf("Model of the scheduler, work items in us on the target:\n");
+    for (Thread_t i = 0; i < THREAD_COUNT; i++)
+    {
+        printf("  %-16s %4u us", threads[i].name, (unsigned)threads[i].jobUs);
+        if (threads[i].periodMs) printf(" every %u ms\n", (unsigned)threads[i].periodMs);
+        else printf(i == THREAD_NET ? " per frame\n" : " per frame, after the network core\n");
+    }
+    printf("  interrupts: PID %u us, TIM7 %u us, SysTick %u us, Ethernet %u us per frame\n\n",
+           PID_US, TIM7_US, SYSTICK_US, ETH_US);
+    printf("%-8s %-6s %-11s %6s %8s %14s %14s %16s\n", "frames/s", "burst", "priorities", "load", "wakeups",
+           "max delay us", "mean delay us", "period us");
+    for (uint32_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++)
+    {
+        for (int tiered = 0; tiered <= 1; tiered++)
+        {
+            Wakeups_t wakeups;
+            Run(tiered, loads[l], &wakeups);
+            printf("%8u %-6u %-11s %5.1f%% %8u %14u %14.1f %7u..%-8u\n", (unsigned)loads[l].framesPerSecond,
+                   (unsigned)loads[l].burst, tiered ? "tiers" : "all Normal",
+                   wakeups.load / 10.0, (unsigned)wakeups.count, (unsigned)wakeups.delayMax,
+                   wakeups.count ? (double)wakeups.delayTotal / wakeups.count : 0.0,
+                   (unsigned)wakeups.periodMin, (unsigned)wakeups.periodMax);
+            uint32_t *worst = tiered ? &worstAfter : &worstBefore;
+            if (wakeups.delayMax > *worst) *worst = wakeups.delayMax;
+            if (wakeups.count != RUN_US / TICK_US / MOTION_PERIOD) failures++;
+        }
+    }
+    printf("\nworst release-to-run delay: %u us with all threads at Normal, %u us with the tiers\n",
+           (unsigned)worstBefore, (unsigned)worstAfter);
+    if (worstAfter > MAX_DELAY_US || worstBefore <= worstAfter) failures++;
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file update_file_check.c
+ * @brief Windowed transfer of firmware images with losses and power cuts
+ *
+ * @details The update file runs over the real flash driver on the simulated
+ * W25Q128, in the OTA region. A sender like the upload tool sends the
+ * missing pages of the window in random order, drops 10 % of them and
+ * duplicates 2 %.
+ *  - 12 images, the first of 3 MB, each interrupted by four power cuts at
+ *    random programs or erases. Every boot resumes the transfer; the image,
+ *    its CRC and the apply flag are then checked in flash, and a boot after
+ *    the end finishes the same image again.
+ *  - An image sent with a wrong CRC is discarded without apply flag, and
+ *    sent again with the right one it is accepted.
+ *  - A page beyond the window is rejected.
+ * Each boot runs in its own process through HostFlash_RunPowered, so no
+ * RAM survives a cut.
+ *
+ * @date 2026-10-17
+ * @author Young.W <com.wang@hotmail.com>
+ * @version 1.0
+ */
+#include "update_file.h"
+#include "crc32.h"
+#include "host_flash.h"
+#include "system_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------- Definitions ----------------------------------- */
+#define BASE            EXT_FLASH_OTA_FILE_ADDRESS
+#define SIZE            EXT_FLASH_OTA_FILE_SIZE
+#define MAX_IMAGE       0x300000U
+#define IMAGES          12
+#define LOSS_PERCENT    10
+#define MAX_CUTS        4
+#define VERSION         7U
+
+/**
+ * @brief Image sent by a powered part
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t crc;           // CRC announced to Begin
+    uint32_t seed;          // Seed of the sender, changes at every boot
+} Transfer_t;
+
+static uint8_t image[MAX_IMAGE];
+
+/* ---------------------- Powered parts --------------------------------- */
+/**
+ * @brief Boot, begin or resume the image and send it until it is finished
+ * @return 0 if Finish accepted the image, 1 if it was refused, 2 if the
+ * transfer stalled
+ */
+static int Send(void *argument)
+{
+    const Transfer_t *transfer = argument;
+    UpdateFile_t file;
+    UpdateFile_Init(&file, BASE, SIZE);
+    if (!file.Begin(&file, transfer->size, transfer->crc, VERSION)) return 2;
+    if (file.committedPages) printf("   resumed at page %u\n", (unsigned)file.committedPages);
+    srand(transfer->seed);
+    uint32_t pages = (transfer->size + UPDATE_FILE_PAGE_SIZE - 1) / UPDATE_FILE_PAGE_SIZE;
+    for (long rounds = 0; file.committedPages < pages; rounds++)
+    {
+        if (rounds > 10L * pages) return 2;
+        // The missing pages of the window, shuffled
+        uint32_t order[UPDATE_FILE_WINDOW_PAGES], count = 0;
+        for (uint32_t i = 0; i < UPDATE_FILE_WINDOW_PAGES && file.committedPages + i < pages; i++)
+        {
+            if (!(file.pendingMask & (1U << i))) order[count++] = file.committedPages + i;
+        }
+        for (uint32_t i = count; i > 1; i--)
+        {
+            uint32_t j = (uint32_t)rand() % i, swap = order[i - 1];
+            order[i - 1] = order[j];
+            order[j] = swap;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (rand() % 100 < LOSS_PERCENT) continue;
+            uint32_t page = order[i], offset = page * UPDATE_FILE_PAGE_SIZE;
+            uint32_t size = transfer->size - offset < UPDATE_FILE_PAGE_SIZE ? transfer->size - offset : UPDATE_FILE_PAGE_SIZE;
+            if (!file.WritePage(&file, page, image + offset, size)) return 2;
+            if (rand() % 50 == 0) file.WritePage(&file, page, image + offset, size);
+        }
+    }
+    return file.Finish(&file) ? 0 : 1;
+}
+
+/**
+ * @brief Boot after the end of a transfer and finish the same image again
+ */
+static int FinishAgain(void *argument)
+{
+    const Transfer_t *transfer = argument;
+    UpdateFile_t file;
+    UpdateFile_Init(&file, BASE, SIZE);
+    return file.Begin(&file, transfer->size, transfer->crc, VERSION) && file.Finish(&file) ? 0 : 1;
+}
+
+/**
+ * @brief Boot, begin an image and write a page beyond the window
+ * @return 0 if the page was rejected
+ */
+static int WriteBeyondWindow(void *argument)
+{
+    (void)argument;
+    UpdateFile_t file;
+    UpdateFile_Init(&file, BASE, SIZE);
+    if (!file.Begin(&file, 100000U, 1U, 1U)) return 2;
+    return file.WritePage(&file, file.committedPages + UPDATE_FILE_WINDOW_PAGES, image, UPDATE_FILE_PAGE_SIZE) ? 1 : 0;
+}
+
+/* ---------------------- Check ----------------------------------------- */
+/**
+ * @brief Whether the flash holds the image, verified and flagged for the bootloader
+ */
+static bool IsApplied(uint32_t size)
+{
+    UpdateFileDescriptor_t descriptor;
+    memcpy(&descriptor, &HostFlash->memory[BASE], sizeof(descriptor));
+    if (descriptor.applyFlag != UPDATE_FILE_APPLY_FLAG || descriptor.imageSize != size) return false;
+    const uint8_t *stored = &HostFlash->memory[descriptor.imagePosition];
+    return memcmp(stored, image, size) == 0 && Crc32(CRC32_INITIAL_VALUE, stored, size) == descriptor.imageCRC;
+}
+
+/**
+ * @brief Send an image through power cuts until Finish returns
+ * @return result of the last Send, HOST_FLASH_POWER_CUT if never finished
+ */
+static int SendWithCuts(Transfer_t *transfer, int maxCuts, int *cuts)
+{
+    int result = HOST_FLASH_POWER_CUT;
+    // About one erase every 16 pages, the cut falls inside what is left to send
+    int32_t operations = (int32_t)((transfer->size / UPDATE_FILE_PAGE_SIZE + 1) * 17 / 16);
+    for (*cuts = 0; result == HOST_FLASH_POWER_CUT; transfer->seed++)
+    {
+        HostFlash->cutAfter = *cuts < maxCuts ? rand() % (operations / (maxCuts + 1) + 1) : -1;
+        result = HostFlash_RunPowered(Send, transfer);
+        HostFlash_PowerOn();
+        if (result == HOST_FLASH_POWER_CUT) (*cuts)++;
+    }
+    return result;
+}
+
+int main(void)
+{
+    int failures = 0;
+    HostFlash_Erase();
+    srand(3);
+    for (int round = 0; round < IMAGES; round++)
+    {
+        Transfer_t transfer = { round == 0 ? MAX_IMAGE : 1000U + (uint32_t)rand() % 300000U, 0, (uint32_t)round * 100U };
+        for (uint32_t i = 0; i < transfer.size; i++) image[i] = (uint8_t)rand();
+        transfer.crc = Crc32(CRC32_INITIAL_VALUE, image, transfer.size);
+        int cuts;
+        int result = SendWithCuts(&transfer, MAX_CUTS, &cuts);
+        bool isApplied = result == 0 && IsApplied(transfer.size);
+        bool isFinishedAgain = HostFlash_RunPowered(FinishAgain, &transfer) == 0;
+        printf("image %2d: %7u bytes, %d power cuts, %s%s\n", round, (unsigned)transfer.size, cuts,
+               isApplied ? "verified in flash" : "NOT verified", isFinishedAgain ? "" : ", NOT finished again after a boot");
+        if (!isApplied || !isFinishedAgain) failures++;
+    }
+
+    // A wrong CRC is discarded, the right one then accepted
+    Transfer_t transfer = { 5000U, 0x12345678U, 1000U };
+    int cuts;
+    int result = SendWithCuts(&transfer, 0, &cuts);
+    UpdateFileDescriptor_t descriptor;
+    memcpy(&descriptor, &HostFlash->memory[BASE], sizeof(descriptor));
+    bool isRejected = result == 1 && descriptor.applyFlag != UPDATE_FILE_APPLY_FLAG;
+    transfer.crc = Crc32(CRC32_INITIAL_VALUE, image, transfer.size);
+    bool isAccepted = SendWithCuts(&transfer, 0, &cuts) == 0 && IsApplied(transfer.size);
+    printf("wrong CRC: %s, sent again with the right one: %s\n", isRejected ? "discarded" : "NOT discarded",
+           isAccepted ? "verified in flash" : "NOT verified");
+    if (!isRejected || !isAccepted) failures++;
+
+    bool isWindowKept = HostFlash_RunPowered(WriteBeyondWindow, NULL) == 0;
+    printf("page beyond the window: %s\n", isWindowKept ? "rejected" : "NOT rejected");
+    if (!isWindowKept) failures++;
+
+    printf(failures ? "%d failures\n" : "all checks passed\n", failures);
+    return failures != 0;
+}
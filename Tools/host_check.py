@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Host checks of the firmware modules that do not need the hardware.
+
+Each check is a small C program in Tools/HostCheck, <name>_check.c, built
+with the host compiler against the module sources it exercises and the
+stand-ins of Tools/HostCheck/Stubs (CMSIS-RTOS2, HAL core, DWT, and the
+SPI flash chip for the storage checks). A check simulates what the module
+would see on the target (flash, encoders, gyro, time), prints its figures
+and exits non-zero when a claim does not hold. Variants build the same
+check again with other configuration macros. A warning fails the build.
+
+The figures are those of the host build of the same C code, not cycle
+counts of the target; a check that models timing says so in its output.
+
+Usage: python3 Tools/host_check.py [check name ...]
+       CC=clang python3 Tools/host_check.py
+"""
+
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CHECK_DIR = os.path.join(ROOT, "Tools", "HostCheck")
+STUB_DIR = os.path.join(CHECK_DIR, "Stubs")
+
+# Sources of the flash storage stack, over the simulated chip
+FLASH_SOURCES = ["Src/Devices/w25qxx.c", "Src/Algorithm/crc32.c"]
+
+# name -> module sources under test, extra stubs, extra flags, and the macro
+# sets of its variants
+CHECKS = {
+    "heading_fusion": {
+        "sources": ["Src/Algorithm/heading_fusion.c", "Src/Algorithm/kalman_filter.c",
+                    "Src/Devices/gyro.c", "Src/MotionControl/two_wheel_odometry.c"],
+    },
+    "mem_pool": {
+        "sources": ["Src/System/mem_pool.c"],
+        "cflags": ["-no-pie"],     # The block stack links blocks by 32-bit addresses
+    },
+    "chassis_kinematic": {
+        "sources": ["Src/MotionControl/chassis_kinematic.c"],
+        "variants": [
+            ["DEFAULT_CHASSIS_TYPE=CHASSIS_TYPE_DIFF"],
+            ["DEFAULT_CHASSIS_TYPE=CHASSIS_TYPE_SKID", "TOTAL_MOTOR_NUMBER=4"],
+            ["DEFAULT_CHASSIS_TYPE=CHASSIS_TYPE_MECANUM", "TOTAL_MOTOR_NUMBER=4"],
+            ["DEFAULT_CHASSIS_TYPE=CHASSIS_TYPE_OMNI3", "TOTAL_MOTOR_NUMBER=3"],
+        ],
+    },
+    "odometry": {
+        "sources": ["Src/MotionControl/two_wheel_odometry.c", "Src/Algorithm/heading_fusion.c",
+                    "Src/Algorithm/kalman_filter.c"],
+    },
+    "pid": {
+        "sources": ["Src/Algorithm/pid.c", "Src/Algorithm/kalman_filter.c"],
+    },
+    "thread_tiers": {
+        "sources": [],
+    },
+    "data_store": {
+        "sources": ["Src/DataStore/data_store.c", "Src/DataStore/kv_store.c", "Src/DataStore/store_file.c",
+                    "Src/System/mem_pool.c"] + FLASH_SOURCES,
+        "stubs": ["host_spi_flash.c"],
+        "variants": [[], ["TOTAL_MOTOR_NUMBER=4"]],
+    },
+    "store_file": {
+        "sources": ["Src/DataStore/store_file.c", "Src/System/mem_pool.c"] + FLASH_SOURCES,
+        "stubs": ["host_spi_flash.c"],
+    },
+    "update_file": {
+        "sources": ["Src/DataStore/update_file.c"] + FLASH_SOURCES,
+        "stubs": ["host_spi_flash.c"],
+    },
+}
+
+CFLAGS = ["-std=gnu11", "-O2", "-g", "-Wall", "-Werror", "-Wno-unused-function"]
+
+
+def include_dirs():
+    """Stubs first, then every source directory like the Keil project."""
+    dirs = [STUB_DIR]
+    dirs += sorted(d.rstrip(os.sep) for d in glob.glob(os.path.join(ROOT, "Src", "*", "")))
+    return ["-I" + d for d in dirs]
+
+
+def build(name, check, defines, out_dir):
+    """Compile one variant of a check, return the path of the program or None."""
+    program = os.path.join(out_dir, name + "".join("_" + d.replace("=", "_") for d in defines))
+    sources = [os.path.join(CHECK_DIR, name + "_check.c"), os.path.join(STUB_DIR, "host_os.c")]
+    sources += [os.path.join(STUB_DIR, s) for s in check.get("stubs", [])]
+    sources += [os.path.join(ROOT, s) for s in check["sources"]]
+    command = [os.environ.get("CC", "gcc")] + CFLAGS + check.get("cflags", []) + include_dirs()
+    command += ["-D" + d for d in defines] + sources + ["-o", program, "-lm"]
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        print(result.stderr)
+        return None
+    return program
+
+
+def main(names):
+    unknown = [n for n in names if n not in CHECKS]
+    if unknown:
+        print("Unknown checks: " + ", ".join(unknown) + "; known: " + ", ".join(CHECKS))
+        return 2
+    failures = []
+    out_dir = tempfile.mkdtemp(prefix="host_check_")
+    try:
+        for name in names or CHECKS:
+            check = CHECKS[name]
+            for defines in check.get("variants", [[]]):
+                label = name + (" [" + " ".join(defines) + "]" if defines else "")
+                print("==== " + label)
+                sys.stdout.flush()
+                program = build(name, check, defines, out_dir)
+                if program is None or subprocess.run([program]).returncode != 0:
+                    failures.append(label)
+                    print("FAIL " + label)
+                else:
+                    print("PASS " + label)
+    finally:
+        shutil.rmtree(out_dir, ignore_errors=True)
+    print("\n%d failed: %s" % (len(failures), ", ".join(failures)) if failures else "\nAll checks passed")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
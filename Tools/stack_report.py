@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+Static stack budget of the firmware threads and interrupts.
+
+Combines the static call graph written by armlink (Objects/ChassisController.htm,
+"Callgraph" listing option) with the thread stack sizes found in the sources
+and the RTX/Network configuration, and prints the worst case depth and the
+headroom of every stack.
+
+Functions called through pointers are invisible to the linker. Callbacks
+passed to the known registration functions are therefore added on top of the
+depth of the thread (or interrupt) which calls them, which is conservative.
+Compare the result with the runtime watermarks reported by the diagnostics
+service (ROS_CMD_READ_RESOURCES) before shrinking a stack.
+
+Usage: python3 Tools/stack_report.py [path/to/ChassisController.htm]
+"""
+
+import glob
+import html
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Registration function -> thread entry (or "MSP" for interrupts) running the callback
+CALLBACK_RUNNERS = {
+    "ROS_Interface_RegisterIncomingCallback": "IncomingTask",
+    "ROS_Interface_RegisterFeedbackCallback": "FeedbackTask",
+    "RC_Receiver_Register_Callback": "RC_Receiver_Process",
+    "IO_RegisterCallback": "AppIoInputThread",
+    "osTimerNew": "osRtxTimerThread",
+    "UDP_RegisterListener": "netCore_Thread",
+    "Timer_RegisterPeriodCallback": "MSP",
+    "Timer_RegisterTickCallback": "MSP",
+    "Timer_RegisterEncoderOverflowCallback": "MSP",
+    "USART_Register_Callback": "MSP",
+}
+
+
+def read(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        return f.read()
+
+
+def parse_callgraph(path):
+    """Return {function: (own frame, max depth)} from the armlink call graph."""
+    text = read(path)
+    functions = {}
+    pattern = re.compile(
+        r'<STRONG><a name="\[[0-9a-f]+\]"></a>([^<]+)</STRONG> \([^)]*?Stack size (\d+) bytes[^)]*\)'
+        r'(?:\s*<BR><BR>\[Stack\]<UL><LI>Max Depth = (\d+))?')
+    for match in pattern.finditer(text):
+        name = html.unescape(match.group(1))
+        frame = int(match.group(2))
+        depth = int(match.group(3)) if match.group(3) else frame
+        functions[name] = (frame, depth)
+    return functions
+
+
+def config_value(path, name):
+    match = re.search(r"#define\s+%s\s+(\w+)" % name, read(os.path.join(ROOT, path)))
+    return int(match.group(1), 0) if match else 0
+
+
+def stack_size(text, value):
+    """Evaluate a .stack_size value: a number or sizeof() of a static stack array."""
+    array = re.fullmatch(r"sizeof\((\w+)\)", value)
+    if not array:
+        return int(value, 0)
+    match = re.search(r"uint(\d+)_t\s+%s\[([^\]]+)\]" % array.group(1), text)
+    if not match:
+        return 0
+    width = int(match.group(1)) // 8
+    count = re.sub(r"sizeof\(uint(\d+)_t\)", lambda m: str(int(m.group(1)) // 8), match.group(2))
+    return width * eval(count, {"__builtins__": {}}) // 1
+
+
+def find_threads(sources):
+    """Return [(entry, stack size, file)] for every osThreadNew call."""
+    default_stack = config_value("RTE/CMSIS/RTX_Config.h", "OS_STACK_SIZE")
+    threads = []
+    for path in sources:
+        text = read(path)
+        for match in re.finditer(r"osThreadNew\(\s*(\w+)\s*,[^,]*,\s*&?(\w+)\s*\)", text):
+            entry, attr = match.groups()
+            stack = default_stack
+            if attr != "NULL":
+                attr_match = re.search(r"osThreadAttr_t\s+%s\s*=\s*\{(.*?)\};" % attr, text, re.S)
+                size_match = attr_match and re.search(r"\.stack_size\s*=\s*(sizeof\(\w+\)|\w+)", attr_match.group(1))
+                if size_match:
+                    stack = stack_size(text, size_match.group(1))
+            threads.append((entry, stack, os.path.relpath(path, ROOT)))
+    threads.append(("osRtxTimerThread", config_value("RTE/CMSIS/RTX_Config.h", "OS_TIMER_THREAD_STACK_SIZE"), "RTX_Config.h"))
+    threads.append(("osRtxIdleThread", config_value("RTE/CMSIS/RTX_Config.h", "OS_IDLE_THREAD_STACK_SIZE"), "RTX_Config.h"))
+    threads.append(("netCore_Thread", config_value("RTE/Network/Net_Config.h", "NET_THREAD_STACK_SIZE"), "Net_Config.h"))
+    return threads
+
+
+def find_callbacks(sources):
+    """Return {runner: set of callback functions} from the registration calls."""
+    callbacks = {}
+    for path in sources:
+        text = read(path)
+        for function, runner in CALLBACK_RUNNERS.items():
+            for match in re.finditer(r"\b%s\(([^;]*?)\)\s*;" % function, text):
+                args = [a.strip() for a in match.group(1).split(",")]
+                names = [a for a in args if re.fullmatch(r"[A-Za-z_]\w*", a) and not a.isupper()]
+                if function == "osTimerNew":
+                    names = names[:1]
+                elif names:
+                    names = names[-1:]
+                for name in names:
+                    callbacks.setdefault(runner, set()).add(name)
+    return callbacks
+
+
+def main():
+    callgraph = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "Objects", "ChassisController.htm")
+    functions = parse_callgraph(callgraph)
+    sources = glob.glob(os.path.join(ROOT, "Src", "**", "*.c"), recursive=True)
+    threads = find_threads(sources)
+    callbacks = find_callbacks(sources)
+
+    def depth(name):
+        return functions.get(name, (0, None))[1]
+
+    def callback_depth(runner):
+        known = [depth(c) for c in callbacks.get(runner, ()) if depth(c) is not None]
+        return max(known, default=0)
+
+    print("%-28s %7s %7s %9s %8s  %s" % ("Thread entry", "Stack", "Depth", "Callbacks", "Headroom", "Defined in"))
+    for entry, stack, where in threads:
+        own = depth(entry)
+        extra = callback_depth(entry)
+        if own is None:
+            print("%-28s %7d %7s %9d %8s  %s" % (entry, stack, "?", extra, "?", where))
+            continue
+        total = own + extra
+        flag = "  <-- over budget" if total > stack else ""
+        print("%-28s %7d %7d %9d %8d  %s%s" % (entry, stack, own, extra, stack - total, where, flag))
+
+    # Interrupts run on the main stack; nesting adds up, the deepest handler is shown
+    startup = glob.glob(os.path.join(ROOT, "STM32CubeMX", "**", "startup_stm32f407xx.s"), recursive=True)
+    msp = 0
+    if startup:
+        match = re.search(r"Stack_Size\s+EQU\s+(\w+)", read(startup[0]))
+        msp = int(match.group(1), 0) if match else 0
+    handlers = {n: d for n, (f, d) in functions.items() if n.endswith("_Handler") or n.endswith("_IRQHandler")}
+    deepest = max(handlers.items(), key=lambda item: item[1], default=("-", 0))
+    extra = callback_depth("MSP")
+    print("%-28s %7d %7d %9d %8d  deepest handler %s" % ("MSP (interrupts)", msp, deepest[1], extra,
+                                                          msp - deepest[1] - extra, deepest[0]))
+
+    unknown = sorted(c for runner in callbacks.values() for c in runner if depth(c) is None)
+    if unknown:
+        print("\nCallbacks missing from the call graph: " + ", ".join(unknown))
+
+
+if __name__ == "__main__":
+    main()